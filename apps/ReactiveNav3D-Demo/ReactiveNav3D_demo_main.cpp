@@ -8,6 +8,7 @@
    +------------------------------------------------------------------------+ */
 
 #include <iostream>
+#include <thread>
 #include "ReactiveNav3D_demo.h"
 #include <mrpt/config/CConfigFile.h>
 #include <mrpt/config/CConfigFileMemory.h>
@@ -14,6 +14,7 @@
 #include <mrpt/math/data_utils.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/containers/copy_container_typecasting.h>
+#include <thread>
 
 using namespace mrpt::math;
 using namespace mrpt::gui;
@@ -20,6 +20,7 @@
 #include <mrpt/opengl/CGridPlaneXY.h>
 #include <mrpt/opengl/graph_tools.h>
 #include <mrpt/serialization/CArchive.h>
+#include <thread>
 
 using namespace mrpt;
 using namespace mrpt::graphs;
@@ -39,7 +39,9 @@ void register_tests_feature_extraction();
 void register_tests_feature_matching();
 void register_tests_graph();
 void register_tests_graphslam();
+void register_tests_kalman();
 void register_tests_CObservation3DRangeScan();
+void register_tests_CObservationVelodyneScan();
 void register_tests_atan2lut();
 void register_tests_strings();
 // -------------------------------------------------
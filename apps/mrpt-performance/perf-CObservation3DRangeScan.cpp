@@ -56,6 +56,7 @@ double obs3d_test_depth_to_3d(int a, int b)
 	T3DPointsProjectionParams pp;
 	pp.PROJ3D_USE_LUT = (a & 0x01) != 0;
 	pp.USE_SSE2 = (a & 0x02) != 0;
+	pp.num_threads = (a & 0x04) != 0 ? 1 : 0;
 
 	TRangeImageFilterParams fp;
 	mrpt::math::CMatrix minF, maxF;
@@ -155,6 +156,11 @@ void register_tests_CObservation3DRangeScan()
 				"3DRangeScan: 320x240 Depth->3D (LUT,w/SSE2)",
 				obs3d_test_depth_to_3d, 0x03, 0));
 
+		lstTests.push_back(
+			TestData(
+				"3DRangeScan: 320x240 Depth->3D (LUT,w/SSE2,1 thread)",
+				obs3d_test_depth_to_3d, 0x07, 0));
+
 		lstTests.push_back(
 			TestData(
 				"3DRangeScan: 320x240 Depth->3D (no LUT,w/o SSE2,minFilter)",
@@ -0,0 +1,144 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/obs/CObservationVelodyneScan.h>
+#include <mrpt/poses/CPose3DInterpolator.h>
+#include <mrpt/random.h>
+#include <mrpt/system/CTimeLogger.h>
+#include <mrpt/system/datetime.h>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::system;
+using namespace std;
+
+// Synthetic full 360deg scan, with random ranges:
+static void generateVelodyneScan(CObservationVelodyneScan& obs, int nLasers)
+{
+	auto& rnd = mrpt::random::getRandomGenerator();
+	rnd.randomize(123);
+
+	const bool vlp16 = (nLasers == 16);
+	obs.calibration =
+		VelodyneCalibration::LoadDefaultCalibration(vlp16 ? "VLP16" : "HDL32");
+	obs.minRange = 1.0;
+	obs.maxRange = 100.0;
+	obs.timestamp = mrpt::system::now();
+
+	// ~10 Hz scans: VLP16 = 754 pkts/s, HDL32 = 1808 pkts/s
+	const size_t nPkts = vlp16 ? 76 : 181;
+	const int nRotPerPkt = CObservationVelodyneScan::ROTATION_MAX_UNITS /
+						   static_cast<int>(nPkts);
+	obs.scan_packets.resize(nPkts);
+	for (size_t p = 0; p < nPkts; p++)
+	{
+		auto& pkt = obs.scan_packets[p];
+		pkt.gps_timestamp = static_cast<uint32_t>(p * (vlp16 ? 1327 : 553));
+		pkt.laser_return_mode = CObservationVelodyneScan::RETMODE_STRONGEST;
+		pkt.velodyne_model_ID = vlp16 ? 0x22 : 0x21;
+		for (int b = 0; b < CObservationVelodyneScan::BLOCKS_PER_PACKET; b++)
+		{
+			auto& blk = pkt.blocks[b];
+			blk.header = CObservationVelodyneScan::UPPER_BANK;
+			blk.rotation = static_cast<uint16_t>(
+				(p * nRotPerPkt +
+				 b * nRotPerPkt / CObservationVelodyneScan::BLOCKS_PER_PACKET) %
+				CObservationVelodyneScan::ROTATION_MAX_UNITS);
+			for (auto& r : blk.laser_returns)
+			{
+				r.distance =
+					static_cast<uint16_t>(rnd.drawUniform32bit() % 20000);
+				r.intensity = static_cast<uint8_t>(rnd.drawUniform32bit());
+			}
+		}
+	}
+}
+
+double velodyne_generatePointCloud(int nLasers, int nThreads)
+{
+	CObservationVelodyneScan obs;
+	generateVelodyneScan(obs, nLasers);
+
+	CObservationVelodyneScan::TGeneratePointCloudParameters pp;
+	pp.num_threads = nThreads;
+
+	CTimeLogger timlog;
+	for (int i = 0; i < 100; i++)
+	{
+		timlog.enter("run");
+		obs.generatePointCloud(pp);
+		timlog.leave("run");
+	}
+	const double t = timlog.getMeanTime("run");
+	timlog.clear(true);
+	return t;
+}
+
+double velodyne_generatePointCloudSE3(int nLasers, int nThreads)
+{
+	CObservationVelodyneScan obs;
+	generateVelodyneScan(obs, nLasers);
+
+	CPose3DInterpolator path;
+	for (int i = -2; i < 5; i++)
+		path.insert(
+			mrpt::system::timestampAdd(obs.timestamp, i * 0.05),
+			mrpt::math::TPose3D(i * 0.5, i * 0.01, 0, i * 0.02, 0, 0));
+
+	CObservationVelodyneScan::TGeneratePointCloudParameters pp;
+	pp.num_threads = nThreads;
+
+	CTimeLogger timlog;
+	std::vector<mrpt::math::TPointXYZIu8> pts;
+	for (int i = 0; i < 100; i++)
+	{
+		pts.clear();
+		CObservationVelodyneScan::TGeneratePointCloudSE3Results res;
+		timlog.enter("run");
+		obs.generatePointCloudAlongSE3Trajectory(path, pts, res, pp);
+		timlog.leave("run");
+	}
+	const double t = timlog.getMeanTime("run");
+	timlog.clear(true);
+	return t;
+}
+
+// ------------------------------------------------------
+// register_tests_CObservationVelodyneScan
+// ------------------------------------------------------
+void register_tests_CObservationVelodyneScan()
+{
+	lstTests.push_back(
+		TestData(
+			"VelodyneScan: VLP16 generatePointCloud (1 thread)",
+			velodyne_generatePointCloud, 16, 1));
+	lstTests.push_back(
+		TestData(
+			"VelodyneScan: VLP16 generatePointCloud (all threads)",
+			velodyne_generatePointCloud, 16, 0));
+	lstTests.push_back(
+		TestData(
+			"VelodyneScan: HDL32 generatePointCloud (1 thread)",
+			velodyne_generatePointCloud, 32, 1));
+	lstTests.push_back(
+		TestData(
+			"VelodyneScan: HDL32 generatePointCloud (all threads)",
+			velodyne_generatePointCloud, 32, 0));
+	lstTests.push_back(
+		TestData(
+			"VelodyneScan: HDL32 PointCloudAlongSE3Trajectory (1 thread)",
+			velodyne_generatePointCloudSE3, 32, 1));
+	lstTests.push_back(
+		TestData(
+			"VelodyneScan: HDL32 PointCloudAlongSE3Trajectory (all threads)",
+			velodyne_generatePointCloudSE3, 32, 0));
+}
@@ -268,6 +268,35 @@ double feature_extraction_test_FASTER(int N, int threshold)
 	return T;
 }
 
+// ------------------------------------------------------
+//				Benchmark: tiled, multi-scale FASTER
+// ------------------------------------------------------
+template <int OCTAVES, int NUM_THREADS>
+double feature_extraction_test_tiled_FASTER(int N, int threshold)
+{
+	CTicTac tictac;
+
+	CImage img;
+	getTestImage(0, img);
+	img.grayscaleInPlace();
+
+	CFeatureExtraction fExt;
+	CFeatureList feats;
+
+	fExt.options.featsType = featFASTER9;
+	fExt.options.FASTOptions.threshold = threshold;
+	fExt.options.patchSize = 0;
+	fExt.options.tiledPyramidOptions.enable = true;
+	fExt.options.tiledPyramidOptions.octaves = OCTAVES;
+	fExt.options.tiledPyramidOptions.num_threads = NUM_THREADS;
+
+	tictac.Tic();
+	for (int i = 0; i < N; i++) fExt.detectFeatures(img, feats, 0, 500);
+
+	const double T = tictac.Tac() / N;
+	return T;
+}
+
 // ------------------------------------------------------
 // register_tests_feature_extraction
 // ------------------------------------------------------
@@ -325,6 +354,26 @@ void register_tests_feature_extraction()
 			"feature_extraction [640x480]: FASTER-12 (sorted best 200)",
 			feature_extraction_test_FASTER<featFASTER12, 200>, 100, 20));
 
+	lstTests.push_back(
+		TestData(
+			"feature_extraction [640x480]: FASTER-9 tiled 4x4, best 500",
+			feature_extraction_test_tiled_FASTER<1, 1>, 100, 20));
+	lstTests.push_back(
+		TestData(
+			"feature_extraction [640x480]: FASTER-9 tiled 4x4, best 500, "
+			"all threads",
+			feature_extraction_test_tiled_FASTER<1, 0>, 100, 20));
+	lstTests.push_back(
+		TestData(
+			"feature_extraction [640x480]: FASTER-9 tiled 4x4, 3 octaves, "
+			"best 500",
+			feature_extraction_test_tiled_FASTER<3, 1>, 100, 20));
+	lstTests.push_back(
+		TestData(
+			"feature_extraction [640x480]: FASTER-9 tiled 4x4, 3 octaves, "
+			"best 500, all threads",
+			feature_extraction_test_tiled_FASTER<3, 0>, 100, 20));
+
 	lstTests.push_back(
 		TestData(
 			"feature_extraction [640x480]: detectFeatures_SSE2_FASTER9()",
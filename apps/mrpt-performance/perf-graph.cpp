@@ -114,6 +114,32 @@ double graphs_dijkstra(int nNodes, int _N)
 	return ret;
 }
 
+template <class EDGE_TYPE, class MAPS_IMPLEMENTATION>
+double graphs_dijkstra_nodes_estimate(int nNodes, int _N)
+{
+	const long N = _N;
+
+	getRandomGenerator().randomize(111);
+	// Generate a random graph: odometry + random loop closures
+	using graph_t =
+		mrpt::graphs::CNetworkOfPoses<EDGE_TYPE, MAPS_IMPLEMENTATION>;
+	graph_t gs;
+	gs.root = 0;
+	for (TNodeID i = 0; i < TNodeID(nNodes); i++)
+	{
+		gs.nodes[i] = typename graph_t::global_pose_t();
+		if (i > 0) gs.insertEdge(i - 1, i, EDGE_TYPE());
+		if (i > 10 && (i % 10) == 0)
+			gs.insertEdge(
+				getRandomGenerator().drawUniform32bit() % (i - 1), i,
+				EDGE_TYPE());
+	}
+
+	CTicTac tictac;
+	for (long i = 0; i < N; i++) gs.dijkstra_nodes_estimate();
+	return tictac.Tac() / N;
+}
+
 // ------------------------------------------------------
 // register_tests_graph
 // ------------------------------------------------------
@@ -191,6 +217,14 @@ void register_tests_graph()
 			CPosePDFGaussianInf, map_traits_map_as_vector>,
 		1e4, 250));
 
+	lstTests.push_back(TestData(
+		"graph(2d,flat): insertEdge x 1e4",
+		graphs_test_populate<CPose2D, map_traits_flat>, 1e4, 250));
+	lstTests.push_back(TestData(
+		"graph(2d pdf,flat): insertEdge x 1e4",
+		graphs_test_populate<CPosePDFGaussianInf, map_traits_flat>, 1e4,
+		250));
+
 	lstTests.push_back(TestData(
 		"graph(3d): insertEdge x 1e3",
 		graphs_test_populate<CPose3D, map_traits_stdmap>, 1e3, 1000));
@@ -293,4 +327,19 @@ void register_tests_graph()
 	lstTests.push_back(TestData(
 		"graph(2d,vec): dijkstra 1e5 nodes",
 		graphs_dijkstra<CPose2D, map_traits_map_as_vector>, 1e5, 50));
+	lstTests.push_back(TestData(
+		"graph(2d,flat): dijkstra 1e5 nodes",
+		graphs_dijkstra<CPose2D, map_traits_flat>, 1e5, 50));
+	lstTests.push_back(TestData(
+		"graph(3d,flat): dijkstra 1e5 nodes",
+		graphs_dijkstra<CPose3D, map_traits_flat>, 1e5, 50));
+
+	lstTests.push_back(TestData(
+		"graph(2d pdf): dijkstra_nodes_estimate 1e5 nodes",
+		graphs_dijkstra_nodes_estimate<CPosePDFGaussianInf, map_traits_stdmap>,
+		1e5, 10));
+	lstTests.push_back(TestData(
+		"graph(2d pdf,flat): dijkstra_nodes_estimate 1e5 nodes",
+		graphs_dijkstra_nodes_estimate<CPosePDFGaussianInf, map_traits_flat>,
+		1e5, 10));
 }
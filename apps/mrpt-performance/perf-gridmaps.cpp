@@ -171,6 +171,58 @@ double grid_test_8(int a1, int a2)
 	return tictac.Tac() / N;
 }
 
+double grid_test_8b(int a1, int a2)
+{
+	getRandomGenerator().randomize(333);
+
+	// prepare the laser scan:
+	CObservation2DRangeScan scan1;
+	scan1.aperture = M_PIf;
+	scan1.rightToLeft = true;
+	scan1.loadFromVectors(
+		sizeof(SCAN_RANGES_1) / sizeof(SCAN_RANGES_1[0]), SCAN_RANGES_1,
+		SCAN_VALID_1);
+
+	COccupancyGridMap2D gridmap(-20, 20, -20, 20, 0.05f);
+	gridmap.likelihoodOptions.LF_decimation = 1;
+
+	CPose3D pose3D(0, 0, 0);
+	gridmap.insertObservation(&scan1, &pose3D);
+
+	CSimplePointsMap pts;
+	pts.insertObservation(&scan1);
+
+	// test 8b: Likelihood field of a batch of poses (a1=0: one by one, a1=1:
+	// batch)
+	const long N = 5000;
+	std::vector<mrpt::math::TPose2D> poses(N);
+	for (auto& p : poses)
+	{
+		p.x = getRandomGenerator().drawUniform(-1.0, 1.0);
+		p.y = getRandomGenerator().drawUniform(-1.0, 1.0);
+		p.phi = getRandomGenerator().drawUniform(-M_PI, M_PI);
+	}
+	std::vector<double> log_liks(N);
+
+	// Warm up the likelihood caches, then measure:
+	for (int rep = 0; rep < 2; rep++)
+	{
+		CTicTac tictac;
+		if (a1 == 0)
+		{
+			for (long i = 0; i < N; i++)
+			{
+				const CPose2D p(poses[i]);
+				log_liks[i] = gridmap.computeLikelihoodField_Thrun(&pts, &p);
+			}
+		}
+		else
+			gridmap.computeLikelihoodField_Thrun_batch(&pts, poses, log_liks);
+		if (rep == 1) return tictac.Tac() / N;
+	}
+	return 0;
+}
+
 double grid_test_9(int a1, int a2)
 {
 	// test 9: computeMatchingWith2D
@@ -229,6 +281,10 @@ void register_tests_grids()
 		TestData("gridmap2D: insert scan with widening", grid_test_5_6, 1));
 	lstTests.push_back(TestData("gridmap2D: resize", grid_test_7));
 	lstTests.push_back(TestData("gridmap2D: computeLikelihood", grid_test_8));
+	lstTests.push_back(
+		TestData("gridmap2D: likelihoodField (one pose)", grid_test_8b, 0));
+	lstTests.push_back(
+		TestData("gridmap2D: likelihoodField (batch)", grid_test_8b, 1));
 	lstTests.push_back(
 		TestData("gridmap2D: determineMatching2D", grid_test_9, 5000));
 }
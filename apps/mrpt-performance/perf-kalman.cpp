@@ -0,0 +1,122 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/slam/CRangeBearingKFSLAM.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CObservationBearingRange.h>
+#include <mrpt/random.h>
+#include <mrpt/system/CTimeLogger.h>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace mrpt::slam;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::random;
+using namespace std;
+
+// 3D range-bearing KF-SLAM with `nLMs` landmarks, all of them visible at
+// each time step. `nThreads`=1 is the serial, per-landmark evaluation of the
+// observation model and Jacobians; any other value selects the batch mode.
+static double kf_slam_3d(int nLMs, int nThreads, bool analyticJacobians)
+{
+	auto& rnd = getRandomGenerator();
+	rnd.randomize(123);
+
+	std::vector<mrpt::math::TPoint3D> lms(nLMs);
+	for (auto& lm : lms)
+		lm = mrpt::math::TPoint3D(
+			rnd.drawUniform(-20, 20), rnd.drawUniform(-20, 20),
+			rnd.drawUniform(-2, 2));
+
+	CRangeBearingKFSLAM slam;
+	slam.KF_options.method = kfEKFNaive;
+	slam.KF_options.num_threads = nThreads;
+	slam.KF_options.use_analytic_observation_jacobian = analyticJacobians;
+	slam.options.std_sensor_range = 0.01f;
+	slam.options.std_sensor_yaw = DEG2RAD(0.1f);
+	slam.options.std_sensor_pitch = DEG2RAD(0.1f);
+
+	CTimeLogger timlog;
+	CPose3D gt_pose;
+	const int nSteps = 8;
+	for (int step = 0; step < nSteps; step++)
+	{
+		const CPose2D incr(step ? 0.2 : 0.0, 0, step ? 0.02 : 0.0);
+		gt_pose = gt_pose + CPose3D(incr);
+
+		CActionRobotMovement2D actmov;
+		CActionRobotMovement2D::TMotionModelOptions odo_opts;
+		odo_opts.modelSelection = CActionRobotMovement2D::mmGaussian;
+		actmov.computeFromOdometry(incr, odo_opts);
+		auto act = mrpt::make_aligned_shared<CActionCollection>();
+		act->insert(actmov);
+
+		auto obs = mrpt::make_aligned_shared<CObservationBearingRange>();
+		obs->minSensorDistance = 0;
+		obs->maxSensorDistance = 100;
+		obs->fieldOfView_yaw = 2 * M_PI;
+		obs->fieldOfView_pitch = M_PI;
+		for (int i = 0; i < nLMs; i++)
+		{
+			double r, yaw, pitch;
+			gt_pose.sphericalCoordinates(lms[i], r, yaw, pitch);
+			CObservationBearingRange::TMeasurement m;
+			m.range = r + rnd.drawGaussian1D(0, 0.01);
+			m.yaw = yaw + rnd.drawGaussian1D(0, DEG2RAD(0.1));
+			m.pitch = pitch + rnd.drawGaussian1D(0, DEG2RAD(0.1));
+			m.landmarkID = i;
+			obs->sensedData.push_back(m);
+		}
+		auto sf = mrpt::make_aligned_shared<CSensoryFrame>();
+		sf->insert(obs);
+
+		// Do not count the first step, which only inserts landmarks:
+		if (step) timlog.enter("run");
+		slam.processActionObservation(act, sf);
+		if (step) timlog.leave("run");
+	}
+	const double t = timlog.getMeanTime("run");
+	timlog.clear(true);
+	return t;
+}
+
+double kf_slam_3d_analytic(int nLMs, int nThreads)
+{
+	return kf_slam_3d(nLMs, nThreads, true);
+}
+double kf_slam_3d_numeric(int nLMs, int nThreads)
+{
+	return kf_slam_3d(nLMs, nThreads, false);
+}
+
+// ------------------------------------------------------
+// register_tests_kalman
+// ------------------------------------------------------
+void register_tests_kalman()
+{
+	lstTests.push_back(
+		TestData(
+			"KF-SLAM 3D: 250 LMs, analytic Jacobians (serial)",
+			kf_slam_3d_analytic, 250, 1));
+	lstTests.push_back(
+		TestData(
+			"KF-SLAM 3D: 250 LMs, analytic Jacobians (batch, all threads)",
+			kf_slam_3d_analytic, 250, 0));
+	lstTests.push_back(
+		TestData(
+			"KF-SLAM 3D: 250 LMs, numeric Jacobians (serial)",
+			kf_slam_3d_numeric, 250, 1));
+	lstTests.push_back(
+		TestData(
+			"KF-SLAM 3D: 250 LMs, numeric Jacobians (batch, all threads)",
+			kf_slam_3d_numeric, 250, 0));
+}
@@ -216,7 +216,9 @@ int main(int argc, char** argv)
 		register_tests_feature_matching();
 		register_tests_graph();
 		register_tests_graphslam();
+		register_tests_kalman();
 		register_tests_CObservation3DRangeScan();
+		register_tests_CObservationVelodyneScan();
 		register_tests_atan2lut();
 		register_tests_strings();
 
@@ -0,0 +1,63 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "rawlog-edit-declarations.h"
+#include <mrpt/obs/CRawlogIndexed.h>
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace mrpt::system;
+using namespace mrpt::rawlogtools;
+using namespace std;
+using namespace mrpt::io;
+
+// ======================================================================
+//		op_generate_index
+// ======================================================================
+DECLARE_OP_FUNCTION(op_generate_index)
+{
+	string inFile;
+	getArgValue<string>(cmdline, "input", inFile);
+
+	// Uncompressed rawlog to index: the input itself, or a decompressed copy
+	// of it if "-o" is given:
+	string rawlogFile = inFile;
+	string outFile;
+	if (getArgValue<string>(cmdline, "output", outFile))
+	{
+		if (fileExists(outFile) && !isFlagSet(cmdline, "overwrite"))
+			throw runtime_error(
+				string("*ABORTING*: Output file already exists: ") + outFile +
+				string("\n. Select a different output path, remove the file "
+						"or force overwrite with '-w' or '--overwrite'."));
+
+		CFileOutputStream fo;
+		if (!fo.open(outFile))
+			throw runtime_error(
+				string("*ABORTING*: Cannot open output file: ") + outFile);
+
+		VERBOSE_COUT << "Writing uncompressed copy to: " << outFile << "\n";
+		std::vector<uint8_t> buf(1 << 20);
+		for (size_t n; (n = in_rawlog.Read(&buf[0], buf.size())) > 0;)
+			fo.Write(&buf[0], n);
+		fo.close();
+		rawlogFile = outFile;
+	}
+
+	const string indexFile = CRawlogIndexed::getIndexFileName(rawlogFile);
+	VERBOSE_COUT << "Building index: " << indexFile << "\n";
+	if (!CRawlogIndexed::buildIndex(rawlogFile, indexFile))
+		throw runtime_error(
+			"Error building the index. Note that gz-compressed rawlogs "
+			"must be decompressed first (use '-o' to do so).");
+
+	CRawlogIndexed rawlog;
+	if (rawlog.open(rawlogFile))
+		VERBOSE_COUT << "Indexed entries: " << rawlog.size() << "\n";
+}
@@ -67,6 +67,7 @@ DECLARE_OP_FUNCTION(op_stereo_rectify);
 DECLARE_OP_FUNCTION(op_rename_externals);
 DECLARE_OP_FUNCTION(op_list_timestamps);
 DECLARE_OP_FUNCTION(op_remap_timestamps);
+DECLARE_OP_FUNCTION(op_generate_index);
 
 // Declare the supported command line switches ===========
 TCLAP::CmdLine cmd(
@@ -141,6 +142,13 @@ TCLAP::SwitchArg arg_overwrite(
 	"w", "overwrite", "Force overwrite target file without prompting.", cmd,
 	false);
 
+TCLAP::ValueArg<unsigned int> arg_gz_threads(
+	"", "gz-threads",
+	"Number of threads for gz compression (output files are then written in "
+	"the BGZF blocked gzip format) and decompression (of BGZF input files). "
+	"0 means as many as hardware threads.",
+	false, 1, "N", cmd);
+
 TCLAP::SwitchArg arg_quiet("q", "quiet", "Terse output", cmd, false);
 
 // ======================================================================
@@ -427,6 +435,15 @@ int main(int argc, char** argv)
 			cmd, false));
 		ops_functors["rename-externals"] = &op_rename_externals;
 
+		arg_ops.push_back(new TCLAP::SwitchArg(
+			"", "generate-index",
+			"Op: generates the index file (<input>.idx) which allows fast "
+			"random access to the rawlog (see mrpt::obs::CRawlogIndexed).\n"
+			"Compressed rawlogs cannot be indexed: use -o (or --output) to "
+			"save an uncompressed copy of the input and index it instead.",
+			cmd, false));
+		ops_functors["generate-index"] = &op_generate_index;
+
 		// --------------- End of list of possible operations --------
 
 		// Parse arguments:
@@ -471,7 +488,7 @@ int main(int argc, char** argv)
 		// Open input rawlog:
 		CFileGZInputStream fil_input;
 		VERBOSE_COUT << "Opening '" << input_rawlog << "'...\n";
-		fil_input.open(input_rawlog);
+		fil_input.open(input_rawlog, arg_gz_threads.getValue());
 		VERBOSE_COUT << "Open OK.\n";
 
 		// External storage directory?
@@ -532,7 +549,9 @@ TOutputRawlogCreator::TOutputRawlogCreator()
 			string("\n. Select a different output path, remove the file or "
 				   "force overwrite with '-w' or '--overwrite'."));
 
-	if (!out_rawlog_io.open(out_rawlog_filename))
+	if (!out_rawlog_io.open(
+			out_rawlog_filename, 1 /*compress level*/,
+			arg_gz_threads.getValue()))
 		throw runtime_error(
 			string("*ABORTING*: Cannot open output file: ") +
 			out_rawlog_filename);
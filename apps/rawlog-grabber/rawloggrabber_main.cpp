@@ -18,6 +18,8 @@
 
 #include <mrpt/hwdrivers/CGenericSensor.h>
 #include <mrpt/config/CConfigFile.h>
+#include <mrpt/config/TaskSchedulerConfig.h>
+#include <mrpt/containers/bounded_queue.h>
 #include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/img/CImage.h>
 #include <mrpt/core/round.h>
@@ -31,6 +33,7 @@
 #include <mrpt/system/filesystem.h>
 #include <mrpt/serialization/CArchive.h>
 
+#include <memory>
 #include <thread>
 
 #ifdef RAWLOGGRABBER_PLUGIN
@@ -61,8 +64,10 @@ struct TThreadParams
 
 void SensorThread(TThreadParams params);
 
-CGenericSensor::TListObservations global_list_obs;
-std::mutex cs_global_list_obs;
+// Observations from all sensor threads, waiting to be sorted by timestamp in
+// the main thread. Created in main(), once its size and policy are known.
+std::unique_ptr<mrpt::containers::mpmc_queue<CGenericSensor::TListObsPair>>
+	global_queue_obs;
 
 bool allThreadsMustExit = false;
 
@@ -107,6 +112,8 @@ int main(int argc, char** argv)
 		int GRABBER_PERIOD_MS = 1000;
 		int rawlog_GZ_compress_level =
 			1;  // 0: No compress, 1-9: compress level
+		// 1: single gzip stream, otherwise: BGZF compressed by N threads
+		int rawlog_GZ_compress_threads = 1;
 
 		MRPT_LOAD_CONFIG_VAR(
 			rawlog_prefix, string, iniFile, GLOBAL_SECTION_NAME);
@@ -121,6 +128,26 @@ int main(int argc, char** argv)
 
 		MRPT_LOAD_CONFIG_VAR(
 			rawlog_GZ_compress_level, int, iniFile, GLOBAL_SECTION_NAME);
+		MRPT_LOAD_CONFIG_VAR(
+			rawlog_GZ_compress_threads, int, iniFile, GLOBAL_SECTION_NAME);
+		// Max. number of observations waiting to be saved. When full, sensor
+		// threads wait for the main thread to make room, unless
+		// obs_queue_drop_oldest=true, which discards the oldest observations
+		// instead (never blocking sensors, but losing data).
+		int obs_queue_len = 1 << 14;
+		bool obs_queue_drop_oldest = false;
+		MRPT_LOAD_CONFIG_VAR(obs_queue_len, int, iniFile, GLOBAL_SECTION_NAME);
+		MRPT_LOAD_CONFIG_VAR(
+			obs_queue_drop_oldest, bool, iniFile, GLOBAL_SECTION_NAME);
+		ASSERT_ABOVE_(obs_queue_len, 0);
+		global_queue_obs.reset(
+			new mrpt::containers::mpmc_queue<CGenericSensor::TListObsPair>(
+				obs_queue_len,
+				obs_queue_drop_oldest
+					? mrpt::containers::queue_full_policy::drop_oldest
+					: mrpt::containers::queue_full_policy::reject));
+		// Optional "num_threads" for all parallel algorithms:
+		mrpt::config::loadTaskSchedulerConfig(iniFile, GLOBAL_SECTION_NAME);
 
 		// Build full rawlog file name:
 		string rawlog_postfix = "_";
@@ -186,17 +213,33 @@ int main(int argc, char** argv)
 		mrpt::io::CFileGZOutputStream out_file;
 		auto out_arch = archiveFrom(out_file);
 
-		out_file.open(rawlog_filename, rawlog_GZ_compress_level);
+		out_file.open(
+			rawlog_filename, rawlog_GZ_compress_level,
+			rawlog_GZ_compress_threads);
 
 		CSensoryFrame curSF;
+		CGenericSensor::TListObservations global_list_obs;
 		CGenericSensor::TListObservations copy_of_global_list_obs;
+		size_t dropped_obs = 0;
 
 		cout << endl << "Press any key to exit program" << endl;
 		while (!os::kbhit() && !allThreadsMustExit)
 		{
 			// See if we have observations and process them:
 			{
-				std::lock_guard<std::mutex> lock(cs_global_list_obs);
+				CGenericSensor::TListObsPair o;
+				while (global_queue_obs->try_pop(o))
+					global_list_obs.insert(std::move(o));
+				if (global_queue_obs->dropped() != dropped_obs)
+				{
+					cerr << "[rawlog-grabber] Warning: "
+						 << global_queue_obs->dropped() - dropped_obs
+						 << " observations discarded, the output file cannot "
+							"be written fast enough."
+						 << endl;
+					dropped_obs = global_queue_obs->dropped();
+				}
+
 				copy_of_global_list_obs.clear();
 
 				if (!global_list_obs.empty())
@@ -208,7 +251,7 @@ int main(int argc, char** argv)
 						global_list_obs.begin(), itEnd);
 					global_list_obs.erase(global_list_obs.begin(), itEnd);
 				}
-			}  // End of cs lock
+			}
 
 			if (use_sensoryframes)
 			{
@@ -526,10 +569,14 @@ void SensorThread(TThreadParams params)
 			CGenericSensor::TListObservations lstObjs;
 			sensor->getObservations(lstObjs);
 
-			{
-				std::lock_guard<std::mutex> lock(cs_global_list_obs);
-				global_list_obs.insert(lstObjs.begin(), lstObjs.end());
-			}
+			// If the queue is full (and not in drop-oldest mode), wait for the
+			// main thread to make room, so no observation is ever lost:
+			for (const auto& o : lstObjs)
+				while (!global_queue_obs->push(
+						   o, std::chrono::milliseconds(100)) &&
+					   !allThreadsMustExit)
+				{
+				}
 
 			lstObjs.clear();
 
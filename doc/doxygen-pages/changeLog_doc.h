@@ -34,6 +34,18 @@ serialization with variants(To be replaced by std::variant eventually).
 			- The ICP module now supports Velodyne 3D scans.
 		- pf-localization:
 			- Odometry is now used also for observation-only rawlogs.
+		-
+[rawlog-edit](http://www.mrpt.org/list-of-mrpt-apps/application-rawlog-edit/):
+			- New operation: `--generate-index`, to build the index used by
+mrpt::obs::CRawlogIndexed.
+			- New flag `--gz-threads` for multi-threaded BGZF compression and
+decompression.
+		- rawlog-grabber:
+			- New option `rawlog_GZ_compress_threads` to compress the output
+rawlog with several threads.
+			- New options `obs_queue_len` and `obs_queue_drop_oldest` for the
+queue of observations waiting to be saved. By default, sensor threads wait if
+it is full, instead of discarding observations.
 	- Changes in libraries:
 		- \ref mrpt_base_grp => Refactored into several smaller libraries, one
 per namespace.
@@ -53,16 +65,74 @@ initializator
 			- Removed the include file: `<mrpt/math/jacobians.h>`. Replace by
 `<mrpt/math/num_jacobian.h>` or individual methods in \ref mrpt_poses_grp
 classes.
+			- mrpt::math::KDTreeCapable queries are now reentrant (can be
+invoked from several threads once the tree is built).
+			- New methods mrpt::math::CSparseMatrix::getCompressedValues() and
+mrpt::math::CSparseMatrix::getNonZeroCount() to update a compressed matrix in
+place.
+		- \ref mrpt_containers_grp
+			- New lock-free bounded queues mrpt::containers::spsc_queue and
+mrpt::containers::mpmc_queue.
+			- New containers mrpt::containers::flat_map and
+mrpt::containers::flat_multimap, sorted contiguous arrays with the std::map API,
+and new storage traits mrpt::containers::map_traits_flat.
+		- \ref mrpt_graphs_grp
+			- mrpt::graphs::CDirectedGraph and mrpt::graphs::CNetworkOfPoses can
+store nodes and edges in contiguous arrays, with
+mrpt::containers::map_traits_flat.
+			- New method mrpt::graphs::CDirectedGraph::getAdjacencyCSR().
+mrpt::graphs::CDijkstra uses it and is now much faster on large graphs.
+			- mrpt::graphs::ScalarFactorGraph has a new sparse Cholesky solver,
+which reuses its symbolic factorization between updates and recovers variances
+with Takahashi recursions, optionally within a time budget. It is the new
+default. See mrpt::graphs::ScalarFactorGraph::setSolver().
 		- \ref mrpt_config_grp  [NEW IN MRPT 2.0.0]
 			- mrpt::config::CConfigFileBase::write() now supports enum types.
+			- New function mrpt::config::loadTaskSchedulerConfig().
 		- \ref mrpt_serialization_grp  [NEW IN MRPT 2.0.0]
 			- New method mrpt::serialization::CArchive::ReadPOD() and macro
 `MRPT_READ_POD()` for reading unaligned POD variables.-
 			- Add support for `$env{}` syntax to evaluate environment variables.
+			- New class mrpt::serialization::CArchiveMemoryBuffer, to serialize
+and deserialize straight from/to caller-owned memory buffers (deserialized
+objects still copy their data; views into the buffer are not supported).
+		- \ref mrpt_io_grp
+			- New class mrpt::io::CMemoryMappedFile.
+			- mrpt::io::CFileGZOutputStream can compress in parallel, writing
+files in the BGZF (blocked gzip) format, which remain valid gzip files.
+mrpt::io::CFileGZInputStream detects BGZF files, decompresses them in parallel
+and supports seeking in them. See mrpt::io::zip::compress_bgzf_block().
+		- \ref mrpt_system_grp
+			- New process-wide, work-stealing task scheduler
+mrpt::system::TaskScheduler, with mrpt::system::TaskGroup,
+mrpt::system::parallel_for() and mrpt::system::parallel_for_chunks(). Its number of threads can be set with the
+environment variable `MRPT_NUM_THREADS`. All the parallel algorithms in MRPT
+(particle filters, point matching, occupancy grid insertion, BGZF compression)
+now share it instead of creating their own threads.
+			- New class mrpt::system::TaskSchedulerThreadsGuard, to change the
+number of threads of the scheduler within a scope.
+		- \ref mrpt_bayes_grp
+			- New method mrpt::bayes::kfSEIF for
+mrpt::bayes::CKalmanFilterCapable: a Sparse Extended Information Filter whose
+updates only modify the vehicle and a bounded set of active landmarks, for maps
+with thousands of landmarks.
+mrpt::slam::CRangeBearingKFSLAM and mrpt::slam::CRangeBearingKFSLAM2D use it
+with `method=kfSEIF`.
+			- mrpt::bayes::CKalmanFilterCapable: New batch mode (see
+mrpt::bayes::TKF_options::num_threads) which predicts the observations and
+evaluates their Jacobians (also the numeric ones) and the innovation matrix in
+parallel, and updates the covariance from the nonzero blocks of the Jacobian,
+in cache-friendly tiles.
 		- \ref mrpt_slam_grp
 			- rbpf-slam: Add support for simplemap continuation.
 			- CICP: parameter `onlyClosestCorrespondences` deleted (always true
 now).
+			- Particle filters (MCL 2D/3D, RBPF) can evaluate the particle
+likelihoods in parallel, with results identical to the serial version. See
+mrpt::bayes::CParticleFilter::TParticleFilterOptions::parallelLikelihoodThreads.
+			- CICP: New ICP-3D methods mrpt::slam::icpPointToPlane and
+mrpt::slam::icpGICP (Generalized-ICP), solved with a robust Gauss-Newton
+method.
 		- \ref mrpt_nav_grp
 			- Removed deprecated mrpt::nav::THolonomicMethod.
 			- mrpt::nav::CAbstractNavigator: callbacks in
@@ -70,13 +140,92 @@ mrpt::nav::CRobot2NavInterface are now invoked *after* `navigationStep()` to
 avoid problems if user code invokes the navigator API to change its state.
 			- Added methods to load/save mrpt::nav::TWaypointSequence to
 configuration files.
+			- mrpt::nav::TMoveTree keeps its nodes in a grid-based spatial index,
+so mrpt::nav::TMoveTree::getNearestNode() no longer scans the whole tree,
+speeding up mrpt::nav::PlannerRRT_SE2_TPS on large trees.
+			- mrpt::nav::CAbstractPTGBasedReactive can evaluate its PTGs in
+parallel. See the new parameter
+mrpt::nav::CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::ptg_evaluation_threads.
+			- New method
+mrpt::nav::CParameterizedTrajectoryGenerator::updateTPObstacles() to update
+TP-Obstacles from a batch of points. mrpt::nav::CPTG_DiffDrive_CollisionGridBased
+implements it with SIMD instructions over a compact collision grid, and the
+reactive navigators and planners use it.
+			- mrpt::nav::CPTG_DiffDrive_CollisionGridBased cache files have a new
+uncompressed format, which is memory-mapped and validated with a hash of all
+PTG parameters and the robot shape. Navigators start up in milliseconds when
+cache files exist. Old `*.dat.gz` cache files are no longer used.
+		- \ref mrpt_img_grp
+			- mrpt::img::CImage copies share their pixels until any of them is
+modified (copy-on-write), so copying images and passing observations around no
+longer copies whole frames. New methods mrpt::img::CImage::makeView() for
+rectangular regions with no copy, and
+mrpt::img::CImage::setFromExternalBuffer() to use external memory.
+			- [API change] The const versions of mrpt::img::CImage::get_unsafe()
+and mrpt::img::CImage::operator() now return `const unsigned char*`.
+		- \ref mrpt_obs_grp
+			- mrpt::obs::CObservationVelodyneScan::generatePointCloud() and
+mrpt::obs::CObservationVelodyneScan::generatePointCloudAlongSE3Trajectory()
+decode packets in parallel into preallocated buffers, with per-block hoisting
+of laser timing and calibration. See
+mrpt::obs::CObservationVelodyneScan::TGeneratePointCloudParameters::num_threads.
+			- mrpt::obs::CObservation3DRangeScan::project3DPointsFromDepthImageInto()
+filters, projects, colors and transforms points in a single pass, with rows
+split among threads and SSE2 for images of any width. See
+mrpt::obs::T3DPointsProjectionParams::num_threads.
+		- \ref mrpt_vision_grp
+			- mrpt::vision::CFeatureExtraction can detect features over tiles
+and pyramid octaves in parallel, spreading them evenly over the image by grid
+bucketing. See
+mrpt::vision::CFeatureExtraction::TOptions::TTiledPyramidOptions.
+			- mrpt::vision::CFeatureTracker_KL no longer depends on OpenCV: it
+has a native pyramidal Lucas-Kanade implementation with SSE2 optimizations,
+which tracks features in parallel and reuses the image pyramid of the previous
+frame. New tracker parameter `num_threads`.
 		- \ref mrpt_comms_grp [NEW IN MRPT 2.0.0]
 			- This new module has been created to hold all serial devices &
 networking classes, with minimal dependencies.
 		- \ref mrpt_maps_grp
 			- Added optional "channel" attribute to CReflectivityGrdMap2D and
 CObservationReflectivity to support different colors of light.
+			- New method
+mrpt::maps::COccupancyGridMap2D::computeLikelihoodField_Thrun_batch() to
+evaluate the likelihood field of many poses at once with SSE2 optimizations.
+It is used by mrpt::slam::CMonteCarloLocalization2D with the standard proposal
+(through the new mrpt::maps::COccupancyGridMap2D::computeObservationLikelihood_batch()).
+			- mrpt::maps::COccupancyGridMap2D: Multi-threaded insertion of range
+scans (see
+mrpt::maps::COccupancyGridMap2D::TInsertionOptions::insertionThreads), and
+optional support for inserting CObservation3DRangeScan and
+CObservationVelodyneScan observations as their equivalent 2D scans (see
+mrpt::maps::COccupancyGridMap2D::TInsertionOptions::insert3DScansAs2D).
+			- mrpt::maps::CPointsMap::determineMatching2D() and
+mrpt::maps::CPointsMap::determineMatching3D() can search for correspondences
+in parallel. See mrpt::maps::TMatchingParams::matchingThreads and the new ICP
+option mrpt::slam::CICP::TConfigParams::matchingThreads.
+			- New methods mrpt::maps::CPointsMap::getPointsNormals() and
+mrpt::maps::CPointsMap::getPointsCovariances(), cached between calls.
+			- GMRF random field maps use the new sparse Cholesky solver of
+mrpt::graphs::ScalarFactorGraph. New options `GMRF_use_cholesky` and
+`GMRF_variance_time_budget`.
+		- \ref mrpt_obs_grp
+			- New class mrpt::obs::CRawlogIndexed for fast random access to
+memory-mapped rawlog files, with lazy deserialization of objects and queries by
+time ranges.
+		- \ref mrpt_graphslam_grp
+			- New class mrpt::graphslam::CIncrementalSmoother for incremental
+(iSAM) optimization of growing graphs, used by
+mrpt::graphslam::optimizers::CLevMarqGSO if the new option
+`incremental_optimization` is set.
+			- mrpt::graphslam::optimize_graph_spa_levmarq() builds the sparse
+structure of the Hessian only once, and evaluates Jacobians and Hessian blocks
+in parallel, directly into the compressed sparse matrix. New parameter
+`num_threads`. mrpt::graphslam::computeJacobiansAndErrors() now returns the
+Jacobians in a flat vector.
 		- \ref mrpt_hwdrivers_grp
+			- mrpt::hwdrivers::CGenericSensor: observations are queued in a
+lock-free queue. Observations exceeding `max_queue_len` are still kept (as
+before) and reported as an error.
 			- COpenNI2Generic: is safer in multithreading apps.
 			- CHokuyoURG:
 				- Rewrite driver to be safer and reduce mem allocs.
@@ -96,6 +245,8 @@ rotation matrices.
 		- Fix segfault in CMetricMap::loadFromSimpleMap() if the provided
 CMetricMap has empty smart pointers.
 	- Fix crash in CGPSInterface when not setting an external mutex.
+	- Fix use of uninitialized first stage weights in the auxiliary PF with
+`pfAuxFilterStandard_FirstStageWeightsMonteCarlo=true`.
 
 <hr>
 <a name="1.5.7">
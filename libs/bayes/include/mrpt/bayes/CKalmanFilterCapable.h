@@ -17,6 +17,7 @@
 #include <mrpt/math/num_jacobian.h>
 #include <mrpt/config/CConfigFileBase.h>
 #include <mrpt/system/CTimeLogger.h>
+#include <mrpt/system/TaskScheduler.h>
 #include <mrpt/core/aligned_std_vector.h>
 #include <mrpt/config/CLoadableOptions.h>
 #include <mrpt/containers/stl_containers_utils.h>
@@ -26,6 +27,8 @@
 #include <mrpt/io/CFileOutputStream.h>
 #include <mrpt/typemeta/TEnumType.h>
 #include <mrpt/system/vector_loadsave.h>
+#include <deque>
+#include <map>
 
 namespace mrpt
 {
@@ -42,7 +45,12 @@ enum TKFMethod
 	kfEKFNaive = 0,
 	kfEKFAlaDavison,
 	kfIKFFull,
-	kfIKF
+	kfIKF,
+	/** Sparse Extended Information Filter: keeps a sparse information matrix
+	 * instead of the covariance, and only modifies it for the vehicle and a
+	 * bounded set of active landmarks in each update. See the SEIF_* fields
+	 * in TKF_options. [New in MRPT 2.0.0] */
+	kfSEIF
 };
 
 // Forward declaration:
@@ -79,6 +87,13 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 		MRPT_LOAD_CONFIG_VAR(
 			debug_verify_analytic_jacobians_threshold, double, iniFile,
 			section);
+		MRPT_LOAD_CONFIG_VAR(
+			SEIF_max_active_landmarks, uint64_t, iniFile, section);
+		MRPT_LOAD_CONFIG_VAR(
+			SEIF_relaxation_iterations, uint64_t, iniFile, section);
+		MRPT_LOAD_CONFIG_VAR(
+			SEIF_relaxation_landmarks, uint64_t, iniFile, section);
+		MRPT_LOAD_CONFIG_VAR(num_threads, uint64_t, iniFile, section);
 	}
 
 	/** This method must display clearly all the contents of the structure in
@@ -99,6 +114,17 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 		out << mrpt::format(
 			"enable_profiler                         = %c\n",
 			enable_profiler ? 'Y' : 'N');
+		out << mrpt::format(
+			"SEIF_max_active_landmarks               = %u\n",
+			SEIF_max_active_landmarks);
+		out << mrpt::format(
+			"SEIF_relaxation_iterations              = %u\n",
+			SEIF_relaxation_iterations);
+		out << mrpt::format(
+			"SEIF_relaxation_landmarks               = %u\n",
+			SEIF_relaxation_landmarks);
+		out << mrpt::format(
+			"num_threads                             = %u\n", num_threads);
 		out << mrpt::format("\n");
 	}
 
@@ -125,6 +151,31 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 	/** (default-1e-2) Sets the threshold for the difference between the
 	 * analytic and the numerical jacobians */
 	double debug_verify_analytic_jacobians_threshold{1e-2};
+	/** (default=10) Only for kfSEIF: max. number of "active" landmarks, i.e.
+	 * those linked to the vehicle in the information matrix. Older links are
+	 * removed (sparsification) to keep the cost of each update bounded. As in
+	 * the original SEIF, this approximation makes the estimated covariances
+	 * somewhat overconfident with respect to those of an EKF. */
+	unsigned int SEIF_max_active_landmarks{10};
+	/** (default=3) Only for kfSEIF: Gauss-Seidel sweeps to recover the mean
+	 * and the vehicle cross-covariances of the vehicle, the active and the
+	 * observed landmarks in each iteration. */
+	unsigned int SEIF_relaxation_iterations{3};
+	/** (default=20) Only for kfSEIF: number of additional landmarks whose mean
+	 * is refreshed in each iteration, in round-robin order, so the whole map
+	 * is recovered over time (amortized mean recovery). */
+	unsigned int SEIF_relaxation_landmarks{20};
+	/** (default=1) 1 runs the observation stage serially, one landmark at a
+	 * time. Any other value selects the batch mode: the predictions, the
+	 * Jacobians (analytic or numeric) and S are evaluated in parallel with up
+	 * to this number of threads (0: all the threads of
+	 * mrpt::system::TaskScheduler), and the update of the covariance in
+	 * kfEKFNaive and kfIKFFull exploits the sparsity of the Jacobian and is
+	 * done in cache-friendly tiles.
+	 * \note In batch mode, OnObservationModel() and OnObservationJacobians()
+	 * are called concurrently from several threads, hence they must not
+	 * modify any shared state. */
+	unsigned int num_threads{1};
 };
 
 /** Auxiliary functions, for internal usage of MRPT classes */
@@ -286,13 +337,29 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 	}
 	/** Returns the covariance of the idx'th landmark (not applicable to
 	 * non-SLAM problems).
+	 * With kfSEIF, this is an approximation: the part of the uncertainty due
+	 * to the vehicle comes from the cross-covariances recovered by
+	 * Gauss-Seidel, which are only refreshed when the landmark is relaxed
+	 * (when observed or in the round-robin recovery), and the one of the
+	 * landmark given the vehicle is conditioned on its Markov blanket, hence
+	 * it may be slightly overconfident.
 	 * \exception std::exception On idx>= getNumberOfLandmarksInTheMap()
 	 */
 	inline void getLandmarkCov(size_t idx, KFMatrix_FxF& feat_cov) const
 	{
+		if (KF_options.method == kfSEIF && !m_seif_Omega.empty())
+		{
+			SEIF_landmarkCov(idx + 1, feat_cov);
+			return;
+		}
 		m_pkk.extractMatrix(
 			VEH_SIZE + idx * FEAT_SIZE, VEH_SIZE + idx * FEAT_SIZE, feat_cov);
 	}
+	/** Returns the full covariance matrix of the state vector.
+	 * With kfSEIF, it is recovered by inverting the whole information
+	 * matrix, which is O(N^3): use it only for small maps or debugging.
+	 */
+	void getFullCovariance(KFMatrix& cov) const;
 
    protected:
 	/** @name Kalman filter state
@@ -300,7 +367,8 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 
 	/** The system state vector. */
 	KFVector m_xkk;
-	/** The system full covariance matrix. */
+	/** The system full covariance matrix. With kfSEIF, only the marginal
+	 * covariance of the vehicle (VEH_SIZE x VEH_SIZE) is kept here. */
 	KFMatrix m_pkk;
 
 	/** @} */
@@ -635,6 +703,30 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 	KFMatrix dh_dx_full_obs;
 	KFMatrix aux_K_dh_dx;
 
+	/** @name kfSEIF state. Nodes are the vehicle (0) and the landmarks (1+i)
+		@{ */
+	/** Nonzero blocks of the information matrix: m_seif_Omega[i][j] is the
+	 * block (i,j), stored for both (i,j) and (j,i) */
+	std::vector<std::map<size_t, KFMatrix>> m_seif_Omega;
+	/** The information vector */
+	KFVector m_seif_xi;
+	/** Active landmarks (nodes linked to the vehicle), least recently
+	 * observed first */
+	std::deque<size_t> m_seif_active;
+	/** An estimate of the columns of the covariance for the vehicle, i.e.
+	 * the rows of Omega^-1 * [I 0 ... 0]^t: the marginal covariance of the
+	 * vehicle and its cross-covariances with each landmark. They are
+	 * recovered along with the mean, by Gauss-Seidel iterations, so the rows
+	 * of landmarks not relaxed recently (see SEIF_relaxation_landmarks) lag
+	 * behind. Motion updates only propagate the rows of the vehicle and the
+	 * active landmarks. */
+	KFMatrix m_seif_Pcol;
+	/** Vehicle covariance last exported to m_pkk, to detect resets */
+	KFMatrix m_seif_last_pxx;
+	/** Next landmark for the amortized mean recovery */
+	size_t m_seif_next_relax{0};
+	/** @} */
+
    protected:
 	/** The main entry point, executes one complete step: prediction + update.
 	 *  It is protected since derived classes must provide a problem-specific
@@ -657,6 +749,87 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 	static void KF_aux_estimate_obs_Hy_jacobian(
 		const KFArray_FEAT& x, const std::pair<KFCLASS*, size_t>& dat,
 		KFArray_OBS& out_x);
+	/** Throws if the analytic observation Jacobians of a landmark differ from
+	 * the given (numeric) ones */
+	void KF_verifyObservationJacobians(
+		const size_t lm_idx, const KFMatrix_OxV& Hx,
+		const KFMatrix_OxF& Hy) const;
+	/** Computes the block (i,j) of S=H*P*H^t for the predictions i and j,
+	 * and copies it transposed into the block (j,i) */
+	void KF_buildSblock(const size_t i, const size_t j);
+
+	/** @name Batch mode auxiliary methods (KF_options.num_threads != 1)
+		@{ */
+	/** Like OnObservationModel(), split into chunks of landmarks which are
+	 * predicted in parallel */
+	void KF_batchObservationModel(
+		const std::vector<size_t>& idx_landmarks,
+		vector_KFArray_OBS& out_predictions) const;
+	/** Fills Hxs[i] and Hys[i] for the predictions i in [first,N_pred) */
+	void KF_batchObservationJacobians(size_t first, size_t N_pred);
+	/** Numeric Jacobians of the predictions i in [first,N_pred): each state
+	 * component is perturbed once for all the landmarks at the same time */
+	void KF_batchNumericObservationJacobians(size_t first, size_t N_pred);
+	/** Builds the upper triangle of S (without R) in parallel tiles */
+	void KF_batchBuildS(size_t N_pred);
+	/** PHt = m_pkk * H^t, from the nonzero blocks of H: for each row of H,
+	 * the prediction index in Hxs & Hys, and the landmark index in the map */
+	void KF_batchBuildPHt(
+		const std::vector<std::pair<size_t, size_t>>& H_rows,
+		KFMatrix& PHt) const;
+	/** m_pkk -= K * PHt^t, in tiles of its upper triangle */
+	void KF_batchUpdateCovariance(const KFMatrix& PHt);
+	/** @} */
+
+	/** @name kfSEIF auxiliary methods
+		@{ */
+	static size_t SEIF_nodeDim(size_t n) { return n ? FEAT_SIZE : VEH_SIZE; }
+	static size_t SEIF_nodeOff(size_t n)
+	{
+		return n ? VEH_SIZE + (n - 1) * FEAT_SIZE : 0;
+	}
+	/** Block (i,j) of the information matrix, created as zeros if needed.
+	 * Only use it to modify blocks in pairs (i,j) and (j,i). */
+	KFMatrix& SEIF_block(size_t i, size_t j);
+	/** Adds M to the block (i,j), and M^t to (j,i) */
+	template <class MAT>
+	void SEIF_addBlock(size_t i, size_t j, const MAT& M);
+	/** Builds the information form from m_xkk and m_pkk */
+	void SEIF_initFromCovariance();
+	/** Marks the landmark node as the most recently observed active one */
+	void SEIF_touchActive(size_t node);
+	/** Replaces the vehicle node by its prediction xv_new */
+	void SEIF_motionUpdate(
+		const KFMatrix_VxV& dfv_dxv, const KFMatrix_VxV& Q,
+		const KFArray_VEH& xv_new);
+	void SEIF_observationUpdate(
+		size_t lm_idx, const KFMatrix_OxV& Hx, const KFMatrix_OxF& Hy,
+		const KFMatrix_OxO& R, const KFArray_OBS& ytilde);
+	void SEIF_addLandmark(
+		const KFArray_FEAT& yn, const KFMatrix_FxV& dyn_dxv,
+		const KFMatrix_FxF& yn_cov);
+	/** Removes the vehicle links of the oldest active landmarks beyond
+	 * SEIF_max_active_landmarks, except those in "keep". */
+	void SEIF_sparsify(const std::vector<size_t>& keep);
+	/** One Gauss-Seidel step for the mean and the vehicle cross-covariance
+	 * of a node */
+	void SEIF_relaxNode(size_t n);
+	void SEIF_recoverMeans(const std::vector<size_t>& observed);
+	/** Calls OnNormalizeStateVector() keeping m_seif_xi consistent with any
+	 * change in the mean (e.g. wrapped angles) */
+	void SEIF_normalizeStateVector();
+	/** Covariance of the given nodes, conditioned on the rest of the map
+	 * beyond their Markov blanket (SEIF approximation) */
+	void SEIF_conditionalCov(
+		const std::vector<size_t>& nodes, KFMatrix& cov) const;
+	/** Covariance of a landmark node, as Cov(y|x) + Pyx Pxx^-1 Pxy, with
+	 * Cov(y|x) from SEIF_conditionalCov() */
+	void SEIF_landmarkCov(size_t node, KFMatrix_FxF& cov) const;
+	/** Updates m_pkk with the vehicle marginal covariance */
+	void SEIF_exportVehicleCov();
+	/** Builds the innovation matrix S for the predicted landmarks */
+	void SEIF_buildS(const KFMatrix_OxO& R);
+	/** @} */
 
 	template <
 		size_t VEH_SIZEb, size_t OBS_SIZEb, size_t FEAT_SIZEb, size_t ACT_SIZEb,
@@ -682,6 +855,7 @@ MRPT_FILL_ENUM(kfEKFNaive);
 MRPT_FILL_ENUM(kfEKFAlaDavison);
 MRPT_FILL_ENUM(kfIKFFull);
 MRPT_FILL_ENUM(kfIKF);
+MRPT_FILL_ENUM(kfSEIF);
 MRPT_ENUM_TYPE_END()
 
 // Template implementation:
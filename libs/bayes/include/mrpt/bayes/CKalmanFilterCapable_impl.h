@@ -32,8 +32,19 @@ void CKalmanFilterCapable<
 	m_timLogger.enable(KF_options.enable_profiler);
 	m_timLogger.enter("KF:complete_step");
 
-	ASSERT_(int(m_xkk.size()) == m_pkk.cols());
+	const bool is_seif = (KF_options.method == kfSEIF);
+	if (!is_seif) ASSERT_(int(m_xkk.size()) == m_pkk.cols());
 	ASSERT_(size_t(m_xkk.size()) >= VEH_SIZE);
+
+	// kfSEIF: (re)build the information form on the first iteration, or if
+	// the user has reset the filter state:
+	if (is_seif &&
+		(m_seif_Omega.size() != 1 + getNumberOfLandmarksInTheMap() ||
+		 m_seif_xi.size() != m_xkk.size() ||
+		 m_pkk.rows() != m_seif_last_pxx.rows() ||
+		 m_pkk.cols() != m_seif_last_pxx.cols() ||
+		 (m_pkk.array() != m_seif_last_pxx.array()).any()))
+		SEIF_initFromCovariance();
 	// =============================================================
 	//  1. CREATE ACTION MATRIX u FROM ODOMETRY
 	// =============================================================
@@ -129,12 +140,18 @@ void CKalmanFilterCapable<
 		KFMatrix_VxV Q;
 		OnTransitionNoise(Q);
 
+		// kfSEIF: the information form is updated instead of 3.1 & 3.2
+		if (is_seif) SEIF_motionUpdate(dfv_dxv, Q, xv);
+
 		// ====================================
 		//  3.1:  Pxx submatrix
 		// ====================================
 		// Replace old covariance:
-		Eigen::Block<typename KFMatrix::Base, VEH_SIZE, VEH_SIZE>(m_pkk, 0, 0) =
-			Q + dfv_dxv *
+		if (!is_seif)
+			Eigen::Block<typename KFMatrix::Base, VEH_SIZE, VEH_SIZE>(
+				m_pkk, 0, 0) =
+				Q +
+				dfv_dxv *
 					Eigen::Block<typename KFMatrix::Base, VEH_SIZE, VEH_SIZE>(
 						m_pkk, 0, 0) *
 					dfv_dxv.transpose();
@@ -144,7 +161,7 @@ void CKalmanFilterCapable<
 		// ====================================
 		// Now, update the cov. of landmarks, if any:
 		KFMatrix_VxF aux;
-		for (size_t i = 0; i < N_map; i++)
+		for (size_t i = 0; i < N_map && !is_seif; i++)
 		{
 			aux = dfv_dxv *
 				  Eigen::Block<typename KFMatrix::Base, VEH_SIZE, FEAT_SIZE>(
@@ -162,7 +179,13 @@ void CKalmanFilterCapable<
 		for (size_t i = 0; i < VEH_SIZE; i++) m_xkk[i] = xv[i];
 
 		// Normalize, if neccesary.
-		OnNormalizeStateVector();
+		if (is_seif)
+		{
+			SEIF_normalizeStateVector();
+			SEIF_exportVehicleCov();
+		}
+		else
+			OnNormalizeStateVector();
 
 	}  // end if (!skipPrediction)
 
@@ -179,8 +202,12 @@ void CKalmanFilterCapable<
 	// Predict the observations for all the map LMs, so the user
 	//  can decide if their covariances (more costly) must be computed as well:
 	all_predictions.resize(N_map);
-	OnObservationModel(
-		mrpt::math::sequenceStdVec<size_t, 1>(0, N_map), all_predictions);
+	if (KF_options.num_threads != 1 && FEAT_SIZE != 0)
+		KF_batchObservationModel(
+			mrpt::math::sequenceStdVec<size_t, 1>(0, N_map), all_predictions);
+	else
+		OnObservationModel(
+			mrpt::math::sequenceStdVec<size_t, 1>(0, N_map), all_predictions);
 
 	const double tim_pred_obs = m_timLogger.leave("KF:3.predict all obs");
 
@@ -265,7 +292,11 @@ void CKalmanFilterCapable<
 		Hxs.resize(N_pred);  // Append new entries, if needed.
 		Hys.resize(N_pred);
 
-		for (size_t i = first_new_pred; i < N_pred; ++i)
+		if (KF_options.num_threads != 1)
+			KF_batchObservationJacobians(first_new_pred, N_pred);
+
+		for (size_t i = first_new_pred;
+			 i < N_pred && KF_options.num_threads == 1; ++i)
 		{
 			const size_t lm_idx = FEAT_SIZE == 0 ? 0 : predictLMidxs[i];
 			KFMatrix_OxV& Hx = Hxs[i];
@@ -320,37 +351,7 @@ void CKalmanFilterCapable<
 					sizeof(m_xkk[0]) * FEAT_SIZE);
 
 				if (KF_options.debug_verify_analytic_jacobians)
-				{
-					KFMatrix_OxV Hx_gt(mrpt::math::UNINITIALIZED_MATRIX);
-					KFMatrix_OxF Hy_gt(mrpt::math::UNINITIALIZED_MATRIX);
-					OnObservationJacobians(lm_idx, Hx_gt, Hy_gt);
-					if ((Hx - Hx_gt).array().abs().sum() >
-						KF_options.debug_verify_analytic_jacobians_threshold)
-					{
-						std::cerr << "[KalmanFilter] ERROR: User analytical "
-									 "observation Hx Jacobians are wrong: \n"
-								  << " Real Hx: \n"
-								  << Hx << "\n Analytical Hx:\n"
-								  << Hx_gt << "Diff:\n"
-								  << Hx - Hx_gt << "\n";
-						THROW_EXCEPTION(
-							"ERROR: User analytical observation Hx Jacobians "
-							"are wrong (More details dumped to cerr)")
-					}
-					if ((Hy - Hy_gt).array().abs().sum() >
-						KF_options.debug_verify_analytic_jacobians_threshold)
-					{
-						std::cerr << "[KalmanFilter] ERROR: User analytical "
-									 "observation Hy Jacobians are wrong: \n"
-								  << " Real Hy: \n"
-								  << Hy << "\n Analytical Hx:\n"
-								  << Hy_gt << "Diff:\n"
-								  << Hy - Hy_gt << "\n";
-						THROW_EXCEPTION(
-							"ERROR: User analytical observation Hy Jacobians "
-							"are wrong (More details dumped to cerr)")
-					}
-				}
+					KF_verifyObservationJacobians(lm_idx, Hx, Hy);
 			}
 		}
 		m_timLogger.leave("KF:5.build Jacobians");
@@ -364,50 +365,22 @@ void CKalmanFilterCapable<
 		// ------------------------------------------
 		S.setSize(N_pred * OBS_SIZE, N_pred * OBS_SIZE);
 
-		if (FEAT_SIZE > 0)
+		if (FEAT_SIZE > 0 && is_seif)
+		{  // SLAM-like problem, from the information form:
+			SEIF_buildS(R);
+		}
+		else if (FEAT_SIZE > 0)
 		{  // SLAM-like problem:
-			const Eigen::Block<
-				const typename KFMatrix::Base, VEH_SIZE, VEH_SIZE>
-				Px(m_pkk, 0, 0);  // Covariance of the vehicle pose
+			if (KF_options.num_threads != 1)
+				KF_batchBuildS(N_pred);
+			else
+				for (size_t i = 0; i < N_pred; ++i)
+					// Only do j>=i (upper triangle), since S is symmetric:
+					for (size_t j = i; j < N_pred; ++j) KF_buildSblock(i, j);
 
+			// Sum the "R" term to the diagonal blocks:
 			for (size_t i = 0; i < N_pred; ++i)
 			{
-				const size_t lm_idx_i = predictLMidxs[i];
-				const Eigen::Block<
-					const typename KFMatrix::Base, FEAT_SIZE, VEH_SIZE>
-					Pxyi_t(
-						m_pkk, VEH_SIZE + lm_idx_i * FEAT_SIZE, 0);  // Pxyi^t
-
-				// Only do j>=i (upper triangle), since S is symmetric:
-				for (size_t j = i; j < N_pred; ++j)
-				{
-					const size_t lm_idx_j = predictLMidxs[j];
-					// Sij block:
-					Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE>
-						Sij(S, OBS_SIZE * i, OBS_SIZE * j);
-
-					const Eigen::Block<
-						const typename KFMatrix::Base, VEH_SIZE, FEAT_SIZE>
-						Pxyj(m_pkk, 0, VEH_SIZE + lm_idx_j * FEAT_SIZE);
-					const Eigen::Block<
-						const typename KFMatrix::Base, FEAT_SIZE, FEAT_SIZE>
-						Pyiyj(
-							m_pkk, VEH_SIZE + lm_idx_i * FEAT_SIZE,
-							VEH_SIZE + lm_idx_j * FEAT_SIZE);
-
-					Sij = Hxs[i] * Px * Hxs[j].transpose() +
-						  Hys[i] * Pxyi_t * Hxs[j].transpose() +
-						  Hxs[i] * Pxyj * Hys[j].transpose() +
-						  Hys[i] * Pyiyj * Hys[j].transpose();
-
-					// Copy transposed to the symmetric lower-triangular part:
-					if (i != j)
-						Eigen::Block<
-							typename KFMatrix::Base, OBS_SIZE, OBS_SIZE>(
-							S, OBS_SIZE * j, OBS_SIZE * i) = Sij.transpose();
-				}
-
-				// Sum the "R" term to the diagonal blocks:
 				const size_t obs_idx_off = i * OBS_SIZE;
 				Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE>(
 					S, obs_idx_off, obs_idx_off) += R;
@@ -468,6 +441,7 @@ void CKalmanFilterCapable<
 	//  7. UPDATE USING THE KALMAN GAIN
 	// =============================================================
 	// Update, only if there are observations!
+	std::vector<size_t> seif_observed;  // Updated landmark nodes (kfSEIF)
 	if (!Z.empty())
 	{
 		m_timLogger.enter("KF:8.update stage");
@@ -505,6 +479,11 @@ void CKalmanFilterCapable<
 
 				const KFVector xkk_0 = m_xkk;
 
+				// Batch mode: the full dh_dx is only required by the IKF
+				// (K and Pkk are computed from its nonzero blocks):
+				const bool batch = KF_options.num_threads != 1;
+				const bool need_dh_dx = !batch || nKF_iterations > 1;
+
 				// For each IKF iteration (or 1 for EKF)
 				if (N_upd > 0)  // Do not update if we have no observations!
 				{
@@ -517,9 +496,13 @@ void CKalmanFilterCapable<
 
 						// TODO: Use a Matrix view of "dh_dx_full" instead of
 						// creating a copy into "dh_dx_full_obs"
-						dh_dx_full_obs.zeros(
-							N_upd * OBS_SIZE,
-							VEH_SIZE + FEAT_SIZE * N_map);  // Init to zeros.
+						if (need_dh_dx)
+							dh_dx_full_obs.zeros(
+								N_upd * OBS_SIZE,
+								VEH_SIZE + FEAT_SIZE * N_map);  // Init to zeros.
+						// For each block row of dh_dx: prediction & map index
+						std::vector<std::pair<size_t, size_t>> H_rows;
+						H_rows.reserve(N_upd);
 						KFMatrix S_observed;  // The KF "S" matrix: A
 						// re-ordered, subset, version of
 						// the prediction S:
@@ -558,17 +541,23 @@ void CKalmanFilterCapable<
 								//(assoc_idx_in_pred*OBS_SIZE,0, OBS_SIZE,
 								// row_len);
 
-								Eigen::Block<
-									typename KFMatrix::Base, OBS_SIZE,
-									VEH_SIZE>(
-									dh_dx_full_obs, S_idxs.size(), 0) =
-									Hxs[assoc_idx_in_pred];
-								Eigen::Block<
-									typename KFMatrix::Base, OBS_SIZE,
-									FEAT_SIZE>(
-									dh_dx_full_obs, S_idxs.size(),
-									VEH_SIZE + assoc_idx_in_map * FEAT_SIZE) =
-									Hys[assoc_idx_in_pred];
+								H_rows.emplace_back(
+									assoc_idx_in_pred, assoc_idx_in_map);
+								if (need_dh_dx)
+								{
+									Eigen::Block<
+										typename KFMatrix::Base, OBS_SIZE,
+										VEH_SIZE>(
+										dh_dx_full_obs, S_idxs.size(), 0) =
+										Hxs[assoc_idx_in_pred];
+									Eigen::Block<
+										typename KFMatrix::Base, OBS_SIZE,
+										FEAT_SIZE>(
+										dh_dx_full_obs, S_idxs.size(),
+										VEH_SIZE +
+											assoc_idx_in_map * FEAT_SIZE) =
+										Hys[assoc_idx_in_pred];
+								}
 
 								// S_idxs.size() is used as counter for
 								// "dh_dx_full_obs".
@@ -593,11 +582,15 @@ void CKalmanFilterCapable<
 						{  // Non-SLAM problems:
 							ASSERT_(
 								Z.size() == 1 && all_predictions.size() == 1);
-							ASSERT_(
-								dh_dx_full_obs.rows() == OBS_SIZE &&
-								dh_dx_full_obs.cols() == VEH_SIZE);
 							ASSERT_(Hxs.size() == 1);
-							dh_dx_full_obs = Hxs[0];  // Was: dh_dx_full
+							H_rows.emplace_back(0, 0);
+							if (need_dh_dx)
+							{
+								ASSERT_(
+									dh_dx_full_obs.rows() == OBS_SIZE &&
+									dh_dx_full_obs.cols() == VEH_SIZE);
+								dh_dx_full_obs = Hxs[0];  // Was: dh_dx_full
+							}
 							KFArray_OBS ytilde_i = Z[0];
 							OnSubstractObservationVectors(
 								ytilde_i, all_predictions[0]);
@@ -615,11 +608,18 @@ void CKalmanFilterCapable<
 						K.setSize(m_pkk.rows(), S_observed.cols());
 
 						// K = m_pkk * (~dh_dx) * S.inv() );
-						K.multiply_ABt(m_pkk, dh_dx_full_obs);
+						KFMatrix PHt;
+						if (batch)
+							KF_batchBuildPHt(H_rows, PHt);
+						else
+							K.multiply_ABt(m_pkk, dh_dx_full_obs);
 
 						// Inverse of S_observed -> S_1
 						S_observed.inv(S_1);
-						K *= S_1;
+						if (batch)
+							K.noalias() = PHt * S_1;
+						else
+							K *= S_1;
 
 						m_timLogger.leave("KF:8.update stage:1.FULLKF:build K");
 
@@ -661,29 +661,36 @@ void CKalmanFilterCapable<
 
 							// Use the full K matrix to update the covariance:
 							// m_pkk = (I - K*dh_dx ) * m_pkk;
-							// TODO: "Optimize this: sparsity!"
-
-							// K * dh_dx_full_obs
-							aux_K_dh_dx.multiply(K, dh_dx_full_obs);
-
-							// aux_K_dh_dx  <-- I-aux_K_dh_dx
-							const size_t stat_len = aux_K_dh_dx.cols();
-							for (size_t r = 0; r < stat_len; r++)
+							if (batch)
 							{
-								for (size_t c = 0; c < stat_len; c++)
+								// m_pkk -= K * (dh_dx * m_pkk), with
+								// dh_dx * m_pkk = PHt^t:
+								KF_batchUpdateCovariance(PHt);
+							}
+							else
+							{
+								// K * dh_dx_full_obs
+								aux_K_dh_dx.multiply(K, dh_dx_full_obs);
+
+								// aux_K_dh_dx  <-- I-aux_K_dh_dx
+								const size_t stat_len = aux_K_dh_dx.cols();
+								for (size_t r = 0; r < stat_len; r++)
 								{
-									if (r == c)
-										aux_K_dh_dx.get_unsafe(r, c) =
-											-aux_K_dh_dx.get_unsafe(r, c) +
-											kftype(1);
-									else
-										aux_K_dh_dx.get_unsafe(r, c) =
-											-aux_K_dh_dx.get_unsafe(r, c);
+									for (size_t c = 0; c < stat_len; c++)
+									{
+										if (r == c)
+											aux_K_dh_dx.get_unsafe(r, c) =
+												-aux_K_dh_dx.get_unsafe(r, c) +
+												kftype(1);
+										else
+											aux_K_dh_dx.get_unsafe(r, c) =
+												-aux_K_dh_dx.get_unsafe(r, c);
+									}
 								}
-							}
 
-							m_pkk.multiply_result_is_symmetric(
-								aux_K_dh_dx, m_pkk);
+								m_pkk.multiply_result_is_symmetric(
+									aux_K_dh_dx, m_pkk);
+							}
 
 							m_timLogger.leave(
 								"KF:8.update stage:3.FULLKF:update Pkk");
@@ -1160,6 +1167,46 @@ void CKalmanFilterCapable<
 			}
 			break;
 
+			// --------------------------------------------------------------------
+			// SPARSE EXTENDED INFORMATION FILTER:
+			//  Each observation only modifies the blocks of the vehicle and
+			//  its landmark in the information matrix, so the cost does not
+			//  depend on the map size. All observations are linearized at
+			//  the predicted state, where all_predictions were evaluated.
+			// --------------------------------------------------------------------
+			case kfSEIF:
+			{
+				for (size_t obsIdx = 0; obsIdx < Z.size(); obsIdx++)
+				{
+					size_t idxInTheFilter = 0;
+					if (!data_association.empty())
+					{
+						if (data_association[obsIdx] < 0) continue;
+						idxInTheFilter = data_association[obsIdx];
+					}
+
+					const size_t i_idx_in_preds =
+						mrpt::containers::find_in_vector(
+							idxInTheFilter, predictLMidxs);
+					ASSERTMSG_(
+						i_idx_in_preds != string::npos,
+						"OnPreComputingPredictions() didn't recommend the "
+						"prediction of a landmark which has been actually "
+						"observed!");
+
+					// ytilde = observation - prediction
+					KFArray_OBS ytilde = Z[obsIdx];
+					OnSubstractObservationVectors(
+						ytilde, all_predictions[idxInTheFilter]);
+
+					SEIF_observationUpdate(
+						idxInTheFilter, Hxs[i_idx_in_preds],
+						Hys[i_idx_in_preds], R, ytilde);
+					if (FEAT_SIZE) seif_observed.push_back(1 + idxInTheFilter);
+				}
+			}
+			break;
+
 			default:
 				THROW_EXCEPTION("Invalid value of options.KF_method");
 		}  // end switch method
@@ -1168,7 +1215,10 @@ void CKalmanFilterCapable<
 	const double tim_update = m_timLogger.leave("KF:8.update stage");
 
 	m_timLogger.enter("KF:9.OnNormalizeStateVector");
-	OnNormalizeStateVector();
+	if (is_seif)
+		SEIF_normalizeStateVector();
+	else
+		OnNormalizeStateVector();
 	m_timLogger.leave("KF:9.OnNormalizeStateVector");
 
 	// =============================================================
@@ -1181,6 +1231,19 @@ void CKalmanFilterCapable<
 		m_timLogger.leave("KF:A.add new landmarks");
 	}  // end if data_association!=empty
 
+	// kfSEIF: bound the number of active landmarks and recover the mean
+	if (is_seif)
+	{
+		m_timLogger.enter("KF:A2.SEIF sparsify & recover mean");
+		for (size_t n = 1 + N_map; n < m_seif_Omega.size(); n++)
+			seif_observed.push_back(n);  // New landmarks
+		SEIF_sparsify(seif_observed);
+		SEIF_recoverMeans(seif_observed);
+		SEIF_normalizeStateVector();
+		SEIF_exportVehicleCov();
+		m_timLogger.leave("KF:A2.SEIF sparsify & recover mean");
+	}
+
 	// Post iteration user code:
 	m_timLogger.enter("KF:B.OnPostIteration");
 	OnPostIteration();
@@ -1247,6 +1310,831 @@ void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
 	out_x = prediction[0];
 }
 
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_verifyObservationJacobians(
+		const size_t lm_idx, const KFMatrix_OxV& Hx,
+		const KFMatrix_OxF& Hy) const
+{
+	KFMatrix_OxV Hx_gt(mrpt::math::UNINITIALIZED_MATRIX);
+	KFMatrix_OxF Hy_gt(mrpt::math::UNINITIALIZED_MATRIX);
+	OnObservationJacobians(lm_idx, Hx_gt, Hy_gt);
+	if ((Hx - Hx_gt).array().abs().sum() >
+		KF_options.debug_verify_analytic_jacobians_threshold)
+	{
+		std::cerr << "[KalmanFilter] ERROR: User analytical "
+					 "observation Hx Jacobians are wrong: \n"
+				  << " Real Hx: \n"
+				  << Hx << "\n Analytical Hx:\n"
+				  << Hx_gt << "Diff:\n"
+				  << Hx - Hx_gt << "\n";
+		THROW_EXCEPTION(
+			"ERROR: User analytical observation Hx Jacobians "
+			"are wrong (More details dumped to cerr)")
+	}
+	if ((Hy - Hy_gt).array().abs().sum() >
+		KF_options.debug_verify_analytic_jacobians_threshold)
+	{
+		std::cerr << "[KalmanFilter] ERROR: User analytical "
+					 "observation Hy Jacobians are wrong: \n"
+				  << " Real Hy: \n"
+				  << Hy << "\n Analytical Hx:\n"
+				  << Hy_gt << "Diff:\n"
+				  << Hy - Hy_gt << "\n";
+		THROW_EXCEPTION(
+			"ERROR: User analytical observation Hy Jacobians "
+			"are wrong (More details dumped to cerr)")
+	}
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_buildSblock(const size_t i, const size_t j)
+{
+	const size_t lm_idx_i = predictLMidxs[i], lm_idx_j = predictLMidxs[j];
+	const Eigen::Block<const typename KFMatrix::Base, VEH_SIZE, VEH_SIZE> Px(
+		m_pkk, 0, 0);  // Covariance of the vehicle pose
+	const Eigen::Block<const typename KFMatrix::Base, FEAT_SIZE, VEH_SIZE>
+		Pxyi_t(m_pkk, VEH_SIZE + lm_idx_i * FEAT_SIZE, 0);  // Pxyi^t
+	const Eigen::Block<const typename KFMatrix::Base, VEH_SIZE, FEAT_SIZE>
+		Pxyj(m_pkk, 0, VEH_SIZE + lm_idx_j * FEAT_SIZE);
+	const Eigen::Block<const typename KFMatrix::Base, FEAT_SIZE, FEAT_SIZE>
+		Pyiyj(
+			m_pkk, VEH_SIZE + lm_idx_i * FEAT_SIZE,
+			VEH_SIZE + lm_idx_j * FEAT_SIZE);
+
+	// Sij block:
+	Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE> Sij(
+		S, OBS_SIZE * i, OBS_SIZE * j);
+	Sij = Hxs[i] * Px * Hxs[j].transpose() +
+		  Hys[i] * Pxyi_t * Hxs[j].transpose() +
+		  Hxs[i] * Pxyj * Hys[j].transpose() +
+		  Hys[i] * Pyiyj * Hys[j].transpose();
+
+	// Copy transposed to the symmetric lower-triangular part:
+	if (i != j)
+		Eigen::Block<typename KFMatrix::Base, OBS_SIZE, OBS_SIZE>(
+			S, OBS_SIZE * j, OBS_SIZE * i) = Sij.transpose();
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_batchObservationModel(
+		const std::vector<size_t>& idx_landmarks,
+		vector_KFArray_OBS& out_predictions) const
+{
+	const size_t N = idx_landmarks.size();
+	out_predictions.resize(N);
+	// At least a few dozens of landmarks per call, so the overhead of each
+	// task and call is negligible:
+	size_t nChunks = std::max<size_t>(1, N / 32);
+	if (KF_options.num_threads)
+		nChunks = std::min<size_t>(nChunks, KF_options.num_threads);
+
+	mrpt::system::parallel_for_chunks(
+		N,
+		[&](const size_t first, const size_t last) {
+			if (first == 0 && last == N)
+			{
+				OnObservationModel(idx_landmarks, out_predictions);
+				return;
+			}
+			const std::vector<size_t> idxs(
+				idx_landmarks.begin() + first, idx_landmarks.begin() + last);
+			vector_KFArray_OBS preds;
+			OnObservationModel(idxs, preds);
+			ASSERT_(preds.size() == idxs.size());
+			std::copy(
+				preds.begin(), preds.end(), out_predictions.begin() + first);
+		},
+		nChunks);
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_batchObservationJacobians(size_t first, size_t N_pred)
+{
+	if (first >= N_pred) return;
+	const bool numeric = !KF_options.use_analytic_observation_jacobian ||
+						 KF_options.debug_verify_analytic_jacobians;
+	const auto lmIdx = [this](size_t i) {
+		return FEAT_SIZE == 0 ? size_t(0) : predictLMidxs[i];
+	};
+
+	if (!numeric)
+	{
+		// The first one in this thread, to find out whether the user
+		// implemented the analytic Jacobians:
+		m_user_didnt_implement_jacobian = false;
+		OnObservationJacobians(lmIdx(first), Hxs[first], Hys[first]);
+		if (!m_user_didnt_implement_jacobian)
+		{
+			mrpt::system::parallel_for_chunks(
+				N_pred - first - 1,
+				[&](const size_t i0, const size_t i1) {
+					for (size_t i = first + 1 + i0; i < first + 1 + i1; i++)
+						OnObservationJacobians(lmIdx(i), Hxs[i], Hys[i]);
+				},
+				KF_options.num_threads);
+			return;
+		}
+	}
+
+	// Numeric approximation:
+	KF_batchNumericObservationJacobians(first, N_pred);
+
+	if (KF_options.debug_verify_analytic_jacobians)
+		for (size_t i = first; i < N_pred; i++)
+			KF_verifyObservationJacobians(lmIdx(i), Hxs[i], Hys[i]);
+}
+
+// Same central differences than estimateJacobian() with
+// KF_aux_estimate_obs_Hx_jacobian() and KF_aux_estimate_obs_Hy_jacobian(),
+// but each component of the vehicle is perturbed once for all the landmarks,
+// as well as each component of all the landmarks at once, since each
+// prediction only depends on the vehicle and its own landmark.
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_batchNumericObservationJacobians(size_t first, size_t N_pred)
+{
+	const size_t N = N_pred - first;
+	std::vector<size_t> lms(N, 0);
+	if (FEAT_SIZE != 0)
+		std::copy(
+			predictLMidxs.begin() + first, predictLMidxs.begin() + N_pred,
+			lms.begin());
+	// Each landmark must be perturbed only once:
+	std::vector<size_t> lms_unique = lms;
+	std::sort(lms_unique.begin(), lms_unique.end());
+	lms_unique.erase(
+		std::unique(lms_unique.begin(), lms_unique.end()), lms_unique.end());
+
+	KFArray_VEH veh_increments;
+	KFArray_FEAT feat_increments;
+	OnObservationJacobiansNumericGetIncrements(veh_increments, feat_increments);
+
+	vector_KFArray_OBS f_plus, f_minus;
+	for (size_t j = 0; j < VEH_SIZE; j++)
+	{
+		ASSERT_(veh_increments[j] > 0);
+		const kftype x = m_xkk[j];
+		m_xkk[j] = x + veh_increments[j];
+		KF_batchObservationModel(lms, f_plus);
+		m_xkk[j] = x - veh_increments[j];
+		KF_batchObservationModel(lms, f_minus);
+		m_xkk[j] = x;  // Leave as original
+
+		const double Ax_2_inv = 0.5 / veh_increments[j];
+		for (size_t i = 0; i < N; i++)
+			for (size_t k = 0; k < OBS_SIZE; k++)
+				Hxs[first + i].get_unsafe(k, j) =
+					Ax_2_inv * (f_plus[i][k] - f_minus[i][k]);
+	}
+
+	KFVector y(lms_unique.size());
+	for (size_t j = 0; j < FEAT_SIZE; j++)
+	{
+		ASSERT_(feat_increments[j] > 0);
+		for (size_t l = 0; l < lms_unique.size(); l++)
+		{
+			const size_t idx = VEH_SIZE + lms_unique[l] * FEAT_SIZE + j;
+			y[l] = m_xkk[idx];
+			m_xkk[idx] = y[l] + feat_increments[j];
+		}
+		KF_batchObservationModel(lms, f_plus);
+		for (size_t l = 0; l < lms_unique.size(); l++)
+			m_xkk[VEH_SIZE + lms_unique[l] * FEAT_SIZE + j] =
+				y[l] - feat_increments[j];
+		KF_batchObservationModel(lms, f_minus);
+		for (size_t l = 0; l < lms_unique.size(); l++)
+			m_xkk[VEH_SIZE + lms_unique[l] * FEAT_SIZE + j] = y[l];
+
+		const double Ax_2_inv = 0.5 / feat_increments[j];
+		for (size_t i = 0; i < N; i++)
+			for (size_t k = 0; k < OBS_SIZE; k++)
+				Hys[first + i].get_unsafe(k, j) =
+					Ax_2_inv * (f_plus[i][k] - f_minus[i][k]);
+	}
+}
+
+// Square tiles of landmarks in the upper triangle of S, so all tasks have
+// similar costs. Each block is computed as in the serial loop.
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_batchBuildS(size_t N_pred)
+{
+	const size_t T = 16, nT = (N_pred + T - 1) / T;
+	std::vector<std::pair<size_t, size_t>> tiles;
+	tiles.reserve(nT * (nT + 1) / 2);
+	for (size_t ti = 0; ti < nT; ti++)
+		for (size_t tj = ti; tj < nT; tj++) tiles.emplace_back(ti, tj);
+
+	mrpt::system::parallel_for_chunks(
+		tiles.size(),
+		[&](const size_t first, const size_t last) {
+			for (size_t t = first; t < last; t++)
+			{
+				const size_t i1 = std::min(N_pred, (tiles[t].first + 1) * T),
+							 j1 = std::min(N_pred, (tiles[t].second + 1) * T);
+				for (size_t i = tiles[t].first * T; i < i1; i++)
+					for (size_t j = std::max(i, tiles[t].second * T); j < j1;
+						 j++)
+						KF_buildSblock(i, j);
+			}
+		},
+		KF_options.num_threads);
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_batchBuildPHt(
+		const std::vector<std::pair<size_t, size_t>>& H_rows,
+		KFMatrix& PHt) const
+{
+	const size_t n = m_pkk.rows(), T = 64, nT = (n + T - 1) / T;
+	PHt.resize(n, OBS_SIZE * H_rows.size());
+	// Split in blocks of rows, so each task reads a contiguous range of P.
+	// Their size does not depend on the number of threads, nor the result:
+	mrpt::system::parallel_for_chunks(
+		nT,
+		[&](const size_t first, const size_t last) {
+			for (size_t t = first; t < last; t++)
+			{
+				const size_t r0 = t * T, nr = std::min(T, n - r0);
+				for (size_t k = 0; k < H_rows.size(); k++)
+				{
+					auto PHt_k = PHt.block(r0, OBS_SIZE * k, nr, OBS_SIZE);
+					PHt_k.noalias() = m_pkk.block(r0, 0, nr, VEH_SIZE) *
+									  Hxs[H_rows[k].first].transpose();
+					if (FEAT_SIZE != 0)
+						PHt_k.noalias() +=
+							m_pkk.block(
+								r0, VEH_SIZE + H_rows[k].second * FEAT_SIZE,
+								nr, FEAT_SIZE) *
+							Hys[H_rows[k].first].transpose();
+				}
+			}
+		},
+		KF_options.num_threads);
+}
+
+// P = P - K*H*P, with H*P = PHt^t since P is symmetric. Only the tiles in
+// the upper triangle are computed, and copied transposed into the lower one,
+// so the result is exactly symmetric.
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	KF_batchUpdateCovariance(const KFMatrix& PHt)
+{
+	const size_t n = m_pkk.rows(), T = 64, nT = (n + T - 1) / T;
+	std::vector<std::pair<size_t, size_t>> tiles;
+	tiles.reserve(nT * (nT + 1) / 2);
+	for (size_t ti = 0; ti < nT; ti++)
+		for (size_t tj = ti; tj < nT; tj++) tiles.emplace_back(ti, tj);
+
+	mrpt::system::parallel_for_chunks(
+		tiles.size(),
+		[&](const size_t first, const size_t last) {
+			KFMatrix blk;
+			for (size_t t = first; t < last; t++)
+			{
+				const size_t r0 = tiles[t].first * T, c0 = tiles[t].second * T;
+				const size_t nr = std::min(T, n - r0), nc = std::min(T, n - c0);
+				blk = m_pkk.block(r0, c0, nr, nc);
+				blk.noalias() -=
+					K.middleRows(r0, nr) * PHt.middleRows(c0, nc).transpose();
+				if (r0 == c0)
+					m_pkk.block(r0, c0, nr, nc) =
+						kftype(0.5) * (blk + blk.transpose());
+				else
+				{
+					m_pkk.block(r0, c0, nr, nc) = blk;
+					m_pkk.block(c0, r0, nc, nr) = blk.transpose();
+				}
+			}
+		},
+		KF_options.num_threads);
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	getFullCovariance(KFMatrix& cov) const
+{
+	if (KF_options.method != kfSEIF || m_seif_Omega.empty())
+	{
+		cov = m_pkk;
+		return;
+	}
+	const size_t n = m_xkk.size();
+	KFMatrix Om, I;
+	Om.setZero(n, n);
+	I.setIdentity(n, n);
+	for (size_t i = 0; i < m_seif_Omega.size(); i++)
+		for (const auto& blk : m_seif_Omega[i])
+			Om.block(
+				SEIF_nodeOff(i), SEIF_nodeOff(blk.first), SEIF_nodeDim(i),
+				SEIF_nodeDim(blk.first)) = blk.second;
+	cov = Om.llt().solve(I);
+}
+
+// ---------------------------------------------------------------------------
+//  kfSEIF: Sparse Extended Information Filter. See: S. Thrun et al.,
+//  "Simultaneous localization and mapping with sparse extended information
+//  filters", IJRR 2004; and "Probabilistic Robotics", chapter 12.
+// ---------------------------------------------------------------------------
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+typename CKalmanFilterCapable<
+	VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::KFMatrix&
+	CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+		SEIF_block(size_t i, size_t j)
+{
+	auto& row = m_seif_Omega[i];
+	auto it = row.find(j);
+	if (it == row.end())
+	{
+		KFMatrix zeros;
+		zeros.setZero(SEIF_nodeDim(i), SEIF_nodeDim(j));
+		it = row.emplace(j, zeros).first;
+	}
+	return it->second;
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+template <class MAT>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_addBlock(size_t i, size_t j, const MAT& M)
+{
+	SEIF_block(i, j) += M;
+	if (i != j) SEIF_block(j, i) += M.transpose();
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_initFromCovariance()
+{
+	const size_t n = m_xkk.size();
+	ASSERTMSG_(
+		size_t(m_pkk.rows()) == n && size_t(m_pkk.cols()) == n,
+		"kfSEIF: m_pkk must hold the full covariance upon initialization");
+
+	// A null vehicle covariance (e.g. right after reset()) would mean
+	// infinite information:
+	KFMatrix P = m_pkk, I;
+	for (size_t i = 0; i < VEH_SIZE; i++)
+		P(i, i) = std::max(P(i, i), KFTYPE(1e-6));
+	I.setIdentity(n, n);
+	const KFMatrix Om = P.llt().solve(I);
+	m_seif_xi = Om * m_xkk;
+	m_seif_Pcol = P.leftCols(VEH_SIZE);
+
+	const size_t nNodes = 1 + getNumberOfLandmarksInTheMap();
+	m_seif_Omega.assign(nNodes, std::map<size_t, KFMatrix>());
+	m_seif_active.clear();
+	for (size_t a = 0; a < nNodes; a++)
+		for (size_t b = 0; b < nNodes; b++)
+		{
+			const KFMatrix blk = Om.block(
+				SEIF_nodeOff(a), SEIF_nodeOff(b), SEIF_nodeDim(a),
+				SEIF_nodeDim(b));
+			if (a != b && blk.isZero(0)) continue;
+			m_seif_Omega[a][b] = blk;
+			if (a == 0 && b != 0) m_seif_active.push_back(b);
+		}
+	m_seif_next_relax = 0;
+	SEIF_exportVehicleCov();
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_touchActive(size_t node)
+{
+	const auto it =
+		std::find(m_seif_active.begin(), m_seif_active.end(), node);
+	if (it != m_seif_active.end()) m_seif_active.erase(it);
+	m_seif_active.push_back(node);
+}
+
+// Motion update: only the vehicle and the active landmarks are involved,
+// so its cost does not depend on the map size.
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_motionUpdate(
+		const KFMatrix_VxV& dfv_dxv, const KFMatrix_VxV& Q,
+		const KFArray_VEH& xv_new)
+{
+	const std::vector<size_t> M(m_seif_active.begin(), m_seif_active.end());
+	const size_t nM = M.size();
+
+	const KFMatrix_VxV A = m_seif_Omega[0].at(0);
+	const KFMatrix_VxV Ainv = A.inverse();
+	KFMatrix B(VEH_SIZE, FEAT_SIZE * nM);  // Omega_{x,M}
+	for (size_t k = 0; k < nM; k++)
+		B.block(0, k * FEAT_SIZE, VEH_SIZE, FEAT_SIZE) =
+			m_seif_Omega[0].at(M[k]);
+
+	// Marginalize the old pose out of the joint (old pose, new pose, map):
+	const KFArray_VEH xv_old(&m_xkk[0]);
+	const KFArray_VEH xi_x(&m_seif_xi[0]);
+	const KFMatrix_VxV Sxx = dfv_dxv * Ainv * dfv_dxv.transpose() + Q;
+	const KFMatrix_VxV Sinv = Sxx.inverse();
+	const KFMatrix Kx = dfv_dxv * Ainv * B;
+	const KFArray_VEH d(dfv_dxv * (Ainv * xi_x) + xv_new - dfv_dxv * xv_old);
+
+	const KFMatrix dOmega_MM =
+		Kx.transpose() * Sinv * Kx - B.transpose() * Ainv * B;
+	const KFVector dxi_M =
+		Kx.transpose() * (Sinv * d) - B.transpose() * (Ainv * xi_x);
+	const KFMatrix SK = Sinv * Kx;
+
+	for (size_t a = 0; a < nM; a++)
+	{
+		m_seif_xi.segment(SEIF_nodeOff(M[a]), FEAT_SIZE) +=
+			dxi_M.segment(a * FEAT_SIZE, FEAT_SIZE);
+		for (size_t b = 0; b < nM; b++)
+			SEIF_block(M[a], M[b]) += dOmega_MM.block(
+				a * FEAT_SIZE, b * FEAT_SIZE, FEAT_SIZE, FEAT_SIZE);
+		SEIF_block(0, M[a]) = SK.block(0, a * FEAT_SIZE, VEH_SIZE, FEAT_SIZE);
+		SEIF_block(M[a], 0) = SEIF_block(0, M[a]).transpose();
+	}
+	m_seif_Omega[0][0] = Sinv;
+	m_seif_xi.template head<VEH_SIZE>() = Sinv * d;
+
+	// Propagate the vehicle columns of the covariance as in the EKF,
+	// Pxx' = F Pxx F^t + Q, Pyx' = Pyx F^t, but only for the active
+	// landmarks: doing it for the whole map would be O(N). The rows of the
+	// other landmarks are left stale until Gauss-Seidel relaxes them.
+	const KFMatrix_VxV Pxx = m_seif_Pcol.topRows(VEH_SIZE);
+	for (const size_t m : M)
+		m_seif_Pcol.middleRows(SEIF_nodeOff(m), FEAT_SIZE) *=
+			dfv_dxv.transpose();
+	m_seif_Pcol.topRows(VEH_SIZE) = dfv_dxv * Pxx * dfv_dxv.transpose() + Q;
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_observationUpdate(
+		size_t lm_idx, const KFMatrix_OxV& Hx, const KFMatrix_OxF& Hy,
+		const KFMatrix_OxO& R, const KFArray_OBS& ytilde)
+{
+	const KFMatrix_OxO Rinv = R.inverse();
+	const size_t l = 1 + lm_idx;
+
+	// Linearized observation: z - h(mu) + H*mu = H*x
+	KFArray_OBS z_lin(ytilde + Hx * KFArray_VEH(&m_xkk[0]));
+	if (FEAT_SIZE)
+		z_lin += Hy * KFArray_FEAT(&m_xkk[SEIF_nodeOff(l)]);
+
+	SEIF_addBlock(0, 0, Hx.transpose() * Rinv * Hx);
+	m_seif_xi.template head<VEH_SIZE>() += Hx.transpose() * (Rinv * z_lin);
+	if (FEAT_SIZE)
+	{
+		SEIF_addBlock(0, l, Hx.transpose() * Rinv * Hy);
+		SEIF_addBlock(l, l, Hy.transpose() * Rinv * Hy);
+		m_seif_xi.segment(SEIF_nodeOff(l), FEAT_SIZE) +=
+			Hy.transpose() * (Rinv * z_lin);
+		SEIF_touchActive(l);
+	}
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_addLandmark(
+		const KFArray_FEAT& yn, const KFMatrix_FxV& dyn_dxv,
+		const KFMatrix_FxF& yn_cov)
+{
+	// yn = dyn_dxv * x + c + noise(yn_cov)
+	const KFMatrix_FxF Lambda = yn_cov.inverse();
+	const KFArray_FEAT c(yn - dyn_dxv * KFArray_VEH(&m_xkk[0]));
+
+	const size_t l = m_seif_Omega.size();
+	const size_t off = m_seif_xi.size();
+	ASSERT_(off == SEIF_nodeOff(l));
+	m_seif_Omega.resize(l + 1);
+	m_seif_xi.conservativeResize(off + FEAT_SIZE);
+	m_seif_Pcol.conservativeResize(off + FEAT_SIZE, VEH_SIZE);
+	m_seif_Pcol.block(off, 0, FEAT_SIZE, VEH_SIZE) =
+		dyn_dxv * m_seif_Pcol.topRows(VEH_SIZE);
+
+	m_seif_xi.segment(off, FEAT_SIZE) = Lambda * c;
+	m_seif_xi.template head<VEH_SIZE>() -= dyn_dxv.transpose() * (Lambda * c);
+	SEIF_addBlock(0, 0, dyn_dxv.transpose() * Lambda * dyn_dxv);
+	SEIF_addBlock(0, l, -dyn_dxv.transpose() * Lambda);
+	SEIF_addBlock(l, l, Lambda);
+	SEIF_touchActive(l);
+}
+
+// Sparsification (Thrun et al., Probabilistic Robotics, table 12.5): the
+// links between the vehicle and the landmarks m0 are removed by
+// approximating p(x, m+, m0) ~= p(x | m+, m0=mu) p(m+, m0), so that the
+// landmarks m0 become conditionally independent of the vehicle.
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_sparsify(const std::vector<size_t>& keep)
+{
+	const size_t maxActive = KF_options.SEIF_max_active_landmarks;
+	if (m_seif_active.size() <= maxActive) return;
+
+	// Deactivate the least recently observed ones:
+	size_t nRemove = m_seif_active.size() - maxActive;
+	std::vector<size_t> m0, mp;
+	for (const size_t n : m_seif_active)
+	{
+		if (nRemove && std::find(keep.begin(), keep.end(), n) == keep.end())
+		{
+			m0.push_back(n);
+			nRemove--;
+		}
+		else
+			mp.push_back(n);
+	}
+	if (m0.empty()) return;
+
+	// Dense information matrix of the nodes = [x, m+, m0]:
+	std::vector<size_t> nodes(1, 0);
+	nodes.insert(nodes.end(), mp.begin(), mp.end());
+	nodes.insert(nodes.end(), m0.begin(), m0.end());
+	std::vector<size_t> off(nodes.size() + 1, 0);
+	for (size_t k = 0; k < nodes.size(); k++)
+		off[k + 1] = off[k] + SEIF_nodeDim(nodes[k]);
+	const size_t N = off.back(), n0 = FEAT_SIZE * m0.size(), i0 = N - n0;
+
+	KFMatrix A;
+	A.setZero(N, N);
+	KFVector mu(N);
+	for (size_t a = 0; a < nodes.size(); a++)
+	{
+		mu.segment(off[a], SEIF_nodeDim(nodes[a])) =
+			m_xkk.segment(SEIF_nodeOff(nodes[a]), SEIF_nodeDim(nodes[a]));
+		for (size_t b = 0; b < nodes.size(); b++)
+		{
+			const auto it = m_seif_Omega[nodes[a]].find(nodes[b]);
+			if (it != m_seif_Omega[nodes[a]].end())
+				A.block(off[a], off[b], it->second.rows(), it->second.cols()) =
+					it->second;
+		}
+	}
+
+	// Omega' = A - T1 + T2 - T3, with each T the information of the
+	// marginal over the nodes not in {m0}, {x,m0} and {x}, respectively:
+	KFMatrix A_x0(N, VEH_SIZE + n0);
+	A_x0 << A.leftCols(VEH_SIZE), A.rightCols(n0);
+	KFMatrix A_x0x0(VEH_SIZE + n0, VEH_SIZE + n0);
+	A_x0x0 << A.topLeftCorner(VEH_SIZE, VEH_SIZE),
+		A.topRightCorner(VEH_SIZE, n0), A.bottomLeftCorner(n0, VEH_SIZE),
+		A.bottomRightCorner(n0, n0);
+
+	const KFMatrix T1 = A.rightCols(n0) *
+		A.bottomRightCorner(n0, n0).llt().solve(A.bottomRows(n0));
+	const KFMatrix T2 = A_x0 * A_x0x0.llt().solve(A_x0.transpose());
+	const KFMatrix T3 = A.leftCols(VEH_SIZE) *
+		A.topLeftCorner(VEH_SIZE, VEH_SIZE).llt().solve(A.topRows(VEH_SIZE));
+	KFMatrix dA = T2 - T1 - T3;
+	// These are exactly zero in theory:
+	dA.block(0, i0, VEH_SIZE, n0) = -A.block(0, i0, VEH_SIZE, n0);
+	dA.block(i0, 0, n0, VEH_SIZE) = -A.block(i0, 0, n0, VEH_SIZE);
+
+	// Keep the mean: xi' = Omega' mu
+	const KFVector dxi = dA * mu;
+	for (size_t a = 0; a < nodes.size(); a++)
+	{
+		const size_t da = SEIF_nodeDim(nodes[a]);
+		m_seif_xi.segment(SEIF_nodeOff(nodes[a]), da) +=
+			dxi.segment(off[a], da);
+		for (size_t b = 0; b < nodes.size(); b++)
+		{
+			const size_t db = SEIF_nodeDim(nodes[b]);
+			if (a == 0 && off[b] >= i0)
+			{
+				m_seif_Omega[0].erase(nodes[b]);
+				m_seif_Omega[nodes[b]].erase(0);
+				continue;
+			}
+			if (b == 0 && off[a] >= i0) continue;
+			const auto dblk = dA.block(off[a], off[b], da, db);
+			if (!dblk.isZero(0)) SEIF_block(nodes[a], nodes[b]) += dblk;
+		}
+	}
+	m_seif_active.assign(mp.begin(), mp.end());
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_relaxNode(size_t n)
+{
+	const size_t d = SEIF_nodeDim(n), o = SEIF_nodeOff(n);
+	// Solve Omega * [mu, Pcol] = [xi, (I 0 ... 0)^t] for this node:
+	KFMatrix rhs(d, 1 + VEH_SIZE);
+	rhs.col(0) = m_seif_xi.segment(o, d);
+	if (n == 0)
+		rhs.rightCols(VEH_SIZE).setIdentity();
+	else
+		rhs.rightCols(VEH_SIZE).setZero();
+	for (const auto& blk : m_seif_Omega[n])
+	{
+		if (blk.first == n) continue;
+		const size_t ob = SEIF_nodeOff(blk.first),
+					 db = SEIF_nodeDim(blk.first);
+		rhs.col(0) -= blk.second * m_xkk.segment(ob, db);
+		rhs.rightCols(VEH_SIZE) -= blk.second * m_seif_Pcol.middleRows(ob, db);
+	}
+	const KFMatrix sol = m_seif_Omega[n].at(n).ldlt().solve(rhs);
+	m_xkk.segment(o, d) = sol.col(0);
+	m_seif_Pcol.middleRows(o, d) = sol.rightCols(VEH_SIZE);
+}
+
+// Amortized mean (and vehicle covariance) recovery: a few Gauss-Seidel sweeps
+// over the nodes involved in this step, plus a bounded number of other
+// landmarks in a round-robin fashion, so all of them converge over time.
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_recoverMeans(const std::vector<size_t>& observed)
+{
+	std::vector<size_t> local(1, 0);
+	local.insert(local.end(), m_seif_active.begin(), m_seif_active.end());
+	for (const size_t n : observed)
+		if (std::find(local.begin(), local.end(), n) == local.end())
+			local.push_back(n);
+
+	for (unsigned int it = 0; it < KF_options.SEIF_relaxation_iterations; it++)
+		for (const size_t n : local) SEIF_relaxNode(n);
+
+	const size_t nLMs = m_seif_Omega.size() - 1;
+	const size_t nExtra =
+		std::min<size_t>(KF_options.SEIF_relaxation_landmarks, nLMs);
+	for (size_t k = 0; k < nExtra; k++)
+	{
+		m_seif_next_relax %= nLMs;
+		SEIF_relaxNode(1 + m_seif_next_relax++);
+	}
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_normalizeStateVector()
+{
+	const KFVector old_xkk = m_xkk;
+	OnNormalizeStateVector();
+	ASSERT_(m_xkk.size() == old_xkk.size());
+	if (m_xkk == old_xkk) return;
+
+	// Shifting the mean by "delta" means: xi' = xi + Omega * delta
+	for (size_t n = 0; n < m_seif_Omega.size(); n++)
+	{
+		const size_t d = SEIF_nodeDim(n), o = SEIF_nodeOff(n);
+		const KFVector delta = m_xkk.segment(o, d) - old_xkk.segment(o, d);
+		if (delta.isZero(0)) continue;
+		for (const auto& blk : m_seif_Omega[n])
+			m_seif_xi.segment(
+				SEIF_nodeOff(blk.first), SEIF_nodeDim(blk.first)) +=
+				blk.second.transpose() * delta;
+	}
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_conditionalCov(const std::vector<size_t>& nodes, KFMatrix& cov) const
+{
+	// The nodes plus their Markov blanket:
+	std::vector<size_t> B = nodes;
+	for (const size_t n : nodes)
+		for (const auto& blk : m_seif_Omega[n])
+			if (std::find(B.begin(), B.end(), blk.first) == B.end())
+				B.push_back(blk.first);
+
+	std::vector<size_t> off(B.size() + 1, 0);
+	for (size_t k = 0; k < B.size(); k++)
+		off[k + 1] = off[k] + SEIF_nodeDim(B[k]);
+
+	KFMatrix Om, I;
+	Om.setZero(off.back(), off.back());
+	I.setIdentity(off.back(), off.back());
+	for (size_t a = 0; a < B.size(); a++)
+		for (size_t b = 0; b < B.size(); b++)
+		{
+			const auto it = m_seif_Omega[B[a]].find(B[b]);
+			if (it != m_seif_Omega[B[a]].end())
+				Om.block(off[a], off[b], it->second.rows(), it->second.cols()) =
+					it->second;
+		}
+	const size_t n = off[nodes.size()];
+	cov = KFMatrix(Om.ldlt().solve(I)).topLeftCorner(n, n);
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_exportVehicleCov()
+{
+	const KFMatrix_VxV Pxx = m_seif_Pcol.topRows(VEH_SIZE);
+	m_pkk = KFMatrix_VxV(0.5 * (Pxx + Pxx.transpose()));
+	m_seif_last_pxx = m_pkk;
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_landmarkCov(size_t node, KFMatrix_FxF& cov) const
+{
+	KFMatrix C;
+	SEIF_conditionalCov(std::vector<size_t>(1, node), C);
+	const KFMatrix_VxV Pxx = m_seif_Pcol.topRows(VEH_SIZE);
+	const KFMatrix_FxV Pyx =
+		m_seif_Pcol.block(SEIF_nodeOff(node), 0, FEAT_SIZE, VEH_SIZE);
+	// Cov(y) = E[Cov(y|x)] + Cov(E[y|x]); the second term comes from the
+	// recovered cross-covariance Pyx, and the first one is conditioned on the
+	// Markov blanket of y:
+	cov = KFMatrix_FxF(C) + Pyx * Pxx.inverse() * Pyx.transpose();
+}
+
+// S for data association, from the recovered vehicle marginal covariance and
+// cross-covariances Pxy. The landmark covariances are those of
+// SEIF_landmarkCov(), and the landmark-landmark cross terms, required only by
+// joint DA, are approximated through the vehicle: Pyiyj ~ Pyix Pxx^-1 Pxyj.
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_buildS(const KFMatrix_OxO& R)
+{
+	const size_t N_pred = predictLMidxs.size();
+	S.setSize(N_pred * OBS_SIZE, N_pred * OBS_SIZE);
+
+	const KFMatrix_VxV Pxx = m_pkk;
+	const KFMatrix_VxV Pxx_inv = Pxx.inverse();
+	mrpt::aligned_std_vector<KFMatrix_VxF> Pxy(N_pred);
+	for (size_t i = 0; i < N_pred; i++)
+		Pxy[i] = m_seif_Pcol
+					 .block(
+						 SEIF_nodeOff(1 + predictLMidxs[i]), 0, FEAT_SIZE,
+						 VEH_SIZE)
+					 .transpose();
+
+	KFMatrix_FxF Pyy;
+	for (size_t i = 0; i < N_pred; i++)
+	{
+		SEIF_landmarkCov(1 + predictLMidxs[i], Pyy);
+		for (size_t j = i; j < N_pred; j++)
+		{
+			const KFMatrix_FxF Pyiyj =
+				i == j ? Pyy
+					   : KFMatrix_FxF(Pxy[i].transpose() * Pxx_inv * Pxy[j]);
+			const KFMatrix_OxO Sij = Hxs[i] * Pxx * Hxs[j].transpose() +
+									 Hys[i] * Pxy[i].transpose() *
+										 Hxs[j].transpose() +
+									 Hxs[i] * Pxy[j] * Hys[j].transpose() +
+									 Hys[i] * Pyiyj * Hys[j].transpose();
+			S.block(i * OBS_SIZE, j * OBS_SIZE, OBS_SIZE, OBS_SIZE) = Sij;
+			if (i != j)
+				S.block(j * OBS_SIZE, i * OBS_SIZE, OBS_SIZE, OBS_SIZE) =
+					Sij.transpose();
+		}
+		S.block(i * OBS_SIZE, i * OBS_SIZE, OBS_SIZE, OBS_SIZE) += R;
+	}
+}
+
 namespace detail
 {
 // generic version for SLAM. There is a speciation below for NON-SLAM problems.
@@ -1308,6 +2196,20 @@ void addNewLandmarks(
 			for (q = 0; q < FEAT_SIZE; q++)
 				obj.internal_getXkk()[idx + q] = yn[q];
 
+			// kfSEIF: add it to the information form instead of Pkk
+			if (obj.KF_options.method == kfSEIF)
+			{
+				typename KF::KFMatrix_FxF yn_cov;
+				if (use_dyn_dhn_jacobian)
+					dyn_dhn.multiply_HCHt(R, yn_cov);
+				else
+					yn_cov = dyn_dhn_R_dyn_dhnT;
+				obj.SEIF_addLandmark(yn, dyn_dxv, yn_cov);
+
+				obj.getProfiler().leave("KF:9.create new LMs");
+				continue;
+			}
+
 			// --------------------
 			// Append to Pkk:
 			// --------------------
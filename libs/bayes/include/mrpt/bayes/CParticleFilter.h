@@ -163,6 +163,22 @@ class CParticleFilter : public mrpt::system::COutputLogger
 		 * perform rejection sampling, but just the most-likely (ML) particle
 		 * found in the preliminary weight-determination stage. */
 		bool pfAuxFilterOptimal_MLE{false};
+
+		/** Maximum number of threads used to evaluate the observation
+		 * likelihood of the particles in the PF implementations of mrpt::slam
+		 * (MCL 2D/3D and RBPF SLAM), in the process-wide
+		 * mrpt::system::TaskScheduler. 1 (default) means serial evaluation in
+		 * the calling thread, 0 means "as many as the scheduler threads".
+		 * The output of the filter is identical for any number of threads,
+		 * but all the metric maps involved must allow concurrent calls to
+		 * computeObservationLikelihood(), which is the case for all MRPT
+		 * maps except COccupancyGridMap2D with its lmConsensusOWA method.
+		 * Data built on demand by the maps (kd-trees, the likelihood cache
+		 * of COccupancyGridMap2D, ...) is created while evaluating the first
+		 * particle, which is always done alone; afterwards, the grid
+		 * likelihood caches are filled concurrently with atomic accesses.
+		 */
+		unsigned int parallelLikelihoodThreads{1};
 	};
 
 	/** Statistics for being returned from the "execute" method. */
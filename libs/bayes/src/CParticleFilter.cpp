@@ -133,6 +133,10 @@ void CParticleFilter::TParticleFilterOptions::saveToConfigFile(
 		pfAuxFilterStandard_FirstStageWeightsMonteCarlo,
 		"Only for PF_algorithm==pfAuxiliaryPFStandard");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(pfAuxFilterOptimal_MLE, "See doxygen docs.");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		parallelLikelihoodThreads,
+		"Number of threads to evaluate particle likelihoods (1=serial, "
+		"0=all cores)");
 }
 
 /*---------------------------------------------------------------
@@ -175,6 +179,8 @@ void CParticleFilter::TParticleFilterOptions::loadFromConfigFile(
 		section.c_str());
 	MRPT_LOAD_CONFIG_VAR(
 		pfAuxFilterOptimal_MLE, bool, iniFile, section.c_str());
+	MRPT_LOAD_CONFIG_VAR(
+		parallelLikelihoodThreads, uint64_t, iniFile, section.c_str());
 
 	MRPT_END
 }
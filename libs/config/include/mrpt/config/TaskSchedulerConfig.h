@@ -0,0 +1,36 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <string>
+
+namespace mrpt::config
+{
+// Frwd. decls:
+class CConfigFileBase;
+
+/** Sets the number of threads of the process-wide
+ * mrpt::system::TaskScheduler from the key `num_threads` in the given
+ * section of a config file, if it exists:
+ *  \code
+ *  [TaskScheduler]
+ *  num_threads = 4   // 0: as many as hardware threads; 1: no parallelism
+ *  \endcode
+ *
+ * Must be called before starting any parallel algorithm, typically right
+ * after loading the config file of an application.
+ * \return true if the key was found.
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_config_grp
+ */
+bool loadTaskSchedulerConfig(
+	const CConfigFileBase& source,
+	const std::string& section = std::string("TaskScheduler"));
+
+}  // namespace mrpt::config
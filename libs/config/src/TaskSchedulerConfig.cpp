@@ -0,0 +1,26 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "config-precomp.h"  // Precompiled headers
+
+#include <mrpt/config/TaskSchedulerConfig.h>
+#include <mrpt/config/CConfigFileBase.h>
+#include <mrpt/system/TaskScheduler.h>
+
+bool mrpt::config::loadTaskSchedulerConfig(
+	const CConfigFileBase& source, const std::string& section)
+{
+	MRPT_START
+	const int n = source.read_int(section, "num_threads", -1);
+	if (n < 0) return false;
+	mrpt::system::TaskScheduler::Instance().setNumThreads(
+		static_cast<std::size_t>(n));
+	return true;
+	MRPT_END
+}
@@ -0,0 +1,325 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace mrpt::containers
+{
+/** What bounded_queue::push() does if the queue is full.
+ * \ingroup mrpt_containers_grp */
+enum class queue_full_policy : uint8_t
+{
+	/** push() returns false and the new element is not inserted. */
+	reject = 0,
+	/** The oldest element in the queue is discarded to make room for the new
+	 * one. Useful for sensor data, where newer data is more valuable. */
+	drop_oldest
+};
+
+/** A bounded, lock-free FIFO queue, for passing objects by value between
+ * threads (typically smart pointers, e.g. `CObservation::Ptr`).
+ *
+ * Use the aliases spsc_queue (single producer, single consumer) and
+ * mpmc_queue (multiple producers and consumers). The storage is a ring
+ * buffer allocated once at construction, so push() and try_pop() never
+ * allocate memory nor take any lock: each slot has a sequence number telling
+ * whether it is ready to be written or read (D. Vyukov's algorithm). With a
+ * single producer, push() does not need any atomic read-modify-write
+ * operation.
+ *
+ * Consumers may also wait for new elements with pop(), optionally with a
+ * timeout, and producers may wait for room with push(v, timeout): only then a
+ * mutex is used, and the other side only touches it if some thread is
+ * actually waiting.
+ *
+ * \code
+ * mrpt::containers::spsc_queue<CObservation::Ptr> q(
+ *     256, mrpt::containers::queue_full_policy::drop_oldest);
+ * // Producer thread:
+ * q.push(obs);
+ * // Consumer thread:
+ * CObservation::Ptr o;
+ * if (q.pop(o, std::chrono::milliseconds(100))) process(o);
+ * \endcode
+ *
+ * A lock-free alternative to CThreadSafeQueue, which passes raw pointers
+ * through a mutex-protected, unbounded std::queue.
+ *
+ * \tparam T Must be default-constructible and move-assignable.
+ * \tparam SINGLE_PRODUCER Only one thread will ever call push().
+ * \sa spsc_queue, mpmc_queue
+ * \note Defined in #include <mrpt/containers/bounded_queue.h>
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_containers_grp
+ */
+template <class T, bool SINGLE_PRODUCER>
+class bounded_queue
+{
+   public:
+	/** Creates the queue, able to hold at least `capacity` elements (it is
+	 * rounded up to a power of two). */
+	explicit bounded_queue(
+		std::size_t capacity,
+		queue_full_policy policy = queue_full_policy::reject)
+		: m_policy(policy)
+	{
+		reset(capacity);
+	}
+
+	bounded_queue(const bounded_queue&) = delete;
+	bounded_queue& operator=(const bounded_queue&) = delete;
+
+	/** Empties the queue and changes its capacity. This is the only method
+	 * which is not thread-safe: it must not be called while any other thread
+	 * is using the queue. */
+	void reset(std::size_t capacity)
+	{
+		std::size_t n = 2;
+		while (n < capacity) n <<= 1;
+		m_cells.reset(new Cell[n]);
+		m_mask = n - 1;
+		for (std::size_t i = 0; i < n; i++)
+			m_cells[i].seq.store(i, std::memory_order_relaxed);
+		m_enqueue_pos.store(0, std::memory_order_relaxed);
+		m_dequeue_pos.store(0, std::memory_order_relaxed);
+		m_dropped.store(0, std::memory_order_relaxed);
+	}
+
+	/** Maximum number of elements in the queue. */
+	std::size_t capacity() const { return m_mask + 1; }
+	queue_full_policy policy() const { return m_policy; }
+
+	/** Inserts an element at the end of the queue.
+	 * \return false if the queue was full and the policy is
+	 * queue_full_policy::reject. */
+	bool push(T v)
+	{
+		if (!push_nonotify(v, m_policy == queue_full_policy::drop_oldest))
+			return false;
+		notify_consumers();
+		return true;
+	}
+
+	/** Inserts an element at the end of the queue, waiting for up to
+	 * `timeout` for a consumer to make room if the queue is full and the
+	 * policy is queue_full_policy::reject (with drop_oldest it never waits).
+	 * \return false on timeout, and then `v` is not inserted. */
+	template <class Rep, class Period>
+	bool push(T v, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		if (m_policy == queue_full_policy::drop_oldest) return push(std::move(v));
+		if (push_nonotify(v, false))
+		{
+			notify_consumers();
+			return true;
+		}
+		const auto deadline = std::chrono::steady_clock::now() + timeout;
+		bool ok;
+		{
+			std::unique_lock<std::mutex> lock(m_space_mtx);
+			m_waiting_producers.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			ok = m_space_cv.wait_until(
+				lock, deadline, [&]() { return push_nonotify(v, false); });
+			m_waiting_producers.fetch_sub(1, std::memory_order_relaxed);
+		}
+		if (ok) notify_consumers();
+		return ok;
+	}
+
+	/** Retrieves the oldest element, if any, without blocking.
+	 * \return false if the queue was empty. */
+	bool try_pop(T& out)
+	{
+		if (!pop_nonotify(out)) return false;
+		notify_producers();
+		return true;
+	}
+
+	/** Retrieves the oldest element, waiting for up to `timeout` for one to
+	 * arrive if the queue is empty.
+	 * \return false on timeout. */
+	template <class Rep, class Period>
+	bool pop(T& out, const std::chrono::duration<Rep, Period>& timeout)
+	{
+		if (try_pop(out)) return true;
+		const auto deadline = std::chrono::steady_clock::now() + timeout;
+		bool ok;
+		{
+			std::unique_lock<std::mutex> lock(m_wait_mtx);
+			m_waiting.fetch_add(1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			ok = m_wait_cv.wait_until(
+				lock, deadline, [&]() { return pop_nonotify(out); });
+			m_waiting.fetch_sub(1, std::memory_order_relaxed);
+		}
+		if (ok) notify_producers();
+		return ok;
+	}
+
+	/** Retrieves the oldest element, waiting as long as needed for one to
+	 * arrive if the queue is empty. */
+	void pop(T& out)
+	{
+		while (!pop(out, std::chrono::seconds(1)))
+		{
+		}
+	}
+
+	/** Approximate number of elements in the queue (exact if no other thread
+	 * is using it). */
+	std::size_t size() const
+	{
+		const std::size_t tail = m_enqueue_pos.load(std::memory_order_acquire);
+		const std::size_t head = m_dequeue_pos.load(std::memory_order_acquire);
+		return tail > head ? tail - head : 0;
+	}
+	bool empty() const { return size() == 0; }
+
+	/** Number of elements discarded so far due to
+	 * queue_full_policy::drop_oldest. */
+	std::size_t dropped() const
+	{
+		return m_dropped.load(std::memory_order_relaxed);
+	}
+
+   private:
+	struct Cell
+	{
+		std::atomic<std::size_t> seq;
+		T data;
+	};
+
+	/** push() without waking up consumers. When full, discards the oldest
+	 * element if `drop_if_full`, otherwise returns false. `v` is only moved
+	 * from on success. */
+	bool push_nonotify(T& v, bool drop_if_full)
+	{
+		Cell* cell;
+		std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &m_cells[pos & m_mask];
+			const std::size_t seq = cell->seq.load(std::memory_order_acquire);
+			const auto diff =
+				static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+			if (diff == 0)
+			{
+				// The slot is free: claim it.
+				if (SINGLE_PRODUCER)
+				{
+					m_enqueue_pos.store(pos + 1, std::memory_order_relaxed);
+					break;
+				}
+				if (m_enqueue_pos.compare_exchange_weak(
+						pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+			{
+				// Full:
+				if (!drop_if_full) return false;
+				T discarded;
+				if (pop_nonotify(discarded))
+					m_dropped.fetch_add(1, std::memory_order_relaxed);
+				else
+					std::this_thread::yield();  // A consumer is reading it
+				pos = m_enqueue_pos.load(std::memory_order_relaxed);
+			}
+			else
+				pos = m_enqueue_pos.load(std::memory_order_relaxed);
+		}
+		cell->data = std::move(v);
+		cell->seq.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** try_pop() without waking up producers. */
+	bool pop_nonotify(T& out)
+	{
+		Cell* cell;
+		std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &m_cells[pos & m_mask];
+			const std::size_t seq = cell->seq.load(std::memory_order_acquire);
+			const auto diff = static_cast<std::intptr_t>(seq) -
+							  static_cast<std::intptr_t>(pos + 1);
+			if (diff == 0)
+			{
+				if (m_dequeue_pos.compare_exchange_weak(
+						pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (diff < 0)
+				return false;  // Empty
+			else
+				pos = m_dequeue_pos.load(std::memory_order_relaxed);
+		}
+		out = std::move(cell->data);
+		// Do not keep alive the moved-from object (e.g. for smart pointers):
+		cell->data = T();
+		cell->seq.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Wake up any thread blocked in pop() or push() with a timeout. Never
+	// called while holding the other mutex, so both can not deadlock.
+	void notify_consumers()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_waiting.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<std::mutex> lock(m_wait_mtx);
+			m_wait_cv.notify_one();
+		}
+	}
+	void notify_producers()
+	{
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (m_waiting_producers.load(std::memory_order_relaxed))
+		{
+			std::lock_guard<std::mutex> lock(m_space_mtx);
+			m_space_cv.notify_one();
+		}
+	}
+
+	std::unique_ptr<Cell[]> m_cells;
+	std::size_t m_mask{0};
+	const queue_full_policy m_policy;
+	// Producer and consumer positions, in different cache lines:
+	alignas(64) std::atomic<std::size_t> m_enqueue_pos{0};
+	alignas(64) std::atomic<std::size_t> m_dequeue_pos{0};
+	alignas(64) std::atomic<std::size_t> m_dropped{0};
+	std::atomic<unsigned int> m_waiting{0}, m_waiting_producers{0};
+	std::mutex m_wait_mtx, m_space_mtx;
+	std::condition_variable m_wait_cv, m_space_cv;
+};
+
+/** A bounded_queue for one producer thread and one consumer thread.
+ * \note With queue_full_policy::drop_oldest, the producer also pops elements,
+ * which is also safe.
+ * \ingroup mrpt_containers_grp */
+template <class T>
+using spsc_queue = bounded_queue<T, true>;
+
+/** A bounded_queue for any number of producer and consumer threads.
+ * \ingroup mrpt_containers_grp */
+template <class T>
+using mpmc_queue = bounded_queue<T, false>;
+
+}  // namespace mrpt::containers
@@ -0,0 +1,359 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/aligned_std_vector.h>
+#include <mrpt/core/exceptions.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace mrpt::containers
+{
+/** A std::map<> (or std::multimap<>, if MULTI=true) look-alike which keeps
+ * all its elements in one contiguous array, sorted by key. Use the aliases
+ * flat_map and flat_multimap.
+ *
+ * Lookups are binary searches over the array, and iterating over the
+ * elements is as fast as iterating a std::vector<>. Besides, for flat_map
+ * with integer keys, looking up a key `k` stored at position `k` (as it
+ * happens when keys are dense, i.e. 0,1,...,N-1) takes constant time.
+ *
+ * Elements inserted with keys not lower than the last one are just appended
+ * at the end. Other insertions are also appended, at an unsorted tail of
+ * the array, which is merged into the sorted part (keeping the order of
+ * insertion of elements with equal keys, as in std::multimap) before the next
+ * lookup or iteration. Hence, building a container in increasing key order
+ * takes O(N), and a flat_multimap in any order, O(N log N). The unsorted tail
+ * of a flat_map is linearly searched upon each insertion to avoid duplicated
+ * keys, so it is merged once it grows beyond sqrt(N) elements: building a
+ * flat_map in random order takes O(N sqrt(N)). Note that each lookup after
+ * out of order insertions also merges the tail, in O(N).
+ *
+ * Unlike std::map:
+ * - Elements are `std::pair<KEY,VALUE>`, with a non-const key.
+ * - As with std::vector, inserting or erasing elements invalidates all
+ * iterators and references to elements. The iterator returned by an insertion
+ * is only valid until the next call to any other method.
+ * - Const methods may sort pending elements, so the container must not be
+ * accessed from several threads right after insertions. Call sort() first.
+ *
+ * \note Defined in #include <mrpt/containers/flat_map.h>
+ * \sa map_as_vector, map_traits_flat
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_containers_grp
+ */
+template <class KEY, class VALUE, bool MULTI>
+class flat_map_base
+{
+   public:
+	using key_type = KEY;
+	using mapped_type = VALUE;
+	using value_type = std::pair<KEY, VALUE>;
+	using vec_t = mrpt::aligned_std_vector<value_type>;
+	using size_type = std::size_t;
+	using iterator = typename vec_t::iterator;
+	using const_iterator = typename vec_t::const_iterator;
+	using reverse_iterator = typename vec_t::reverse_iterator;
+	using const_reverse_iterator = typename vec_t::const_reverse_iterator;
+
+	/** @name Iterators
+		@{ */
+	iterator begin()
+	{
+		sort();
+		return m_vec.begin();
+	}
+	iterator end() { return m_vec.end(); }
+	const_iterator begin() const
+	{
+		sort();
+		return m_vec.begin();
+	}
+	const_iterator end() const { return m_vec.end(); }
+	const_iterator cbegin() const { return begin(); }
+	const_iterator cend() const { return end(); }
+	reverse_iterator rbegin()
+	{
+		sort();
+		return m_vec.rbegin();
+	}
+	reverse_iterator rend() { return m_vec.rend(); }
+	const_reverse_iterator rbegin() const
+	{
+		sort();
+		return m_vec.rbegin();
+	}
+	const_reverse_iterator rend() const { return m_vec.rend(); }
+	/** @} */
+
+	/** @name Size and memory
+		@{ */
+	size_type size() const { return m_vec.size(); }
+	bool empty() const { return m_vec.empty(); }
+	void clear()
+	{
+		m_vec.clear();
+		m_nSorted = 0;
+	}
+	/** Reserves memory for `n` elements, to avoid reallocations. */
+	void reserve(const size_type n) { m_vec.reserve(n); }
+	void swap(flat_map_base& o)
+	{
+		m_vec.swap(o.m_vec);
+		std::swap(m_nSorted, o.m_nSorted);
+	}
+	/** Read-only access to the underlying (sorted) array. */
+	const vec_t& getVector() const
+	{
+		sort();
+		return m_vec;
+	}
+	/** Merges any pending (out of order) insertion into the sorted array.
+	 * Done automatically, but can be called explicitly before sharing the
+	 * container among threads. */
+	void sort() const
+	{
+		if (m_nSorted == m_vec.size()) return;
+		const auto mid = m_vec.begin() + m_nSorted;
+		std::stable_sort(mid, m_vec.end(), key_less);
+		std::inplace_merge(m_vec.begin(), mid, m_vec.end(), key_less);
+		m_nSorted = m_vec.size();
+	}
+	/** @} */
+
+	/** @name Lookup
+		@{ */
+	iterator lower_bound(const KEY& k)
+	{
+		sort();
+		return std::lower_bound(m_vec.begin(), m_vec.end(), k, elem_less);
+	}
+	const_iterator lower_bound(const KEY& k) const
+	{
+		sort();
+		return std::lower_bound(m_vec.begin(), m_vec.end(), k, elem_less);
+	}
+	iterator upper_bound(const KEY& k)
+	{
+		sort();
+		return std::upper_bound(m_vec.begin(), m_vec.end(), k, less_elem);
+	}
+	const_iterator upper_bound(const KEY& k) const
+	{
+		sort();
+		return std::upper_bound(m_vec.begin(), m_vec.end(), k, less_elem);
+	}
+	std::pair<iterator, iterator> equal_range(const KEY& k)
+	{
+		return {lower_bound(k), upper_bound(k)};
+	}
+	std::pair<const_iterator, const_iterator> equal_range(const KEY& k) const
+	{
+		return {lower_bound(k), upper_bound(k)};
+	}
+	/** Returns an iterator to the (first) element with the given key, or
+	 * end() if there is none. */
+	iterator find(const KEY& k)
+	{
+		sort();
+		return m_vec.begin() + find_index(k);
+	}
+	const_iterator find(const KEY& k) const
+	{
+		sort();
+		return m_vec.begin() + find_index(k);
+	}
+	size_type count(const KEY& k) const
+	{
+		if constexpr (!MULTI)
+			return find_index(k) != m_vec.size() ? 1 : 0;
+		else
+		{
+			const auto r = equal_range(k);
+			return static_cast<size_type>(r.second - r.first);
+		}
+	}
+	/** Access the value of a given key.
+	 * \exception std::out_of_range If the key does not exist. */
+	VALUE& at(const KEY& k)
+	{
+		const auto it = find(k);
+		if (it == end()) throw std::out_of_range("flat_map::at()");
+		return it->second;
+	}
+	const VALUE& at(const KEY& k) const
+	{
+		const auto it = find(k);
+		if (it == end()) throw std::out_of_range("flat_map::at()");
+		return it->second;
+	}
+	/** Returns the value of a given key, inserting a default-constructed one
+	 * if it did not exist (only for flat_map). */
+	VALUE& operator[](const KEY& k)
+	{
+		static_assert(!MULTI, "operator[] is not available in multimaps");
+		const size_type idx = find_index(k);
+		if (idx != m_vec.size()) return m_vec[idx].second;
+		return append(value_type(k, VALUE()))->second;
+	}
+	/** @} */
+
+	/** @name Insertion and removal
+		@{ */
+
+	/** Inserts an element. For flat_map, nothing is inserted if the key
+	 * already exists. \return As in std::map::insert() (a pair of iterator
+	 * and `true` if inserted) or std::multimap::insert() (an iterator). */
+	auto insert(const value_type& v)
+	{
+		if constexpr (!MULTI)
+		{
+			const size_type idx = find_index(v.first);
+			if (idx != m_vec.size())
+				return std::make_pair(m_vec.begin() + idx, false);
+			return std::make_pair(append(v), true);
+		}
+		else
+			return append(v);
+	}
+	/** Inserts an element. The hint is ignored, since insertions at the end
+	 * are always efficient. */
+	iterator insert(const_iterator hint, const value_type& v)
+	{
+		MRPT_UNUSED_PARAM(hint);
+		if constexpr (!MULTI)
+			return insert(v).first;
+		else
+			return insert(v);
+	}
+	template <class InputIt>
+	void insert(InputIt first, InputIt last)
+	{
+		for (; first != last; ++first) insert(*first);
+	}
+
+	/** Erases all elements with the given key. \return The number of erased
+	 * elements. */
+	size_type erase(const KEY& k)
+	{
+		const auto r = equal_range(k);
+		const auto n = static_cast<size_type>(r.second - r.first);
+		erase(r.first, r.second);
+		return n;
+	}
+	iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+	iterator erase(const_iterator first, const_iterator last)
+	{
+		sort();
+		const auto n = static_cast<size_type>(last - first);
+		const auto it = m_vec.erase(first, last);
+		m_nSorted -= n;
+		return it;
+	}
+	/** @} */
+
+	bool operator==(const flat_map_base& o) const
+	{
+		return getVector() == o.getVector();
+	}
+	bool operator!=(const flat_map_base& o) const { return !(*this == o); }
+
+   private:
+	/** All elements. Those at [0,m_nSorted-1] are sorted. */
+	mutable vec_t m_vec;
+	mutable size_type m_nSorted{0};
+	/** Min. value of the max. number of unsorted elements of a flat_map,
+	 * which is sqrt(size()) otherwise, since they are linearly searched for
+	 * upon insertion to avoid duplicated keys. */
+	static constexpr size_type MIN_MAX_PENDING = 64;
+
+	static bool key_less(const value_type& a, const value_type& b)
+	{
+		return a.first < b.first;
+	}
+	static bool elem_less(const value_type& a, const KEY& k)
+	{
+		return a.first < k;
+	}
+	static bool less_elem(const KEY& k, const value_type& a)
+	{
+		return k < a.first;
+	}
+
+	/** Index of the (first) element with key `k`, or size() */
+	size_type find_index(const KEY& k) const
+	{
+		const size_type N = m_vec.size();
+		if constexpr (!MULTI && std::is_integral<KEY>::value)
+		{
+			// Fast path for dense keys:
+			const auto idx = static_cast<size_type>(k);
+			if (idx < m_nSorted && m_vec[idx].first == k) return idx;
+		}
+		if constexpr (!MULTI)
+		{
+			// Avoid sorting just to look for a key:
+			const auto itEnd = m_vec.begin() + m_nSorted;
+			const auto it =
+				std::lower_bound(m_vec.begin(), itEnd, k, elem_less);
+			if (it != itEnd && !(k < it->first))
+				return static_cast<size_type>(it - m_vec.begin());
+			for (size_type i = m_nSorted; i < N; i++)
+				if (!(k < m_vec[i].first) && !(m_vec[i].first < k)) return i;
+			return N;
+		}
+		else
+		{
+			sort();
+			const auto it =
+				std::lower_bound(m_vec.begin(), m_vec.end(), k, elem_less);
+			return (it != m_vec.end() && !(k < it->first))
+					   ? static_cast<size_type>(it - m_vec.begin())
+					   : N;
+		}
+	}
+
+	/** Appends an element, which is assumed not to exist in a flat_map. */
+	iterator append(const value_type& v)
+	{
+		const bool in_order =
+			m_nSorted == m_vec.size() &&
+			(m_vec.empty() || !(v.first < m_vec.back().first));
+		m_vec.push_back(v);
+		if (in_order)
+			m_nSorted++;
+		else if (
+			!MULTI && m_vec.size() - m_nSorted > MIN_MAX_PENDING &&
+			m_vec.size() - m_nSorted >
+				static_cast<size_type>(std::sqrt(double(m_vec.size()))))
+		{
+			sort();
+			return m_vec.begin() + find_index(v.first);
+		}
+		return m_vec.end() - 1;
+	}
+};
+
+/** A std::map<> look-alike stored in a sorted, contiguous array.
+ * \sa flat_map_base
+ * \ingroup mrpt_containers_grp */
+template <class KEY, class VALUE>
+using flat_map = flat_map_base<KEY, VALUE, false>;
+
+/** A std::multimap<> look-alike stored in a sorted, contiguous array.
+ * \sa flat_map_base
+ * \ingroup mrpt_containers_grp */
+template <class KEY, class VALUE>
+using flat_multimap = flat_map_base<KEY, VALUE, true>;
+
+}  // namespace mrpt::containers
@@ -9,7 +9,9 @@
 #pragma once
 
 #include <mrpt/containers/map_as_vector.h>
+#include <mrpt/containers/flat_map.h>
 #include <mrpt/core/aligned_allocator.h>
+#include <mrpt/core/aligned_std_map.h>
 
 namespace mrpt::containers
 {
@@ -30,6 +32,9 @@ struct map_traits_stdmap
 	struct map : public std::map<KEY, VALUE, _LessPred, _Alloc>
 	{
 	};
+	/** Used for multimaps, e.g. for the edges of a graph */
+	template <class KEY, class VALUE>
+	using multimap = mrpt::aligned_std_multimap<KEY, VALUE>;
 };
 
 /**  Traits for using a mrpt::utils::map_as_vector<> (dense, fastest
@@ -42,6 +47,23 @@ struct map_traits_map_as_vector
 	struct map : public mrpt::containers::map_as_vector<KEY, VALUE>
 	{
 	};
+	template <class KEY, class VALUE>
+	using multimap = mrpt::aligned_std_multimap<KEY, VALUE>;
+};
+
+/**  Traits for using mrpt::containers::flat_map<> and flat_multimap<>
+ * (sorted contiguous arrays): compact and cache-friendly, with constant-time
+ * lookups for dense keys (0,1,...,N-1) and, unlike map_traits_map_as_vector,
+ * also valid for sparse keys.
+ * \sa map_traits_stdmap */
+struct map_traits_flat
+{
+	template <class KEY, class VALUE, class _LessPred = std::less<KEY>,
+			  class _Alloc =
+				  mrpt::aligned_allocator_cpp11<std::pair<const KEY, VALUE>>>
+	using map = mrpt::containers::flat_map<KEY, VALUE>;
+	template <class KEY, class VALUE>
+	using multimap = mrpt::containers::flat_multimap<KEY, VALUE>;
 };
 
 /** @} */
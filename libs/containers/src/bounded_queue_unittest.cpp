@@ -0,0 +1,106 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/containers/bounded_queue.h>
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+using namespace mrpt::containers;
+
+TEST(bounded_queue, PushPopReject)
+{
+	spsc_queue<std::shared_ptr<int>> q(3);
+	EXPECT_EQ(q.capacity(), 4U);
+	std::shared_ptr<int> v;
+	EXPECT_FALSE(q.try_pop(v));
+	for (int i = 0; i < 4; i++) EXPECT_TRUE(q.push(std::make_shared<int>(i)));
+	EXPECT_FALSE(q.push(std::make_shared<int>(4)));
+	EXPECT_EQ(q.size(), 4U);
+	for (int i = 0; i < 4; i++)
+	{
+		ASSERT_TRUE(q.try_pop(v));
+		EXPECT_EQ(*v, i);
+	}
+	EXPECT_TRUE(q.empty());
+	EXPECT_EQ(q.dropped(), 0U);
+	// Popped objects are not kept alive by the queue:
+	EXPECT_EQ(v.use_count(), 1);
+}
+
+TEST(bounded_queue, DropOldest)
+{
+	mpmc_queue<int> q(4, queue_full_policy::drop_oldest);
+	for (int i = 0; i < 10; i++) EXPECT_TRUE(q.push(i));
+	EXPECT_EQ(q.dropped(), 6U);
+	int v;
+	for (int i = 6; i < 10; i++)
+	{
+		ASSERT_TRUE(q.try_pop(v));
+		EXPECT_EQ(v, i);
+	}
+	EXPECT_FALSE(q.pop(v, std::chrono::milliseconds(1)));
+}
+
+TEST(bounded_queue, MultiThreaded)
+{
+	const int nProducers = 4, nPerProducer = 20000;
+	mpmc_queue<int> q(64);
+	std::vector<std::thread> producers;
+	for (int p = 0; p < nProducers; p++)
+		producers.emplace_back([&q, p]() {
+			for (int i = 0; i < nPerProducer; i++)
+				while (!q.push(p * nPerProducer + i)) std::this_thread::yield();
+		});
+
+	// Each value must be received exactly once, in order for each producer:
+	std::vector<int> last(nProducers, -1);
+	long long sum = 0;
+	for (int n = 0; n < nProducers * nPerProducer; n++)
+	{
+		int v;
+		ASSERT_TRUE(q.pop(v, std::chrono::seconds(10)));
+		const int p = v / nPerProducer;
+		EXPECT_GT(v, last[p]);
+		last[p] = v;
+		sum += v;
+	}
+	for (auto& t : producers) t.join();
+	const long long N = nProducers * nPerProducer;
+	EXPECT_EQ(sum, N * (N - 1) / 2);
+	EXPECT_TRUE(q.empty());
+}
+
+TEST(bounded_queue, BlockingPush)
+{
+	spsc_queue<int> q(2);
+	EXPECT_TRUE(q.push(0, std::chrono::milliseconds(1)));
+	EXPECT_TRUE(q.push(1, std::chrono::milliseconds(1)));
+	// Full: times out and does not insert anything.
+	EXPECT_FALSE(q.push(2, std::chrono::milliseconds(10)));
+	EXPECT_EQ(q.size(), 2U);
+
+	// A producer much faster than the consumer must not lose anything:
+	const int N = 2000;
+	std::thread producer([&q]() {
+		for (int i = 2; i < N; i++)
+			while (!q.push(i, std::chrono::seconds(1)))
+			{
+			}
+	});
+	for (int i = 0; i < N; i++)
+	{
+		int v;
+		ASSERT_TRUE(q.pop(v, std::chrono::seconds(10)));
+		EXPECT_EQ(v, i);
+	}
+	producer.join();
+	EXPECT_TRUE(q.empty());
+	EXPECT_EQ(q.dropped(), 0U);
+}
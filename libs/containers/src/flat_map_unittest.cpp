@@ -0,0 +1,95 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/containers/flat_map.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+#include <map>
+#include <stdexcept>
+
+using namespace mrpt::containers;
+
+TEST(flat_map, InsertInOrder)
+{
+	flat_map<size_t, double> m;
+	for (size_t i = 0; i < 100; i++) m[i] = 2.0 * i;
+	EXPECT_EQ(m.size(), 100U);
+	for (size_t i = 0; i < 100; i++)
+	{
+		const auto it = m.find(i);
+		ASSERT_TRUE(it != m.end());
+		EXPECT_EQ(it->first, i);
+		EXPECT_EQ(it->second, 2.0 * i);
+	}
+	EXPECT_TRUE(m.find(100) == m.end());
+	EXPECT_EQ(m.count(5), 1U);
+	EXPECT_EQ(m.count(500), 0U);
+	EXPECT_THROW(m.at(500), std::out_of_range);
+	// Duplicated keys are not inserted:
+	EXPECT_FALSE(m.insert({5, 0.0}).second);
+	EXPECT_EQ(m.at(5), 10.0);
+}
+
+TEST(flat_map, CompareWithStdMap)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+	flat_map<int, int> m;
+	std::map<int, int> ref;
+	for (int i = 0; i < 1000; i++)
+	{
+		const int k = rng.drawUniform32bit() % 300;
+		if (i % 3 == 0)
+		{
+			m[k] = i;
+			ref[k] = i;
+		}
+		else
+			EXPECT_EQ(m.insert({k, i}).second, ref.insert({k, i}).second);
+		if (i % 50 == 0)
+		{
+			EXPECT_EQ(m.erase(k / 2), ref.erase(k / 2));
+		}
+	}
+	ASSERT_EQ(m.size(), ref.size());
+	auto it = m.begin();
+	for (const auto& p : ref)
+	{
+		EXPECT_EQ(it->first, p.first);
+		EXPECT_EQ(it->second, p.second);
+		++it;
+	}
+	EXPECT_TRUE(it == m.end());
+}
+
+TEST(flat_multimap, KeepsInsertionOrderOfEqualKeys)
+{
+	flat_multimap<int, int> m;
+	std::multimap<int, int> ref;
+	for (int i = 0; i < 200; i++)
+	{
+		const int k = (i * 7) % 13;
+		m.insert({k, i});
+		ref.insert({k, i});
+	}
+	EXPECT_EQ(m.count(3), ref.count(3));
+	ASSERT_EQ(m.size(), ref.size());
+	EXPECT_TRUE(std::equal(
+		m.begin(), m.end(), ref.begin(),
+		[](const auto& a, const auto& b) {
+			return a.first == b.first && a.second == b.second;
+		}));
+
+	const auto r = m.equal_range(4);
+	EXPECT_EQ(r.first->first, 4);
+	EXPECT_EQ(r.first, m.find(4));
+	EXPECT_EQ(m.erase(4), ref.erase(4));
+	EXPECT_TRUE(m.find(4) == m.end());
+	EXPECT_EQ(m.size(), ref.size());
+}
@@ -1852,7 +1852,7 @@ void CFaceDetection::experimental_calcHist(
 	for (size_t row = r1; row <= r2; row++)
 		for (size_t col = c1; col <= c2; col++)
 		{
-			unsigned char* c = face.get_unsafe(col, row);
+			const unsigned char* c = face.get_unsafe(col, row);
 			size_t value = (size_t)*c;
 			int count = hist.get_unsafe(0, value) + 1;
 			hist.set_unsafe(0, value, count);
@@ -13,10 +13,13 @@
 #include <mrpt/core/aligned_allocator.h>
 #include <mrpt/core/aligned_std_map.h>
 #include <mrpt/core/exceptions.h>
+#include <mrpt/containers/traits_map.h>
 #include <mrpt/graphs/TNodeID.h>
+#include <algorithm>
 #include <set>
 #include <map>
 #include <fstream>
+#include <vector>
 
 namespace mrpt
 {
@@ -59,12 +62,20 @@ struct edge_annotations_empty
  *  Note that edges are stored as a std::multimap<> to allow <b>multiple
  * edges</b> between the same pair of nodes.
  *
+ *  The template argument EDGES_IMPLEMENTATION selects the type of that
+ * multimap: mrpt::containers::map_traits_stdmap (default) for a
+ * std::multimap<>, or mrpt::containers::map_traits_flat for a
+ * mrpt::containers::flat_multimap<>, which keeps all the edges in one
+ * contiguous array sorted by (from,to), so that the outgoing edges of each
+ * node are also contiguous.
+ *
  * \sa mrpt::graphs::CDijkstra, mrpt::graphs::CNetworkOfPoses,
  * mrpt::graphs::CDirectedTree
  * \ingroup mrpt_graphs_grp
  */
 template <class TYPE_EDGES,
-		  class EDGE_ANNOTATIONS = detail::edge_annotations_empty>
+		  class EDGE_ANNOTATIONS = detail::edge_annotations_empty,
+		  class EDGES_IMPLEMENTATION = mrpt::containers::map_traits_stdmap>
 class CDirectedGraph
 {
    public:
@@ -89,13 +100,15 @@ class CDirectedGraph
 	/** Underlying type for edge_t = TYPE_EDGES + annotations */
 	using edge_underlying_t = TYPE_EDGES;
 	/** The type of the member \a edges */
-	using edges_map_t = mrpt::aligned_std_multimap<TPairNodeIDs, edge_t>;
+	using edges_map_t = typename EDGES_IMPLEMENTATION::template multimap<
+		TPairNodeIDs, edge_t>;
 	using iterator = typename edges_map_t::iterator;
 	using reverse_iterator = typename edges_map_t::reverse_iterator;
 	using const_iterator = typename edges_map_t::const_iterator;
 	using const_reverse_iterator = typename edges_map_t::const_reverse_iterator;
 	/**\brief Handy self type */
-	using self_t = CDirectedGraph<TYPE_EDGES, EDGE_ANNOTATIONS>;
+	using self_t =
+		CDirectedGraph<TYPE_EDGES, EDGE_ANNOTATIONS, EDGES_IMPLEMENTATION>;
 
 	/** The public member with the directed edges in the graph */
 	edges_map_t edges;
@@ -313,6 +326,70 @@ class CDirectedGraph
 		}
 	}
 
+	/** The adjacency of all the nodes (regardless of the edge direction) in
+	 * compressed sparse row (CSR) form. \sa getAdjacencyCSR */
+	struct TAdjacencyCSR
+	{
+		/** Sorted IDs of all the nodes in the edges */
+		std::vector<TNodeID> nodeIDs;
+		/** The neighbors of nodeIDs[i] are
+		 * neighbors[row_ptr[i]],...,neighbors[row_ptr[i+1]-1], as sorted
+		 * indices in nodeIDs, without duplicates. */
+		std::vector<size_t> row_ptr, neighbors;
+
+		/** Index of a node in nodeIDs, or nodeIDs.size() if not found. */
+		size_t indexOf(const TNodeID id) const
+		{
+			const auto it =
+				std::lower_bound(nodeIDs.begin(), nodeIDs.end(), id);
+			return (it != nodeIDs.end() && *it == id)
+					   ? static_cast<size_t>(it - nodeIDs.begin())
+					   : nodeIDs.size();
+		}
+		size_t nodeCount() const { return nodeIDs.size(); }
+	};
+
+	/** Builds the adjacency of all the nodes in CSR form, a more compact and
+	 * faster to traverse alternative to getAdjacencyMatrix(), built in
+	 * O(E log E) time with just a few memory allocations.
+	 * \sa getAdjacencyMatrix */
+	void getAdjacencyCSR(TAdjacencyCSR& out) const
+	{
+		auto& ids = out.nodeIDs;
+		ids.clear();
+		ids.reserve(2 * edges.size());
+		for (const auto& e : edges)
+		{
+			ids.push_back(e.first.first);
+			ids.push_back(e.first.second);
+		}
+		std::sort(ids.begin(), ids.end());
+		ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+		// Both directions of each edge, as (row,col) pairs of indices:
+		std::vector<std::pair<size_t, size_t>> arcs;
+		arcs.reserve(2 * edges.size());
+		for (const auto& e : edges)
+		{
+			const size_t i = out.indexOf(e.first.first);
+			const size_t j = out.indexOf(e.first.second);
+			arcs.emplace_back(i, j);
+			arcs.emplace_back(j, i);
+		}
+		std::sort(arcs.begin(), arcs.end());
+		arcs.erase(std::unique(arcs.begin(), arcs.end()), arcs.end());
+
+		out.row_ptr.assign(ids.size() + 1, 0);
+		out.neighbors.resize(arcs.size());
+		for (size_t k = 0; k < arcs.size(); k++)
+		{
+			out.row_ptr[arcs[k].first + 1]++;
+			out.neighbors[k] = arcs[k].second;
+		}
+		for (size_t i = 0; i < ids.size(); i++)
+			out.row_ptr[i + 1] += out.row_ptr[i];
+	}
+
 	/** @} */  // end of edge/nodes utilities
 
 	/** @name I/O utilities
@@ -10,6 +10,7 @@
 #define MRPT_DIRECTED_TREE_H
 
 #include <list>
+#include <map>
 #include <mrpt/graphs/TNodeID.h>
 #include <sstream>
 
@@ -105,9 +105,13 @@ class CMRVisualizer;
  *		- CPOSE: The type of the edges, which hold a relative pose (2D/3D, just
  *a
  *value or a Gaussian, etc.)
- *		- MAPS_IMPLEMENTATION: Can be either mrpt::containers::map_traits_stdmap
- *or mrpt::containers::map_traits_map_as_vector. Determines the type of the list
- *of global poses (member \a nodes).
+ *		- MAPS_IMPLEMENTATION: Can be mrpt::containers::map_traits_stdmap,
+ *mrpt::containers::map_traits_map_as_vector or
+ *mrpt::containers::map_traits_flat. Determines the type of the list of global
+ *poses (member \a nodes) and, for map_traits_flat, also that of the edges:
+ *both are then stored in contiguous arrays sorted by node IDs, with
+ *constant-time lookup of nodes with dense IDs. This is the fastest choice for
+ *large graphs which are built once and then optimized or traversed.
  *
  * \sa mrpt::graphslam
  * \ingroup mrpt_graphs_grp
@@ -119,14 +123,15 @@ template <
 	// std::vector<>
 	class NODE_ANNOTATIONS = mrpt::graphs::detail::TNodeAnnotationsEmpty,
 	class EDGE_ANNOTATIONS = mrpt::graphs::detail::edge_annotations_empty>
-class CNetworkOfPoses
-	: public mrpt::graphs::CDirectedGraph<CPOSE, EDGE_ANNOTATIONS>
+class CNetworkOfPoses : public mrpt::graphs::CDirectedGraph<
+							CPOSE, EDGE_ANNOTATIONS, MAPS_IMPLEMENTATION>
 {
    public:
 	/** @name Typedef's
 		@{ */
 	/** The base class "CDirectedGraph<CPOSE,EDGE_ANNOTATIONS>" */
-	using BASE = mrpt::graphs::CDirectedGraph<CPOSE, EDGE_ANNOTATIONS>;
+	using BASE = mrpt::graphs::CDirectedGraph<
+		CPOSE, EDGE_ANNOTATIONS, MAPS_IMPLEMENTATION>;
 	/** My own type */
 	using self_t = CNetworkOfPoses<
 		CPOSE, MAPS_IMPLEMENTATION, NODE_ANNOTATIONS, EDGE_ANNOTATIONS>;
@@ -1036,6 +1041,7 @@ namespace typemeta
 {
 MRPT_DECLARE_TTYPENAME(mrpt::containers::map_traits_stdmap)
 MRPT_DECLARE_TTYPENAME(mrpt::containers::map_traits_map_as_vector)
+MRPT_DECLARE_TTYPENAME(mrpt::containers::map_traits_flat)
 }  // namespace typemeta
 
 }  // namespace mrpt
@@ -71,6 +71,46 @@ struct TPosePDFHelper<CPose3D>
 };
 
 /// a helper struct with static template functions \sa CNetworkOfPoses
+// Binary serialization of the containers of nodes and edges. STL containers
+// use the STL serialization, and flat containers are stored with the same
+// format than std::map / std::multimap:
+template <class CONTAINER>
+void writeGraphContainer(
+	mrpt::serialization::CArchive& out, const CONTAINER& c)
+{
+	out << c;
+}
+template <class K, class V, bool MULTI>
+void writeGraphContainer(
+	mrpt::serialization::CArchive& out,
+	const mrpt::containers::flat_map_base<K, V, MULTI>& c)
+{
+	out << std::string(MULTI ? "std::multimap" : "std::map")
+		<< mrpt::typemeta::TTypeName<K>::get()
+		<< mrpt::typemeta::TTypeName<V>::get();
+	out << static_cast<uint32_t>(c.size());
+	for (const auto& e : c) out << e.first << e.second;
+}
+template <class CONTAINER>
+void readGraphContainer(mrpt::serialization::CArchive& in, CONTAINER& c)
+{
+	in >> c;
+}
+template <class K, class V, bool MULTI>
+void readGraphContainer(
+	mrpt::serialization::CArchive& in,
+	mrpt::containers::flat_map_base<K, V, MULTI>& c)
+{
+	std::conditional_t<
+		MULTI, mrpt::aligned_std_multimap<K, V>, mrpt::aligned_std_map<K, V>>
+		m;
+	in >> m;
+	c.clear();
+	c.reserve(m.size());
+	for (const auto& e : m)
+		c.insert(c.end(), std::make_pair(e.first, e.second));
+}
+
 template <class graph_t>
 struct graph_ops
 {
@@ -213,7 +253,9 @@ struct graph_ops
 		// Store serialization version & object data:
 		const uint32_t version = 0;
 		out << version;
-		out << g->nodes << g->edges << g->root;
+		writeGraphContainer(out, g->nodes);
+		writeGraphContainer(out, g->edges);
+		out << g->root;
 	}
 
 	// =================================================================
@@ -237,7 +279,9 @@ struct graph_ops
 		switch (stored_version)
 		{
 			case 0:
-				in >> g->nodes >> g->edges >> g->root;
+				readGraphContainer(in, g->nodes);
+				readGraphContainer(in, g->edges);
+				in >> g->root;
 				break;
 			default:
 				MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(stored_version)
@@ -957,9 +1001,7 @@ struct graph_ops
 	// --------------------------------------------------------------------------------
 	static double graph_edge_sqerror(
 		const graph_t* g,
-		const typename mrpt::graphs::CDirectedGraph<
-			typename graph_t::constraint_t>::edges_map_t::const_iterator&
-			itEdge,
+		const typename graph_t::edges_map_t::const_iterator& itEdge,
 		bool ignoreCovariances)
 	{
 		MRPT_START
@@ -8,6 +8,7 @@
    +------------------------------------------------------------------------+ */
 #pragma once
 
+#include <mrpt/core/pimpl.h>
 #include <mrpt/math/types_math.h>
 #include <mrpt/system/COutputLogger.h>
 #include <mrpt/system/CTimeLogger.h>
@@ -27,13 +28,14 @@ namespace mrpt::graphs
  *   - Linear error functions (for now).
  *   - Scalar (1-dim) error functions.
  *   - Gaussian factors.
- *   - Solver: Eigen SparseQR.
+ *   - Solver: Eigen SparseQR, or sparse Cholesky (LDL^T) of the information
+ * matrix, see setSolver().
  *
  *  Usage:
  *   - Call initialize() to set the number of nodes.
  *   - Call addConstraints() to insert constraints. This may be called more than
  * once.
- *   - Call updateEstimation() to run one step of the linear SparseQR solver.
+ *   - Call updateEstimation() to run one step of the linear solver.
  *
  * \ingroup mrpt_graph_grp
  * \note [New in MRPT 1.5.0] Requires Eigen>=3.1
@@ -43,6 +45,24 @@ class ScalarFactorGraph : public mrpt::system::COutputLogger
    public:
 	ScalarFactorGraph();
 
+	/** Linear solvers available in updateEstimation()
+	 * \note [New in MRPT 2.0.0] */
+	enum TSolver
+	{
+		/** QR factorization of the whitened Jacobian, from scratch in each
+		 * call. Copes with rank-deficient problems. */
+		solverSparseQR = 0,
+		/** LDL^T factorization of the information matrix \f$ H = J^T
+		 * \Lambda J \f$. The symbolic analysis (fill-reducing ordering and
+		 * sparsity pattern) is kept between calls and only redone when the
+		 * set of binary factors changes, so successive calls only run the
+		 * numeric factorization. Variances are recovered with Takahashi
+		 * recursions, which only visit the nonzero pattern of the factor.
+		 * Falls back to solverSparseQR if H turns out to be singular
+		 * (default) */
+		solverCholesky
+	};
+
 	struct FactorBase
 	{
 		virtual ~FactorBase();
@@ -95,11 +115,34 @@ class ScalarFactorGraph : public mrpt::system::COutputLogger
 		/** Output increment of the current estimate. Caller must add this
 		   vector to current state vector to obtain the optimal estimation. */
 		Eigen::VectorXd& solved_x_inc,
-		/** If !=nullptr, the variances of each estimate will be stored here. */
+		/** If !=nullptr, the variances of each estimate will be stored here.
+		 * Those not computed within the time budget (see
+		 * setVarianceTimeBudget()) are set to NaN. */
 		Eigen::VectorXd* solved_variances = nullptr);
 
 	bool isProfilerEnabled() const { return m_enable_profiler; }
 	void enableProfiler(bool enable = true) { m_enable_profiler = enable; }
+	TSolver getSolver() const { return m_solver; }
+	/** Selects the linear solver. \sa TSolver */
+	void setSolver(TSolver s) { m_solver = s; }
+	double getVarianceTimeBudget() const { return m_variance_time_budget; }
+	/** Sets the maximum time (seconds) to spend in the recovery of
+	 * variances in each updateEstimation() call (default: 0=no limit).
+	 * Only honored by solverCholesky.
+	 *
+	 * Variances are recovered backwards along the elimination order of the
+	 * factorization, and each one requires those computed before it. When
+	 * the budget runs out, the next call resumes the recovery where it
+	 * stopped (unless the structure of the graph changed), using the former
+	 * values of the variances already recovered, so all nodes get their
+	 * variance refreshed every few calls. Nodes not reached in a call get
+	 * NaN variances.
+	 * \note [New in MRPT 2.0.0] */
+	void setVarianceTimeBudget(double seconds)
+	{
+		m_variance_time_budget = seconds;
+	}
+
    private:
 	/** number of nodes in the graph */
 	size_t m_numNodes;
@@ -109,6 +152,16 @@ class ScalarFactorGraph : public mrpt::system::COutputLogger
 
 	mrpt::system::CTimeLogger m_timelogger;
 	bool m_enable_profiler;
+	TSolver m_solver{solverCholesky};
+	double m_variance_time_budget{0};
+
+	/** Cached symbolic factorization, etc. for solverCholesky */
+	struct Impl;
+	mrpt::pimpl<Impl> m_impl;
+
+	void solveSparseQR(Eigen::VectorXd& x, Eigen::VectorXd* variances);
+	/** Returns false if H is singular, so the QR solver must be used. */
+	bool solveCholesky(Eigen::VectorXd& x, Eigen::VectorXd* variances);
 
 };  // End of class def.
 
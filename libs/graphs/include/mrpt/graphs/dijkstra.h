@@ -139,8 +139,6 @@ class CDijkstra
 	// Intermediary and final results:
 	/** All the distances */
 	id2dist_map_t m_distances;
-	std::map<TNodeID, TDistance>
-		m_distances_non_visited;  // Use a std::map here in all cases.
 	id2id_map_t m_prev_node;
 	id2pairIDs_map_t m_prev_arc;
 	std::set<TNodeID> m_lstNode_IDs;
@@ -210,11 +208,24 @@ class CDijkstra
 		14                        m_prev_node[v] := u
 		*/
 
-		// Make a list of all the nodes in the graph:
-		graph.getAllNodes(m_lstNode_IDs);
-		const size_t nNodes = m_lstNode_IDs.size();
+		// Precompute all neighbors of all the nodes in the given graph, in
+		// compressed form. Nodes are referred to by their index in the
+		// sorted list of IDs (adj.nodeIDs) from now on:
+		typename graph_t::TAdjacencyCSR adj;
+		graph.getAdjacencyCSR(adj);
+		const size_t nNodes = adj.nodeCount();
+		m_lstNode_IDs.insert(adj.nodeIDs.begin(), adj.nodeIDs.end());
+		// Same contents, as returned by getCachedAdjacencyMatrix(), built
+		// in order from the compressed form:
+		for (size_t i = 0; i < nNodes; i++)
+		{
+			auto& nei = m_allNeighbors[adj.nodeIDs[i]];
+			for (size_t k = adj.row_ptr[i]; k < adj.row_ptr[i + 1]; k++)
+				nei.insert(nei.end(), adj.nodeIDs[adj.neighbors[k]]);
+		}
 
-		if (m_lstNode_IDs.find(source_node_ID) == m_lstNode_IDs.end())
+		const size_t source_idx = adj.indexOf(source_node_ID);
+		if (source_idx == nNodes)
 		{
 			THROW_EXCEPTION_FMT(
 				"Cannot find the source node_ID=%lu in the graph",
@@ -222,53 +233,25 @@ class CDijkstra
 		}
 
 		// Init:
-		// m_distances: already initialized to infinity by default.
-		// m_prev_node: idem
-		// m_prev_arc: idem
-		// m_visited: idem
-		size_t visitedCount = 0;
-		m_distances[source_node_ID] = 0;
-		m_distances_non_visited[source_node_ID] = 0;
+		const double INF = std::numeric_limits<double>::max();
+		const size_t INVALID_IDX = static_cast<size_t>(-1);
+		std::vector<double> dist(nNodes, INF);
+		std::vector<size_t> prev_idx(nNodes, INVALID_IDX);
+		std::vector<TPairNodeIDs> prev_arc(nNodes);
+		// The non-visited nodes with a known distance, sorted by distance
+		// and then by ID:
+		std::set<std::pair<double, size_t>> non_visited;
 
-		// Precompute all neighbors of all the nodes in the given graph:
-		graph.getAdjacencyMatrix(m_allNeighbors);
-
-		using namespace std;
+		size_t visitedCount = 0;
+		dist[source_idx] = 0;
+		non_visited.emplace(0, source_idx);
 
-		TNodeID u;
 		// as long as there are nodes not yet visited.
 		do
 		{  // The algorithm:
 			// Find the nodeID with the minimum known distance so far
 			// considered:
-			double min_d = std::numeric_limits<double>::max();
-			u = INVALID_NODEID;
-
-			// No need to check if the min. distance node is not visited yet,
-			// since we
-			// keep two lists: m_distances_non_visited & m_distances
-			for (typename std::map<TNodeID, TDistance>::const_iterator itDist =
-					 m_distances_non_visited.begin();
-				 itDist != m_distances_non_visited.end(); ++itDist)
-			{
-				// TODO - remove these
-				// cout << "Current min distance: " << min_d << endl;
-				// cout << "itDist->first: " << itDist->first << endl;
-				// cout << "itDist->second (distance to this node): " <<
-				// itDist->second.dist << endl;
-
-				if (itDist->second.dist < min_d)
-				{
-					u = itDist->first;
-					min_d = itDist->second.dist;
-					// cout << "updating u, min_d... " << endl;
-				}
-				// cout << "finished for." << endl;
-			}
-
-			// make sure we have found the next nodeID from the available
-			// non-visited distances
-			if (u == INVALID_NODEID)
+			if (non_visited.empty())
 			{
 				std::set<TNodeID> nodeIDs_unconnected;
 
@@ -278,22 +261,9 @@ class CDijkstra
 					 n_it != graph.nodes.end(); ++n_it)
 				{
 					// have I already visited this node in Dijkstra?
-					bool have_traversed = false;
-					for (typename id2dist_map_t::const_iterator d_it =
-							 m_distances.begin();
-						 d_it != m_distances.end(); ++d_it)
-					{
-						if (n_it->first == d_it->first)
-						{
-							have_traversed = true;
-							break;
-						}
-					}
-
-					if (!have_traversed)
-					{
+					const size_t idx = adj.indexOf(n_it->first);
+					if (idx == nNodes || dist[idx] == INF)
 						nodeIDs_unconnected.insert(n_it->first);
-					}
 				}
 
 				std::string err_str =
@@ -302,10 +272,11 @@ class CDijkstra
 					nodeIDs_unconnected, err_str);
 			}
 
-			// Update distance (for possible future reference...) and remove
-			// this node from "non-visited":
-			m_distances[u] = m_distances_non_visited[u];
-			m_distances_non_visited.erase(u);
+			// Remove this node from "non-visited":
+			const double min_d = non_visited.begin()->first;
+			const size_t u_idx = non_visited.begin()->second;
+			const TNodeID u = adj.nodeIDs[u_idx];
+			non_visited.erase(non_visited.begin());
 
 			visitedCount++;
 
@@ -313,13 +284,12 @@ class CDijkstra
 			if (functor_on_progress) functor_on_progress(graph, visitedCount);
 
 			// For each arc from "u":
-			const std::set<TNodeID>& neighborsOfU =
-				m_allNeighbors[u];  // graph.getNeighborsOf(u,neighborsOfU);
-			for (std::set<TNodeID>::const_iterator itNei = neighborsOfU.begin();
-				 itNei != neighborsOfU.end(); ++itNei)
+			for (size_t k = adj.row_ptr[u_idx]; k < adj.row_ptr[u_idx + 1];
+				 k++)
 			{
-				const TNodeID i = *itNei;
-				if (i == u) continue;  // ignore self-loops...
+				const size_t i_idx = adj.neighbors[k];
+				if (i_idx == u_idx) continue;  // ignore self-loops...
+				const TNodeID i = adj.nodeIDs[i_idx];
 
 				// the "edge_ui" may be searched here or a bit later, so the
 				// "bool" var will tell us.
@@ -346,13 +316,15 @@ class CDijkstra
 					edge_ui_found = true;
 				}
 
-				if ((min_d + edge_ui_weight) < m_distances[i].dist)
-				{  // the [] creates the entry if needed
-					// update m_distances, m_distances_non_visited
-					m_distances_non_visited[i].dist = min_d + edge_ui_weight;
-					m_distances[i].dist = min_d + edge_ui_weight;
+				if ((min_d + edge_ui_weight) < dist[i_idx])
+				{
+					// update the distance and the non-visited list:
+					if (dist[i_idx] != INF)
+						non_visited.erase(std::make_pair(dist[i_idx], i_idx));
+					dist[i_idx] = min_d + edge_ui_weight;
+					non_visited.emplace(dist[i_idx], i_idx);
 
-					m_prev_node[i].id = u;
+					prev_idx[i_idx] = u_idx;
 					// If still not done above, detect the direction of the arc
 					// now:
 					if (!edge_ui_found)
@@ -367,13 +339,23 @@ class CDijkstra
 					}
 
 					if (!edge_ui_reverse)
-						m_prev_arc[i] = std::make_pair(u, i);  // *u -> *i
+						prev_arc[i_idx] = std::make_pair(u, i);  // *u -> *i
 					else
-						m_prev_arc[i] = std::make_pair(i, u);  // *i -> *u
+						prev_arc[i_idx] = std::make_pair(i, u);  // *i -> *u
 				}
 			}
 		} while (visitedCount < nNodes);
 
+		// Save results, in increasing order of node IDs:
+		for (size_t i = 0; i < nNodes; i++)
+		{
+			if (dist[i] == INF) continue;
+			const TNodeID id = adj.nodeIDs[i];
+			m_distances[id] = dist[i];
+			if (prev_idx[i] == INVALID_IDX) continue;
+			m_prev_node[id].id = adj.nodeIDs[prev_idx[i]];
+			m_prev_arc[id] = prev_arc[i];
+		}
 	}  // end Dijkstra
 
 	/** @name Query Dijkstra results
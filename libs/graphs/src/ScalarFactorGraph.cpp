@@ -11,6 +11,8 @@
 
 #include <mrpt/graphs/ScalarFactorGraph.h>
 #include <mrpt/system/CTicTac.h>
+#include <algorithm>
+#include <limits>
 
 using namespace mrpt;
 using namespace mrpt::graphs;
@@ -19,11 +21,43 @@ using namespace std;
 #if EIGEN_VERSION_AT_LEAST(3, 1, 0)  // Requires Eigen>=3.1
 #include <Eigen/SparseCore>
 #include <Eigen/SparseQR>
+#include <Eigen/SparseCholesky>
 #endif
 
+struct ScalarFactorGraph::Impl
+{
+	Impl() = default;
+	/** Eigen solvers can't be copied: copies start from scratch. */
+	Impl(const Impl&) {}
+	Impl& operator=(const Impl&)
+	{
+		pattern_valid = false;
+		return *this;
+	}
+
+#if EIGEN_VERSION_AT_LEAST(3, 1, 0)
+	/** Upper triangle of the information matrix, with a fixed pattern */
+	Eigen::SparseMatrix<double> H;
+	/** Indices in H.valuePtr() of each diagonal entry, and of the
+	 * off-diagonal entry of each binary factor */
+	std::vector<int> diag_pos, binary_pos;
+	/** The nodes of the binary factors for which H was built */
+	std::vector<std::pair<size_t, size_t>> binary_ids;
+	Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>, Eigen::Upper> ldlt;
+	/** Entries of Z=inv(H) in the pattern of L, and its diagonal, kept
+	 * between calls when the variance time budget runs out */
+	std::vector<double> Zx, Zd;
+	/** Next column of Z to compute, or -1 to start from scratch */
+	int Z_next_col{-1};
+#endif
+	bool pattern_valid{false};
+};
+
 ScalarFactorGraph::FactorBase::~FactorBase() {}
 ScalarFactorGraph::ScalarFactorGraph()
-	: COutputLogger("GMRF"), m_enable_profiler(false)
+	: COutputLogger("GMRF"),
+	  m_enable_profiler(false),
+	  m_impl(mrpt::make_impl<ScalarFactorGraph::Impl>())
 {
 }
 
@@ -34,6 +68,7 @@ void ScalarFactorGraph::clear()
 	m_numNodes = 0;
 	m_factors_unary.clear();
 	m_factors_binary.clear();
+	m_impl->pattern_valid = false;
 }
 
 void ScalarFactorGraph::initialize(const size_t nodeCount)
@@ -41,6 +76,7 @@ void ScalarFactorGraph::initialize(const size_t nodeCount)
 	MRPT_LOG_DEBUG_STREAM("initialize() called, nodeCount=" << nodeCount);
 
 	m_numNodes = nodeCount;
+	m_impl->pattern_valid = false;
 }
 
 void ScalarFactorGraph::addConstraint(const UnaryFactorVirtualBase& c)
@@ -74,13 +110,6 @@ bool ScalarFactorGraph::eraseConstraint(const FactorBase& c)
 	return false;
 }
 
-/* Method:
-  (\Sigma)^{-1/2) *  d( h(x) )/d( x )  * x_incr = - (\Sigma)^{-1/2) * r(x)
-  ===================================            ========================
-			  =A                                           =b
-
-   A * x_incr = b         --> SparseQR.
-*/
 void ScalarFactorGraph::updateEstimation(
 	/** Output increment of the current estimate. Caller must add this
 	   vector to current state vector to obtain the optimal estimation. */
@@ -93,7 +122,28 @@ void ScalarFactorGraph::updateEstimation(
 	m_timelogger.enable(m_enable_profiler);
 
 #if EIGEN_VERSION_AT_LEAST(3, 1, 0)
+	if (m_solver == solverCholesky)
+	{
+		if (solveCholesky(solved_x_inc, solved_variances)) return;
+		MRPT_LOG_DEBUG("Singular information matrix: falling back to QR.");
+	}
+	solveSparseQR(solved_x_inc, solved_variances);
+#else
+	THROW_EXCEPTION("This method requires Eigen 3.1.0 or above");
+#endif
+}
 
+#if EIGEN_VERSION_AT_LEAST(3, 1, 0)
+/* Method:
+  (\Sigma)^{-1/2) *  d( h(x) )/d( x )  * x_incr = - (\Sigma)^{-1/2) * r(x)
+  ===================================            ========================
+			  =A                                           =b
+
+   A * x_incr = b         --> SparseQR.
+*/
+void ScalarFactorGraph::solveSparseQR(
+	Eigen::VectorXd& solved_x_inc, Eigen::VectorXd* solved_variances)
+{
 	// Number of vertices:
 	const size_t n = m_numNodes;
 	solved_x_inc.setZero(n);
@@ -243,8 +293,213 @@ void ScalarFactorGraph::updateEstimation(
 		}
 
 	}  // end calc variances
+}
 
-#else
-	THROW_EXCEPTION("This method requires Eigen 3.1.0 or above");
-#endif
+
+/* Method:
+   H * x_incr = b, with H = J' * Lambda * J, b = - J' * Lambda * r(x)
+   and H = inv(P) * L * D * L' * P   --> SimplicialLDLT.
+
+   The pattern of H only depends on the binary factors, so its symbolic
+   analysis is reused while they do not change.
+*/
+bool ScalarFactorGraph::solveCholesky(
+	Eigen::VectorXd& solved_x_inc, Eigen::VectorXd* solved_variances)
+{
+	Impl& d = *m_impl;
+	const size_t n = m_numNodes;
+	const size_t m2 = m_factors_binary.size();
+
+	// (Re)build the pattern of H, only if the graph changed:
+	// ---------------------------------------------------------
+	bool same_pattern = d.pattern_valid && size_t(d.H.cols()) == n &&
+						d.binary_ids.size() == m2;
+	if (same_pattern)
+	{
+		size_t k = 0;
+		for (const auto& e : m_factors_binary)
+		{
+			ASSERT_(e != nullptr);
+			if (d.binary_ids[k].first != e->node_id_i ||
+				d.binary_ids[k].second != e->node_id_j)
+			{
+				same_pattern = false;
+				break;
+			}
+			++k;
+		}
+	}
+	if (!same_pattern)
+	{
+		mrpt::system::CTimeLoggerEntry tle(m_timelogger, "GMRF.chol_analyze");
+
+		std::vector<Eigen::Triplet<double>> H_tri;
+		H_tri.reserve(n + m2);
+		for (size_t i = 0; i < n; i++)
+			H_tri.push_back(Eigen::Triplet<double>(i, i, .0));
+		d.binary_ids.clear();
+		d.binary_ids.reserve(m2);
+		for (const auto& e : m_factors_binary)
+		{
+			ASSERT_(e != nullptr);
+			ASSERT_(e->node_id_i < n && e->node_id_j < n);
+			d.binary_ids.emplace_back(e->node_id_i, e->node_id_j);
+			H_tri.push_back(
+				Eigen::Triplet<double>(
+					std::min(e->node_id_i, e->node_id_j),
+					std::max(e->node_id_i, e->node_id_j), .0));
+		}
+		d.H.resize(n, n);
+		d.H.setFromTriplets(H_tri.begin(), H_tri.end());
+		d.H.makeCompressed();
+
+		// Upper triangle: the diagonal is the last entry of each column.
+		const int* outer = d.H.outerIndexPtr();
+		const int* inner = d.H.innerIndexPtr();
+		d.diag_pos.resize(n);
+		for (size_t c = 0; c < n; c++) d.diag_pos[c] = outer[c + 1] - 1;
+		d.binary_pos.resize(m2);
+		for (size_t k = 0; k < m2; k++)
+		{
+			const auto& ij = d.binary_ids[k];
+			const int r = std::min(ij.first, ij.second),
+					  c = std::max(ij.first, ij.second);
+			d.binary_pos[k] =
+				std::lower_bound(inner + outer[c], inner + outer[c + 1], r) -
+				inner;
+		}
+
+		d.ldlt.analyzePattern(d.H);
+		d.pattern_valid = true;
+		d.Z_next_col = -1;
+	}
+
+	// Build H and b
+	// -----------------------
+	Eigen::VectorXd b;
+	b.setZero(n);
+	{
+		mrpt::system::CTimeLoggerEntry tle(m_timelogger, "GMRF.chol_build_H");
+
+		double* h = d.H.valuePtr();
+		std::fill(h, h + d.H.nonZeros(), .0);
+		for (const auto& e : m_factors_unary)
+		{
+			ASSERT_(e != nullptr);
+			ASSERT_(e->node_id < n);
+			const double w = e->getInformation();
+			double dr_dx;
+			e->evalJacobian(dr_dx);
+			h[d.diag_pos[e->node_id]] += w * dr_dx * dr_dx;
+			b[e->node_id] -= w * dr_dx * e->evaluateResidual();
+		}
+		size_t k = 0;
+		for (const auto& e : m_factors_binary)
+		{
+			const double w = e->getInformation();
+			double dr_dxi, dr_dxj;
+			e->evalJacobian(dr_dxi, dr_dxj);
+			const size_t i = e->node_id_i, j = e->node_id_j;
+			const double r = e->evaluateResidual();
+			h[d.diag_pos[i]] += w * dr_dxi * dr_dxi;
+			h[d.diag_pos[j]] += w * dr_dxj * dr_dxj;
+			// H(i,j) and H(j,i) share one entry, unless they are both H(i,i)
+			h[d.binary_pos[k]] += (i == j ? 2.0 : 1.0) * w * dr_dxi * dr_dxj;
+			b[i] -= w * dr_dxi * r;
+			b[j] -= w * dr_dxj * r;
+			++k;
+		}
+	}
+
+	// Solve increment
+	// -----------------------
+	{
+		mrpt::system::CTimeLoggerEntry tle(m_timelogger, "GMRF.solve");
+
+		d.ldlt.factorize(d.H);
+		if (d.ldlt.info() != Eigen::Success) return false;
+		// Rank deficient? (e.g. no observations yet, only priors):
+		const auto D = d.ldlt.vectorD();
+		if (!(D.minCoeff() > 1e-12 * D.cwiseAbs().maxCoeff())) return false;
+
+		solved_x_inc = d.ldlt.solve(b);
+	}
+
+	// Recover variances
+	// -----------------------
+	if (solved_variances)
+	{
+		mrpt::system::CTimeLoggerEntry tle(m_timelogger, "GMRF.variance");
+
+		// Takahashi recursions for Z=inv(L*D*L'), only evaluated in the
+		// pattern of L (which is closed under these equations):
+		//  Z(k,j) = - sum_{l>j} L(l,j) * Z(l,k),  for k>j, L(k,j)!=0
+		//  Z(j,j) = 1/D(j) - sum_{k>j} L(k,j) * Z(k,j)
+		const auto D = d.ldlt.vectorD();
+		const auto& L = d.ldlt.matrixL().nestedExpression();
+		ASSERT_(L.isCompressed());
+		const int* Lp = L.outerIndexPtr();
+		const int* Li = L.innerIndexPtr();
+		const double* Lx = L.valuePtr();
+
+		// If the time budget ran out in the previous call, resume the
+		// recursion where it stopped, so all variances are eventually
+		// recovered. The entries of Z of the columns after that one come
+		// from former factorizations, hence they are approximations.
+		const double budget = m_variance_time_budget;
+		std::vector<double>& Zx = d.Zx;
+		std::vector<double>& Zd = d.Zd;
+		int j = static_cast<int>(n) - 1;
+		if (budget > 0 && d.Z_next_col >= 0 && d.Z_next_col < int(n) &&
+			Zx.size() == size_t(L.nonZeros()) && Zd.size() == n)
+			j = d.Z_next_col;
+		else
+		{
+			Zx.assign(L.nonZeros(), .0);
+			Zd.assign(n, std::numeric_limits<double>::quiet_NaN());
+		}
+		const int j_first = j;
+		auto Z = [&](int r, int c) {
+			if (r == c) return Zd[r];
+			if (r < c) std::swap(r, c);
+			return Zx[std::lower_bound(Li + Lp[c], Li + Lp[c + 1], r) - Li];
+		};
+
+		mrpt::system::CTicTac tictac;
+		for (size_t done = 0; j >= 0; j--, done++)
+		{
+			// Check the clock every 64 columns:
+			if (budget > 0 && done > 0 && (done % 64) == 0 &&
+				tictac.Tac() > budget)
+				break;
+
+			const int p0 = Lp[j], p1 = Lp[j + 1];
+			for (int p = p0; p < p1; p++)
+			{
+				double sum = .0;
+				for (int q = p0; q < p1; q++) sum += Lx[q] * Z(Li[q], Li[p]);
+				Zx[p] = -sum;
+			}
+			double sum = .0;
+			for (int p = p0; p < p1; p++) sum += Lx[p] * Zx[p];
+			Zd[j] = 1.0 / D[j] - sum;
+		}
+		d.Z_next_col = j;
+		if (j >= 0)
+			MRPT_LOG_DEBUG_FMT(
+				"Variance time budget exhausted: %i out of %u variances left, "
+				"resuming in the next call.",
+				j + 1, static_cast<unsigned int>(n));
+
+		// Only report the variances computed in this call:
+		solved_variances->resize(n);
+		const auto& P = d.ldlt.permutationP().indices();
+		for (size_t i = 0; i < n; i++)
+			(*solved_variances)[i] =
+				(P[i] <= j_first && P[i] > j)
+					? Zd[P[i]]
+					: std::numeric_limits<double>::quiet_NaN();
+	}
+	return true;
 }
+#endif
@@ -9,6 +9,7 @@
 
 #include <mrpt/graphs/ScalarFactorGraph.h>
 #include <gtest/gtest.h>
+#include <cmath>
 
 using namespace mrpt;
 using namespace mrpt::graphs;
@@ -174,4 +175,195 @@ TEST(ScalarFactorGraph, MiniMRF_BinaryEdges)
 	}
 }
 
+// A 2D grid with 4-neighbors priors and a few observed cells:
+static void solveGridMRF(
+	ScalarFactorGraph::TSolver solver, Eigen::VectorXd& x_incr,
+	Eigen::VectorXd& x_var, bool with_observations = true,
+	double time_budget = 0, Eigen::VectorXd* dense_var = nullptr,
+	size_t num_updates = 1)
+{
+	const size_t W = 13, H = 9, N = W * H;
+	vector<double> my_map(N, .0);
+
+	ScalarFactorGraph gmrf;
+	gmrf.setSolver(solver);
+	gmrf.setVarianceTimeBudget(time_budget);
+	gmrf.initialize(N);
+
+	std::deque<MySimpleBinaryEdge> priors;
+	for (size_t y = 0; y < H; y++)
+		for (size_t x = 0; x < W; x++)
+		{
+			if (x + 1 < W)
+				priors.emplace_back(my_map, y * W + x, y * W + x + 1, 2.0);
+			if (y + 1 < H)
+				priors.emplace_back(my_map, y * W + x, (y + 1) * W + x, 2.0);
+		}
+	for (const auto& e : priors) gmrf.addConstraint(e);
+
+	std::deque<MySimpleUnaryEdge> obs;
+	if (with_observations)
+		for (size_t i = 0; i < N; i += 7)
+			obs.emplace_back(my_map, i, std::sin(0.1 * i), 1.0 + (i % 5));
+	for (const auto& e : obs) gmrf.addConstraint(e);
+
+	gmrf.updateEstimation(x_incr, &x_var);
+	// Further updates (of the same problem) only fill in missing variances:
+	for (size_t k = 1; k < num_updates; k++)
+	{
+		Eigen::VectorXd x_incr2, x_var2;
+		gmrf.updateEstimation(x_incr2, &x_var2);
+		for (int i = 0; i < x_var.size(); i++)
+			if (std::isnan(x_var[i])) x_var[i] = x_var2[i];
+	}
+
+	if (dense_var)
+	{
+		Eigen::MatrixXd Hd = Eigen::MatrixXd::Zero(N, N);
+		for (const auto& e : priors)
+		{
+			Hd(e.node_id_i, e.node_id_i) += 2.0;
+			Hd(e.node_id_j, e.node_id_j) += 2.0;
+			Hd(e.node_id_i, e.node_id_j) -= 2.0;
+			Hd(e.node_id_j, e.node_id_i) -= 2.0;
+		}
+		for (const auto& e : obs)
+			Hd(e.node_id, e.node_id) += e.getInformation();
+		*dense_var = Hd.inverse().diagonal();
+	}
+}
+
+TEST(ScalarFactorGraph, CholeskyMatchesQRAndDenseInverse)
+{
+	Eigen::VectorXd x_qr, var_qr, x_ch, var_ch;
+	solveGridMRF(ScalarFactorGraph::solverSparseQR, x_qr, var_qr);
+	Eigen::VectorXd var_ref;
+	solveGridMRF(
+		ScalarFactorGraph::solverCholesky, x_ch, var_ch, true, 0, &var_ref);
+
+	ASSERT_EQ(x_qr.size(), x_ch.size());
+	ASSERT_EQ(var_ref.size(), var_ch.size());
+	for (int i = 0; i < x_qr.size(); i++)
+	{
+		EXPECT_NEAR(x_qr[i], x_ch[i], 1e-9);
+		EXPECT_NEAR(var_ref[i], var_ch[i], 1e-9);
+	}
+}
+
+TEST(ScalarFactorGraph, CholeskyWarmStartAndErase)
+{
+	const size_t N = 5;
+	vector<double> my_map(N, .0);
+
+	ScalarFactorGraph gmrf;
+	gmrf.initialize(N);
+
+	std::deque<MySimpleBinaryEdge> priors;
+	for (size_t i = 0; i + 1 < N; i++)
+		priors.emplace_back(my_map, i, i + 1, 1.0);
+	for (const auto& e : priors) gmrf.addConstraint(e);
+
+	MySimpleUnaryEdge obs0(my_map, 0, 2.0, 4.0), obs4(my_map, 4, 6.0, 4.0);
+	gmrf.addConstraint(obs0);
+	gmrf.addConstraint(obs4);
+
+	// Dense reference: H = J'*Lambda*J, x = inv(H) * b
+	auto dense_sol = [&](bool with_obs4, Eigen::VectorXd& x) {
+		Eigen::MatrixXd Hd = Eigen::MatrixXd::Zero(N, N);
+		for (size_t i = 0; i + 1 < N; i++)
+		{
+			Hd(i, i) += 1;
+			Hd(i + 1, i + 1) += 1;
+			Hd(i, i + 1) -= 1;
+			Hd(i + 1, i) -= 1;
+		}
+		Hd(0, 0) += 4;
+		Eigen::VectorXd b = Eigen::VectorXd::Zero(N);
+		b[0] = 4 * 2.0;
+		if (with_obs4)
+		{
+			Hd(N - 1, N - 1) += 4;
+			b[N - 1] = 4 * 6.0;
+		}
+		x = Hd.ldlt().solve(b);
+		return Eigen::VectorXd(Hd.inverse().diagonal());
+	};
+
+	for (int iter = 0; iter < 2; iter++)
+	{
+		Eigen::VectorXd x_incr, x_var;
+		gmrf.updateEstimation(x_incr, &x_var);
+		Eigen::VectorXd x_ref;
+		const Eigen::VectorXd ref = dense_sol(true, x_ref);
+		for (size_t i = 0; i < N; i++)
+		{
+			EXPECT_NEAR(x_incr[i], x_ref[i], 1e-9);
+			EXPECT_NEAR(x_var[i], ref[i], 1e-9);
+		}
+	}
+
+	// Removing an observation keeps the pattern of H:
+	EXPECT_TRUE(gmrf.eraseConstraint(obs4));
+	{
+		Eigen::VectorXd x_incr, x_var;
+		gmrf.updateEstimation(x_incr, &x_var);
+		Eigen::VectorXd x_ref;
+		const Eigen::VectorXd ref = dense_sol(false, x_ref);
+		for (size_t i = 0; i < N; i++)
+		{
+			EXPECT_NEAR(x_incr[i], 2.0, 1e-9);
+			EXPECT_NEAR(x_var[i], ref[i], 1e-9);
+		}
+	}
+
+	// Removing a prior changes it (two independent chains now):
+	EXPECT_TRUE(gmrf.eraseConstraint(priors[3]));
+	gmrf.addConstraint(obs4);
+	{
+		Eigen::VectorXd x_incr, x_var;
+		gmrf.updateEstimation(x_incr, &x_var);
+		for (size_t i = 0; i + 1 < N; i++)
+			EXPECT_NEAR(x_incr[i], 2.0, 1e-9);
+		EXPECT_NEAR(x_incr[N - 1], 6.0, 1e-9);
+		EXPECT_NEAR(x_var[N - 1], 1.0 / 4.0, 1e-9);
+	}
+}
+
+TEST(ScalarFactorGraph, CholeskySingularFallsBackToQR)
+{
+	// Only priors: H is singular.
+	Eigen::VectorXd x_qr, var_qr, x_ch, var_ch;
+	solveGridMRF(ScalarFactorGraph::solverSparseQR, x_qr, var_qr, false);
+	solveGridMRF(ScalarFactorGraph::solverCholesky, x_ch, var_ch, false);
+	ASSERT_EQ(x_qr.size(), x_ch.size());
+	for (int i = 0; i < x_qr.size(); i++) EXPECT_EQ(x_qr[i], x_ch[i]);
+}
+
+TEST(ScalarFactorGraph, CholeskyVarianceTimeBudget)
+{
+	Eigen::VectorXd x_ref, var_ref, x_incr, x_var;
+	solveGridMRF(ScalarFactorGraph::solverCholesky, x_ref, var_ref);
+	// A budget so small that only the first batch of variances is computed:
+	solveGridMRF(
+		ScalarFactorGraph::solverCholesky, x_incr, x_var, true, 1e-12);
+
+	size_t nComputed = 0;
+	for (int i = 0; i < x_var.size(); i++)
+	{
+		EXPECT_NEAR(x_incr[i], x_ref[i], 1e-9);
+		if (std::isnan(x_var[i])) continue;
+		EXPECT_NEAR(x_var[i], var_ref[i], 1e-9);
+		nComputed++;
+	}
+	EXPECT_GT(nComputed, 0U);
+	EXPECT_LT(nComputed, size_t(x_var.size()));
+
+	// Each update resumes where the former one stopped, so none is starved:
+	solveGridMRF(
+		ScalarFactorGraph::solverCholesky, x_incr, x_var, true, 1e-12,
+		nullptr, 3);
+	for (int i = 0; i < x_var.size(); i++)
+		EXPECT_NEAR(x_var[i], var_ref[i], 1e-9) << "i=" << i;
+}
+
 #endif  // Eigen>=3.1
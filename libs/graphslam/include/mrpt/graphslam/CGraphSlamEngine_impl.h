@@ -642,6 +642,10 @@ bool CGraphSlamEngine<GRAPH_T>::_execGraphSlamStep(
 		std::lock_guard<std::mutex> graph_lock(m_graph_section);
 
 		m_time_logger.enter("optimizer");
+		std::vector<mrpt::graphs::TPairNodeIDs> new_edges;
+		m_node_reg->fetchNewEdges(&new_edges);
+		m_edge_reg->fetchNewEdges(&new_edges);
+		m_optimizer->notifyOfNewEdges(new_edges);
 		m_optimizer->updateState(action, observations, observation);
 		m_time_logger.leave("optimizer");
 	}
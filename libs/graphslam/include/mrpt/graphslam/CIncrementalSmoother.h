@@ -0,0 +1,196 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/graphslam/types.h>
+#include <mrpt/graphslam/levmarq_impl.h>  // Aux classes
+#include <mrpt/core/aligned_std_map.h>
+#include <mrpt/core/aligned_std_vector.h>
+#include <map>
+#include <set>
+#include <vector>
+
+namespace mrpt::graphslam
+{
+/** Incremental smoothing of a graph of pose constraints (iSAM), for graphs
+ * which grow one node at a time, as in online graph SLAM.
+ *
+ * optimize_graph_spa_levmarq() builds and factorizes the whole Hessian of the
+ * problem on each call. Instead, this class keeps from previous calls to
+ * update() the square-root information matrix `R` of the problem, that is,
+ * the upper triangular Cholesky factor of the Hessian, stored as sparse
+ * blocks of pose size. When new edges are added to the graph, only those rows
+ * of `R` reached by them are updated, by means of Householder QR, and the new
+ * estimate of all the nodes is recovered by a cheap back-substitution. Hence,
+ * the cost of adding odometry-like edges does not depend on the size of the
+ * graph, while loop closures fill in the rows of the nodes in the loop.
+ *
+ * Edges are linearized only once, when they are added. Every
+ * TOptions::relinearize_every calls to update(), or whenever relinearize()
+ * is called, all edges are linearized again at the current estimate and `R`
+ * is rebuilt from scratch, after reordering the nodes with AMD to reduce the
+ * accumulated fill-in.
+ *
+ * \code
+ * mrpt::graphslam::CIncrementalSmoother<CNetworkOfPoses2DInf> isam;
+ * for (...)
+ * {
+ *     graph.nodes[id] = initial_guess;
+ *     graph.insertEdge(id - 1, id, odometry);
+ *     isam.update(graph);  // Updates graph.nodes
+ * }
+ * \endcode
+ *
+ * The root node of the graph (`graph.root`) is kept fixed, and only those
+ * nodes with at least one edge are estimated. Edges must not be removed or
+ * modified in the graph between calls to update(), unless reset() is called.
+ * The new edges can be given explicitly to update(), which then only looks up
+ * those pairs of nodes. Otherwise, update() detects them by counting the
+ * edges between each pair of nodes, which walks all the edges of the graph
+ * whenever their number changed.
+ *
+ * Reference: M. Kaess, A. Ranganathan, F. Dellaert, "iSAM: Incremental
+ * Smoothing and Mapping", IEEE Trans. on Robotics, 2008.
+ *
+ * \tparam GRAPH_T Any of the graph types supported by
+ * optimize_graph_spa_levmarq(). As with it, 3D graphs can not be used yet,
+ * since the SE(3) Jacobians in mrpt::poses::SE_traits<3> are not implemented.
+ * \sa optimize_graph_spa_levmarq(),
+ * mrpt::graphslam::optimizers::CLevMarqGSO
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_graphslam_grp
+ */
+template <class GRAPH_T>
+class CIncrementalSmoother
+{
+   public:
+	using gst = graphslam_traits<GRAPH_T>;
+	using pose_t = typename gst::graph_t::constraint_t::type_value;
+	using edge_t = typename gst::edge_t;
+	using block_t = typename gst::matrix_VxV_t;
+	using Array_O = typename gst::Array_O;
+	constexpr static size_t DIMS_POSE = gst::SE_TYPE::VECTOR_SIZE;
+
+	struct TOptions
+	{
+		/** Relinearize all edges every this number of calls to update(). `0`
+		 * means never, unless relinearize() is explicitly called. */
+		size_t relinearize_every{100};
+		/** Number of Gauss-Newton iterations in each relinearization. */
+		size_t relinearize_iterations{1};
+		/** Reorder the nodes upon relinearization to reduce fill-in.
+		 * Otherwise, nodes are kept in the order they were first seen. */
+		bool reorder{true};
+	};
+	TOptions options;
+
+	/** Information on one call to update() */
+	struct TUpdateStats
+	{
+		size_t new_nodes{0}, new_edges{0};
+		/** Number of (block) rows of `R` changed by the new edges */
+		size_t modified_rows{0};
+		/** Whether all edges were relinearized in this call */
+		bool relinearized{false};
+	};
+
+	/** Incorporates the edges added to `graph` since the last call, and
+	 * updates the poses of all the nodes in `graph.nodes`. The current value
+	 * of new nodes in `graph.nodes` is used as initial guess. */
+	void update(GRAPH_T& graph, TUpdateStats* stats = nullptr);
+
+	/** Like update(), but only incorporates the given edges, with one entry
+	 * for each call to `graph.insertEdge()` since the last update. This
+	 * avoids walking all the edges of `graph`. */
+	void update(
+		GRAPH_T& graph,
+		const std::vector<mrpt::graphs::TPairNodeIDs>& newEdges,
+		TUpdateStats* stats = nullptr);
+
+	/** Relinearizes all edges at the current estimate, rebuilding `R` from
+	 * scratch, and updates the poses in `graph.nodes`. New edges are also
+	 * incorporated, as in update(). */
+	void relinearize(GRAPH_T& graph);
+
+	/** Forgets all nodes and edges, so the next update() starts over. */
+	void reset();
+
+	/** Number of estimated nodes */
+	size_t getNodeCount() const { return m_nodeIDs.size(); }
+	/** Number of edges incorporated so far */
+	size_t getEdgeCount() const { return m_factors.size(); }
+	/** Number of non-zero blocks of size DIMS_POSE^2 in `R` */
+	size_t getNonZeroBlockCount() const;
+
+   private:
+	/** A sparse row of pose blocks, indexed by column */
+	using sparse_row_t = mrpt::aligned_std_map<size_t, block_t>;
+	static constexpr size_t INVALID_IDX = static_cast<size_t>(-1);
+
+	struct TFactor
+	{
+		mrpt::graphs::TPairNodeIDs ids;
+		edge_t edge;
+		/** Index of the nodes in m_nodeIDs, or INVALID_IDX for the root */
+		size_t idx1, idx2;
+	};
+
+	/** Node ID of each estimated node, in elimination order */
+	std::vector<mrpt::graphs::TNodeID> m_nodeIDs;
+	std::map<mrpt::graphs::TNodeID, size_t> m_nodeIdx;
+	/** Linearization point of each node */
+	mrpt::aligned_std_vector<pose_t> m_linPoint;
+	/** Current estimate of each node, as an increment over m_linPoint */
+	mrpt::aligned_std_vector<Array_O> m_delta;
+	/** Rows of R (block-upper triangular) and right-hand vector d, such that
+	 * R * m_delta = d */
+	std::vector<sparse_row_t> m_R;
+	mrpt::aligned_std_vector<Array_O> m_d;
+
+	mrpt::aligned_std_vector<TFactor> m_factors;
+	/** Edges already known between each pair of nodes */
+	std::map<mrpt::graphs::TPairNodeIDs, size_t> m_edgeCount;
+	size_t m_updatesSinceRelinearization{0};
+
+	/** Adds the edges (and their nodes) not seen yet, either those between
+	 * the pairs of nodes in `newEdges` or, if it is null, all of them.
+	 * \return The index of the first new factor in m_factors. */
+	size_t addNewEdges(
+		const GRAPH_T& graph,
+		const std::vector<mrpt::graphs::TPairNodeIDs>* newEdges,
+		TUpdateStats& stats);
+	/** Adds the new edges between one pair of nodes, checking that there are
+	 * `expected` of them (unless it is INVALID_IDX) */
+	void addNewEdgesBetween(
+		const GRAPH_T& graph, const mrpt::graphs::TPairNodeIDs& ids,
+		size_t expected);
+	void doUpdate(
+		GRAPH_T& graph,
+		const std::vector<mrpt::graphs::TPairNodeIDs>* newEdges,
+		TUpdateStats* stats);
+	/** Relinearizes all the factors already in m_factors */
+	void relinearizeAll(GRAPH_T& graph);
+	size_t addNode(const GRAPH_T& graph, mrpt::graphs::TNodeID id);
+	/** Linearizes a factor at m_linPoint and eliminates it into R. \return
+	 * The indices of modified rows are inserted in `modified`. */
+	void addFactorToR(
+		const GRAPH_T& graph, const TFactor& f, std::set<size_t>& modified);
+	/** Computes the variable order that reduces fill-in (AMD) */
+	void reorderNodes();
+	/** Solves R * m_delta = d. If `modifiedRows` is given, only the nodes
+	 * affected by those rows are solved for again. */
+	void backSubstitution(const std::set<size_t>* modifiedRows);
+	/** Nodes whose m_delta changed in the last back-substitution */
+	std::vector<bool> m_changed;
+	void updateGraphNodes(GRAPH_T& graph) const;
+};
+
+}  // namespace mrpt::graphslam
+
+#include "CIncrementalSmoother_impl.h"
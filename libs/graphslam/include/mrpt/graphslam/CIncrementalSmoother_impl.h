@@ -0,0 +1,408 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/math/CSparseMatrix.h>  // CSparse, for AMD ordering
+#include <Eigen/Dense>
+#include <algorithm>
+#include <cmath>
+#include <set>
+
+namespace mrpt::graphslam
+{
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::reset()
+{
+	m_nodeIDs.clear();
+	m_nodeIdx.clear();
+	m_linPoint.clear();
+	m_delta.clear();
+	m_R.clear();
+	m_d.clear();
+	m_factors.clear();
+	m_edgeCount.clear();
+	m_updatesSinceRelinearization = 0;
+}
+
+template <class GRAPH_T>
+size_t CIncrementalSmoother<GRAPH_T>::getNonZeroBlockCount() const
+{
+	size_t n = 0;
+	for (const auto& row : m_R) n += row.size();
+	return n;
+}
+
+template <class GRAPH_T>
+size_t CIncrementalSmoother<GRAPH_T>::addNode(
+	const GRAPH_T& graph, mrpt::graphs::TNodeID id)
+{
+	if (id == graph.root) return INVALID_IDX;
+	const auto it = m_nodeIdx.find(id);
+	if (it != m_nodeIdx.end()) return it->second;
+
+	const auto itP = graph.nodes.find(id);
+	ASSERTMSG_(
+		itP != graph.nodes.end(),
+		mrpt::format("Edge node %u has no global pose", (unsigned)id));
+
+	const size_t idx = m_nodeIDs.size();
+	m_nodeIDs.push_back(id);
+	m_nodeIdx[id] = idx;
+	m_linPoint.push_back(itP->second);
+	Array_O zero;
+	zero.fill(0);
+	m_delta.push_back(zero);
+	m_d.push_back(zero);
+	m_R.emplace_back();
+	return idx;
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::addNewEdgesBetween(
+	const GRAPH_T& graph, const mrpt::graphs::TPairNodeIDs& ids,
+	size_t expected)
+{
+	// Edges with the same pair of IDs are consecutive in the multimap, and new
+	// ones are inserted after the existing ones:
+	const auto range = graph.edges.equal_range(ids);
+	size_t& known = m_edgeCount[ids];
+	size_t k = 0;
+	for (auto it = range.first; it != range.second; ++it, ++k)
+	{
+		if (k < known) continue;
+		TFactor f;
+		f.ids = ids;
+		f.edge = it->second;
+		f.idx1 = addNode(graph, ids.first);
+		f.idx2 = addNode(graph, ids.second);
+		m_factors.push_back(f);
+	}
+	ASSERTMSG_(
+		k >= known,
+		mrpt::format(
+			"Edges between %u and %u were removed from the graph: call "
+			"reset() first",
+			(unsigned)ids.first, (unsigned)ids.second));
+	ASSERTMSG_(
+		expected == INVALID_IDX || k - known == expected,
+		mrpt::format(
+			"Expected %u new edges between %u and %u, found %u",
+			(unsigned)expected, (unsigned)ids.first, (unsigned)ids.second,
+			(unsigned)(k - known)));
+	known = k;
+}
+
+template <class GRAPH_T>
+size_t CIncrementalSmoother<GRAPH_T>::addNewEdges(
+	const GRAPH_T& graph,
+	const std::vector<mrpt::graphs::TPairNodeIDs>* newEdges,
+	TUpdateStats& stats)
+{
+	const size_t first = m_factors.size(), nNodes0 = m_nodeIDs.size();
+	if (newEdges)
+	{
+		// Only look up the given pairs of nodes: O(k log(E))
+		std::map<mrpt::graphs::TPairNodeIDs, size_t> count;
+		for (const auto& ids : *newEdges) count[ids]++;
+		for (const auto& c : count)
+			addNewEdgesBetween(graph, c.first, c.second);
+	}
+	else
+	{
+		// Edges are never removed, so if the count did not change there is
+		// nothing new and we can skip walking all the edges:
+		ASSERTMSG_(
+			graph.edges.size() >= m_factors.size(),
+			"Edges were removed from the graph: call reset() first");
+		if (graph.edges.size() != m_factors.size())
+		{
+			for (auto it = graph.edges.begin(); it != graph.edges.end();
+				 it = graph.edges.upper_bound(it->first))
+				addNewEdgesBetween(graph, it->first, INVALID_IDX);
+		}
+	}
+	stats.new_edges = m_factors.size() - first;
+	stats.new_nodes = m_nodeIDs.size() - nNodes0;
+	return first;
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::addFactorToR(
+	const GRAPH_T& graph, const TFactor& f, std::set<size_t>& modified)
+{
+	constexpr size_t D = DIMS_POSE;
+	// The root is not estimated: use its value in the graph.
+	auto getPose = [&](size_t idx, mrpt::graphs::TNodeID id) -> const pose_t& {
+		if (idx != INVALID_IDX) return m_linPoint[idx];
+		return graph.nodes.at(id);
+	};
+	const pose_t& P1 = getPose(f.idx1, f.ids.first);
+	const pose_t& P2 = getPose(f.idx2, f.ids.second);
+	const pose_t& EDGE_POSE = f.edge.getPoseMean();
+
+	// Error and Jacobians at the linearization point, as in
+	// computeJacobiansAndErrors():
+	Array_O err;
+	detail::AuxErrorEval<edge_t, gst>::computePseudoLnError(
+		(P2 - P1) - EDGE_POSE, err, f.edge);
+	block_t J1, J2;
+	gst::SE_TYPE::jacobian_dDinvP1invP2_depsilon(
+		-EDGE_POSE, P1, P2, &J1, &J2);
+	detail::AuxErrorEval<edge_t, gst>::whiten(J1, J2, err, f.edge);
+
+	// The new rows of the system: J1*delta1 + J2*delta2 = -err
+	sparse_row_t row;
+	if (f.idx1 != INVALID_IDX) row[f.idx1] = J1;
+	if (f.idx2 != INVALID_IDX)
+	{
+		if (row.count(f.idx2))
+			row[f.idx2] += J2;
+		else
+			row[f.idx2] = J2;
+	}
+	Array_O b;
+	b = -err;
+
+	// Eliminate the new rows, leftmost block first, by stacking them below
+	// the row of R for that block and applying QR:
+	Eigen::MatrixXd M;
+	std::vector<size_t> cols;
+	while (!row.empty())
+	{
+		const size_t c = row.begin()->first;
+		sparse_row_t& Rc = m_R[c];
+		modified.insert(c);
+
+		cols.clear();
+		for (const auto& blk : Rc) cols.push_back(blk.first);
+		for (const auto& blk : row) cols.push_back(blk.first);
+		std::sort(cols.begin(), cols.end());
+		cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+		ASSERTDEB_(cols[0] == c);
+
+		const size_t nCols = cols.size() * D + 1;
+		M.setZero(2 * D, nCols);
+		for (size_t k = 0; k < cols.size(); k++)
+		{
+			const auto itR = Rc.find(cols[k]);
+			if (itR != Rc.end()) M.block<D, D>(0, k * D) = itR->second;
+			const auto itA = row.find(cols[k]);
+			if (itA != row.end()) M.block<D, D>(D, k * D) = itA->second;
+		}
+		M.block<D, 1>(0, nCols - 1) = m_d[c];
+		M.block<D, 1>(D, nCols - 1) = b;
+
+		const Eigen::HouseholderQR<Eigen::MatrixXd> qr(M.leftCols<D>());
+		M.applyOnTheLeft(qr.householderQ().adjoint());
+
+		Rc.clear();
+		row.clear();
+		for (size_t k = 0; k < cols.size(); k++)
+		{
+			Rc[cols[k]] = M.block<D, D>(0, k * D);
+			// The first block of the bottom rows is now zero:
+			if (k > 0 && M.block<D, D>(D, k * D).squaredNorm() > 0)
+				row[cols[k]] = M.block<D, D>(D, k * D);
+		}
+		Rc[c].template triangularView<Eigen::StrictlyLower>().setZero();
+		m_d[c] = M.block<D, 1>(0, nCols - 1);
+		b = M.block<D, 1>(D, nCols - 1);
+	}
+	// What is left in "b" is the residual of the least-squares problem.
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::backSubstitution(
+	const std::set<size_t>* modifiedRows)
+{
+	constexpr size_t D = DIMS_POSE;
+	const size_t N = m_nodeIDs.size();
+	m_changed.assign(N, modifiedRows == nullptr);
+	if (modifiedRows)
+		for (const size_t i : *modifiedRows) m_changed[i] = true;
+
+	for (size_t i = N; i-- > 0;)
+	{
+		// Row "i" only needs to be solved again if it changed, or if any of
+		// the nodes it depends on did:
+		bool dirty = m_changed[i];
+		for (auto it = m_R[i].rbegin(); !dirty && it != m_R[i].rend(); ++it)
+			dirty = m_changed[it->first];
+		if (!dirty) continue;
+
+		Array_O r = m_d[i];
+		const block_t* Rii = nullptr;
+		for (const auto& blk : m_R[i])
+		{
+			if (blk.first == i)
+				Rii = &blk.second;
+			else
+				r -= blk.second * m_delta[blk.first];
+		}
+		// Triangular solve. Directions not constrained by any edge (zero
+		// diagonal) are left unchanged:
+		Array_O x;
+		x.fill(0);
+		for (size_t k = D; Rii && k-- > 0;)
+		{
+			double s = r[k];
+			for (size_t l = k + 1; l < D; l++) s -= (*Rii)(k, l) * x[l];
+			const double diag = (*Rii)(k, k);
+			x[k] = std::abs(diag) > 1e-12 ? s / diag : 0;
+		}
+		m_changed[i] = (x != m_delta[i]);
+		m_delta[i] = x;
+	}
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::updateGraphNodes(GRAPH_T& graph) const
+{
+	for (size_t i = 0; i < m_nodeIDs.size(); i++)
+	{
+		if (!m_changed[i]) continue;
+		pose_t p = m_linPoint[i];
+		detail::AuxPoseOPlus<edge_t, gst>::sumIncr(p, m_delta[i]);
+		// Keep the node annotations, if any:
+		static_cast<pose_t&>(graph.nodes[m_nodeIDs[i]]) = p;
+	}
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::reorderNodes()
+{
+	const size_t N = m_nodeIDs.size();
+	if (N < 3) return;
+
+	// Symmetric sparsity pattern of the Hessian, one entry per pose block:
+	cs* T = cs_spalloc(N, N, N + 2 * m_factors.size(), 1, 1);
+	for (size_t i = 0; i < N; i++) cs_entry(T, i, i, 1);
+	for (const auto& f : m_factors)
+		if (f.idx1 != INVALID_IDX && f.idx2 != INVALID_IDX)
+		{
+			cs_entry(T, f.idx1, f.idx2, 1);
+			cs_entry(T, f.idx2, f.idx1, 1);
+		}
+	cs* C = cs_compress(T);
+	cs_spfree(T);
+	auto* P = cs_amd(1 /* Cholesky */, C);
+	cs_spfree(C);
+	ASSERT_(P != nullptr);
+
+	// P[k] is the old index of the node at position "k":
+	std::vector<size_t> old2new(N);
+	std::vector<mrpt::graphs::TNodeID> nodeIDs(N);
+	mrpt::aligned_std_vector<pose_t> linPoint(N);
+	for (size_t k = 0; k < N; k++)
+	{
+		const size_t old = static_cast<size_t>(P[k]);
+		old2new[old] = k;
+		nodeIDs[k] = m_nodeIDs[old];
+		linPoint[k] = m_linPoint[old];
+		m_nodeIdx[nodeIDs[k]] = k;
+	}
+	cs_free(P);
+	m_nodeIDs.swap(nodeIDs);
+	m_linPoint.swap(linPoint);
+	for (auto& f : m_factors)
+	{
+		if (f.idx1 != INVALID_IDX) f.idx1 = old2new[f.idx1];
+		if (f.idx2 != INVALID_IDX) f.idx2 = old2new[f.idx2];
+	}
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::relinearize(GRAPH_T& graph)
+{
+	TUpdateStats stats;
+	addNewEdges(graph, nullptr, stats);
+	relinearizeAll(graph);
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::relinearizeAll(GRAPH_T& graph)
+{
+	MRPT_START
+
+	const size_t N = m_nodeIDs.size();
+	Array_O zero;
+	zero.fill(0);
+	const size_t nIters = std::max<size_t>(1, options.relinearize_iterations);
+	for (size_t iter = 0; iter < nIters; iter++)
+	{
+		// New linearization point: the current estimate
+		for (size_t i = 0; i < N; i++)
+			m_linPoint[i] = graph.nodes.at(m_nodeIDs[i]);
+		if (iter == 0 && options.reorder) reorderNodes();
+
+		m_R.assign(N, sparse_row_t());
+		m_d.assign(N, zero);
+		m_delta.assign(N, zero);
+		std::set<size_t> modified;
+		for (const auto& f : m_factors) addFactorToR(graph, f, modified);
+
+		backSubstitution(nullptr);
+		updateGraphNodes(graph);
+	}
+	m_updatesSinceRelinearization = 0;
+
+	MRPT_END
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::update(
+	GRAPH_T& graph, TUpdateStats* out_stats)
+{
+	doUpdate(graph, nullptr, out_stats);
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::update(
+	GRAPH_T& graph, const std::vector<mrpt::graphs::TPairNodeIDs>& newEdges,
+	TUpdateStats* out_stats)
+{
+	doUpdate(graph, &newEdges, out_stats);
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::doUpdate(
+	GRAPH_T& graph, const std::vector<mrpt::graphs::TPairNodeIDs>* newEdges,
+	TUpdateStats* out_stats)
+{
+	MRPT_START
+
+	TUpdateStats stats;
+	const size_t first = addNewEdges(graph, newEdges, stats);
+
+	if (options.relinearize_every &&
+		++m_updatesSinceRelinearization >= options.relinearize_every)
+	{
+		relinearizeAll(graph);
+		stats.modified_rows = m_nodeIDs.size();
+		stats.relinearized = true;
+		if (out_stats) *out_stats = stats;
+		return;
+	}
+
+	std::set<size_t> modified;
+	for (size_t i = first; i < m_factors.size(); i++)
+		addFactorToR(graph, m_factors[i], modified);
+	stats.modified_rows = modified.size();
+
+	if (!modified.empty())
+	{
+		backSubstitution(&modified);
+		updateGraphNodes(graph);
+	}
+	if (out_stats) *out_stats = stats;
+
+	MRPT_END
+}
+
+}  // namespace mrpt::graphslam
@@ -19,6 +19,7 @@
 #include <mrpt/poses/CPose3D.h>
 
 #include <mrpt/graphslam/levmarq.h>
+#include <mrpt/graphslam/CIncrementalSmoother.h>
 #include <mrpt/graphslam/interfaces/CGraphSlamOptimizer.h>
 
 #include <iostream>
@@ -68,6 +69,25 @@ namespace mrpt::graphslam::optimizers
  *  graph node are optimized according to the corresponding constraints between
  *  them
  *
+ * - \b incremental_optimization
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : FALSE
+ *  + \a Required      : FALSE
+ *  + \a Description   : Instead of re-running Levenberg-Marquardt on the nodes
+ *  within \b optimization_distance after each new node, update the
+ *  estimate of the whole graph incrementally with
+ *  mrpt::graphslam::CIncrementalSmoother, whose cost depends on the number
+ *  of nodes affected by the new edges rather than on the graph size. Full
+ *  optimizations upon loop closures still use Levenberg-Marquardt.
+ *
+ * - \b incremental_relinearize_every
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 100
+ *  + \a Required      : FALSE
+ *  + \a Description   : Only if \b incremental_optimization is set: number
+ *  of updates between relinearizations of all edges. See
+ *  mrpt::graphslam::CIncrementalSmoother::TOptions::relinearize_every
+ *
  * - \b verbose
  *  + \a Section       : OptimizerParameters
  *  + \a Default value : FALSE
@@ -180,6 +200,10 @@ class CLevMarqGSO
 		// nodeID difference for an edge to be considered loop closure
 		int LC_min_nodeid_diff;
 
+		/**\brief Use CIncrementalSmoother for partial optimizations */
+		bool incremental_optimization{false};
+		size_t incremental_relinearize_every{100};
+
 		// Map of TPairNodesID to their corresponding edge as recorded in the
 		// last update of the optimizer state
 		typename GRAPH_T::edges_map_t last_pair_nodes_to_edge;
@@ -213,6 +237,8 @@ class CLevMarqGSO
 	void getDescriptiveReport(std::string* report_str) const;
 
 	bool justFullyOptimizedGraph() const;
+	void notifyOfNewEdges(
+		const std::vector<mrpt::graphs::TPairNodeIDs>& new_edges);
 
 	// Public members
 	// ////////////////////////////
@@ -393,6 +419,12 @@ class CLevMarqGSO
 
 	/**\brief Minimum number of nodes before we try optimizing the graph */
 	size_t m_min_nodes_for_optimization;
+
+	/**\brief Incremental optimizer, used if
+	 * OptimizationParams::incremental_optimization is set */
+	mrpt::graphslam::CIncrementalSmoother<GRAPH_T> m_smoother;
+	/** Edges registered since the last update of m_smoother */
+	std::vector<mrpt::graphs::TPairNodeIDs> m_smoother_new_edges;
 };
 }
 #include "CLevMarqGSO_impl.h"
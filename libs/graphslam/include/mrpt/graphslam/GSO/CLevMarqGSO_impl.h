@@ -430,6 +430,28 @@ void CLevMarqGSO<GRAPH_T>::_optimizeGraph(bool is_full_update /*=false*/)
 	mrpt::system::CTicTac optimization_timer;
 	optimization_timer.Tic();
 
+	if (opt_params.incremental_optimization && !is_full_update)
+	{
+		// Only update the nodes affected by the new edges:
+		m_smoother.options.relinearize_every =
+			opt_params.incremental_relinearize_every;
+		// Pass the new edges explicitly, so the smoother does not walk all
+		// of them, unless some were inserted without notifying us:
+		if (m_smoother.getEdgeCount() + m_smoother_new_edges.size() ==
+			this->m_graph->edgeCount())
+			m_smoother.update(*(this->m_graph), m_smoother_new_edges);
+		else
+			m_smoother.update(*(this->m_graph));
+		m_smoother_new_edges.clear();
+		m_just_fully_optimized_graph = false;
+
+		this->logFmt(
+			mrpt::system::LVL_DEBUG, "Incremental optimization took: %fs",
+			optimization_timer.Tac());
+		this->m_time_logger.leave("CLevMarqGSO::_optimizeGraph");
+		return;
+	}
+
 	// set of nodes for which the optimization procedure will take place
 	std::set<mrpt::graphs::TNodeID>* nodes_to_optimize;
 
@@ -466,6 +488,12 @@ void CLevMarqGSO<GRAPH_T>::_optimizeGraph(bool is_full_update /*=false*/)
 	if (is_full_update)
 	{
 		m_just_fully_optimized_graph = true;
+		// Restart incremental updates from the optimized graph:
+		if (opt_params.incremental_optimization)
+		{
+			m_smoother.relinearize(*(this->m_graph));
+			m_smoother_new_edges.clear();
+		}
 	}
 	else
 	{
@@ -617,6 +645,15 @@ bool CLevMarqGSO<GRAPH_T>::justFullyOptimizedGraph() const
 	return m_just_fully_optimized_graph;
 }
 
+template <class GRAPH_T>
+void CLevMarqGSO<GRAPH_T>::notifyOfNewEdges(
+	const std::vector<mrpt::graphs::TPairNodeIDs>& new_edges)
+{
+	if (!opt_params.incremental_optimization) return;
+	m_smoother_new_edges.insert(
+		m_smoother_new_edges.end(), new_edges.begin(), new_edges.end());
+}
+
 template <class GRAPH_T>
 void CLevMarqGSO<GRAPH_T>::levMarqFeedback(
 	const GRAPH_T& graph, const size_t iter, const size_t max_iter,
@@ -749,6 +786,8 @@ void CLevMarqGSO<GRAPH_T>::OptimizationParams::dumpToTextStream(
 		<< (optimization_on_second_thread ? "TRUE" : "FALSE") << std::endl;
 	out << "Optimize nodes in distance     = " << optimization_distance << "\n";
 	out << "Min. node difference for LC    = " << LC_min_nodeid_diff << "\n";
+	out << "Incremental optimization       = "
+		<< (incremental_optimization ? "TRUE" : "FALSE") << std::endl;
 	out << cfg.getAsString() << std::endl;
 	MRPT_END;
 }
@@ -769,6 +808,11 @@ void CLevMarqGSO<GRAPH_T>::OptimizationParams::loadFromConfigFile(
 		format(
 			"Invalid value for optimization distance: %.2f",
 			optimization_distance));
+	incremental_optimization = source.read_bool(
+		section, "incremental_optimization", incremental_optimization, false);
+	incremental_relinearize_every = source.read_uint64_t(
+		section, "incremental_relinearize_every",
+		incremental_relinearize_every, false);
 
 	// optimization parameters
 	cfg["verbose"] = source.read_bool(section, "verbose", 0, false);
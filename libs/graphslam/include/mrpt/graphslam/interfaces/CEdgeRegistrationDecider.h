@@ -19,6 +19,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 namespace mrpt::graphslam::deciders
 {
@@ -72,6 +73,16 @@ class CEdgeRegistrationDecider
 	 * last edge registration procedure.
 	 */
 	virtual bool justInsertedLoopClosure() const { return m_just_inserted_lc; }
+	/**\brief Append the node pairs of the edges registered since the last
+	 * call to the given vector, so that the optimizer can be notified of
+	 * them.
+	 */
+	void fetchNewEdges(std::vector<mrpt::graphs::TPairNodeIDs>* new_edges)
+	{
+		new_edges->insert(
+			new_edges->end(), m_new_edges.begin(), m_new_edges.end());
+		m_new_edges.clear();
+	}
 	virtual void getDescriptiveReport(std::string* report_str) const;
 
    protected:
@@ -96,13 +107,15 @@ class CEdgeRegistrationDecider
 	/**\brief Register a new constraint/edge in the current graph.
 	 *
 	 * Implementations of this class should provide a wrapper around
-	 * GRAPH_T::insertEdge method.
+	 * GRAPH_T::insertEdge method, and call this one as well.
  */
 	virtual void registerNewEdge(
 		const mrpt::graphs::TNodeID& from, const mrpt::graphs::TNodeID& to,
 		const constraint_t& rel_edge);
 
 	bool m_just_inserted_lc;
+	/**\brief Edges registered since the last call to fetchNewEdges() */
+	std::vector<mrpt::graphs::TPairNodeIDs> m_new_edges;
 	/**\brief Indicates whether the ERD implementation expects, at most one
 	 * single node to be registered, between successive calls to the
 	 * updateState method.
@@ -47,6 +47,8 @@ void CEdgeRegistrationDecider<GRAPH_T>::registerNewEdge(
 {
 	using namespace std;
 
+	m_new_edges.emplace_back(from, to);
+
 	MRPT_LOG_DEBUG_STREAM(
 		"Registering new edge: " << from << " => " << to << endl
 								 << "\tRelative Edge: "
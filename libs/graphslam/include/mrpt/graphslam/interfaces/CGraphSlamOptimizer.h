@@ -64,6 +64,13 @@ class CGraphSlamOptimizer
 	 * on the latest optimizer run
 	 */
 	virtual bool justFullyOptimizedGraph() const { return false; }
+	/**\brief Used by the caller to pass the node pairs of the edges
+	 * registered in the graph since the last call to updateState().
+	 */
+	virtual void notifyOfNewEdges(
+		const std::vector<mrpt::graphs::TPairNodeIDs>& new_edges)
+	{
+	}
 
    protected:
 	/**\brief method called for optimizing the underlying graph.
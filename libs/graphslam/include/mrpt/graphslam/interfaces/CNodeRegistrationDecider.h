@@ -16,6 +16,8 @@
 
 #include "CRegistrationDeciderOrOptimizer.h"
 
+#include <vector>
+
 namespace mrpt::graphslam::deciders
 {
 /**\brief Interface for implementing node registration classes.
@@ -73,6 +75,16 @@ class CNodeRegistrationDecider
 		mrpt::obs::CSensoryFrame::Ptr observations,
 		mrpt::obs::CObservation::Ptr observation) = 0;
 	virtual void getDescriptiveReport(std::string* report_str) const;
+	/**\brief Append the node pairs of the edges registered since the last
+	 * call to the given vector, so that the optimizer can be notified of
+	 * them.
+	 */
+	void fetchNewEdges(std::vector<mrpt::graphs::TPairNodeIDs>* new_edges)
+	{
+		new_edges->insert(
+			new_edges->end(), m_new_edges.begin(), m_new_edges.end());
+		m_new_edges.clear();
+	}
 
    protected:
 	/**\brief Reset the given PDF method and assign a fixed high-certainty
@@ -129,6 +141,8 @@ class CNodeRegistrationDecider
 	 * (initial) pose
 	 */
 	inf_mat_t m_init_inf_mat;
+	/**\brief Edges registered since the last call to fetchNewEdges() */
+	std::vector<mrpt::graphs::TPairNodeIDs> m_new_edges;
 };
 }
 #include "CNodeRegistrationDecider_impl.h"
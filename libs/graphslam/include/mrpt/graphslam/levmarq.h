@@ -11,8 +11,7 @@
 
 #include <mrpt/graphslam/types.h>
 #include <mrpt/system/TParameters.h>
-#include <mrpt/containers/stl_containers_utils.h>  // find_in_vector()
-#include <mrpt/core/aligned_std_map.h>
+#include <mrpt/core/aligned_std_vector.h>
 #include <mrpt/graphslam/levmarq_impl.h>  // Aux classes
 #include <mrpt/system/CTimeLogger.h>
 #include <mrpt/math/CSparseMatrix.h>
@@ -59,6 +58,14 @@ namespace mrpt::graphslam
  *		- "e2": (default=1e-6) Lev-marq algorithm iteration stopping criterion
  *#2:
  *|delta_incr| < e2*(x_norm+e2)
+ *		- "num_threads": (default=0) Maximum number of threads used to
+ *evaluate the Jacobians and to build the Hessian. 0 means as many as the
+ *concurrency of mrpt::system::TaskScheduler, 1 disables parallelism.
+ *
+ * The sparse structure of the Hessian is built only once, and each one of its
+ *blocks of DIMS_POSE x DIMS_POSE is then evaluated (in parallel) by adding up
+ *the contributions of its edges, directly into the column-compressed storage
+ *of the matrix. Results do not depend on the number of threads.
  *
  * \note The following graph types are supported:
  *mrpt::graphs::CNetworkOfPoses2D, mrpt::graphs::CNetworkOfPoses3D,
@@ -111,6 +118,8 @@ void optimize_graph_spa_levmarq(
 	const double tau = extra_params.getWithDefaultVal("tau", 1e-3);
 	const double e1 = extra_params.getWithDefaultVal("e1", 1e-6);
 	const double e2 = extra_params.getWithDefaultVal("e2", 1e-6);
+	const auto num_threads =
+		static_cast<size_t>(extra_params.getWithDefaultVal("num_threads", 0));
 
 	mrpt::system::CTimeLogger profiler(enable_profiler);
 	profiler.enter("optimize_graph_spa_levmarq (entire)");
@@ -203,8 +212,8 @@ void optimize_graph_spa_levmarq(
 	// The list of Jacobians: for each constraint i->j,
 	//  we need the pair of Jacobians: { dh(xi,xj)_dxi, dh(xi,xj)_dxj },
 	//  which are "first" and "second" in each pair.
-	// Index of the map are the node IDs {i,j} for each contraint.
-	typename gst::map_pairIDs_pairJacobs_t lstJacobians;
+	// In the same order than lstObservationData.
+	typename gst::vector_pairJacobs_t lstJacobians;
 	// The vector of errors: err_k = SE(2/3)::pseudo_Ln( P_i * EDGE_ij *
 	// inv(P_j) )
 	// Separated vectors for each edge. i \in [0,nObservations-1], in
@@ -216,7 +225,7 @@ void optimize_graph_spa_levmarq(
 	// ===================================
 	profiler.enter("optimize_graph_spa_levmarq.Jacobians&err");
 	double total_sqr_err = computeJacobiansAndErrors<GRAPH_T>(
-		graph, lstObservationData, lstJacobians, errs);
+		graph, lstObservationData, lstJacobians, errs, num_threads);
 	profiler.leave("optimize_graph_spa_levmarq.Jacobians&err");
 
 	// Only once (since this will be static along iterations), build a quick
@@ -227,24 +236,38 @@ void optimize_graph_spa_levmarq(
 	vector<pair<size_t, size_t>> obsIdx2fnIdx;
 	// "relatedFreeNodeIndex" is in [0,nFreeNodes-1], or "-1" if that node
 	// is fixed, as defined by "nodes_to_optimize"
-	obsIdx2fnIdx.reserve(nObservations);
-	ASSERTDEB_(lstJacobians.size() == nObservations);
-	for (typename gst::map_pairIDs_pairJacobs_t::const_iterator itJ =
-			 lstJacobians.begin();
-		 itJ != lstJacobians.end(); ++itJ)
 	{
-		const TNodeID id1 = itJ->first.first;
-		const TNodeID id2 = itJ->first.second;
-		obsIdx2fnIdx.push_back(std::make_pair(
-			mrpt::containers::find_in_vector(id1, *nodes_to_optimize),
-			mrpt::containers::find_in_vector(id2, *nodes_to_optimize)));
+		std::map<TNodeID, size_t> freeNodeIdx;
+		for (const auto id : *nodes_to_optimize)
+			freeNodeIdx.emplace_hint(
+				freeNodeIdx.end(), id, freeNodeIdx.size());
+		auto freeIdx = [&freeNodeIdx](const TNodeID id) {
+			const auto it = freeNodeIdx.find(id);
+			return it == freeNodeIdx.end() ? string::npos : it->second;
+		};
+		obsIdx2fnIdx.reserve(nObservations);
+		for (const auto& obs : lstObservationData)
+			obsIdx2fnIdx.emplace_back(
+				freeIdx(obs.edge->first.first),
+				freeIdx(obs.edge->first.second));
 	}
 
+	// Also static: the sparse structure of the Hessian, and the sparse matrix
+	// itself, whose values are overwritten on each iteration.
+	// Note: we only need to fill out the upper diagonal part, since
+	// Cholesky will later on ignore the other part.
+	profiler.enter("optimize_graph_spa_levmarq.sp_H:structure");
+	detail::THessianLayout layout;
+	CSparseMatrix sp_H;
+	layout.build(obsIdx2fnIdx, nFreeNodes, DIMS_POSE, sp_H);
+	const size_t nBlocks = layout.blocks.size();
+	profiler.leave("optimize_graph_spa_levmarq.sp_H:structure");
+
 	// other important vars for the main loop:
 	CVectorDouble grad(nFreeNodes * DIMS_POSE);
 	grad.setZero();
-	using map_ID2matrix_VxV_t =
-		mrpt::aligned_std_map<TNodeID, typename gst::matrix_VxV_t>;
+	// Blocks of H, in the order of layout.blocks:
+	mrpt::aligned_std_vector<typename gst::matrix_VxV_t> H_blocks(nBlocks);
 
 	double lambda = initial_lambda;  // Will be actually set on first iteration.
 	double v = 1;  // was 2, changed since it's modified in the first pass.
@@ -259,7 +282,6 @@ void optimize_graph_spa_levmarq(
 
 	for (size_t iter = 0; iter < max_iters; ++iter)
 	{
-		vector<map_ID2matrix_VxV_t> H_map(nFreeNodes);
 		last_iter = iter;
 
 		// This will be false only when the delta leads to a worst solution and
@@ -279,48 +301,28 @@ void optimize_graph_spa_levmarq(
 			mrpt::aligned_std_vector<typename gst::Array_O> grad_parts(
 				nFreeNodes, array_O_zeros);
 
-			// "lstJacobians" is sorted in the same order than
-			// "lstObservationData":
-			ASSERTDEB_EQUAL_(lstJacobians.size(), lstObservationData.size());
-			{
-				size_t idx_obs;
-				typename gst::map_pairIDs_pairJacobs_t::const_iterator itJ;
-
-				for (idx_obs = 0, itJ = lstJacobians.begin();
-					 itJ != lstJacobians.end(); ++itJ, ++idx_obs)
-				{
-					// make sure they're in the expected order!
-					ASSERTDEB_(
-						itJ->first == lstObservationData[idx_obs].edge->first);
-
-					//  grad[k] += J^t_{i->k} * Inf.Matrix * errs_i
-					//    k: [0,nFreeNodes-1]     <-- IDs.first & IDs.second
-					//    i: [0,nObservations-1]  <--- idx_obs
-
-					// Get the corresponding indices in the vector of "free
-					// variables" being optimized:
-					const size_t idx1 = obsIdx2fnIdx[idx_obs].first;
-					const size_t idx2 = obsIdx2fnIdx[idx_obs].second;
-
-					if (idx1 != string::npos)
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiply_Jt_W_err(
-								itJ->second.first /* J */,
-								lstObservationData[idx_obs].edge /* W */,
-								errs[idx_obs] /* err */,
-								grad_parts[idx1] /* out */
-							);
-
-					if (idx2 != string::npos)
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiply_Jt_W_err(
-								itJ->second.second /* J */,
-								lstObservationData[idx_obs].edge /* W */,
-								errs[idx_obs] /* err */,
-								grad_parts[idx2] /* out */
-							);
-				}
-			}
+			mrpt::system::parallel_for_chunks(
+				nFreeNodes,
+				[&](const size_t first, const size_t last) {
+					for (size_t i = first; i < last; i++)
+						for (size_t c = layout.grad_ptr[i];
+							 c < layout.grad_ptr[i + 1]; c++)
+						{
+							//  grad[i] += J^t_{k->i} * Inf.Matrix * errs_k
+							const auto& ctr = layout.grad_contribs[c];
+							const auto& J = lstJacobians[ctr.obs];
+							detail::AuxErrorEval<typename gst::edge_t, gst>::
+								multiply_Jt_W_err(
+									ctr.kind == detail::THessianLayout::J1t_err
+										? J.first
+										: J.second /* J */,
+									lstObservationData[ctr.obs].edge /* W */,
+									errs[ctr.obs] /* err */,
+									grad_parts[i] /* out */
+								);
+						}
+				},
+				num_threads);
 
 			// build the gradient as a single vector:
 			::memcpy(
@@ -343,80 +345,67 @@ void optimize_graph_spa_levmarq(
 				break;
 			}
 
-			profiler.enter("optimize_graph_spa_levmarq.sp_H:build map");
+			profiler.enter("optimize_graph_spa_levmarq.sp_H:blocks");
 			// ======================================================================
-			// Build sparse representation of the upper triangular part of
-			//  the Hessian matrix H = J^t * J
-			//
-			// Sparse memory structure is a vector of maps, such as:
-			//  - H_map[i]: corresponds to the i'th column of H.
-			//              Here "i" corresponds to [0,N-1] indices of
-			//              appearance in the map "*nodes_to_optimize".
-			//  - H_map[i][j] is the entry for the j'th row, with "j" also in
-			//  the range [0,N-1] as ordered in "*nodes_to_optimize".
+			// Evaluate each block of the upper triangular part of the Hessian
+			// matrix H = J^t * J, from its list of contributions (see
+			// detail::THessianLayout).
 			// ======================================================================
-			{
-				size_t idxObs;
-				typename gst::map_pairIDs_pairJacobs_t::const_iterator
-					itJacobPair;
-
-				for (idxObs = 0, itJacobPair = lstJacobians.begin();
-					 idxObs < nObservations; ++itJacobPair, ++idxObs)
-				{
-					const bool Hij_upper_triang =
-						itJacobPair->first.first < itJacobPair->first.second;
-
-					// Indices in the "H_map" vector:
-					const size_t idx_i = obsIdx2fnIdx[idxObs].first;
-					const size_t idx_j = obsIdx2fnIdx[idxObs].second;
-
-					const bool is_i_free_node = idx_i != string::npos;
-					const bool is_j_free_node = idx_j != string::npos;
-
-					// Take references to both Jacobians (wrt pose "i" and pose
-					// "j"), taking into account the possible
-					// switch in their order:
-					const typename gst::matrix_VxV_t& J1 = itJacobPair->second.first;
-					const typename gst::matrix_VxV_t& J2 = itJacobPair->second.second;
-
-					// Is "i" a free (to be optimized) node? -> Ji^t * Inf *  Ji
-					if (is_i_free_node)
-					{
-						typename gst::matrix_VxV_t JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJtLambdaJ(
-								J1, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_i][idx_i] += JtJ;
-					}
-					// Is "j" a free (to be optimized) node? -> Jj^t * Inf *  Jj
-					if (is_j_free_node)
-					{
-						typename gst::matrix_VxV_t JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJtLambdaJ(
-								J2, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_j][idx_j] += JtJ;
-					}
-					// Are both "i" and "j" free nodes? -> Ji^t * Inf *  Jj
-					if (is_i_free_node && is_j_free_node)
+			mrpt::system::parallel_for_chunks(
+				nBlocks,
+				[&](const size_t first, const size_t last) {
+					using layout_t = detail::THessianLayout;
+					using aux_t =
+						detail::AuxErrorEval<typename gst::edge_t, gst>;
+					typename gst::matrix_VxV_t JtJ(
+						mrpt::math::UNINITIALIZED_MATRIX);
+					for (size_t k = first; k < last; k++)
 					{
-						typename gst::matrix_VxV_t JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJ1tLambdaJ2(
-								J1, J2, JtJ, lstObservationData[idxObs].edge);
-						// We sort IDs such as "i" < "j" and we can build just
-						// the upper triangular part of the Hessian:
-						if (Hij_upper_triang)  // H_map[col][row]
-							H_map[idx_j][idx_i] += JtJ;
-						else
-							H_map[idx_i][idx_j] += JtJ.transpose();
+						auto& H = H_blocks[k];
+						H.setZero();
+						for (size_t c = layout.contrib_ptr[k];
+							 c < layout.contrib_ptr[k + 1]; c++)
+						{
+							const auto& ctr = layout.contribs[c];
+							const auto& J = lstJacobians[ctr.obs];
+							const auto* edge =
+								lstObservationData[ctr.obs].edge;
+							switch (ctr.kind)
+							{
+								case layout_t::J1tJ1:
+									aux_t::multiplyJtLambdaJ(
+										J.first, JtJ, edge);
+									H += JtJ;
+									break;
+								case layout_t::J2tJ2:
+									aux_t::multiplyJtLambdaJ(
+										J.second, JtJ, edge);
+									H += JtJ;
+									break;
+								case layout_t::J1tJ2:
+									aux_t::multiplyJ1tLambdaJ2(
+										J.first, J.second, JtJ, edge);
+									H += JtJ;
+									break;
+								case layout_t::J2tJ1:
+									aux_t::multiplyJ1tLambdaJ2(
+										J.first, J.second, JtJ, edge);
+									H += JtJ.transpose();
+									break;
+								case layout_t::J1tJ2_plus_J2tJ1:
+									aux_t::multiplyJ1tLambdaJ2(
+										J.first, J.second, JtJ, edge);
+									H += JtJ;
+									H += JtJ.transpose();
+									break;
+								default:
+									break;
+							}
+						}
 					}
-				}
-			}
-			profiler.leave("optimize_graph_spa_levmarq.sp_H:build map");
+				},
+				num_threads);
+			profiler.leave("optimize_graph_spa_levmarq.sp_H:blocks");
 
 			// Just in the first iteration, we need to calculate an estimate for
 			// the first value of "lamdba":
@@ -425,21 +414,15 @@ void optimize_graph_spa_levmarq(
 				profiler.enter(
 					"optimize_graph_spa_levmarq.lambda_init");  // ---\  .
 				double H_diagonal_max = 0;
-				for (size_t i = 0; i < nFreeNodes; i++)
-					for (typename map_ID2matrix_VxV_t::const_iterator it =
-							 H_map[i].begin();
-						 it != H_map[i].end(); ++it)
-					{
-						const size_t j =
-							it->first;  // entry submatrix is for (i,j).
-						if (i == j)
-						{
-							for (size_t k = 0; k < DIMS_POSE; k++)
-								mrpt::keep_max(
-									H_diagonal_max,
-									it->second.get_unsafe(k, k));
-						}
-					}
+				for (size_t k = 0; k < nBlocks; k++)
+				{
+					// entry submatrix is for (i,j).
+					if (layout.blocks[k].first != layout.blocks[k].second)
+						continue;
+					for (size_t d = 0; d < DIMS_POSE; d++)
+						mrpt::keep_max(
+							H_diagonal_max, H_blocks[k].get_unsafe(d, d));
+				}
 				lambda = tau * H_diagonal_max;
 
 				profiler.leave(
@@ -468,50 +451,35 @@ void optimize_graph_spa_levmarq(
 		}
 
 		profiler.enter("optimize_graph_spa_levmarq.sp_H:build");
-		// Now, build the actual sparse matrix H:
-		// Note: we only need to fill out the upper diagonal part, since
-		// Cholesky will later on ignore the other part.
-		CSparseMatrix sp_H(nFreeNodes * DIMS_POSE, nFreeNodes * DIMS_POSE);
-		for (size_t i = 0; i < nFreeNodes; i++)
+		// Now, write the values of the actual sparse matrix H + lambda*I,
+		// in place:
 		{
-			const size_t i_offset = i * DIMS_POSE;
-
-			for (typename map_ID2matrix_VxV_t::const_iterator it =
-					 H_map[i].begin();
-				 it != H_map[i].end(); ++it)
-			{
-				const size_t j = it->first;  // entry submatrix is for (i,j).
-				const size_t j_offset = j * DIMS_POSE;
-
-				// For i==j (diagonal blocks), it's different, since we only
-				// need to insert their
-				// upper-diagonal half and also we have to add the lambda*I to
-				// the diagonal from the Lev-Marq. algorithm:
-				if (i == j)
-				{
-					for (size_t r = 0; r < DIMS_POSE; r++)
+			double* H_values = sp_H.getCompressedValues();
+			mrpt::system::parallel_for_chunks(
+				nBlocks,
+				[&](const size_t first, const size_t last) {
+					for (size_t k = first; k < last; k++)
 					{
-						// c=r: add lambda from LM
-						sp_H.insert_entry_fast(
-							j_offset + r, i_offset + r,
-							it->second.get_unsafe(r, r) + lambda);
-						// c>r:
-						for (size_t c = r + 1; c < DIMS_POSE; c++)
+						const auto& H = H_blocks[k];
+						// For diagonal blocks, it's different, since we only
+						// need their upper-diagonal half and also we have to
+						// add the lambda*I to the diagonal from the Lev-Marq.
+						// algorithm:
+						const bool is_diag =
+							layout.blocks[k].first == layout.blocks[k].second;
+						for (size_t c = 0; c < DIMS_POSE; c++)
 						{
-							sp_H.insert_entry_fast(
-								j_offset + r, i_offset + c,
-								it->second.get_unsafe(r, c));
+							double* col = H_values + layout.value_idx[
+								k * DIMS_POSE + c];
+							const size_t nRows = is_diag ? c + 1 : DIMS_POSE;
+							for (size_t r = 0; r < nRows; r++)
+								col[r] = H.get_unsafe(r, c);
+							if (is_diag) col[c] += lambda;
 						}
 					}
-				}
-				else
-				{
-					sp_H.insert_submatrix(j_offset, i_offset, it->second);
-				}
-			}
-		}  // end for each free node, build sp_H
-
-		sp_H.compressFromTriplet();
+				},
+				num_threads);
+		}
 		profiler.leave("optimize_graph_spa_levmarq.sp_H:build");
 
 		// Use the cparse Cholesky decomposition to efficiently solve:
@@ -621,12 +589,13 @@ void optimize_graph_spa_levmarq(
 			// =============================================================
 			// Compute Jacobians & errors with the new "graph.nodes" info:
 			// =============================================================
-			typename gst::map_pairIDs_pairJacobs_t new_lstJacobians;
+			typename gst::vector_pairJacobs_t new_lstJacobians;
 			mrpt::aligned_std_vector<typename gst::Array_O> new_errs;
 
 			profiler.enter("optimize_graph_spa_levmarq.Jacobians&err");
 			double new_total_sqr_err = computeJacobiansAndErrors<GRAPH_T>(
-				graph, lstObservationData, new_lstJacobians, new_errs);
+				graph, lstObservationData, new_lstJacobians, new_errs,
+				num_threads);
 			profiler.leave("optimize_graph_spa_levmarq.Jacobians&err");
 
 			// Now, to decide whether to accept the change:
@@ -9,6 +9,12 @@
 #ifndef GRAPH_SLAM_LEVMARQ_IMPL_H
 #define GRAPH_SLAM_LEVMARQ_IMPL_H
 
+#include <mrpt/math/CSparseMatrix.h>
+#include <mrpt/system/TaskScheduler.h>
+#include <map>
+#include <string>
+#include <vector>
+
 namespace mrpt
 {
 namespace graphslam
@@ -125,6 +131,15 @@ struct AuxErrorEval<CPose2D, gst>
 		const auto grad_incr = (J.transpose() * ERR).eval();
 		OUT += grad_incr;
 	}
+
+	template <class MAT, class VEC, class EDGE>
+	static inline void whiten(MAT& J1, MAT& J2, VEC& err, const EDGE& edge)
+	{
+		MRPT_UNUSED_PARAM(J1);
+		MRPT_UNUSED_PARAM(J2);
+		MRPT_UNUSED_PARAM(err);
+		MRPT_UNUSED_PARAM(edge);
+	}
 };
 
 // For graphs of 3D constraints (no information matrix)
@@ -162,6 +177,15 @@ struct AuxErrorEval<CPose3D, gst>
 		MRPT_UNUSED_PARAM(edge);
 		OUT += J.transpose() * ERR;
 	}
+
+	template <class MAT, class VEC, class EDGE>
+	static inline void whiten(MAT& J1, MAT& J2, VEC& err, const EDGE& edge)
+	{
+		MRPT_UNUSED_PARAM(J1);
+		MRPT_UNUSED_PARAM(J2);
+		MRPT_UNUSED_PARAM(err);
+		MRPT_UNUSED_PARAM(edge);
+	}
 };
 
 // For graphs of 2D constraints (with information matrix)
@@ -194,6 +218,16 @@ struct AuxErrorEval<CPosePDFGaussianInf, gst>
 	{
 		OUT += (J.transpose() * edge->second.cov_inv) * ERR;
 	}
+
+	// Multiply Jacobians and error by U, with cov_inv = U^t * U
+	template <class MAT, class VEC, class EDGE>
+	static inline void whiten(MAT& J1, MAT& J2, VEC& err, const EDGE& edge)
+	{
+		const auto llt = edge.cov_inv.llt();
+		J1 = (llt.matrixU() * J1).eval();
+		J2 = (llt.matrixU() * J2).eval();
+		err = (llt.matrixU() * err).eval();
+	}
 };
 
 // For graphs of 3D constraints (with information matrix)
@@ -228,67 +262,190 @@ struct AuxErrorEval<CPose3DPDFGaussianInf, gst>
 	{
 		OUT += (J.transpose() * edge->second.cov_inv) * ERR;
 	}
+
+	// Multiply Jacobians and error by U, with cov_inv = U^t * U
+	template <class MAT, class VEC, class EDGE>
+	static inline void whiten(MAT& J1, MAT& J2, VEC& err, const EDGE& edge)
+	{
+		const auto llt = edge.cov_inv.llt();
+		J1 = (llt.matrixU() * J1).eval();
+		J2 = (llt.matrixU() * J2).eval();
+		err = (llt.matrixU() * err).eval();
+	}
+};
+
+// Block structure of the upper triangular part of the Hessian H=J^t*W*J and
+// of the gradient, which is built only once since it does not change along
+// iterations. The contributions of the edges to each block of H (and to each
+// part of the gradient) are grouped by block, in CSR fashion, so that blocks
+// can be computed in parallel without any synchronization, and always adding
+// up the same terms in the same order.
+struct THessianLayout
+{
+	enum contrib_kind_t : uint8_t
+	{
+		// Hessian blocks:
+		J1tJ1 = 0,
+		J2tJ2,
+		J1tJ2,
+		J2tJ1,
+		J1tJ2_plus_J2tJ1,  // For edges from a node to itself
+		// Gradient:
+		J1t_err,
+		J2t_err
+	};
+	struct TContrib
+	{
+		size_t obs;  // Index in the list of observations
+		contrib_kind_t kind;
+	};
+
+	// (row,col) of each non-zero block of H, with row<=col, sorted by column
+	// and row. There is always a block for each diagonal entry.
+	std::vector<std::pair<size_t, size_t>> blocks;
+	// Block "k" is the sum of contribs[contrib_ptr[k]:contrib_ptr[k+1]-1]:
+	std::vector<size_t> contrib_ptr;
+	std::vector<TContrib> contribs;
+	// The same, for the gradient of each free node:
+	std::vector<size_t> grad_ptr;
+	std::vector<TContrib> grad_contribs;
+	// Index in the compressed values of H of the first entry of column "c" of
+	// block "k", at [k*dims+c]. The rest of the column follows.
+	std::vector<size_t> value_idx;
+
+	// Builds the layout and "sp_H", a column-compressed matrix with the
+	// structure of H (with zeros). "obsIdx2fnIdx" has the indices of the free
+	// nodes of each observation, or std::string::npos for fixed nodes.
+	void build(
+		const std::vector<std::pair<size_t, size_t>>& obsIdx2fnIdx,
+		const size_t nFreeNodes, const size_t dims,
+		mrpt::math::CSparseMatrix& sp_H)
+	{
+		const size_t INVALID = std::string::npos;
+		// Collect contributions by (col,row), so they end up sorted:
+		std::map<std::pair<size_t, size_t>, std::vector<TContrib>> byBlock;
+		std::vector<std::vector<TContrib>> byNode(nFreeNodes);
+		for (size_t i = 0; i < nFreeNodes; i++) byBlock[{i, i}];
+		for (size_t k = 0; k < obsIdx2fnIdx.size(); k++)
+		{
+			const size_t i = obsIdx2fnIdx[k].first, j = obsIdx2fnIdx[k].second;
+			if (i != INVALID)
+			{
+				byBlock[{i, i}].push_back({k, J1tJ1});
+				byNode[i].push_back({k, J1t_err});
+			}
+			if (j != INVALID)
+			{
+				byBlock[{j, j}].push_back({k, J2tJ2});
+				byNode[j].push_back({k, J2t_err});
+			}
+			if (i == INVALID || j == INVALID) continue;
+			if (i < j)
+				byBlock[{j, i}].push_back({k, J1tJ2});
+			else if (j < i)
+				byBlock[{i, j}].push_back({k, J2tJ1});
+			else
+				byBlock[{i, i}].push_back({k, J1tJ2_plus_J2tJ1});
+		}
+
+		blocks.clear();
+		contribs.clear();
+		contrib_ptr.assign(1, 0);
+		for (const auto& b : byBlock)
+		{
+			blocks.emplace_back(b.first.second, b.first.first);
+			contribs.insert(contribs.end(), b.second.begin(), b.second.end());
+			contrib_ptr.push_back(contribs.size());
+		}
+		grad_contribs.clear();
+		grad_ptr.assign(1, 0);
+		for (const auto& n : byNode)
+		{
+			grad_contribs.insert(grad_contribs.end(), n.begin(), n.end());
+			grad_ptr.push_back(grad_contribs.size());
+		}
+
+		// Insert the entries of the triplet matrix sorted by column, so we
+		// know where each one will be in the compressed matrix. Only the
+		// upper triangular part of diagonal blocks is needed:
+		sp_H.clear(nFreeNodes * dims, nFreeNodes * dims);
+		value_idx.assign(blocks.size() * dims, 0);
+		size_t nnz = 0;
+		for (size_t k0 = 0; k0 < blocks.size();)
+		{
+			const size_t col = blocks[k0].second;
+			size_t k1 = k0;
+			while (k1 < blocks.size() && blocks[k1].second == col) k1++;
+			for (size_t c = 0; c < dims; c++)
+				for (size_t k = k0; k < k1; k++)
+				{
+					const size_t row = blocks[k].first;
+					value_idx[k * dims + c] = nnz;
+					const size_t nRows = row == col ? c + 1 : dims;
+					for (size_t r = 0; r < nRows; r++, nnz++)
+						sp_H.insert_entry(row * dims + r, col * dims + c, 0);
+				}
+			k0 = k1;
+		}
+		sp_H.compressFromTriplet();
+		ASSERT_EQUAL_(sp_H.getNonZeroCount(), nnz);
+	}
 };
 
 }  // namespace detail
 
 // Compute, at once, jacobians and the error vectors for each constraint in
-// "lstObservationData", returns the overall squared error.
+// "lstObservationData", returns the overall squared error. Jacobians and
+// errors are computed in parallel, in up to "maxThreads" threads (0: as many
+// as the mrpt::system::TaskScheduler concurrency).
 template <class GRAPH_T>
 double computeJacobiansAndErrors(
 	const GRAPH_T& graph,
 	const std::vector<typename graphslam_traits<GRAPH_T>::observation_info_t>&
 		lstObservationData,
-	typename graphslam_traits<GRAPH_T>::map_pairIDs_pairJacobs_t& lstJacobians,
-	mrpt::aligned_std_vector<typename graphslam_traits<GRAPH_T>::Array_O>& errs)
+	typename graphslam_traits<GRAPH_T>::vector_pairJacobs_t& lstJacobians,
+	mrpt::aligned_std_vector<typename graphslam_traits<GRAPH_T>::Array_O>& errs,
+	const size_t maxThreads = 0)
 {
 	MRPT_UNUSED_PARAM(graph);
 	using gst = graphslam_traits<GRAPH_T>;
 
-	lstJacobians.clear();
-	errs.clear();
-
 	const size_t nObservations = lstObservationData.size();
-
-	for (size_t i = 0; i < nObservations; i++)
-	{
-		const typename gst::observation_info_t& obs = lstObservationData[i];
-		auto e = obs.edge;
-		const typename gst::graph_t::constraint_t::type_value* EDGE_POSE =
-			obs.edge_mean;
-		typename gst::graph_t::constraint_t::type_value* P1 = obs.P1;
-		typename gst::graph_t::constraint_t::type_value* P2 = obs.P2;
-
-		const auto& ids = e->first;
-		const auto& edge = e->second;
-
-		// Compute the residual pose error of these pair of nodes + its
-		// constraint:
-		// DinvP1invP2 = inv(EDGE) * inv(P1) * P2 = (P2 \ominus P1) \ominus EDGE
-		typename gst::graph_t::constraint_t::type_value DinvP1invP2 =
-			((*P2) - (*P1)) - *EDGE_POSE;
-
-		// Add to vector of errors:
-		errs.resize(errs.size() + 1);
-		detail::AuxErrorEval<typename gst::edge_t, gst>::computePseudoLnError(
-			DinvP1invP2, errs.back(), edge);
-
-		// Compute the jacobians:
-		alignas(MRPT_MAX_ALIGN_BYTES)
-			std::pair<mrpt::graphs::TPairNodeIDs, typename gst::TPairJacobs>
-				newMapEntry;
-		newMapEntry.first = ids;
-		gst::SE_TYPE::jacobian_dDinvP1invP2_depsilon(
-			-(*EDGE_POSE), *P1, *P2, &newMapEntry.second.first,
-			&newMapEntry.second.second);
-
-		// And insert into map of jacobians:
-		lstJacobians.insert(lstJacobians.end(), newMapEntry);
-	}
-
-	// return overall square error:  (Was:
-	// std::accumulate(...,mrpt::squareNorm_accum<>), but led to GCC
-	// errors when enabling parallelization)
+	lstJacobians.resize(nObservations);
+	errs.resize(nObservations);
+
+	mrpt::system::parallel_for_chunks(
+		nObservations,
+		[&](const size_t first, const size_t last) {
+			for (size_t i = first; i < last; i++)
+			{
+				const typename gst::observation_info_t& obs =
+					lstObservationData[i];
+				const typename gst::graph_t::constraint_t::type_value*
+					EDGE_POSE = obs.edge_mean;
+				const auto* P1 = obs.P1;
+				const auto* P2 = obs.P2;
+
+				// Compute the residual pose error of these pair of nodes + its
+				// constraint:
+				// DinvP1invP2 = inv(EDGE) * inv(P1) * P2 =
+				//  (P2 \ominus P1) \ominus EDGE
+				typename gst::graph_t::constraint_t::type_value DinvP1invP2 =
+					((*P2) - (*P1)) - *EDGE_POSE;
+
+				detail::AuxErrorEval<typename gst::edge_t, gst>::
+					computePseudoLnError(
+						DinvP1invP2, errs[i], obs.edge->second);
+
+				// Compute the jacobians:
+				gst::SE_TYPE::jacobian_dDinvP1invP2_depsilon(
+					-(*EDGE_POSE), *P1, *P2, &lstJacobians[i].first,
+					&lstJacobians[i].second);
+			}
+		},
+		maxThreads);
+
+	// return overall square error, always added up in the same order:
 	double ret_err = 0.0;
 	for (size_t i = 0; i < errs.size(); i++) ret_err += errs[i].squaredNorm();
 	return ret_err;
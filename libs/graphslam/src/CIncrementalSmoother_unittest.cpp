@@ -0,0 +1,126 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "graph_slam_levmarq_test_common.h"
+
+#include <mrpt/graphslam/CIncrementalSmoother.h>
+#include <gtest/gtest.h>
+
+template <class my_graph_t>
+class IncrementalSmootherTester : public GraphSlamLevMarqTest<my_graph_t>,
+								  public ::testing::Test
+{
+   protected:
+	void test_ring_path(bool explicit_new_edges = false)
+	{
+		my_graph_t full;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(full);
+
+		// Feed the graph node by node, with the edges to previous nodes:
+		my_graph_t graph;
+		graph.root = full.root;
+		graphslam::CIncrementalSmoother<my_graph_t> isam;
+		isam.options.relinearize_every = 10;
+
+		for (const auto& n : full.nodes)
+		{
+			graph.nodes[n.first] = n.second;
+			std::vector<mrpt::graphs::TPairNodeIDs> new_edges;
+			for (const auto& e : full.edges)
+				if (std::max(e.first.first, e.first.second) == n.first)
+				{
+					graph.insertEdge(e.first.first, e.first.second, e.second);
+					new_edges.push_back(e.first);
+				}
+
+			const double err_before = graph.chi2();
+			typename graphslam::CIncrementalSmoother<my_graph_t>::TUpdateStats
+				st;
+			if (explicit_new_edges)
+				isam.update(graph, new_edges, &st);
+			else
+				isam.update(graph, &st);
+			EXPECT_EQ(st.new_edges, new_edges.size());
+			if (n.first == graph.root) continue;
+			EXPECT_LE(graph.chi2(), err_before + 1e-6);
+			// Odometry-like edges only touch the last rows of R:
+			if (!st.relinearized && st.new_edges == 1)
+				EXPECT_LE(st.modified_rows, 2U);
+		}
+		EXPECT_EQ(isam.getEdgeCount(), full.edges.size());
+		EXPECT_EQ(isam.getNodeCount(), full.nodes.size() - 1);
+
+		isam.options.relinearize_iterations = 5;
+		isam.relinearize(graph);
+		EXPECT_LT(graph.chi2(), 1e-3);
+
+		// Compare with a batch optimization:
+		mrpt::system::TParametersDouble params;
+		params["max_iterations"] = 100;
+		graphslam::TResultInfoSpaLevMarq info;
+		graphslam::optimize_graph_spa_levmarq(full, info, nullptr, params);
+		for (const auto& n : full.nodes)
+			EXPECT_NEAR(
+				0,
+				(n.second.getAsVectorVal() -
+				 graph.nodes[n.first].getAsVectorVal())
+					.array()
+					.abs()
+					.maxCoeff(),
+				1e-2);
+	}
+
+	void test_removed_edges()
+	{
+		my_graph_t graph;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(graph);
+		graphslam::CIncrementalSmoother<my_graph_t> isam;
+		isam.update(graph);
+		EXPECT_EQ(isam.getEdgeCount(), graph.edges.size());
+
+		// Nothing new:
+		typename graphslam::CIncrementalSmoother<my_graph_t>::TUpdateStats st;
+		isam.update(graph, &st);
+		EXPECT_EQ(st.new_edges, 0U);
+		EXPECT_EQ(st.modified_rows, 0U);
+
+		graph.edges.erase(graph.edges.begin());
+		EXPECT_ANY_THROW(isam.update(graph));
+		isam.reset();
+		isam.update(graph);
+		EXPECT_EQ(isam.getEdgeCount(), graph.edges.size());
+	}
+};
+
+using IncrementalSmoother2D = IncrementalSmootherTester<CNetworkOfPoses2D>;
+using IncrementalSmoother2DInf =
+	IncrementalSmootherTester<CNetworkOfPoses2DInf>;
+// Not yet: SE_traits<3> lacks the Jacobians.
+// using IncrementalSmoother3D = IncrementalSmootherTester<CNetworkOfPoses3D>;
+
+TEST_F(IncrementalSmoother2D, RingPath)
+{
+	getRandomGenerator().randomize(123);
+	test_ring_path();
+}
+TEST_F(IncrementalSmoother2DInf, RingPath)
+{
+	getRandomGenerator().randomize(123);
+	test_ring_path();
+}
+TEST_F(IncrementalSmoother2D, RingPathExplicitNewEdges)
+{
+	getRandomGenerator().randomize(123);
+	test_ring_path(true);
+}
+TEST_F(IncrementalSmoother2D, RemovedEdgesRequireReset)
+{
+	getRandomGenerator().randomize(123);
+	test_removed_edges();
+}
@@ -12,6 +12,7 @@
 #include <gtest/gtest.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/system/filesystem.h>
+#include <mrpt/system/TaskScheduler.h>
 
 // Defined in tests/test_main.cpp
 namespace mrpt
@@ -34,6 +35,9 @@ const std::map<std::string, in_out_filenames> inout_graph_files{
 	  {"graphslam_SE2_in2.graph", "graphslam_SE2_out_good2.graph"},
 	  {"graphslam_SE2_in3.graph", "graphslam_SE2_out_good3.graph"}}},
 	{"GraphTester2DInf",
+	 {{"graphslam_SE2_in.graph", "graphslam_SE2_out_good.graph"},
+	  {"graphslam_SE2pdf_in.graph", "graphslam_SE2pdf_out_good.graph"}}},
+	{"GraphTester2DInfFlat",
 	 {{"graphslam_SE2_in.graph", "graphslam_SE2_out_good.graph"},
 	  {"graphslam_SE2pdf_in.graph", "graphslam_SE2pdf_out_good.graph"}}}};
 
@@ -218,6 +222,8 @@ using GraphTester2D = GraphTester<CNetworkOfPoses2D>;
 using GraphTester3D = GraphTester<CNetworkOfPoses3D>;
 using GraphTester2DInf = GraphTester<CNetworkOfPoses2DInf>;
 using GraphTester3DInf = GraphTester<CNetworkOfPoses3DInf>;
+using GraphTester2DInfFlat = GraphTester<
+	CNetworkOfPoses<CPosePDFGaussianInf, mrpt::containers::map_traits_flat>>;
 
 #define GRAPHS_TESTS(_TYPE)                           \
 	TEST_F(_TYPE, OptimizeSampleRingPath)             \
@@ -249,3 +255,110 @@ GRAPHS_TESTS(GraphTester2D)
 //GRAPHS_TESTS(GraphTester3D)
 GRAPHS_TESTS(GraphTester2DInf)
 //GRAPHS_TESTS(GraphTester3DInf)
+GRAPHS_TESTS(GraphTester2DInfFlat)
+
+// Both node/edge storage schemes must lead to the very same results:
+TEST(GraphTesterFlat, SameResultsAsStdMap)
+{
+	using flat_graph_t = CNetworkOfPoses<
+		CPosePDFGaussianInf, mrpt::containers::map_traits_flat>;
+	getRandomGenerator().randomize(123);
+	CNetworkOfPoses2DInf graph;
+	GraphSlamLevMarqTest<CNetworkOfPoses2DInf>::create_ring_path(graph);
+
+	flat_graph_t flat_graph;
+	flat_graph.root = graph.root;
+	// Insert in reverse order, to exercise out-of-order insertions:
+	for (auto it = graph.nodes.rbegin(); it != graph.nodes.rend(); ++it)
+		flat_graph.nodes[it->first] = it->second;
+	for (auto it = graph.edges.rbegin(); it != graph.edges.rend(); ++it)
+		flat_graph.insertEdge(it->first.first, it->first.second, it->second);
+	ASSERT_EQ(flat_graph.nodeCount(), graph.nodeCount());
+	ASSERT_EQ(flat_graph.edgeCount(), graph.edgeCount());
+	EXPECT_NEAR(flat_graph.chi2(), graph.chi2(), 1e-6);
+
+	// Spanning tree:
+	graph.dijkstra_nodes_estimate();
+	flat_graph.dijkstra_nodes_estimate();
+	for (const auto& n : graph.nodes)
+		EXPECT_NEAR(
+			0,
+			(n.second.getAsVectorVal() -
+			 flat_graph.nodes.at(n.first).getAsVectorVal())
+				.array()
+				.abs()
+				.maxCoeff(),
+			1e-9);
+
+	// Adjacency:
+	CNetworkOfPoses2DInf::TAdjacencyCSR adj;
+	flat_graph_t::TAdjacencyCSR flat_adj;
+	graph.getAdjacencyCSR(adj);
+	flat_graph.getAdjacencyCSR(flat_adj);
+	EXPECT_EQ(adj.nodeIDs, flat_adj.nodeIDs);
+	EXPECT_EQ(adj.row_ptr, flat_adj.row_ptr);
+	EXPECT_EQ(adj.neighbors, flat_adj.neighbors);
+	std::map<TNodeID, std::set<TNodeID>> neighbors;
+	graph.getAdjacencyMatrix(neighbors);
+	for (size_t i = 0; i < adj.nodeCount(); i++)
+	{
+		const auto& nei = neighbors[adj.nodeIDs[i]];
+		ASSERT_EQ(nei.size(), adj.row_ptr[i + 1] - adj.row_ptr[i]);
+		size_t k = adj.row_ptr[i];
+		for (const auto id : nei)
+			EXPECT_EQ(id, adj.nodeIDs[adj.neighbors[k++]]);
+	}
+	const mrpt::graphs::CDijkstra<
+		flat_graph_t, mrpt::containers::map_traits_flat>
+		dijkstra(flat_graph, flat_graph.root);
+	const auto& cached = dijkstra.getCachedAdjacencyMatrix();
+	ASSERT_EQ(cached.size(), neighbors.size());
+	for (const auto& n : neighbors) EXPECT_EQ(cached.at(n.first), n.second);
+}
+
+// The Hessian is built in parallel, but the solution must not depend on the
+// number of threads:
+template <class my_graph_t>
+void test_levmarq_threads_independent_result()
+{
+	// Several threads even on single-core machines:
+	mrpt::system::TaskSchedulerThreadsGuard threads(4);
+
+	getRandomGenerator().randomize(123);
+	my_graph_t graph_serial;
+	GraphSlamLevMarqTest<my_graph_t>::create_ring_path(graph_serial);
+	my_graph_t graph_parallel = graph_serial;
+
+	mrpt::system::TParametersDouble params;
+	params["max_iterations"] = 20;
+	graphslam::TResultInfoSpaLevMarq info_serial, info_parallel;
+
+	params["num_threads"] = 1;
+	graphslam::optimize_graph_spa_levmarq(
+		graph_serial, info_serial, nullptr, params);
+	params["num_threads"] = 4;
+	graphslam::optimize_graph_spa_levmarq(
+		graph_parallel, info_parallel, nullptr, params);
+
+	EXPECT_EQ(info_serial.num_iters, info_parallel.num_iters);
+	EXPECT_EQ(
+		info_serial.final_total_sq_error, info_parallel.final_total_sq_error);
+	ASSERT_EQ(graph_serial.nodeCount(), graph_parallel.nodeCount());
+	for (const auto& n : graph_serial.nodes)
+	{
+		const auto v1 = n.second.getAsVectorVal();
+		const auto v2 = graph_parallel.nodes.at(n.first).getAsVectorVal();
+		for (int i = 0; i < v1.size(); i++)
+			EXPECT_EQ(v1[i], v2[i]) << "node #" << n.first;
+	}
+}
+
+TEST(GraphTesterThreads, LevMarqSameResultForAnyNumThreads2D)
+{
+	test_levmarq_threads_independent_result<CNetworkOfPoses2D>();
+}
+TEST(GraphTesterThreads, LevMarqSameResultForAnyNumThreads2DInf)
+{
+	test_levmarq_threads_independent_result<CNetworkOfPoses2DInf>();
+}
+// Not yet for 3D graphs, as GRAPHS_TESTS(GraphTester3D) above.
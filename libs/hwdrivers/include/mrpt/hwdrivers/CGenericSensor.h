@@ -11,7 +11,9 @@
 #define CGenericSensor_H
 
 #include <mrpt/config/CConfigFileBase.h>
+#include <mrpt/containers/bounded_queue.h>
 #include <mrpt/obs/CObservation.h>
+#include <atomic>
 #include <map>
 #include <mutex>
 
@@ -48,7 +50,7 @@ struct TSensorClassId
  *thread should invoke "doProcess".
  *			- "max_queue_len": (Optional) The maximum number of objects in the
  *observations queue (default is 200). If overflow occurs, an error message
- *will be issued at run-time.
+ *will be issued at run-time, but no observation is discarded.
  *			- "grab_decimation": (Optional) Grab only 1 out of N observations
  *captured
  *by the sensor (default is 1, i.e. do not decimate).
@@ -114,10 +116,15 @@ class CGenericSensor
 	static void registerClass(const TSensorClassId* pNewClass);
 
    private:
-	/** The critical section for m_objList */
-	std::mutex m_csObjList;
-	/** The queue of objects to be returned by getObservations */
-	TListObservations m_objList;
+	/** The queue of objects to be returned by getObservations. It is
+	 * lock-free, so the sensor thread never blocks while the consumer thread
+	 * retrieves observations, unless the queue is full. */
+	mrpt::containers::mpmc_queue<TListObsPair> m_objList;
+	/** Observations which did not fit in m_objList, protected by
+	 * m_csObjListOverflow. Only used if the consumer falls behind. */
+	TListObservations m_objListOverflow;
+	std::mutex m_csObjListOverflow;
+	std::atomic_bool m_objListOverflowed{false};
 
 	/** Used in registerClass */
 	using registered_sensor_classes_t =
@@ -254,6 +261,8 @@ class CGenericSensor
 
 	/** Returns a list of enqueued objects, emptying it (thread-safe). The
 	 * objects must be freed by the invoker.
+	 * An error message is issued if the queue reached "max_queue_len" objects
+	 * since the last call (no observation is discarded, though).
 	 */
 	void getObservations(TListObservations& lstObjects);
 
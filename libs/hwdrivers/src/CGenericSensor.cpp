@@ -12,6 +12,7 @@
 #include <mrpt/hwdrivers/CGenericSensor.h>
 #include <mrpt/obs/CAction.h>
 #include <mrpt/obs/CObservation.h>
+#include <iostream>
 
 using namespace mrpt::obs;
 using namespace mrpt::system;
@@ -23,7 +24,8 @@ using namespace std;
 						Constructor
 -------------------------------------------------------------*/
 CGenericSensor::CGenericSensor()
-	: m_process_rate(0),
+	: m_objList(200),
+	  m_process_rate(0),
 	  m_max_queue_len(200),
 	  m_grab_decimation(0),
 	  m_sensorLabel("UNNAMED_SENSOR"),
@@ -44,7 +46,7 @@ CGenericSensor::CGenericSensor()
 CGenericSensor::~CGenericSensor()
 {
 	// Free objects in list, if any:
-	m_objList.clear();
+	m_objList.reset(0);
 }
 
 /*-------------------------------------------------------------
@@ -57,8 +59,6 @@ void CGenericSensor::appendObservations(
 	{
 		m_grab_decimation_counter = 0;
 
-		std::lock_guard<std::mutex> lock(m_csObjList);
-
 		for (size_t i = 0; i < objs.size(); i++)
 		{
 			const CSerializable::Ptr& obj = objs[i];
@@ -79,8 +79,15 @@ void CGenericSensor::appendObservations(
 			else
 				THROW_EXCEPTION("Passed object must be CObservation.");
 
-			// Add it:
-			m_objList.insert(TListObsPair(timestamp, obj));
+			// Add it. If the queue is full (the consumer is too slow), keep
+			// the observation in the overflow list rather than losing it:
+			TListObsPair o(timestamp, obj);
+			if (!m_objList.push(o))
+			{
+				std::lock_guard<std::mutex> lock(m_csObjListOverflow);
+				m_objListOverflow.insert(std::move(o));
+				m_objListOverflowed = true;
+			}
 		}
 	}
 }
@@ -90,9 +97,25 @@ void CGenericSensor::appendObservations(
 -------------------------------------------------------------*/
 void CGenericSensor::getObservations(TListObservations& lstObjects)
 {
-	std::lock_guard<std::mutex> lock(m_csObjList);
-	lstObjects = m_objList;
-	m_objList.clear();  // Memory of objects will be freed by invoker.
+	lstObjects.clear();
+	TListObsPair o;
+	while (m_objList.try_pop(o)) lstObjects.insert(std::move(o));
+
+	if (m_objListOverflowed)
+	{
+		size_t nOverflow;
+		{
+			std::lock_guard<std::mutex> lock(m_csObjListOverflow);
+			nOverflow = m_objListOverflow.size();
+			lstObjects.insert(
+				m_objListOverflow.begin(), m_objListOverflow.end());
+			m_objListOverflow.clear();
+			m_objListOverflowed = false;
+		}
+		cerr << "[CGenericSensor::getObservations] Sensor '" << m_sensorLabel
+			 << "': queue is full (max_queue_len=" << m_max_queue_len
+			 << "), " << nOverflow << " observations were delayed.\n";
+	}
 }
 
 /*-------------------------------------------------------------
@@ -145,6 +168,8 @@ void CGenericSensor::loadConfig(
 	m_sensorLabel = cfg.read_string(sect, "sensorLabel", m_sensorLabel);
 
 	m_grab_decimation_counter = 0;
+	// Sensor threads are not running yet, so the queue can be resized:
+	m_objList.reset(std::max<size_t>(m_max_queue_len, 1));
 
 	loadConfig_sensorSpecific(cfg, sect);
 
@@ -13,6 +13,7 @@
 #include <mrpt/img/CCanvas.h>
 #include <mrpt/img/TCamera.h>
 #include <mrpt/img/TPixelCoord.h>
+#include <memory>
 
 // Add for declaration of mexplus::from template specialization
 DECLARE_MEXPLUS_FROM(mrpt::img::CImage)
@@ -99,9 +100,13 @@ class CExceptionExternalImageNotFound : public std::runtime_error
  *CImage::setExternalStorage, useful for storing large collections of image
  *objects in memory while loading the image data itself only for the relevant
  *images at any time.
- *		- To move images from one object to the another, use
- *CImage::copyFastFrom
- *rather than the copy operator =.
+ *		- Copies of an image share the same pixels until one of them is
+ *modified (copy-on-write), so the copy operator = is cheap. Pixels are only
+ *copied by the methods which modify the image, including the non-const
+ *versions of CImage::getAs(), CImage::get_unsafe() and CImage::operator(), so
+ *prefer their const versions for just reading. Use CImage::makeView for
+ *regions of an image and CImage::setFromExternalBuffer for pixels in external
+ *memory, without copying them.
  *		- If you are interested in a smart pointer to an image, use:
  *  \code
  *    CImage::Ptr   myImg::Ptr = CImage::Ptr( new CImage(...) );
@@ -153,9 +158,11 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 		unsigned int width, unsigned int height,
 		TImageChannels nChannels = CH_RGB, bool originTopLeft = true);
 
-	/** Copy constructor, makes a full copy of the original image contents
-	 * (unless it was externally stored, in that case, this new image will just
-	 * point to the same image file). */
+	/** Copy constructor: the new image shares the pixels of the original one,
+	 * which are only actually copied if any of the two is later modified
+	 * (copy-on-write). If the original was externally stored, this new image
+	 * will just point to the same image file.
+	 * \sa makeSureImageIsNotShared */
 	CImage(const CImage& o);
 
 	/** Fast constructor that leaves the image uninitialized (the internal
@@ -176,9 +183,9 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 	 * <b>reference</b> to the original image if it already was in grayscale, or
 	 * otherwise creating a new grayscale image and converting the original
 	 * image into it.
-	 *   It's <b>very important to keep in mind</b> that the original image
-	 * can't be destroyed before the new object being created with this
-	 * constructor.
+	 *   The pixels are shared with the original image, which can be destroyed
+	 * or modified afterwards without affecting this one, unless it was itself
+	 * created with setFromIplImageReadOnly().
 	 * Example of usage:
 	 *   \code
 	 *     void my_func(const CImage &in_img) {
@@ -397,7 +404,8 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 	/** Extract a patch from this image, saveing it into "patch" (its previous
 	 * contents will be overwritten).
 	 *  The patch to extract starts at (col,row) and has the given dimensions.
-	 * \sa update_patch
+	 *  Use makeView() instead to avoid copying the pixels.
+	 * \sa update_patch, makeView
 	 */
 	void extract_patch(
 		CImage& patch, const unsigned int col = 0, const unsigned int row = 0,
@@ -563,8 +571,9 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 		@{ */
 
 	/** Copy operator (if the image is externally stored, the writen image will
-	 * be such as well).
-	 * \sa copyFastFrom
+	 * be such as well). Pixels are shared until any of the images is modified
+	 * (copy-on-write), so this is a constant time operation.
+	 * \sa copyFastFrom, makeSureImageIsNotShared
 	 */
 	CImage& operator=(const CImage& o);
 
@@ -585,6 +594,43 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 	/** Very efficient swap of two images (just swap the internal pointers) */
 	void swap(CImage& o);
 
+	/** Returns an image which refers to a rectangular region of this one,
+	 * without copying its pixels. The view has the same row stride than this
+	 * image (see getRowStride()) and keeps its pixels alive, so it can outlive
+	 * this object. Views are read-only: modifying a view gives it a private
+	 * copy of its pixels first, and modifying this image afterwards does not
+	 * change the view contents.
+	 * \note Keeping a small view alive keeps the whole original image in
+	 * memory. Use extract_patch() for long-lived patches.
+	 * \exception std::exception If the region does not fit in the image.
+	 * \sa extract_patch
+	 * \note [New in MRPT 2.0.0]
+	 */
+	CImage makeView(
+		const unsigned int col, const unsigned int row,
+		const unsigned int width, const unsigned int height) const;
+
+	/** Returns true if the pixels of this image are shared with other images
+	 * or belong to an external buffer, that is, if modifying the image would
+	 * require making a copy of them first.
+	 * \sa makeSureImageIsNotShared
+	 * \note [New in MRPT 2.0.0] */
+	bool isBufferShared() const
+	{
+		return m_imgIsReadOnly || (m_imgOwner && m_imgOwner.use_count() > 1);
+	}
+
+	/** Makes a private copy of the pixels if they are shared with other
+	 * images (see isBufferShared()). This is automatically done by all
+	 * methods which modify the image, including the non-const versions of
+	 * getAs(), get_unsafe() and operator(). Note that pointers to pixels
+	 * obtained before copying an image still point to the shared buffer.
+	 * \note [New in MRPT 2.0.0] */
+	inline void makeSureImageIsNotShared()
+	{
+		if (isBufferShared()) unshareBuffer();
+	}
+
 	/** @} */
 	// ================================================================
 
@@ -603,11 +649,13 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 	}
 	/** Returns a pointer to a T* containing the image - the idea is to call
 	 * like "img.getAs<IplImage>()" so we can avoid here including OpenCV's
-	 * headers. */
+	 * headers. The image gets a private copy of its pixels first, if they
+	 * were shared (see makeSureImageIsNotShared()). */
 	template <typename T>
 	inline T* getAs()
 	{
 		makeSureImageIsLoaded();
+		makeSureImageIsNotShared();
 		return static_cast<T*>(img);
 	}
 
@@ -615,8 +663,17 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 	  operator better, which checks the coordinates.
 	  \sa CImage::operator()
 	  */
-	unsigned char* get_unsafe(
+	const unsigned char* get_unsafe(
 		unsigned int col, unsigned int row, unsigned int channel = 0) const;
+	/** \overload Makes a private copy of the pixels first, if they were
+	 * shared with other images. */
+	inline unsigned char* get_unsafe(
+		unsigned int col, unsigned int row, unsigned int channel = 0)
+	{
+		makeSureImageIsNotShared();
+		return const_cast<unsigned char*>(
+			static_cast<const CImage*>(this)->get_unsafe(col, row, channel));
+	}
 
 	/** Returns the contents of a given pixel at the desired channel, in float
 	 * format: [0,255]->[0,1]
@@ -640,8 +697,17 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 	 *   The coordinate origin is pixel(0,0)=top-left corner of the image.
 	 * \exception std::exception On pixel coordinates out of bounds
 	 */
-	unsigned char* operator()(
+	const unsigned char* operator()(
 		unsigned int col, unsigned int row, unsigned int channel = 0) const;
+	/** \overload Makes a private copy of the pixels first, if they were
+	 * shared with other images. */
+	inline unsigned char* operator()(
+		unsigned int col, unsigned int row, unsigned int channel = 0)
+	{
+		makeSureImageIsNotShared();
+		return const_cast<unsigned char*>(
+			static_cast<const CImage&>(*this)(col, row, channel));
+	}
 
 	/** @} */
 	// ================================================================
@@ -869,18 +935,29 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 	 */
 	void setFromIplImageReadOnly(void* iplImage);
 
-	/** Sets the internal IplImage pointer to that of another given image,
-	 * WITHOUT making a copy, and from now on the image cannot be modified in
-	 * this object (it will be neither freed, so the memory responsibility will
-	 * still be of the original image object).
-	 *  When assigning an IPLImage to this object with this method, the
-	 * IPLImage will NOT be released/freed at this object destructor.
+	/** Makes this image refer to the pixels of another given image, WITHOUT
+	 * making a copy. The pixels are kept alive while this object uses them,
+	 * and modifying this image makes a private copy of them first.
+	 *  If the other image was itself set with setFromIplImageReadOnly(), the
+	 * memory responsibility is still of the owner of that IplImage.
 	 *  \sa setFromIplImageReadOnly
 	 */
-	inline void setFromImageReadOnly(const CImage& other_img)
-	{
-		setFromIplImageReadOnly(const_cast<void*>(other_img.getAs<void>()));
-	}
+	void setFromImageReadOnly(const CImage& other_img);
+
+	/** Makes this image refer to an external buffer of 8-bit pixels, WITHOUT
+	 * making a copy. Color images must be stored in BGR order.
+	 * \param row_stride Bytes between the beginning of consecutive rows.
+	 * \param owner If provided, it is kept alive while this image (or any
+	 * copy of it) uses the buffer. Otherwise, the caller must keep the
+	 * buffer alive and unmodified while it is used.
+	 *  The image is read-only: modifying it makes a private copy of the
+	 * pixels first.
+	 * \note [New in MRPT 2.0.0]
+	 */
+	void setFromExternalBuffer(
+		unsigned int width, unsigned int height, TImageChannels nChannels,
+		size_t row_stride, unsigned char* pixels,
+		std::shared_ptr<void> owner = std::shared_ptr<void>());
 
 	/** Set the image from a matrix, interpreted as grayscale intensity values,
 	 *in the range [0,1] (normalized=true) or [0,255] (normalized=false)
@@ -1089,8 +1166,14 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 	/** The internal IplImage pointer to the actual image content. */
 	void* img;
 
-	/**  Set to true only when using setFromIplImageReadOnly.
-	 * \sa setFromIplImageReadOnly  */
+	/** Keeps alive the IplImage in "img" and its pixels. It is shared among
+	 * copies of this image and views into it. Empty for images set with
+	 * setFromIplImageReadOnly. */
+	std::shared_ptr<void> m_imgOwner;
+	/**  Set to true for images whose pixels can't be modified in place:
+	 * those set with setFromIplImageReadOnly, setFromImageReadOnly or
+	 * setFromExternalBuffer, and views.
+	 * \sa setFromIplImageReadOnly, makeView  */
 	bool m_imgIsReadOnly;
 	/**  Set to true only when using setExternalStorage.
 	 * \sa setExternalStorage
@@ -1111,6 +1194,10 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 	/** Release the internal IPL image, if not nullptr or read-only. */
 	void releaseIpl(bool thisIsExternalImgUnload = false) noexcept;
 
+	/** Replaces the pixels with a private copy of them.
+	 * \sa makeSureImageIsNotShared */
+	void unshareBuffer();
+
 	/** Checks if the image is of type "external storage", and if so and not
 	 * loaded yet, load it.
 	 * \exception CExceptionExternalImageNotFound */
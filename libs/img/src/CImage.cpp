@@ -63,6 +63,48 @@ void CImage::setImagesPathBase(const std::string& path)
 mrpt::img::CTimeLogger alloc_tims;
 #endif
 
+#if MRPT_HAS_OPENCV
+/** Makes a copy of an image with its own buffer and a compact row stride.
+ * Unlike cvCloneImage(), it also works for headers with an arbitrary
+ * widthStep, e.g. views or external buffers. */
+static IplImage* deep_copy_ipl(const IplImage* src)
+{
+	IplImage* out = cvCreateImage(cvGetSize(src), src->depth, src->nChannels);
+	out->origin = src->origin;
+	memcpy(out->colorModel, src->colorModel, 4);
+	memcpy(out->channelSeq, src->channelSeq, 4);
+	out->dataOrder = src->dataOrder;
+	const size_t row_bytes = static_cast<size_t>(src->width) *
+							 src->nChannels * ((src->depth & 255) >> 3);
+	for (int r = 0; r < src->height; r++)
+		memcpy(
+			out->imageData + r * out->widthStep,
+			src->imageData + r * src->widthStep, row_bytes);
+	return out;
+}
+
+/** Shared owner of an IplImage created with cvCreateImage() */
+static std::shared_ptr<void> make_ipl_owner(IplImage* ipl)
+{
+	return std::shared_ptr<void>(ipl, [](void* p) {
+		IplImage* ptr = static_cast<IplImage*>(p);
+		cvReleaseImage(&ptr);
+	});
+}
+
+/** Shared owner of an IplImage header pointing to pixels owned by
+ * someone else, which are kept alive by holding `pixels_owner`. */
+static std::shared_ptr<void> make_header_owner(
+	IplImage* header, std::shared_ptr<void> pixels_owner)
+{
+	return std::shared_ptr<void>(header, [pixels_owner](void* p) mutable {
+		IplImage* ptr = static_cast<IplImage*>(p);
+		cvReleaseImageHeader(&ptr);
+		pixels_owner.reset();  // The pixels may be freed now, too.
+	});
+}
+#endif
+
 /*---------------------------------------------------------------
 					Constructor
 ---------------------------------------------------------------*/
@@ -116,7 +158,19 @@ CImage& CImage::operator=(const CImage& o)
 		ASSERTMSG_(
 			o.img != nullptr,
 			"Source image in = operator has nullptr IplImage*");
-		img = cvCloneImage((IplImage*)o.img);
+		if (o.m_imgOwner)
+		{
+			// Just share the pixels (copy-on-write):
+			img = o.img;
+			m_imgOwner = o.m_imgOwner;
+			m_imgIsReadOnly = o.m_imgIsReadOnly;
+		}
+		else
+		{
+			// Read-only IplImage: we don't know for how long it will exist.
+			img = deep_copy_ipl(static_cast<const IplImage*>(o.img));
+			m_imgOwner = make_ipl_owner(static_cast<IplImage*>(img));
+		}
 #endif
 	}
 	else
@@ -133,6 +187,7 @@ CImage& CImage::operator=(const CImage& o)
 void CImage::swap(CImage& o)
 {
 	std::swap(img, o.img);
+	std::swap(m_imgOwner, o.m_imgOwner);
 	std::swap(m_imgIsReadOnly, o.m_imgIsReadOnly);
 	std::swap(m_imgIsExternalStorage, o.m_imgIsExternalStorage);
 	std::swap(m_externalFile, o.m_externalFile);
@@ -184,11 +239,13 @@ void CImage::copyFastFrom(CImage& o)
 
 		// Make the transfer of just the pointer:
 		img = o.img;
+		m_imgOwner = std::move(o.m_imgOwner);
 		m_imgIsReadOnly = o.m_imgIsReadOnly;
 		m_imgIsExternalStorage = o.m_imgIsExternalStorage;
 		m_externalFile = o.m_externalFile;
 
 		o.img = nullptr;
+		o.m_imgOwner.reset();
 		o.m_imgIsReadOnly = false;
 		o.m_imgIsExternalStorage = false;
 	}
@@ -208,7 +265,7 @@ CImage::CImage(void* iplImage)
 	if (!iplImage)
 		changeSize(1, 1, 1, true);
 	else
-		img = cvCloneImage((IplImage*)iplImage);
+		setFromIplImage(deep_copy_ipl(static_cast<const IplImage*>(iplImage)));
 #endif
 	MRPT_END
 }
@@ -236,7 +293,7 @@ void CImage::changeSize(
 		if (static_cast<unsigned int>(ipl->width) == width &&
 			static_cast<unsigned int>(ipl->height) == height &&
 			ipl->nChannels == nChannels &&
-			ipl->origin == (originTopLeft ? 0 : 1))
+			ipl->origin == (originTopLeft ? 0 : 1) && !isBufferShared())
 		{
 			return;  // nothing to do, we're already right with the current
 			// IplImage!
@@ -251,8 +308,10 @@ void CImage::changeSize(
 	alloc_tims.enter(sLog.c_str());
 #endif
 
-	img = cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, nChannels);
-	((IplImage*)img)->origin = originTopLeft ? 0 : 1;
+	IplImage* newImg =
+		cvCreateImage(cvSize(width, height), IPL_DEPTH_8U, nChannels);
+	newImg->origin = originTopLeft ? 0 : 1;
+	setFromIplImage(newImg);
 
 #if IMAGE_ALLOC_PERFLOG
 	alloc_tims.leave(sLog.c_str());
@@ -276,8 +335,7 @@ bool CImage::loadFromFile(const std::string& fileName, int isColor)
 	IplImage* newImg = cvLoadImage(fileName.c_str(), isColor);
 	if (newImg != nullptr)
 	{
-		releaseIpl();
-		img = newImg;
+		setFromIplImage(newImg);
 		return true;
 	}
 	else
@@ -326,7 +384,7 @@ void CImage::loadFromIplImage(void* iplImage)
 	if (iplImage)
 	{
 #if MRPT_HAS_OPENCV
-		img = cvCloneImage((IplImage*)iplImage);
+		setFromIplImage(deep_copy_ipl(static_cast<const IplImage*>(iplImage)));
 #else
 		THROW_EXCEPTION("The MRPT has been compiled with MRPT_HAS_OPENCV=0 !");
 #endif
@@ -368,7 +426,8 @@ void CImage::setFromIplImage(void* iplImage)
 	if (iplImage)
 	{
 #if MRPT_HAS_OPENCV
-		img = (IplImage*)iplImage;
+		img = iplImage;
+		m_imgOwner = make_ipl_owner(static_cast<IplImage*>(iplImage));
 #else
 		THROW_EXCEPTION("The MRPT has been compiled with MRPT_HAS_OPENCV=0 !");
 #endif
@@ -379,6 +438,124 @@ void CImage::setFromIplImage(void* iplImage)
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+					setFromImageReadOnly
+---------------------------------------------------------------*/
+void CImage::setFromImageReadOnly(const CImage& other_img)
+{
+	MRPT_START
+	if (this == &other_img) return;
+	other_img.makeSureImageIsLoaded();
+	if (!other_img.m_imgOwner)
+	{
+		// Read-only IplImage: keep the same semantics
+		setFromIplImageReadOnly(other_img.img);
+		return;
+	}
+	releaseIpl();
+	img = other_img.img;
+	m_imgOwner = other_img.m_imgOwner;
+	m_imgIsReadOnly = true;
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					setFromExternalBuffer
+---------------------------------------------------------------*/
+void CImage::setFromExternalBuffer(
+	unsigned int width, unsigned int height, TImageChannels nChannels,
+	size_t row_stride, unsigned char* pixels, std::shared_ptr<void> owner)
+{
+	MRPT_START
+#if MRPT_HAS_OPENCV
+	ASSERT_(pixels != nullptr);
+	ASSERT_(nChannels == CH_GRAY || nChannels == CH_RGB);
+	ASSERT_(row_stride >= static_cast<size_t>(width) * nChannels);
+
+	IplImage* header =
+		cvCreateImageHeader(cvSize(width, height), IPL_DEPTH_8U, nChannels);
+	cvSetData(header, pixels, static_cast<int>(row_stride));
+
+	releaseIpl();
+	img = header;
+	m_imgOwner = make_header_owner(header, std::move(owner));
+	m_imgIsReadOnly = true;
+#else
+	MRPT_UNUSED_PARAM(width);
+	MRPT_UNUSED_PARAM(height);
+	MRPT_UNUSED_PARAM(nChannels);
+	MRPT_UNUSED_PARAM(row_stride);
+	MRPT_UNUSED_PARAM(pixels);
+	MRPT_UNUSED_PARAM(owner);
+	THROW_EXCEPTION("The MRPT has been compiled with MRPT_HAS_OPENCV=0 !");
+#endif
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					makeView
+---------------------------------------------------------------*/
+CImage CImage::makeView(
+	const unsigned int col, const unsigned int row, const unsigned int width,
+	const unsigned int height) const
+{
+	MRPT_START
+	CImage view(UNINITIALIZED_IMAGE);
+#if MRPT_HAS_OPENCV
+	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	const IplImage* src = static_cast<const IplImage*>(img);
+	ASSERT_(src);
+	if (src->width < static_cast<int>(col + width) ||
+		src->height < static_cast<int>(row + height))
+	{
+		THROW_EXCEPTION(
+			format(
+				"Trying to make a view out of image boundaries: Image "
+				"size=%ix%i, View size=%ux%u, location=(%u,%u)",
+				src->width, src->height, width, height, col, row))
+	}
+
+	IplImage* header =
+		cvCreateImageHeader(cvSize(width, height), src->depth, src->nChannels);
+	header->origin = src->origin;
+	memcpy(header->colorModel, src->colorModel, 4);
+	memcpy(header->channelSeq, src->channelSeq, 4);
+	cvSetData(
+		header,
+		src->imageData + row * src->widthStep +
+			col * src->nChannels * ((src->depth & 255) >> 3),
+		src->widthStep);
+
+	view.img = header;
+	view.m_imgOwner = make_header_owner(header, m_imgOwner);
+	view.m_imgIsReadOnly = true;
+#else
+	MRPT_UNUSED_PARAM(col);
+	MRPT_UNUSED_PARAM(row);
+	MRPT_UNUSED_PARAM(width);
+	MRPT_UNUSED_PARAM(height);
+	THROW_EXCEPTION("The MRPT has been compiled with MRPT_HAS_OPENCV=0 !");
+#endif
+	return view;
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					unshareBuffer
+---------------------------------------------------------------*/
+void CImage::unshareBuffer()
+{
+	MRPT_START
+#if MRPT_HAS_OPENCV
+	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	IplImage* copy = deep_copy_ipl(static_cast<const IplImage*>(img));
+	releaseIpl(true);  // Keep the external storage flags, if any
+	img = copy;
+	m_imgOwner = make_ipl_owner(copy);
+#endif
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 					loadFromMemoryBuffer
 ---------------------------------------------------------------*/
@@ -449,7 +626,7 @@ void CImage::loadFromMemoryBuffer(
 /*---------------------------------------------------------------
 					operator()
 ---------------------------------------------------------------*/
-unsigned char* CImage::operator()(
+const unsigned char* CImage::operator()(
 	unsigned int col, unsigned int row, unsigned int channel) const
 {
 #if MRPT_HAS_OPENCV
@@ -488,7 +665,7 @@ unsigned char* CImage::operator()(
 /*---------------------------------------------------------------
 					get_unsafe()
 ---------------------------------------------------------------*/
-unsigned char* CImage::get_unsafe(
+const unsigned char* CImage::get_unsafe(
 	unsigned int col, unsigned int row, unsigned int channel) const
 {
 #if MRPT_HAS_OPENCV
@@ -516,6 +693,18 @@ void CImage::serializeTo(mrpt::serialization::CArchive& out) const
 	if (m_imgIsExternalStorage) out << m_externalFile;
 // Nothing else to serialize!
 #else
+	// Views and external buffers may have any row stride, but the raw
+	// formats below assume that of a newly created image:
+	const IplImage* ipl_src = static_cast<const IplImage*>(img);
+	if (!m_imgIsExternalStorage && m_imgIsReadOnly && ipl_src &&
+		ipl_src->widthStep != ((ipl_src->width * ipl_src->nChannels + 3) & ~3))
+	{
+		CImage compact(UNINITIALIZED_IMAGE);
+		compact.setFromIplImage(deep_copy_ipl(ipl_src));
+		compact.serializeTo(out);
+		return;
+	}
+
 	{
 		// Added in version 6: possibility of being stored offline:
 		out << m_imgIsExternalStorage;
@@ -962,7 +1151,7 @@ float CImage::getAsFloat(unsigned int col, unsigned int row) const
 	if (isColor())
 	{
 		// Luminance: Y = 0.3R + 0.59G + 0.11B
-		unsigned char* pixels = (*this)(col, row, 0);
+		const unsigned char* pixels = (*this)(col, row, 0);
 		return (pixels[0] * 0.3f + pixels[1] * 0.59f + pixels[2] * 0.11f) /
 			   255.0f;
 	}
@@ -1232,6 +1421,7 @@ void CImage::setOriginTopLeft(bool val)
 {
 #if MRPT_HAS_OPENCV
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	makeSureImageIsNotShared();
 	ASSERT_(img);
 	((IplImage*)img)->origin = val ? 0 : 1;
 #endif
@@ -1249,6 +1439,7 @@ void CImage::setPixel(int x, int y, size_t color)
 #endif
 
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	makeSureImageIsNotShared();
 
 	IplImage* ipl = ((IplImage*)img);
 
@@ -1300,6 +1491,7 @@ void CImage::line(
 #if MRPT_HAS_OPENCV
 	MRPT_UNUSED_PARAM(penStyle);
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	makeSureImageIsNotShared();
 	IplImage* ipl = ((IplImage*)img);
 	ASSERT_(ipl);
 
@@ -1318,6 +1510,7 @@ void CImage::drawCircle(
 {
 #if MRPT_HAS_OPENCV
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	makeSureImageIsNotShared();
 	IplImage* ipl = ((IplImage*)img);
 	ASSERT_(ipl);
 
@@ -1333,6 +1526,8 @@ void CImage::update_patch(
 	const CImage& patch, const unsigned int col_, const unsigned int row_)
 {
 #if MRPT_HAS_OPENCV
+	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	makeSureImageIsNotShared();
 	IplImage* ipl_int = ((IplImage*)img);
 	IplImage* ipl_ext = ((IplImage*)patch.img);
 	ASSERT_(ipl_int);
@@ -1343,12 +1538,14 @@ void CImage::update_patch(
 	{
 		THROW_EXCEPTION("Error : Patch jut out of image");
 	}
+	// Copy just the pixels: the patch could be a view, with a larger stride.
+	const size_t row_bytes = ipl_ext->width * ipl_ext->nChannels;
 	for (unsigned int i = 0; i < patch.getHeight(); i++)
 	{
 		memcpy(
 			&ipl_int->imageData[(i + row_) * ipl_int->widthStep +
 								col_ * ipl_int->nChannels],
-			&ipl_ext->imageData[i * ipl_ext->widthStep], ipl_ext->widthStep);
+			&ipl_ext->imageData[i * ipl_ext->widthStep], row_bytes);
 	}
 #endif
 }
@@ -1380,13 +1577,14 @@ void CImage::extract_patch(
 	IplImage* ipl_ext = ((IplImage*)patch.img);
 	ASSERT_(ipl_ext);
 
+	const size_t row_bytes = col_num * ipl_ext->nChannels;
 	for (unsigned int i = 0; i < row_num; i++)
 	{
 		memcpy(
 			&ipl_ext->imageData[i * ipl_ext->widthStep],
 			&ipl_int->imageData[(i + row_) * ipl_int->widthStep +
 								col_ * ipl_int->nChannels],
-			ipl_ext->widthStep);
+			row_bytes);
 	}
 
 #endif
@@ -1641,7 +1839,7 @@ void CImage::getAsMatrix(
 		// Luminance: Y = 0.3R + 0.59G + 0.11B
 		for (int y = 0; y < ly; y++)
 		{
-			unsigned char* pixels = this->get_unsafe(x_min, y_min + y, 0);
+			const unsigned char* pixels = this->get_unsafe(x_min, y_min + y, 0);
 			float aux;
 			for (int x = 0; x < lx; x++)
 			{
@@ -1656,7 +1854,7 @@ void CImage::getAsMatrix(
 	{
 		for (int y = 0; y < ly; y++)
 		{
-			unsigned char* pixels = this->get_unsafe(x_min, y_min + y, 0);
+			const unsigned char* pixels = this->get_unsafe(x_min, y_min + y, 0);
 			for (int x = 0; x < lx; x++)
 				outMatrix.set_unsafe(y, x, (*pixels++) * (1.0f / 255));
 		}
@@ -1701,7 +1899,7 @@ void CImage::getAsRGBMatrices(
 	{
 		for (int y = 0; y < ly; y++)
 		{
-			unsigned char* pixels = this->get_unsafe(x_min, y_min + y, 0);
+			const unsigned char* pixels = this->get_unsafe(x_min, y_min + y, 0);
 			float aux;
 			for (int x = 0; x < lx; x++)
 			{
@@ -1718,7 +1916,7 @@ void CImage::getAsRGBMatrices(
 	{
 		for (int y = 0; y < ly; y++)
 		{
-			unsigned char* pixels = this->get_unsafe(x_min, y_min + y, 0);
+			const unsigned char* pixels = this->get_unsafe(x_min, y_min + y, 0);
 			for (int x = 0; x < lx; x++)
 			{
 				outMatrixR.set_unsafe(y, x, (*pixels) * (1.0f / 255));
@@ -1907,11 +2105,8 @@ void CImage::unload() const noexcept
 void CImage::releaseIpl(bool thisIsExternalImgUnload) noexcept
 {
 #if MRPT_HAS_OPENCV
-	if (img && !m_imgIsReadOnly)
-	{
-		IplImage* ptr = (IplImage*)img;
-		cvReleaseImage(&ptr);
-	}
+	// The IplImage is freed, if needed, once no other image shares it:
+	m_imgOwner.reset();
 	img = nullptr;
 	m_imgIsReadOnly = false;
 	if (!thisIsExternalImgUnload)
@@ -1984,6 +2179,8 @@ void CImage::getExternalStorageFileAbsolutePath(std::string& out_path) const
 void CImage::flipVertical(bool also_swapRB)
 {
 #if MRPT_HAS_OPENCV
+	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	makeSureImageIsNotShared();
 	IplImage* ptr = (IplImage*)img;
 	int options = CV_CVTIMG_FLIP;
 	if (also_swapRB) options |= CV_CVTIMG_SWAP_RB;
@@ -1994,6 +2191,8 @@ void CImage::flipVertical(bool also_swapRB)
 void CImage::flipHorizontal()
 {
 #if MRPT_HAS_OPENCV
+	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	makeSureImageIsNotShared();
 	IplImage* ptr = (IplImage*)img;
 	cvFlip(ptr, nullptr, 1);
 #endif
@@ -2006,6 +2205,7 @@ void CImage::swapRB()
 {
 #if MRPT_HAS_OPENCV
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	makeSureImageIsNotShared();
 	ASSERT_(img != nullptr);
 	IplImage* ptr = (IplImage*)img;
 	cvConvertImage(ptr, ptr, CV_CVTIMG_SWAP_RB);
@@ -2025,7 +2225,7 @@ void CImage::rectifyImageInPlace(void* mapX, void* mapY)
 	THROW_EXCEPTION("This method requires OpenCV 2.0.0 or above.");
 #else
 
-	IplImage* srcImg = getAs<IplImage>();  // Source Image
+	const IplImage* srcImg = static_cast<const IplImage*>(img);  // Source Image
 	IplImage* outImg =
 		cvCreateImage(cvGetSize(srcImg), srcImg->depth, srcImg->nChannels);
 
@@ -2039,8 +2239,7 @@ void CImage::rectifyImageInPlace(void* mapX, void* mapY)
 	cvRemap(srcImg, outImg, &_mapXX, &_mapYY, CV_INTER_CUBIC);
 #endif
 
-	releaseIpl();
-	img = outImg;
+	setFromIplImage(outImg);
 #endif
 }
 
@@ -2053,7 +2252,7 @@ void CImage::rectifyImageInPlace(const mrpt::img::TCamera& cameraParams)
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
 	ASSERT_(img != nullptr);
 	// MRPT -> OpenCV Input Transformation
-	IplImage* srcImg = getAs<IplImage>();  // Source Image
+	const IplImage* srcImg = static_cast<const IplImage*>(img);  // Source Image
 	IplImage* outImg;  // Output Image
 	outImg = cvCreateImage(cvGetSize(srcImg), srcImg->depth, srcImg->nChannels);
 
@@ -2071,8 +2270,7 @@ void CImage::rectifyImageInPlace(const mrpt::img::TCamera& cameraParams)
 	cvUndistort2(srcImg, outImg, &inMat, &distM);
 
 	// Assign the output image to the IPLImage pointer within the CImage
-	releaseIpl();
-	img = outImg;
+	setFromIplImage(outImg);
 #endif
 }
 
@@ -2146,7 +2344,7 @@ void CImage::filterMedianInPlace(int W)
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
 	ASSERT_(img != nullptr);
 	// MRPT -> OpenCV Input Transformation
-	IplImage* srcImg = getAs<IplImage>();  // Source Image
+	const IplImage* srcImg = static_cast<const IplImage*>(img);  // Source Image
 	IplImage* outImg;  // Output Image
 	outImg = cvCreateImage(cvGetSize(srcImg), srcImg->depth, srcImg->nChannels);
 
@@ -2156,8 +2354,7 @@ void CImage::filterMedianInPlace(int W)
 	outImg->origin = srcImg->origin;
 
 	// Assign the output image to the IPLImage pointer within the CImage
-	releaseIpl();
-	img = outImg;
+	setFromIplImage(outImg);
 #endif
 }
 
@@ -2196,7 +2393,7 @@ void CImage::filterGaussianInPlace(int W, int H)
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
 	ASSERT_(img != nullptr);
 	// MRPT -> OpenCV Input Transformation
-	IplImage* srcImg = getAs<IplImage>();  // Source Image
+	const IplImage* srcImg = static_cast<const IplImage*>(img);  // Source Image
 	IplImage* outImg;  // Output Image
 	outImg = cvCreateImage(cvGetSize(srcImg), srcImg->depth, srcImg->nChannels);
 
@@ -2206,8 +2403,7 @@ void CImage::filterGaussianInPlace(int W, int H)
 	outImg->origin = srcImg->origin;
 
 	// Assign the output image to the IPLImage pointer within the CImage
-	releaseIpl();
-	img = outImg;
+	setFromIplImage(outImg);
 #endif
 }
 
@@ -2220,7 +2416,7 @@ void CImage::scaleImage(
 #if MRPT_HAS_OPENCV
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
 	ASSERT_(img != nullptr);
-	IplImage* srcImg = getAs<IplImage>();  // Source Image
+	const IplImage* srcImg = static_cast<const IplImage*>(img);  // Source Image
 
 	if (static_cast<unsigned int>(srcImg->width) == width &&
 		static_cast<unsigned int>(srcImg->height) == height)
@@ -2236,8 +2432,7 @@ void CImage::scaleImage(
 	outImg->origin = srcImg->origin;
 
 	// Assign the output image to the IPLImage pointer within the CImage
-	releaseIpl();
-	img = outImg;
+	setFromIplImage(outImg);
 #endif
 }
 
@@ -2285,7 +2480,7 @@ void CImage::rotateImage(
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
 	ASSERT_(img != nullptr);
 
-	IplImage* srcImg = getAs<IplImage>();  // Source Image
+	const IplImage* srcImg = static_cast<const IplImage*>(img);  // Source Image
 	IplImage* outImg;  // Output Image
 	outImg = cvCreateImage(cvGetSize(srcImg), srcImg->depth, srcImg->nChannels);
 
@@ -2308,8 +2503,7 @@ void CImage::rotateImage(
 	outImg->origin = srcImg->origin;
 
 	// Assign the output image to the IPLImage pointer within the CImage
-	releaseIpl();
-	img = outImg;
+	setFromIplImage(outImg);
 
 #endif
 }
@@ -2415,9 +2609,10 @@ void CImage::colorImage(CImage& ret) const
 void CImage::colorImageInPlace()
 {
 #if MRPT_HAS_OPENCV
+	makeSureImageIsLoaded();  // For delayed loaded images stored externally
 	if (this->isColor()) return;
 
-	IplImage* srcImg = getAs<IplImage>();  // Source Image
+	const IplImage* srcImg = static_cast<const IplImage*>(img);  // Source Image
 	IplImage* outImg;  // Output Image
 	outImg = cvCreateImage(cvGetSize(srcImg), srcImg->depth, 3);
 
@@ -2426,8 +2621,7 @@ void CImage::colorImageInPlace()
 	outImg->origin = srcImg->origin;
 
 	// Assign the output image to the IPLImage pointer within the CImage
-	releaseIpl();
-	img = outImg;
+	setFromIplImage(outImg);
 #endif
 }
 
@@ -2464,10 +2658,11 @@ void CImage::joinImagesHorz(const CImage& im1, const CImage& im2)
 			cvSize(_im1->width + _im2->width, _im1->height), _im1->depth,
 			this->getChannelCount());
 		cvCvtColor(out, out2, CV_GRAY2BGR);
-		this->setFromIplImageReadOnly(out2);
+		cvReleaseImage(&out);
+		this->setFromIplImage(out2);
 	}
 	else  // Assign the output image to the IPLImage pointer within the CImage
-		this->setFromIplImageReadOnly(out);
+		this->setFromIplImage(out);
 
 #endif
 }  // end
@@ -2517,8 +2712,9 @@ void CImage::equalizeHist(CImage& outImg) const
 void CImage::equalizeHistInPlace()
 {
 #if MRPT_HAS_OPENCV
+	makeSureImageIsLoaded();  // For delayed loaded images stored externally
 	// Convert to a single luminance channel image
-	IplImage* srcImg = getAs<IplImage>();  // Source Image
+	const IplImage* srcImg = static_cast<const IplImage*>(img);  // Source Image
 	ASSERT_(srcImg != nullptr);
 
 	IplImage* outImg =
@@ -2551,8 +2747,7 @@ void CImage::equalizeHistInPlace()
 	}
 
 	// Assign the output image to the IPLImage pointer within the CImage
-	releaseIpl();
-	img = outImg;
+	setFromIplImage(outImg);
 
 #endif
 }
@@ -2732,6 +2927,7 @@ void CImage::setChannelsOrder_RGB()
 {
 #if MRPT_HAS_OPENCV
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	makeSureImageIsNotShared();
 	ASSERT_(img);
 	strcpy(((IplImage*)img)->channelSeq, "RGB");
 #else
@@ -2743,6 +2939,7 @@ void CImage::setChannelsOrder_BGR()
 {
 #if MRPT_HAS_OPENCV
 	makeSureImageIsLoaded();  // For delayed loaded images stored externally
+	makeSureImageIsNotShared();
 	ASSERT_(img);
 	strcpy(((IplImage*)img)->channelSeq, "BGR");
 #else
@@ -0,0 +1,141 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/config.h>
+#include <mrpt/img/CImage.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+using namespace mrpt::img;
+
+#if MRPT_HAS_OPENCV  // CImage has no pixels without OpenCV
+
+static uint8_t testPattern(unsigned int x, unsigned int y)
+{
+	return static_cast<uint8_t>((x + 3 * y) & 0x7F);
+}
+
+static CImage makeTestImage(unsigned int w, unsigned int h)
+{
+	CImage img(w, h, CH_GRAY);
+	for (unsigned int y = 0; y < h; y++)
+		for (unsigned int x = 0; x < w; x++) *img(x, y) = testPattern(x, y);
+	return img;
+}
+
+// Checks the pixels of `img` against the pattern, starting at (x0,y0):
+static void checkTestPattern(
+	const CImage& img, unsigned int x0 = 0, unsigned int y0 = 0)
+{
+	for (unsigned int y = 0; y < img.getHeight(); y++)
+		for (unsigned int x = 0; x < img.getWidth(); x++)
+			ASSERT_EQ(*img(x, y), testPattern(x0 + x, y0 + y))
+				<< "x=" << x << " y=" << y;
+}
+
+TEST(CImage, CopyOnWrite)
+{
+	CImage a = makeTestImage(40, 30);
+
+	// Modifying a copy leaves the original intact:
+	CImage b(a);
+	EXPECT_TRUE(a.isBufferShared());
+	EXPECT_TRUE(b.isBufferShared());
+	*b(5, 5) = 255;
+	EXPECT_FALSE(b.isBufferShared());
+	EXPECT_EQ(*static_cast<const CImage&>(b)(5, 5), 255);
+	checkTestPattern(a);
+
+	// Modifying the original leaves the copy intact:
+	CImage c;
+	c = a;
+	EXPECT_TRUE(c.isBufferShared());
+	*a(6, 6) = 255;
+	EXPECT_EQ(*static_cast<const CImage&>(a)(6, 6), 255);
+	checkTestPattern(c);
+
+	// In-place operations also unshare the pixels:
+	CImage d(c);
+	d.flipVertical();
+	checkTestPattern(c);
+}
+
+TEST(CImage, ViewOutlivesParent)
+{
+	CImage view;
+	{
+		const CImage parent = makeTestImage(40, 30);
+		view = parent.makeView(10, 5, 8, 6);
+		EXPECT_EQ(view.getRowStride(), parent.getRowStride());
+	}
+	EXPECT_EQ(view.getWidth(), 8U);
+	EXPECT_EQ(view.getHeight(), 6U);
+	checkTestPattern(view, 10, 5);
+	EXPECT_ANY_THROW(view.makeView(4, 4, 8, 6));
+}
+
+TEST(CImage, NonConstAccessUnsharesView)
+{
+	const CImage parent = makeTestImage(40, 30);
+	CImage view = parent.makeView(10, 5, 8, 6);
+	EXPECT_TRUE(view.isBufferShared());
+
+	// Const accesses keep sharing the pixels:
+	const CImage& cview = view;
+	EXPECT_EQ(cview.get_unsafe(0, 0), parent.get_unsafe(10, 5));
+	EXPECT_TRUE(view.isBufferShared());
+
+	*view(0, 0) = 255;
+	EXPECT_FALSE(view.isBufferShared());
+	EXPECT_NE(cview.get_unsafe(0, 0), parent.get_unsafe(10, 5));
+	EXPECT_EQ(*cview(0, 0), 255);
+	EXPECT_EQ(*cview(1, 0), testPattern(11, 5));
+	EXPECT_EQ(*cview(7, 5), testPattern(17, 10));
+	checkTestPattern(parent);
+}
+
+TEST(CImage, ExternalBufferSerialization)
+{
+	const unsigned int W = 13, H = 7;
+	const size_t stride = 32;
+	const uint8_t PADDING = 0xAB;
+	auto buf = std::make_shared<std::vector<uint8_t>>(stride * H, PADDING);
+	for (unsigned int y = 0; y < H; y++)
+		for (unsigned int x = 0; x < W; x++)
+			(*buf)[y * stride + x] = testPattern(x, y);
+
+	CImage ext;
+	ext.setFromExternalBuffer(W, H, CH_GRAY, stride, buf->data(), buf);
+	buf.reset();  // The image keeps the buffer alive
+	EXPECT_EQ(ext.getRowStride(), stride);
+	EXPECT_TRUE(ext.isBufferShared());
+	checkTestPattern(ext);
+
+	mrpt::io::CMemoryStream mem;
+	auto arch = mrpt::serialization::archiveFrom(mem);
+	arch << ext;
+	mem.Seek(0);
+	CImage out;
+	arch >> out;
+
+	EXPECT_EQ(out.getWidth(), W);
+	EXPECT_EQ(out.getHeight(), H);
+	EXPECT_FALSE(out.isColor());
+	checkTestPattern(out);
+
+	// Serializing did not touch the external buffer:
+	const CImage& cext = ext;
+	checkTestPattern(cext);
+	EXPECT_EQ(cext.get_unsafe(0, 0)[W], PADDING);
+}
+
+#endif  // MRPT_HAS_OPENCV
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <mrpt/io/CStream.h>
+#include <memory>
 
 namespace mrpt::io
 {
@@ -18,7 +19,12 @@ namespace mrpt::io
  *  This class requires compiling MRPT with wxWidgets. If wxWidgets is not
  * available then the class is actually mapped to the standard CFileInputStream
  *
- * \sa CFileInputStream
+ *  Files in BGZF (blocked gzip) format, e.g. those written by
+ * CFileGZOutputStream in multi-threaded mode, are detected automatically.
+ * For them, blocks can be decompressed ahead in parallel (see open()) and
+ * Seek() is supported.
+ *
+ * \sa CFileInputStream, mrpt::io::zip::decompress_bgzf_block
  * \ingroup mrpt_io_grp
  */
 class CFileGZInputStream : public CStream
@@ -27,6 +33,9 @@ class CFileGZInputStream : public CStream
 	void* m_f;
 	/** Compressed file size */
 	uint64_t m_file_size;
+	struct BGZFImpl;
+	/** Only used for files in BGZF format */
+	std::unique_ptr<BGZFImpl> m_bgzf;
 
    public:
 	/** Constructor without open */
@@ -46,9 +55,13 @@ class CFileGZInputStream : public CStream
 
 	/** Opens the file for read.
 	 * \param fileName The file to be open in this stream
+	 * \param num_threads Only for files in BGZF format: if `1` (default),
+	 * blocks are decompressed in the calling thread; otherwise, up to this
+	 * number of the next blocks are decompressed ahead of the reads in
+	 * mrpt::system::TaskScheduler (`0` means as many as its concurrency).
 	 * \return false if there's an error opening the file, true otherwise
 	 */
-	bool open(const std::string& fileName);
+	bool open(const std::string& fileName, unsigned int num_threads = 1);
 	/** Closes the file */
 	void close();
 	/** Returns true if the file was open without errors. */
@@ -64,9 +77,17 @@ class CFileGZInputStream : public CStream
 	/** Method for getting the current cursor position in the <b>compressed</b>,
 	 * where 0 is the first byte and TotalBytesCount-1 the last one. */
 	uint64_t getPosition() const override;
+	/** Returns true if the open file is in BGZF format, hence seekable. */
+	bool isBGZF() const { return m_bgzf != nullptr; }
 
-	/** This method is not implemented in this class */
-	uint64_t Seek(int64_t, CStream::TSeekOrigin = sFromBeginning) override;
+	/** Moves the read position to the given <b>uncompressed</b> offset.
+	 * Only available for files in BGZF format: the first call scans the
+	 * headers of all blocks in the file, then the block with the requested
+	 * offset is decompressed.
+	 * \exception std::exception If the file is not in BGZF format, or the
+	 * offset is out of range. */
+	uint64_t Seek(
+		int64_t Offset, CStream::TSeekOrigin Origin = sFromBeginning) override;
 	size_t Read(void* Buffer, size_t Count) override;
 	size_t Write(const void* Buffer, size_t Count) override;
 };  // End of class def.
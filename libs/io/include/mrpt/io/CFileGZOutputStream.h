@@ -9,6 +9,7 @@
 #pragma once
 
 #include <mrpt/io/CStream.h>
+#include <memory>
 
 namespace mrpt::io
 {
@@ -18,13 +19,21 @@ namespace mrpt::io
  *  This class requires compiling MRPT with wxWidgets. If wxWidgets is not
  * available then the class is actually mapped to the standard CFileOutputStream
  *
- * \sa CFileOutputStream
+ *  If open() is called with `num_threads!=1`, the file is written in the
+ * BGZF (blocked gzip) format, compressing blocks of 64 KiB in parallel in the
+ * process-wide mrpt::system::TaskScheduler. BGZF files are also valid gzip files, and
+ * CFileGZInputStream can decompress them in parallel and seek in them.
+ *
+ * \sa CFileOutputStream, mrpt::io::zip::compress_bgzf_block
  * \ingroup mrpt_io_grp
  */
 class CFileGZOutputStream : public CStream
 {
    private:
 	void* m_f;
+	struct BGZFImpl;
+	/** Only used in multi-threaded BGZF mode */
+	std::unique_ptr<BGZFImpl> m_bgzf;
 
    public:
 	/** Constructor: opens an output file with compression level = 1 (minimum,
@@ -48,10 +57,18 @@ class CFileGZOutputStream : public CStream
 	/** Open a file for write, choosing the compression level
 	 * \param fileName The file to be open in this stream
 	 * \param compress_level 0:no compression, 1:fastest, 9:best
+	 * \param num_threads If `1` (default), the file is compressed as a single
+	 * gzip stream in the calling thread. Otherwise, it is written in BGZF
+	 * format, compressing up to this number of blocks at once in
+	 * mrpt::system::TaskScheduler (`0` means as many as its concurrency).
 	 * \return true on success, false on any error.
 	 */
-	bool open(const std::string& fileName, int compress_level = 1);
-	/** Close the file */
+	bool open(
+		const std::string& fileName, int compress_level = 1,
+		unsigned int num_threads = 1);
+	/** Close the file. In BGZF mode, this waits for all pending blocks to
+	 * be compressed and written.
+	 * \exception std::exception On any error writing pending blocks. */
 	void close();
 	/** Returns true if the file was open without errors. */
 	bool fileOpenCorrectly() const;
@@ -0,0 +1,69 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace mrpt::io
+{
+/** Read-only view of the contents of a file, mapped into the process memory
+ * with `mmap()` (or `MapViewOfFile()` in Windows).
+ *
+ * Pages of the file are loaded by the OS on demand when they are accessed,
+ * so opening a file is fast regardless of its size, and only the parts
+ * actually accessed are read from disk. The memory is shared among threads
+ * and can be read concurrently.
+ *
+ * Wrap a fragment of the file with mrpt::io::CMemoryStream::assignMemoryNotOwn()
+ * to deserialize objects from it without copying the file contents.
+ *
+ * \sa mrpt::obs::CRawlogIndexed
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_io_grp
+ */
+class CMemoryMappedFile
+{
+   public:
+	/** Default constructor, without opening any file \sa open */
+	CMemoryMappedFile() = default;
+	/** Constructor which opens a file
+	 * \exception std::exception On any error opening or mapping the file.
+	 */
+	CMemoryMappedFile(const std::string& fileName);
+	/** Unmaps the file, if it was open */
+	~CMemoryMappedFile();
+
+	CMemoryMappedFile(const CMemoryMappedFile&) = delete;
+	CMemoryMappedFile& operator=(const CMemoryMappedFile&) = delete;
+
+	/** Opens a file and maps its whole contents into memory, closing any
+	 * previously open file.
+	 * \return false on any error.
+	 */
+	bool open(const std::string& fileName);
+	/** Unmaps the file. */
+	void close();
+	/** Returns true if a file is open */
+	bool isOpen() const { return m_open; }
+	/** Pointer to the first byte of the file */
+	const uint8_t* data() const { return m_data; }
+	/** Size of the file in bytes */
+	uint64_t size() const { return m_size; }
+
+   private:
+	const uint8_t* m_data{nullptr};
+	uint64_t m_size{0};
+	bool m_open{false};
+#ifdef _WIN32
+	void* m_hFile{nullptr};
+	void* m_hMapping{nullptr};
+#endif
+};
+}  // namespace mrpt::io
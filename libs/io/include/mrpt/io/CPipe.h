@@ -11,6 +11,7 @@
 #include <mrpt/io/CStream.h>
 #include <string>
 #include <memory>  // for unique_ptr<>
+#include <stdexcept>
 
 namespace mrpt::io
 {
@@ -97,6 +97,46 @@ bool compress_gz_data_block(
 bool decompress_gz_data_block(
 	const std::vector<uint8_t>& in_gz_data, std::vector<uint8_t>& out_data);
 
+/** \name BGZF (blocked gzip) blocks
+ * BGZF is the gzip variant used in the SAM/BAM file formats: a sequence of
+ * gzip members ("blocks"), each one holding up to BGZF_MAX_BLOCK_DATA
+ * uncompressed bytes, and storing its compressed size in a gzip extra field.
+ * Blocks are independent, so they can be compressed or decompressed in
+ * parallel, and decompression can start at any block. A BGZF file is a valid
+ * gzip file, readable by any gzip tool.
+ * \sa CFileGZOutputStream::open, CFileGZInputStream::open
+ * @{ */
+
+/** Maximum number of uncompressed bytes stored in one BGZF block */
+constexpr size_t BGZF_MAX_BLOCK_DATA = 0xff00;
+/** Length of the header of a BGZF block, in bytes */
+constexpr size_t BGZF_HEADER_LENGTH = 18;
+
+/** Compresses up to BGZF_MAX_BLOCK_DATA bytes into one BGZF block.
+ *  compress_level: 0=no compression, 1=best speed, 9=maximum
+ * \exception std::exception On any error or if inDataSize is too large.
+ */
+void compress_bgzf_block(
+	const void* inData, size_t inDataSize, std::vector<uint8_t>& outBlock,
+	const int compress_level = 1);
+
+/** Decompresses one whole BGZF block (header included), checking its CRC.
+ * \exception std::exception On any error or corrupted data.
+ */
+void decompress_bgzf_block(
+	const void* block, size_t blockSize, std::vector<uint8_t>& outData);
+
+/** Parses the header of a BGZF block (BGZF_HEADER_LENGTH bytes).
+ * \return The total length of the block in bytes (header included), or 0 if
+ * the data is not a BGZF header.
+ */
+size_t bgzf_block_size(const void* header, size_t headerLength);
+
+/** The empty BGZF block which marks the end of a BGZF file. */
+const std::vector<uint8_t>& bgzf_eof_block();
+
+/** @} */
+
 }  // End of namespace
 }  // End of namespace
 }  // End of namespace
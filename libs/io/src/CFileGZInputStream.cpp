@@ -10,10 +10,16 @@
 #include "io-precomp.h"  // Precompiled headers
 
 #include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/io/CFileInputStream.h>
+#include <mrpt/io/zip.h>
 #include <mrpt/system/filesystem.h>
+#include <mrpt/system/TaskScheduler.h>
 #include <mrpt/core/exceptions.h>
 
 #include <zlib.h>
+#include <algorithm>
+#include <cstring>
+#include <deque>
 
 using namespace mrpt::io;
 using namespace std;
@@ -25,6 +31,144 @@ static_assert(
 
 #define THE_GZFILE reinterpret_cast<gzFile>(m_f)
 
+// Reader of BGZF blocks, which are decompressed ahead in the process-wide task
+// scheduler:
+struct CFileGZInputStream::BGZFImpl
+{
+	CFileInputStream in;
+	/** Compressed file size, and position of the next block to read */
+	uint64_t fileSize{0}, filePos{0};
+	/** Maximum number of blocks decompressed at once. 1: decompress in the
+	 * calling thread */
+	size_t maxThreads{1};
+	/** Blocks being decompressed, in file order */
+	std::deque<std::future<std::vector<uint8_t>>> ahead;
+	/** Current decompressed block, and read position within it */
+	std::vector<uint8_t> cur;
+	size_t curPos{0};
+	/** Uncompressed read position */
+	uint64_t position{0};
+	bool noMoreBlocks{false};
+	/** (compressed offset, uncompressed offset) of each block, plus the end of
+	 * the file. Built on demand by buildBlockTable() */
+	std::vector<std::pair<uint64_t, uint64_t>> blocks;
+
+	/** Reads the next whole compressed block, or returns false at EOF. */
+	bool readRawBlock(std::vector<uint8_t>& raw)
+	{
+		// Never read past the end, which would leave "in" in a failed state:
+		if (filePos >= fileSize) return false;
+		uint8_t hdr[zip::BGZF_HEADER_LENGTH];
+		const size_t len =
+			zip::bgzf_block_size(hdr, in.Read(hdr, sizeof(hdr)));
+		ASSERTMSG_(len > sizeof(hdr), "Corrupted BGZF file: bad block header");
+		ASSERTMSG_(
+			filePos + len <= fileSize, "Corrupted BGZF file: truncated block");
+		raw.resize(len);
+		std::memcpy(&raw[0], hdr, sizeof(hdr));
+		in.Read(&raw[sizeof(hdr)], len - sizeof(hdr));
+		filePos += len;
+		return true;
+	}
+
+	/** Enqueues the decompression of the next blocks */
+	void readAhead()
+	{
+		const size_t maxAhead = maxThreads > 1 ? 2 * maxThreads : 1;
+		std::vector<uint8_t> raw;
+		while (!noMoreBlocks && ahead.size() < maxAhead)
+		{
+			if (!readRawBlock(raw))
+			{
+				noMoreBlocks = true;
+				break;
+			}
+			auto task = [](const std::vector<uint8_t>& blk) {
+				std::vector<uint8_t> out;
+				zip::decompress_bgzf_block(&blk[0], blk.size(), out);
+				return out;
+			};
+			if (maxThreads > 1)
+				ahead.emplace_back(
+					mrpt::system::TaskScheduler::Instance().async(
+						[task, blk = std::move(raw)]() { return task(blk); }));
+			else
+				ahead.emplace_back(
+					std::async(std::launch::deferred, task, std::move(raw)));
+		}
+	}
+
+	/** Moves to the next non-empty block. Returns false at EOF. */
+	bool nextBlock()
+	{
+		do
+		{
+			readAhead();
+			if (ahead.empty()) return false;
+			if (maxThreads > 1)
+				mrpt::system::TaskScheduler::Instance().wait(ahead.front());
+			cur = ahead.front().get();
+			ahead.pop_front();
+			curPos = 0;
+		} while (cur.empty());
+		return true;
+	}
+
+	void buildBlockTable()
+	{
+		if (!blocks.empty()) return;
+		uint64_t comp = 0, uncomp = 0;
+		while (comp < fileSize)
+		{
+			uint8_t hdr[zip::BGZF_HEADER_LENGTH];
+			in.Seek(comp);
+			const size_t len =
+				zip::bgzf_block_size(hdr, in.Read(hdr, sizeof(hdr)));
+			ASSERTMSG_(
+				len > sizeof(hdr) && comp + len <= fileSize,
+				"Corrupted BGZF file");
+			// The uncompressed length is the last field of the block:
+			uint8_t isize[4];
+			in.Seek(comp + len - 4);
+			ASSERTMSG_(in.Read(isize, 4) == 4, "Corrupted BGZF file");
+			blocks.emplace_back(comp, uncomp);
+			comp += len;
+			uncomp += uint32_t(isize[0]) | (uint32_t(isize[1]) << 8) |
+					  (uint32_t(isize[2]) << 16) | (uint32_t(isize[3]) << 24);
+		}
+		blocks.emplace_back(comp, uncomp);
+	}
+
+	void seek(uint64_t target)
+	{
+		buildBlockTable();
+		ASSERTMSG_(
+			target <= blocks.back().second, "Seek offset beyond end of file");
+		// Last block starting at or before "target":
+		auto it = std::upper_bound(
+			blocks.begin(), blocks.end(), target,
+			[](uint64_t t, const std::pair<uint64_t, uint64_t>& b) {
+				return t < b.second;
+			});
+		--it;
+		// Discard blocks decompressed ahead (tasks still running own their
+		// data, so there is no need to wait for them):
+		ahead.clear();
+		cur.clear();
+		curPos = 0;
+		in.Seek(it->first);
+		filePos = it->first;
+		noMoreBlocks = false;
+		position = it->second;
+		if (target > position)
+		{
+			nextBlock();
+			curPos = target - position;
+			position = target;
+		}
+	}
+};
+
 CFileGZInputStream::CFileGZInputStream(const string& fileName) : m_f(nullptr)
 {
 	MRPT_START
@@ -33,17 +177,36 @@ CFileGZInputStream::CFileGZInputStream(const string& fileName) : m_f(nullptr)
 }
 
 CFileGZInputStream::CFileGZInputStream() : m_f(nullptr) {}
-bool CFileGZInputStream::open(const std::string& fileName)
+bool CFileGZInputStream::open(
+	const std::string& fileName, unsigned int num_threads)
 {
 	MRPT_START
 
-	if (m_f) gzclose(THE_GZFILE);
+	close();
 
 	// Get compressed file size:
 	m_file_size = mrpt::system::getFileSize(fileName);
 	if (m_file_size == uint64_t(-1))
 		THROW_EXCEPTION_FMT("Couldn't access the file '%s'", fileName.c_str());
 
+	// Detect BGZF files:
+	{
+		auto bgzf = std::make_unique<BGZFImpl>();
+		if (!bgzf->in.open(fileName)) return false;
+		bgzf->fileSize = m_file_size;
+		uint8_t hdr[zip::BGZF_HEADER_LENGTH];
+		if (zip::bgzf_block_size(hdr, bgzf->in.Read(hdr, sizeof(hdr))))
+		{
+			bgzf->in.Seek(0);
+			bgzf->maxThreads =
+				num_threads
+					? num_threads
+					: mrpt::system::TaskScheduler::Instance().concurrency();
+			m_bgzf = std::move(bgzf);
+			return true;
+		}
+	}
+
 	// Open gz stream:
 	m_f = gzopen(fileName.c_str(), "rb");
 	return m_f != nullptr;
@@ -58,11 +221,28 @@ void CFileGZInputStream::close()
 		gzclose(THE_GZFILE);
 		m_f = nullptr;
 	}
+	m_bgzf.reset();
 }
 
 CFileGZInputStream::~CFileGZInputStream() { close(); }
 size_t CFileGZInputStream::Read(void* Buffer, size_t Count)
 {
+	if (m_bgzf)
+	{
+		auto& b = *m_bgzf;
+		auto* out = reinterpret_cast<uint8_t*>(Buffer);
+		size_t done = 0;
+		while (done < Count)
+		{
+			if (b.curPos == b.cur.size() && !b.nextBlock()) break;
+			const size_t n = std::min(Count - done, b.cur.size() - b.curPos);
+			std::memcpy(out + done, &b.cur[b.curPos], n);
+			b.curPos += n;
+			done += n;
+		}
+		b.position += done;
+		return done;
+	}
 	if (!m_f)
 	{
 		THROW_EXCEPTION("File is not open.");
@@ -80,7 +260,7 @@ size_t CFileGZInputStream::Write(const void* Buffer, size_t Count)
 
 uint64_t CFileGZInputStream::getTotalBytesCount() const
 {
-	if (!m_f)
+	if (!m_f && !m_bgzf)
 	{
 		THROW_EXCEPTION("File is not open.");
 	}
@@ -89,6 +269,7 @@ uint64_t CFileGZInputStream::getTotalBytesCount() const
 
 uint64_t CFileGZInputStream::getPosition() const
 {
+	if (m_bgzf) return m_bgzf->position;
 	if (!m_f)
 	{
 		THROW_EXCEPTION("File is not open.");
@@ -96,16 +277,46 @@ uint64_t CFileGZInputStream::getPosition() const
 	return gztell(THE_GZFILE);
 }
 
-bool CFileGZInputStream::fileOpenCorrectly() const { return m_f != nullptr; }
+bool CFileGZInputStream::fileOpenCorrectly() const
+{
+	return m_f != nullptr || m_bgzf;
+}
 bool CFileGZInputStream::checkEOF()
 {
+	if (m_bgzf)
+	{
+		auto& b = *m_bgzf;
+		if (b.curPos != b.cur.size()) return false;
+		if (b.filePos >= b.fileSize && b.ahead.empty()) return true;
+		// The remaining blocks may be empty (e.g. the BGZF EOF marker): move
+		// to the next one with data, which Read() would do anyway.
+		return !b.nextBlock();
+	}
 	if (!m_f)
 		return true;
 	else
 		return 0 != gzeof(THE_GZFILE);
 }
 
-uint64_t CFileGZInputStream::Seek(int64_t, CStream::TSeekOrigin)
+uint64_t CFileGZInputStream::Seek(int64_t Offset, CStream::TSeekOrigin Origin)
 {
-	THROW_EXCEPTION("Method not available in this class.");
+	MRPT_START
+	ASSERTMSG_(m_bgzf, "Seek() is only available for BGZF files.");
+	int64_t target = Offset;
+	switch (Origin)
+	{
+		case sFromBeginning:
+			break;
+		case sFromCurrent:
+			target += m_bgzf->position;
+			break;
+		case sFromEnd:
+			m_bgzf->buildBlockTable();
+			target += m_bgzf->blocks.back().second;
+			break;
+	};
+	ASSERTMSG_(target >= 0, "Seek offset before beginning of file");
+	m_bgzf->seek(static_cast<uint64_t>(target));
+	return m_bgzf->position;
+	MRPT_END
 }
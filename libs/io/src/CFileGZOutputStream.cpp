@@ -10,15 +10,77 @@
 #include "io-precomp.h"  // Precompiled headers
 
 #include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/zip.h>
 #include <mrpt/core/exceptions.h>
+#include <mrpt/system/TaskScheduler.h>
 
 #include <zlib.h>
+#include <deque>
+#include <iostream>
 
 #define THE_GZFILE reinterpret_cast<gzFile>(m_f)
 
 using namespace mrpt::io;
 using namespace std;
 
+// Writer of BGZF blocks, compressed in parallel in the process-wide task
+// scheduler and written in order:
+struct CFileGZOutputStream::BGZFImpl
+{
+	BGZFImpl(unsigned int num_threads, int compress_level)
+		: sched(mrpt::system::TaskScheduler::Instance()),
+		  maxThreads(num_threads ? num_threads : sched.concurrency()),
+		  level(compress_level)
+	{
+		block.reserve(zip::BGZF_MAX_BLOCK_DATA);
+	}
+
+	mrpt::system::TaskScheduler& sched;
+	/** Maximum number of blocks being compressed at once */
+	size_t maxThreads;
+	int level;
+	CFileOutputStream out;
+	/** Uncompressed data of the block being filled */
+	std::vector<uint8_t> block;
+	/** Blocks being compressed, in file order */
+	std::deque<std::future<std::vector<uint8_t>>> pending;
+	uint64_t position{0};
+
+	void writeFrontBlock()
+	{
+		sched.wait(pending.front());
+		const std::vector<uint8_t> blk = pending.front().get();
+		pending.pop_front();
+		if (out.Write(&blk[0], blk.size()) != blk.size())
+			THROW_EXCEPTION("Error writing to output file");
+	}
+
+	void dispatchBlock()
+	{
+		if (block.empty()) return;
+		pending.emplace_back(sched.async(
+			[in = std::move(block), lev = level]() {
+				std::vector<uint8_t> blk;
+				zip::compress_bgzf_block(&in[0], in.size(), blk, lev);
+				return blk;
+			}));
+		block.clear();
+		block.reserve(zip::BGZF_MAX_BLOCK_DATA);
+		// Bound the memory used by blocks waiting to be written:
+		while (pending.size() > 2 * maxThreads) writeFrontBlock();
+	}
+
+	void finish()
+	{
+		dispatchBlock();
+		while (!pending.empty()) writeFrontBlock();
+		const auto& eof = zip::bgzf_eof_block();
+		out.Write(&eof[0], eof.size());
+		out.close();
+	}
+};
+
 CFileGZOutputStream::CFileGZOutputStream(const string& fileName) : m_f(nullptr)
 {
 	MRPT_START
@@ -29,11 +91,23 @@ CFileGZOutputStream::CFileGZOutputStream(const string& fileName) : m_f(nullptr)
 }
 
 CFileGZOutputStream::CFileGZOutputStream() : m_f(nullptr) {}
-bool CFileGZOutputStream::open(const string& fileName, int compress_level)
+bool CFileGZOutputStream::open(
+	const string& fileName, int compress_level, unsigned int num_threads)
 {
 	MRPT_START
 
-	if (m_f) gzclose(THE_GZFILE);
+	close();
+
+	if (num_threads != 1)
+	{
+		m_bgzf.reset(new BGZFImpl(num_threads, compress_level));
+		if (!m_bgzf->out.open(fileName))
+		{
+			m_bgzf.reset();
+			return false;
+		}
+		return true;
+	}
 
 	// Open gz stream:
 	m_f = gzopen(fileName.c_str(), format("wb%i", compress_level).c_str());
@@ -42,7 +116,18 @@ bool CFileGZOutputStream::open(const string& fileName, int compress_level)
 	MRPT_END
 }
 
-CFileGZOutputStream::~CFileGZOutputStream() { close(); }
+CFileGZOutputStream::~CFileGZOutputStream()
+{
+	try
+	{
+		close();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[~CFileGZOutputStream] " << e.what() << std::endl;
+	}
+}
+
 void CFileGZOutputStream::close()
 {
 	if (m_f)
@@ -50,6 +135,12 @@ void CFileGZOutputStream::close()
 		gzclose(THE_GZFILE);
 		m_f = nullptr;
 	}
+	if (m_bgzf)
+	{
+		// Release the writer even if flushing throws:
+		std::unique_ptr<BGZFImpl> bgzf = std::move(m_bgzf);
+		bgzf->finish();
+	}
 }
 
 size_t CFileGZOutputStream::Read(void*, size_t)
@@ -59,6 +150,22 @@ size_t CFileGZOutputStream::Read(void*, size_t)
 
 size_t CFileGZOutputStream::Write(const void* Buffer, size_t Count)
 {
+	if (m_bgzf)
+	{
+		const auto* data = reinterpret_cast<const uint8_t*>(Buffer);
+		for (size_t done = 0; done < Count;)
+		{
+			auto& blk = m_bgzf->block;
+			const size_t n =
+				std::min(Count - done, zip::BGZF_MAX_BLOCK_DATA - blk.size());
+			blk.insert(blk.end(), data + done, data + done + n);
+			done += n;
+			if (blk.size() == zip::BGZF_MAX_BLOCK_DATA)
+				m_bgzf->dispatchBlock();
+		}
+		m_bgzf->position += Count;
+		return Count;
+	}
 	if (!m_f)
 	{
 		THROW_EXCEPTION("File is not open.");
@@ -68,6 +175,7 @@ size_t CFileGZOutputStream::Write(const void* Buffer, size_t Count)
 
 uint64_t CFileGZOutputStream::getPosition() const
 {
+	if (m_bgzf) return m_bgzf->position;
 	if (!m_f)
 	{
 		THROW_EXCEPTION("File is not open.");
@@ -75,7 +183,10 @@ uint64_t CFileGZOutputStream::getPosition() const
 	return gztell(THE_GZFILE);
 }
 
-bool CFileGZOutputStream::fileOpenCorrectly() const { return m_f != nullptr; }
+bool CFileGZOutputStream::fileOpenCorrectly() const
+{
+	return m_f != nullptr || m_bgzf;
+}
 uint64_t CFileGZOutputStream::Seek(int64_t, CStream::TSeekOrigin)
 {
 	THROW_EXCEPTION("Method not available in this class.");
@@ -0,0 +1,99 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/io/zip.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt::io;
+
+// Low-entropy data, so there is something to compress:
+static std::vector<uint8_t> generateTestData(size_t N)
+{
+	std::vector<uint8_t> data(N);
+	for (size_t i = 0; i < N; i++)
+		data[i] = static_cast<uint8_t>((i * i) >> 7);
+	return data;
+}
+
+TEST(CFileGZStreams, BGZFBlock)
+{
+	const auto data = generateTestData(zip::BGZF_MAX_BLOCK_DATA);
+	for (int level : {0, 1, 9})
+	{
+		std::vector<uint8_t> blk, out;
+		zip::compress_bgzf_block(&data[0], data.size(), blk, level);
+		EXPECT_EQ(zip::bgzf_block_size(&blk[0], blk.size()), blk.size());
+		zip::decompress_bgzf_block(&blk[0], blk.size(), out);
+		EXPECT_EQ(out, data);
+
+		// Corrupted data must be detected:
+		blk[blk.size() / 2] ^= 0x55;
+		EXPECT_THROW(
+			zip::decompress_bgzf_block(&blk[0], blk.size(), out),
+			std::exception);
+	}
+	const auto& eof = zip::bgzf_eof_block();
+	EXPECT_EQ(zip::bgzf_block_size(&eof[0], eof.size()), eof.size());
+}
+
+TEST(CFileGZStreams, MultiThreadedBGZFWriteAndRead)
+{
+	const auto data = generateTestData(1000000);
+	const std::string fil = mrpt::system::getTempFileName();
+	{
+		CFileGZOutputStream fo;
+		ASSERT_TRUE(fo.open(fil, 1, 4));
+		// Write in chunks of uneven sizes:
+		for (size_t i = 0; i < data.size();)
+		{
+			const size_t n = std::min<size_t>(data.size() - i, 1 + i % 100000);
+			fo.Write(&data[i], n);
+			i += n;
+		}
+		EXPECT_EQ(fo.getPosition(), data.size());
+	}
+
+	// The output must be a valid gzip file:
+	std::vector<uint8_t> gz_data;
+	ASSERT_TRUE(zip::decompress_gz_file(fil, gz_data));
+	EXPECT_EQ(gz_data, data);
+
+	for (unsigned int nThreads : {1, 3})
+	{
+		CFileGZInputStream fi;
+		ASSERT_TRUE(fi.open(fil, nThreads));
+		EXPECT_TRUE(fi.isBGZF());
+		EXPECT_FALSE(fi.checkEOF());
+		std::vector<uint8_t> read(data.size());
+		EXPECT_EQ(fi.Read(&read[0], read.size()), data.size());
+		EXPECT_EQ(read, data);
+		// EOF is reported right after the last byte, without a failed read:
+		EXPECT_TRUE(fi.checkEOF());
+		uint8_t dummy;
+		EXPECT_EQ(fi.Read(&dummy, 1), 0U);
+		EXPECT_TRUE(fi.checkEOF());
+
+		// Random access:
+		for (uint64_t pos : {500000U, 12U, 65280U, 999990U})
+		{
+			EXPECT_EQ(fi.Seek(pos), pos);
+			uint8_t buf[10];
+			EXPECT_EQ(fi.Read(buf, sizeof(buf)), sizeof(buf));
+			EXPECT_TRUE(std::equal(buf, buf + sizeof(buf), &data[pos]));
+			EXPECT_EQ(fi.getPosition(), pos + sizeof(buf));
+			EXPECT_EQ(fi.checkEOF(), pos + sizeof(buf) == data.size());
+		}
+		EXPECT_EQ(fi.Seek(-5, CStream::sFromEnd), data.size() - 5);
+		EXPECT_THROW(fi.Seek(data.size() + 1), std::exception);
+	}
+	mrpt::system::deleteFile(fil);
+}
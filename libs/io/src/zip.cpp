@@ -26,6 +26,7 @@
 #include <mrpt/io/CFileInputStream.h>
 #include <mrpt/system/filesystem.h>
 #include <chrono>
+#include <cstring>
 #include <iostream>
 
 using namespace mrpt;
@@ -370,3 +371,133 @@ bool mrpt::io::zip::decompress_gz_data_block(
 
 	return retVal;
 }
+
+// BGZF block header: a gzip member header with FEXTRA, holding a "BC"
+// subfield with the total block size minus 1.
+static const uint8_t BGZF_HEADER_MAGIC[BGZF_HEADER_LENGTH] = {
+	0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0, 0, 0};
+// Max. total block size: header + deflate data + CRC32 + ISIZE
+static const size_t BGZF_MAX_BLOCK_SIZE = 0x10000;
+static const size_t BGZF_FOOTER_LENGTH = 8;
+
+static void write_le32(uint8_t* p, uint32_t v)
+{
+	for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+static uint32_t read_le32(const uint8_t* p)
+{
+	return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+		   (uint32_t(p[3]) << 24);
+}
+
+void mrpt::io::zip::compress_bgzf_block(
+	const void* inData, size_t inDataSize, std::vector<uint8_t>& outBlock,
+	const int compress_level)
+{
+	MRPT_START
+	ASSERT_BELOW_(inDataSize, BGZF_MAX_BLOCK_DATA + 1);
+
+	outBlock.resize(BGZF_MAX_BLOCK_SIZE);
+	// Try with the requested level; if the data is incompressible and it does
+	// not fit, store it uncompressed (level 0 always fits):
+	for (int level = compress_level;; level = 0)
+	{
+		z_stream zs;
+		zs.zalloc = nullptr;
+		zs.zfree = nullptr;
+		zs.opaque = nullptr;
+		// Negative window bits: raw deflate data, without zlib header
+		if (deflateInit2(
+				&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			THROW_EXCEPTION("deflateInit2() failed");
+		zs.next_in =
+			const_cast<Bytef*>(reinterpret_cast<const Bytef*>(inData));
+		zs.avail_in = static_cast<uInt>(inDataSize);
+		zs.next_out = &outBlock[BGZF_HEADER_LENGTH];
+		zs.avail_out = static_cast<uInt>(
+			BGZF_MAX_BLOCK_SIZE - BGZF_HEADER_LENGTH - BGZF_FOOTER_LENGTH);
+		const int ret = deflate(&zs, Z_FINISH);
+		const size_t compLen = zs.total_out;
+		deflateEnd(&zs);
+
+		if (ret != Z_STREAM_END)
+		{
+			if (level == 0)
+				THROW_EXCEPTION_FMT("deflate() failed with code %i", ret);
+			continue;
+		}
+
+		const size_t blockSize =
+			BGZF_HEADER_LENGTH + compLen + BGZF_FOOTER_LENGTH;
+		std::memcpy(&outBlock[0], BGZF_HEADER_MAGIC, BGZF_HEADER_LENGTH);
+		outBlock[16] = static_cast<uint8_t>((blockSize - 1) & 0xff);
+		outBlock[17] = static_cast<uint8_t>((blockSize - 1) >> 8);
+
+		const uint32_t crc = crc32(
+			crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(inData),
+			static_cast<uInt>(inDataSize));
+		write_le32(&outBlock[BGZF_HEADER_LENGTH + compLen], crc);
+		write_le32(
+			&outBlock[BGZF_HEADER_LENGTH + compLen + 4],
+			static_cast<uint32_t>(inDataSize));
+		outBlock.resize(blockSize);
+		return;
+	}
+	MRPT_END
+}
+
+void mrpt::io::zip::decompress_bgzf_block(
+	const void* block, size_t blockSize, std::vector<uint8_t>& outData)
+{
+	MRPT_START
+	const auto* blk = reinterpret_cast<const uint8_t*>(block);
+	ASSERTMSG_(
+		blockSize >= BGZF_HEADER_LENGTH + BGZF_FOOTER_LENGTH &&
+			bgzf_block_size(blk, blockSize) == blockSize,
+		"Invalid BGZF block");
+
+	const uint8_t* footer = blk + blockSize - BGZF_FOOTER_LENGTH;
+	const uint32_t crc = read_le32(footer), isize = read_le32(footer + 4);
+	ASSERTMSG_(isize <= BGZF_MAX_BLOCK_SIZE, "Invalid BGZF block length");
+	outData.resize(isize);
+	if (!isize) return;
+
+	z_stream zs;
+	zs.zalloc = nullptr;
+	zs.zfree = nullptr;
+	zs.opaque = nullptr;
+	zs.next_in = const_cast<Bytef*>(blk + BGZF_HEADER_LENGTH);
+	zs.avail_in = static_cast<uInt>(
+		blockSize - BGZF_HEADER_LENGTH - BGZF_FOOTER_LENGTH);
+	if (inflateInit2(&zs, -15) != Z_OK) THROW_EXCEPTION("inflateInit2() failed");
+	zs.next_out = &outData[0];
+	zs.avail_out = isize;
+	const int ret = inflate(&zs, Z_FINISH);
+	inflateEnd(&zs);
+	if (ret != Z_STREAM_END || zs.total_out != isize)
+		THROW_EXCEPTION_FMT("inflate() failed with code %i", ret);
+
+	if (crc32(crc32(0L, Z_NULL, 0), &outData[0], isize) != crc)
+		THROW_EXCEPTION("CRC mismatch in BGZF block");
+	MRPT_END
+}
+
+size_t mrpt::io::zip::bgzf_block_size(const void* header, size_t headerLength)
+{
+	const auto* h = reinterpret_cast<const uint8_t*>(header);
+	if (headerLength < BGZF_HEADER_LENGTH) return 0;
+	// gzip magic, deflate method, FEXTRA flag, XLEN=6, 'BC' subfield:
+	if (h[0] != 0x1f || h[1] != 0x8b || h[2] != 0x08 || !(h[3] & 0x04) ||
+		h[10] != 6 || h[11] != 0 || h[12] != 'B' || h[13] != 'C' ||
+		h[14] != 2 || h[15] != 0)
+		return 0;
+	return (size_t(h[16]) | (size_t(h[17]) << 8)) + 1;
+}
+
+const std::vector<uint8_t>& mrpt::io::zip::bgzf_eof_block()
+{
+	static const std::vector<uint8_t> eof = {
+		0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C',
+		2,    0,    0x1b, 0,    3, 0, 0, 0, 0, 0,    0, 0, 0,   0};
+	return eof;
+}
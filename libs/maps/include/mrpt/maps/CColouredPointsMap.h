@@ -395,6 +395,13 @@ class PointCloudAdapter<mrpt::maps::CColouredPointsMap>
 		m_obj.setPointFast(idx, x, y, z);
 	}
 
+	/** Not supported: point maps need to be dense */
+	inline void setInvalidPoint(const size_t idx)
+	{
+		MRPT_UNUSED_PARAM(idx);
+		THROW_EXCEPTION("mrpt::maps::CColouredPointsMap needs to be dense");
+	}
+
 	/** Get XYZ_RGBf coordinates of i'th point */
 	template <typename T>
 	inline void getPointXYZ_RGBf(
@@ -21,6 +21,7 @@
 #include <mrpt/obs/CObservation2DRangeScanWithUncertainty.h>
 #include <mrpt/obs/obs_frwds.h>
 #include <mrpt/typemeta/TEnumType.h>
+#include <atomic>
 
 #include <mrpt/config.h>
 #if (                                                \
@@ -107,10 +108,41 @@ class COccupancyGridMap2D : public CMetricMap,
 	/** Cell size, i.e. resolution of the grid map. */
 	float resolution;
 
+	/** A cell of the likelihood caches below. Cells are filled on demand
+	 * while evaluating likelihoods, possibly from several threads at once
+	 * (see CParticleFilter::TParticleFilterOptions::parallelLikelihoodThreads),
+	 * hence the (relaxed, thus as cheap as plain) atomic accesses. All
+	 * threads would write the same value into a given cell. */
+	template <typename T>
+	struct TLikelihoodCacheCell
+	{
+		TLikelihoodCacheCell(T v = T()) : value(v) {}
+		TLikelihoodCacheCell(const TLikelihoodCacheCell& o) : value(o.load())
+		{
+		}
+		TLikelihoodCacheCell& operator=(const TLikelihoodCacheCell& o)
+		{
+			store(o.load());
+			return *this;
+		}
+		T load() const { return value.load(std::memory_order_relaxed); }
+		void store(T v) { value.store(v, std::memory_order_relaxed); }
+
+	   private:
+		std::atomic<T> value;
+	};
+
 	/** Auxiliary variables to speed up the computation of observation
 	 * likelihood values for LF method among others, at a high cost in memory
-	 * (see TLikelihoodOptions::enableLikelihoodCache). */
-	std::vector<double> precomputedLikelihood;
+	 * (see TLikelihoodOptions::enableLikelihoodCache).
+	 * The tables are (re)allocated by the first likelihood evaluation after
+	 * the map changes, which must not run concurrently with others (the PF
+	 * implementations in mrpt::slam always evaluate one particle alone
+	 * first). */
+	std::vector<TLikelihoodCacheCell<double>> precomputedLikelihood;
+	/** Compact (float) cache of log-likelihood values for the LF method, used
+	 * by computeLikelihoodField_Thrun_batch(). NaN means "not computed yet". */
+	std::vector<TLikelihoodCacheCell<float>> precomputedLogLikelihood;
 	bool precomputedLikelihoodToBeRecomputed;
 
 	/** Used for Voronoi calculation.Same struct as "map", but contains a "0" if
@@ -192,6 +224,14 @@ class COccupancyGridMap2D : public CMetricMap,
 		const mrpt::obs::CObservation* obs,
 		const mrpt::poses::CPose2D& takenFrom);
 
+	/** Resets all the likelihood caches if the map has been modified since
+	 * they were last filled in. */
+	void checkLikelihoodCachesAreValid();
+	/** Returns the likelihood (not its log) of a point falling into the cell
+	 * (cx,cy) with the LF method, which must be a valid cell index such as
+	 * cx<size_x-1 and cy<size_y-1. */
+	double computeLikelihoodField_Thrun_cell(const int cx, const int cy) const;
+
 	/** Clear the map: It set all cells to their default occupancy value (0.5),
 	 * without changing the resolution (the grid extension is reset to the
 	 * default values). */
@@ -545,6 +585,18 @@ class COccupancyGridMap2D : public CMetricMap,
 		/** Enabled: Rays widen with distance to approximate the real behavior
 		 * of lasers, disabled: insert rays as simple lines (Default=false) */
 		bool wideningBeamsWithDistance;
+		/** Maximum number of threads used to insert the rays of range scans,
+		 * in the process-wide mrpt::system::TaskScheduler (1=serial, 0=as
+		 * many as the scheduler threads). The grid is split in bands of
+		 * rows, one per thread, so the resulting map is identical to that of
+		 * the serial algorithm. Only used if wideningBeamsWithDistance=false
+		 * (Default=1) */
+		unsigned int insertionThreads{1};
+		/** Insert CObservation3DRangeScan and CObservationVelodyneScan
+		 * observations as the 2D scan equivalent to their points within the
+		 * default vertical FOV of mrpt::obs::T3DPointsTo2DScanParams.
+		 * Otherwise, they are not inserted (Default=false) */
+		bool insert3DScansAs2D{false};
 	};
 
 	/** With this struct options are provided to the observation insertion
@@ -950,6 +1002,46 @@ class COccupancyGridMap2D : public CMetricMap,
 		const CPointsMap* pm,
 		const mrpt::poses::CPose2D* relativePose = nullptr);
 
+	/** Evaluates computeLikelihoodField_Thrun() for a batch of poses of the
+	 * same points map, e.g. all the particles of a localization filter or all
+	 * candidate poses in a scan matcher.
+	 *
+	 * The (decimated) points are loaded once and each pose is evaluated with
+	 * a vectorized (SSE2, if available) kernel which transforms 4 points at
+	 * once and looks up their log-likelihood in a compact float table. This
+	 * table is filled in lazily and kept while the map is not modified, even
+	 * if TLikelihoodOptions::enableLikelihoodCache is false.
+	 *
+	 * Results are those of computeLikelihoodField_Thrun() up to float
+	 * rounding errors, except with TLikelihoodOptions::LF_alternateAverageMethod
+	 * enabled, where the results are exact since each pose is evaluated
+	 * with computeLikelihoodField_Thrun().
+	 *
+	 * \param pm The points map
+	 * \param poses The relative poses of the points map in this map's
+	 * coordinates.
+	 * \param out_log_liks The output log-likelihoods, one per pose.
+	 * \note [New in MRPT 2.0.0]
+	 */
+	void computeLikelihoodField_Thrun_batch(
+		const CPointsMap* pm, const std::vector<mrpt::math::TPose2D>& poses,
+		std::vector<double>& out_log_liks);
+
+	/** Like computeObservationLikelihood() for a batch of robot poses, using
+	 * computeLikelihoodField_Thrun_batch(). Only supported for
+	 * mrpt::obs::CObservation2DRangeScan observations with the
+	 * lmLikelihoodField_Thrun method and
+	 * TLikelihoodOptions::enableLikelihoodCache enabled (since the batch
+	 * method always keeps a table of likelihood values).
+	 * eturn false if not supported, then `out_log_liks` is not modified.
+	 * 
+ote [New in MRPT 2.0.0]
+	 */
+	bool computeObservationLikelihood_batch(
+		const mrpt::obs::CObservation* obs,
+		const std::vector<mrpt::math::TPose2D>& takenFrom,
+		std::vector<double>& out_log_liks);
+
 	/** Computes the likelihood [0,1] of a set of points, given the current grid
 	 * map as reference.
 	 * \param pm The points map
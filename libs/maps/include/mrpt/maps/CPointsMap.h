@@ -748,6 +748,34 @@ class CPointsMap : public CMetricMap,
 		mrpt::tfest::TMatchingPairList& correspondences,
 		float& correspondencesRatio);
 
+	/** Returns the unit normal vector of the local surface around each point,
+	 * estimated as the eigenvector of the smallest eigenvalue of the
+	 * covariance of its `kNeighbors` closest points (in 3D). The sign of each
+	 * normal is arbitrary. Points with less than 3 neighbors get a (0,0,0)
+	 * normal.
+	 *
+	 * Normals are computed on the first call and cached until the map is
+	 * modified (see mark_as_modified()) or a different `kNeighbors` is
+	 * requested. Used by the point-to-plane and GICP methods in
+	 * mrpt::slam::CICP.
+	 * \sa getPointsCovariances()
+	 * \note [New in MRPT 2.0.0]
+	 */
+	const std::vector<mrpt::math::TPoint3Df>& getPointsNormals(
+		const unsigned int kNeighbors = 10) const;
+
+	/** Returns the covariance of the local surface around each point, as
+	 * used in Generalized-ICP: the sample covariance of its `kNeighbors`
+	 * closest points, with its eigenvalues replaced by `(1e-3, 1, 1)` so the
+	 * smallest one goes along the surface normal. Points with less than 3
+	 * neighbors get the identity matrix.
+	 *
+	 * Computed and cached together with getPointsNormals().
+	 * \note [New in MRPT 2.0.0]
+	 */
+	const std::vector<mrpt::math::CMatrixFloat33>& getPointsCovariances(
+		const unsigned int kNeighbors = 10) const;
+
 	/** Transform the range scan into a set of cartessian coordinated
 	 *	 points. The options in "insertionOptions" are considered in this
 	 *method.
@@ -1086,6 +1114,7 @@ class CPointsMap : public CMetricMap,
 	{
 		m_largestDistanceFromOriginIsUpdated = false;
 		m_boundingBoxIsUpdated = false;
+		m_normals_kNeighbors = 0;
 		kdtree_mark_as_outdated();
 	}
 
@@ -1110,6 +1139,14 @@ class CPointsMap : public CMetricMap,
 	mutable float m_bb_min_x, m_bb_max_x, m_bb_min_y, m_bb_max_y, m_bb_min_z,
 		m_bb_max_z;
 
+	/** Cached results of getPointsNormals() and getPointsCovariances() */
+	mutable std::vector<mrpt::math::TPoint3Df> m_normals;
+	mutable std::vector<mrpt::math::CMatrixFloat33> m_local_covariances;
+	/** The `kNeighbors` used to compute m_normals, or 0 if outdated */
+	mutable unsigned int m_normals_kNeighbors{0};
+	/** Computes m_normals and m_local_covariances */
+	void computeLocalSurfaceGeometry(const unsigned int kNeighbors) const;
+
 	/** This is a common version of CMetricMap::insertObservation() for point
 	 * maps (actually, CMetricMap::internal_insertObservation),
 	 *   so derived classes don't need to worry implementing that method unless
@@ -1212,6 +1249,13 @@ class PointCloudAdapter<mrpt::maps::CPointsMap>
 	{
 		m_obj.setPointFast(idx, x, y, z);
 	}
+
+	/** Not supported: point maps need to be dense */
+	inline void setInvalidPoint(const size_t idx)
+	{
+		MRPT_UNUSED_PARAM(idx);
+		THROW_EXCEPTION("mrpt::maps::CPointsMap needs to be dense");
+	}
 };  // end of PointCloudAdapter<mrpt::maps::CPointsMap>
 }  // namespace opengl
 }  // namespace mrpt
@@ -309,6 +309,18 @@ class CRandomFieldGridMap2D
 		/** (Default:false) Skip the computation of the variance, just compute
 		 * the mean */
 		bool GMRF_skip_variance;
+		/** (Default:true) Use the sparse Cholesky solver, which reuses the
+		 * factorization pattern between updates, instead of SparseQR. See
+		 * mrpt::graphs::ScalarFactorGraph::TSolver */
+		bool GMRF_use_cholesky;
+		/** (Default:0=no limit) Max. time (seconds) to spend recovering
+		 * variances in each map update. Cells not reached keep their
+		 * former std. deviation. Only used if GMRF_use_cholesky=true.
+		 * \note Each update resumes the recovery where the previous one
+		 * ran out of time (see
+		 * mrpt::graphs::ScalarFactorGraph::setVarianceTimeBudget()), so all
+		 * cells are eventually refreshed. */
+		double GMRF_variance_time_budget;
 		/** @} */
 	};
 
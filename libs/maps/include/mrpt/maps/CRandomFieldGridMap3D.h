@@ -143,6 +143,17 @@ class CRandomFieldGridMap3D
 		/** (Default:false) Skip the computation of the variance, just compute
 		 * the mean */
 		bool GMRF_skip_variance;
+		/** (Default:true) Use the sparse Cholesky solver, which reuses the
+		 * factorization pattern between updates, instead of SparseQR */
+		bool GMRF_use_cholesky{true};
+		/** (Default:0=no limit) Max. time (seconds) to spend recovering
+		 * variances in each map update. Voxels not reached keep their
+		 * former std. deviation.
+		 * \note Each update resumes the recovery where the previous one
+		 * ran out of time (see
+		 * mrpt::graphs::ScalarFactorGraph::setVarianceTimeBudget()), so all
+		 * voxels are eventually refreshed. */
+		double GMRF_variance_time_budget{0};
 		/** @} */
 	};
 
@@ -197,6 +197,13 @@ class PointCloudAdapter<mrpt::maps::CWeightedPointsMap>
 	{
 		m_obj.setPointFast(idx, x, y, z);
 	}
+
+	/** Not supported: point maps need to be dense */
+	inline void setInvalidPoint(const size_t idx)
+	{
+		MRPT_UNUSED_PARAM(idx);
+		THROW_EXCEPTION("mrpt::maps::CWeightedPointsMap needs to be dense");
+	}
 };  // end of PointCloudAdapter<mrpt::maps::CPointsMap>
 }  // namespace opengl
 }  // namespace mrpt
@@ -575,7 +575,7 @@ bool CColouredPointsMap::colourFromObservation(
 			itProPoints->y > 0 && itProPoints->y < imgH)
 		{
 			unsigned int ii = p_idx[p_proj[k]];
-			uint8_t* p = obs.image(
+			const uint8_t* p = obs.image(
 				(unsigned int)itProPoints->x, (unsigned int)itProPoints->y);
 
 			m_color_R[ii] = p[chR] * factor;  // R
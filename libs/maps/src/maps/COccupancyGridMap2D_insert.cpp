@@ -11,10 +11,13 @@
 
 #include <mrpt/maps/COccupancyGridMap2D.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CObservation3DRangeScan.h>
 #include <mrpt/obs/CObservationRange.h>
+#include <mrpt/obs/CObservationVelodyneScan.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/core/round.h>  // round()
 #include <mrpt/system/memory.h>  // alloca()
+#include <mrpt/system/TaskScheduler.h>
 
 #if HAVE_ALLOCA_H
 #include <alloca.h>
@@ -35,6 +38,56 @@ struct TLocalPoint
 	int cx, cy;
 };
 
+/** Floor and ceil of a/b, for b>0 */
+static inline int floor_div(const int a, const int b)
+{
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+static inline int ceil_div(const int a, const int b)
+{
+	return a >= 0 ? (a + b - 1) / b : -((-a) / b);
+}
+
+/** Builds a 360deg 2D scan from a 3D point cloud in sensor coordinates, taking
+ * the closest point in each direction among those within the given vertical
+ * FOV. */
+static void pointCloudToPlanarScan(
+	const std::vector<float>& xs, const std::vector<float>& ys,
+	const std::vector<float>& zs, const T3DPointsTo2DScanParams& sp,
+	const float maxRange, CObservation2DRangeScan& out_scan2d)
+{
+	const size_t nRays = 720;
+	out_scan2d.aperture = 2 * M_PIf;
+	out_scan2d.rightToLeft = true;
+	out_scan2d.maxRange = maxRange;
+	out_scan2d.resizeScanAndAssign(nRays, maxRange, false);
+
+	const float tan_min = -tan(std::abs(sp.angle_inf));
+	const float tan_max = tan(std::abs(sp.angle_sup));
+	// As in CSinCosLookUpTableFor2DScans, the first and last rays point to
+	// -aperture/2 and +aperture/2:
+	const float K = (nRays - 1) / out_scan2d.aperture;
+
+	for (size_t i = 0; i < xs.size(); i++)
+	{
+		const float r2d = std::sqrt(square(xs[i]) + square(ys[i]));
+		if (r2d <= 0 || r2d >= maxRange) continue;
+		const float tan_vert = zs[i] / r2d;
+		if (tan_vert <= tan_min || tan_vert >= tan_max) continue;
+
+		// Ray "k" points to -pi + 2*pi*k/(nRays-1):
+		const size_t k = std::min(
+			nRays - 1, static_cast<size_t>(mrpt::round(
+						   (atan2(ys[i], xs[i]) + M_PIf) * K)));
+		if (!out_scan2d.getScanRangeValidity(k) ||
+			r2d < out_scan2d.getScanRange(k))
+		{
+			out_scan2d.setScanRange(k, r2d);
+			out_scan2d.setScanRangeValidity(k, true);
+		}
+	}
+}
+
 /*---------------------------------------------------------------
 					insertObservation
 
@@ -123,7 +176,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 			// ---------------------------------------------
 			//		Insert the scan as simple rays:
 			// ---------------------------------------------
-			int cx, cy, N = o->scan.size();
+			int N = o->scan.size();
 			float px, py;
 			double A, dAK;
 
@@ -255,74 +308,115 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					x2idx(px);  // Remember: This must be after the resizeGrid!!
 				int cy0 = y2idx(py);
 
-				// Insert rays:
-				for (idx = 0; idx < nRanges; idx += K)
-				{
-					if (!o->validRange[idx] && !invalidAsFree) continue;
-
-					// Starting position: Laser position
-					cx = cx0;
-					cy = cy0;
+				// Insert rays into the rows [row_min,row_max) of the grid:
+				auto insertRays = [&](const int row_min, const int row_max) {
+					for (size_t i = 0; i < nRanges; i += K)
+					{
+						if (!o->validRange[i] && !invalidAsFree) continue;
 
-					// Target, in cell indexes:
-					int trg_cx = x2idx(scanPoints_x[idx]);
-					int trg_cy = y2idx(scanPoints_y[idx]);
+						// Starting position: Laser position
+						int cx = cx0;
+						int cy = cy0;
 
-					// The x> comparison implicitly holds if x<0
-					ASSERT_(
-						static_cast<unsigned int>(trg_cx) < size_x &&
-						static_cast<unsigned int>(trg_cy) < size_y);
+						// Target, in cell indexes:
+						int trg_cx = x2idx(scanPoints_x[i]);
+						int trg_cy = y2idx(scanPoints_y[i]);
 
-					// Use "fractional integers" to approximate float operations
-					//  during the ray tracing:
-					int Acx = trg_cx - cx;
-					int Acy = trg_cy - cy;
+						// The x> comparison implicitly holds if x<0
+						ASSERT_(
+							static_cast<unsigned int>(trg_cx) < size_x &&
+							static_cast<unsigned int>(trg_cy) < size_y);
 
-					int Acx_ = abs(Acx);
-					int Acy_ = abs(Acy);
+						// Use "fractional integers" to approximate float
+						// operations during the ray tracing:
+						int Acx = trg_cx - cx;
+						int Acy = trg_cy - cy;
 
-					int nStepsRay = max(Acx_, Acy_);
-					if (!nStepsRay) continue;  // May be...
+						int Acx_ = abs(Acx);
+						int Acy_ = abs(Acy);
 
-					// Integers store "float values * 128"
-					float N_1 = 1.0f / nStepsRay;  // Avoid division twice.
+						int nStepsRay = max(Acx_, Acy_);
+						if (!nStepsRay) continue;  // May be...
 
-					// Increments at each raytracing step:
-					int frAcx =
-						(Acx < 0 ? -1 : +1) * round((Acx_ << FRBITS) * N_1);
-					int frAcy =
-						(Acy < 0 ? -1 : +1) * round((Acy_ << FRBITS) * N_1);
-
-					int frCX = cx << FRBITS;
-					int frCY = cy << FRBITS;
-					const auto logodd_free = o->validRange[idx]
-												 ? logodd_observation_free
-												 : logodd_noecho_free;
-
-					for (int nStep = 0; nStep < nStepsRay; nStep++)
-					{
-						updateCell_fast_free(
-							cx, cy, logodd_free, logodd_thres_free, theMapArray,
-							theMapSize_x);
+						// Integers store "float values * 128"
+						float N_1 = 1.0f / nStepsRay;  // Avoid division twice.
 
-						frCX += frAcx;
-						frCY += frAcy;
+						// Increments at each raytracing step:
+						int frAcx =
+							(Acx < 0 ? -1 : +1) * round((Acx_ << FRBITS) * N_1);
+						int frAcy =
+							(Acy < 0 ? -1 : +1) * round((Acy_ << FRBITS) * N_1);
+
+						int frCX = cx << FRBITS;
+						int frCY = cy << FRBITS;
+						const auto logodd_free = o->validRange[i]
+													 ? logodd_observation_free
+													 : logodd_noecho_free;
+
+						// Rows change monotonically along the ray, so the
+						// steps falling within [row_min,row_max) are
+						// consecutive: find them, i.e. [step0,step1)
+						const int frRowMin = row_min << FRBITS;
+						const int frRowMax = row_max << FRBITS;
+						int step0 = 0, step1 = nStepsRay;
+						if (frAcy > 0)
+						{
+							step0 = max(step0, ceil_div(frRowMin - frCY, frAcy));
+							step1 = min(step1, ceil_div(frRowMax - frCY, frAcy));
+						}
+						else if (frAcy < 0)
+						{
+							step0 = max(
+								step0, floor_div(frCY - frRowMax, -frAcy) + 1);
+							step1 = min(
+								step1, floor_div(frCY - frRowMin, -frAcy) + 1);
+						}
+						else if (cy < row_min || cy >= row_max)
+							step1 = 0;
 
+						frCX += step0 * frAcx;
+						frCY += step0 * frAcy;
 						cx = frCX >> FRBITS;
 						cy = frCY >> FRBITS;
-					}
 
-					// And finally, the occupied cell at the end:
-					// Only if:
-					//  - It was a valid ray, and
-					//  - The ray was not truncated
-					if (o->validRange[idx] &&
-						o->scan[idx] < maxDistanceInsertion)
-						updateCell_fast_occupied(
-							trg_cx, trg_cy, logodd_observation_occupied,
-							logodd_thres_occupied, theMapArray, theMapSize_x);
+						for (int nStep = step0; nStep < step1; nStep++)
+						{
+							updateCell_fast_free(
+								cx, cy, logodd_free, logodd_thres_free,
+								theMapArray, theMapSize_x);
 
-				}  // End of each range
+							frCX += frAcx;
+							frCY += frAcy;
+
+							cx = frCX >> FRBITS;
+							cy = frCY >> FRBITS;
+						}
+
+						// And finally, the occupied cell at the end:
+						// Only if:
+						//  - It was a valid ray, and
+						//  - The ray was not truncated
+						if (o->validRange[i] &&
+							o->scan[i] < maxDistanceInsertion &&
+							trg_cy >= row_min && trg_cy < row_max)
+							updateCell_fast_occupied(
+								trg_cx, trg_cy, logodd_observation_occupied,
+								logodd_thres_occupied, theMapArray,
+								theMapSize_x);
+
+					}  // End of each range
+				};
+
+				// With several threads, each one owns a band of rows and all
+				// of them trace all rays, so each cell gets exactly the same
+				// sequence of updates as in the serial algorithm:
+				mrpt::system::parallel_for_chunks(
+					size_y,
+					[&](const size_t r0, const size_t r1) {
+						insertRays(
+							static_cast<int>(r0), static_cast<int>(r1));
+					},
+					insertionOptions.insertionThreads);
 
 				mrpt_alloca_free(scanPoints_x);
 				mrpt_alloca_free(scanPoints_y);
@@ -802,6 +896,47 @@ bool COccupancyGridMap2D::internal_insertObservation(
 			return false;
 		}
 	}
+	else if (CLASS_ID(CObservation3DRangeScan) == obs->GetRuntimeClass())
+	{
+		/********************************************************************
+					OBSERVATION TYPE: CObservation3DRangeScan
+			Inserted as the equivalent 2D scan within the default vertical
+			FOV of T3DPointsTo2DScanParams, if insert3DScansAs2D=true.
+			********************************************************************/
+		if (!insertionOptions.insert3DScansAs2D) return false;
+		const CObservation3DRangeScan* o =
+			static_cast<const CObservation3DRangeScan*>(obs);
+		CObservation2DRangeScan scan2d;
+		o->convertTo2DScan(scan2d, T3DPointsTo2DScanParams());
+		if (!scan2d.getScanSize()) return false;
+		return internal_insertObservation(&scan2d, robotPose);
+	}
+	else if (CLASS_ID(CObservationVelodyneScan) == obs->GetRuntimeClass())
+	{
+		/********************************************************************
+					OBSERVATION TYPE: CObservationVelodyneScan
+			Inserted as a 360deg 2D scan built from the points within the
+			default vertical FOV of T3DPointsTo2DScanParams, if
+			insert3DScansAs2D=true.
+			********************************************************************/
+		if (!insertionOptions.insert3DScansAs2D) return false;
+		const CObservationVelodyneScan* o =
+			static_cast<const CObservationVelodyneScan*>(obs);
+		// Decode the packets if the observation has no pointcloud yet:
+		CObservationVelodyneScan::TPointCloud decoded;
+		if (!o->point_cloud.size()) o->generatePointCloud(decoded);
+		const CObservationVelodyneScan::TPointCloud& pc =
+			o->point_cloud.size() ? o->point_cloud : decoded;
+
+		CObservation2DRangeScan scan2d;
+		scan2d.timestamp = o->timestamp;
+		scan2d.sensorLabel = o->sensorLabel;
+		scan2d.sensorPose = o->sensorPose;
+		pointCloudToPlanarScan(
+			pc.x, pc.y, pc.z, T3DPointsTo2DScanParams(),
+			static_cast<float>(o->maxRange), scan2d);
+		return internal_insertObservation(&scan2d, robotPose);
+	}
 	else if (CLASS_ID(CObservationRange) == obs->GetRuntimeClass())
 	{
 		const CObservationRange* o = static_cast<const CObservationRange*>(obs);
@@ -1351,6 +1486,8 @@ void COccupancyGridMap2D::TInsertionOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(CFD_features_gaussian_size, float, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(CFD_features_median_size, float, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(wideningBeamsWithDistance, bool, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(insertionThreads, uint64_t, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(insert3DScansAs2D, bool, iniFile, section);
 }
 
 /*---------------------------------------------------------------
@@ -1375,6 +1512,8 @@ void COccupancyGridMap2D::TInsertionOptions::dumpToTextStream(
 	LOADABLEOPTS_DUMP_VAR(CFD_features_gaussian_size, float)
 	LOADABLEOPTS_DUMP_VAR(CFD_features_median_size, float)
 	LOADABLEOPTS_DUMP_VAR(wideningBeamsWithDistance, bool)
+	LOADABLEOPTS_DUMP_VAR(insertionThreads, int)
+	LOADABLEOPTS_DUMP_VAR(insert3DScansAs2D, bool)
 
 	out << mrpt::format("\n");
 }
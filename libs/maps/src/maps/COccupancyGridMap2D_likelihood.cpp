@@ -14,6 +14,9 @@
 #include <mrpt/obs/CObservationRange.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/serialization/CArchive.h>
+#include <mrpt/core/SSE_types.h>
+#include <cmath>
+#include <limits>
 
 using namespace mrpt;
 using namespace mrpt::math;
@@ -519,6 +522,98 @@ double COccupancyGridMap2D::computeObservationLikelihood_likelihoodField_II(
 	MRPT_END
 }
 
+#define LIK_LF_CACHE_INVALID (66)
+
+/*---------------------------------------------------------------
+					checkLikelihoodCachesAreValid
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::checkLikelihoodCachesAreValid()
+{
+	if (!precomputedLikelihoodToBeRecomputed) return;
+
+	// Reset the precomputed likelihood values maps. They are allocated on
+	// demand by their users:
+	precomputedLikelihood.clear();
+	precomputedLogLikelihood.clear();
+
+	precomputedLikelihoodToBeRecomputed = false;
+}
+
+/*---------------------------------------------------------------
+					computeLikelihoodField_Thrun_cell
+ ---------------------------------------------------------------*/
+double COccupancyGridMap2D::computeLikelihoodField_Thrun_cell(
+	const int cx, const int cy) const
+{
+	// The size of the checking area for matchings:
+	const int K = (int)ceil(
+		likelihoodOptions.LF_maxCorrsDistance /*m*/ / resolution);
+
+	const float zHit = likelihoodOptions.LF_zHit;
+	const float zRandomTerm =
+		likelihoodOptions.LF_zRandom / likelihoodOptions.LF_maxRange;
+	const float Q = -0.5f / square(likelihoodOptions.LF_stdHit);
+
+	const unsigned int size_x_1 = size_x - 1;
+	const unsigned int size_y_1 = size_y - 1;
+
+	const double maxCorrDist_sq = square(likelihoodOptions.LF_maxCorrsDistance);
+	const cellType thresholdCellValue = p2l(0.5f);
+
+	const double _resolution = this->resolution;
+	const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
+	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
+
+	float occupiedMinDist;
+
+	// Find the closest occupied cell in a certain range, given by K:
+	int xx1 = max(0, cx - K);
+	int xx2 = min(size_x_1, (unsigned)(cx + K));
+	int yy1 = max(0, cy - K);
+	int yy2 = min(size_y_1, (unsigned)(cy + K));
+
+	// Optimized code: this part will be invoked a *lot* of times:
+	{
+		const cellType* mapPtr =
+			&map[xx1 + yy1 * size_x];  // Initial pointer position
+		unsigned incrAfterRow = size_x - ((xx2 - xx1) + 1);
+
+		signed int Ax0 = 10 * (xx1 - cx);
+		signed int Ay = 10 * (yy1 - cy);
+
+		unsigned int occupiedMinDistInt =
+			mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
+
+		for (int yy = yy1; yy <= yy2; yy++)
+		{
+			unsigned int Ay2 =
+				square((unsigned int)(Ay));  // Square is faster
+			// with unsigned.
+			signed short Ax = Ax0;
+			cellType cell;
+
+			for (int xx = xx1; xx <= xx2; xx++)
+			{
+				if ((cell = *mapPtr++) < thresholdCellValue)
+				{
+					unsigned int d = square((unsigned int)(Ax)) + Ay2;
+					keep_min(occupiedMinDistInt, d);
+				}
+				Ax += 10;
+			}
+			// Go to (xx1,yy++)
+			mapPtr += incrAfterRow;
+			Ay += 10;
+		}
+
+		occupiedMinDist = occupiedMinDistInt * constDist2DiscrUnits_INV;
+	}
+
+	if (likelihoodOptions.LF_useSquareDist) occupiedMinDist *= occupiedMinDist;
+
+	return zRandomTerm + zHit * exp(Q * occupiedMinDist);
+}
+
 /*---------------------------------------------------------------
 					computeLikelihoodField_Thrun
  ---------------------------------------------------------------*/
@@ -529,9 +624,6 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 
 	double ret;
 	size_t N = pm->size();
-	int K = (int)ceil(
-		likelihoodOptions.LF_maxCorrsDistance /*m*/ /
-		resolution);  // The size of the checking area for matchings:
 
 	bool Product_T_OrSum_F = !likelihoodOptions.LF_alternateAverageMethod;
 
@@ -554,36 +646,19 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 	unsigned int size_x_1 = size_x - 1;
 	unsigned int size_y_1 = size_y - 1;
 
-#define LIK_LF_CACHE_INVALID (66)
-
 	// Aux. variables for the "for j" loop:
 	double thisLik = LIK_LF_CACHE_INVALID;
 	double maxCorrDist_sq = square(likelihoodOptions.LF_maxCorrsDistance);
 	double minimumLik = zRandomTerm + zHit * exp(Q * maxCorrDist_sq);
 	double ccos, ssin;
-	float occupiedMinDist;
 
-	if (likelihoodOptions.enableLikelihoodCache)
-	{
-		// Reset the precomputed likelihood values map
-		if (precomputedLikelihoodToBeRecomputed)
-		{
-			if (!map.empty())
-				precomputedLikelihood.assign(map.size(), LIK_LF_CACHE_INVALID);
-			else
-				precomputedLikelihood.clear();
+	checkLikelihoodCachesAreValid();
+	if (likelihoodOptions.enableLikelihoodCache &&
+		precomputedLikelihood.size() != map.size())
+		precomputedLikelihood.assign(map.size(), LIK_LF_CACHE_INVALID);
 
-			precomputedLikelihoodToBeRecomputed = false;
-		}
-	}
-
-	cellType thresholdCellValue = p2l(0.5f);
 	int decimation = likelihoodOptions.LF_decimation;
 
-	const double _resolution = this->resolution;
-	const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
-	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
-
 	if (N < 10) decimation = 1;
 
 	TPoint2D pointLocal;
@@ -591,8 +666,6 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 
 	for (size_t j = 0; j < N; j += decimation)
 	{
-		occupiedMinDist = maxCorrDist_sq;  // The max.distance
-
 		// Get the point and pass it to global coordinates:
 		if (relativePose)
 		{
@@ -632,68 +705,18 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 			// We are into the map limits:
 			if (likelihoodOptions.enableLikelihoodCache)
 			{
-				thisLik = precomputedLikelihood[cx + cy * size_x];
+				thisLik = precomputedLikelihood[cx + cy * size_x].load();
 			}
 
 			if (!likelihoodOptions.enableLikelihoodCache ||
 				thisLik == LIK_LF_CACHE_INVALID)
 			{
 				// Compute now:
-				// -------------
-				// Find the closest occupied cell in a certain range, given by
-				// K:
-				int xx1 = max(0, cx - K);
-				int xx2 = min(size_x_1, (unsigned)(cx + K));
-				int yy1 = max(0, cy - K);
-				int yy2 = min(size_y_1, (unsigned)(cy + K));
-
-				// Optimized code: this part will be invoked a *lot* of times:
-				{
-					cellType* mapPtr =
-						&map[xx1 + yy1 * size_x];  // Initial pointer position
-					unsigned incrAfterRow = size_x - ((xx2 - xx1) + 1);
-
-					signed int Ax0 = 10 * (xx1 - cx);
-					signed int Ay = 10 * (yy1 - cy);
-
-					unsigned int occupiedMinDistInt =
-						mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
-
-					for (int yy = yy1; yy <= yy2; yy++)
-					{
-						unsigned int Ay2 =
-							square((unsigned int)(Ay));  // Square is faster
-						// with unsigned.
-						signed short Ax = Ax0;
-						cellType cell;
-
-						for (int xx = xx1; xx <= xx2; xx++)
-						{
-							if ((cell = *mapPtr++) < thresholdCellValue)
-							{
-								unsigned int d =
-									square((unsigned int)(Ax)) + Ay2;
-								keep_min(occupiedMinDistInt, d);
-							}
-							Ax += 10;
-						}
-						// Go to (xx1,yy++)
-						mapPtr += incrAfterRow;
-						Ay += 10;
-					}
-
-					occupiedMinDist =
-						occupiedMinDistInt * constDist2DiscrUnits_INV;
-				}
-
-				if (likelihoodOptions.LF_useSquareDist)
-					occupiedMinDist *= occupiedMinDist;
-
-				thisLik = zRandomTerm + zHit * exp(Q * occupiedMinDist);
+				thisLik = computeLikelihoodField_Thrun_cell(cx, cy);
 
 				if (likelihoodOptions.enableLikelihoodCache)
 					// And save it into the table and into "thisLik":
-					precomputedLikelihood[cx + cy * size_x] = thisLik;
+					precomputedLikelihood[cx + cy * size_x].store(thisLik);
 			}
 		}
 
@@ -716,6 +739,185 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+					computeLikelihoodField_Thrun_batch
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::computeLikelihoodField_Thrun_batch(
+	const CPointsMap* pm, const std::vector<TPose2D>& poses,
+	std::vector<double>& out_log_liks)
+{
+	MRPT_START
+
+	ASSERT_(pm != nullptr);
+	const size_t nPoses = poses.size();
+	out_log_liks.resize(nPoses);
+
+	const size_t N = pm->size();
+	if (!N)
+	{
+		// No way to estimate this likelihood!!
+		std::fill(out_log_liks.begin(), out_log_liks.end(), -100.0);
+		return;
+	}
+
+	if (likelihoodOptions.LF_alternateAverageMethod)
+	{
+		// The average of likelihoods can't be accumulated from the table of
+		// log-likelihoods: use the regular method
+		for (size_t i = 0; i < nPoses; i++)
+		{
+			const CPose2D p(poses[i]);
+			out_log_liks[i] = computeLikelihoodField_Thrun(pm, &p);
+		}
+		return;
+	}
+
+	checkLikelihoodCachesAreValid();
+	if (precomputedLogLikelihood.size() != map.size())
+		precomputedLogLikelihood.assign(
+			map.size(), std::numeric_limits<float>::quiet_NaN());
+
+	const float zRandomTerm =
+		likelihoodOptions.LF_zRandom / likelihoodOptions.LF_maxRange;
+	const float Q = -0.5f / square(likelihoodOptions.LF_stdHit);
+	const double maxCorrDist_sq = square(likelihoodOptions.LF_maxCorrsDistance);
+	const float minimumLogLik = static_cast<float>(
+		log(zRandomTerm + likelihoodOptions.LF_zHit * exp(Q * maxCorrDist_sq)));
+
+	// Decimated points, in SoA form:
+	const size_t decimation = N < 10 ? 1 : likelihoodOptions.LF_decimation;
+	const auto& xs_all = pm->getPointsBufferRef_x();
+	const auto& ys_all = pm->getPointsBufferRef_y();
+	mrpt::aligned_std_vector<float> xs, ys;
+	xs.reserve(N / decimation + 1);
+	ys.reserve(N / decimation + 1);
+	for (size_t j = 0; j < N; j += decimation)
+	{
+		xs.push_back(xs_all[j]);
+		ys.push_back(ys_all[j]);
+	}
+	const size_t nPts = xs.size();
+
+	const unsigned int size_x_1 = size_x - 1;
+	const unsigned int size_y_1 = size_y - 1;
+
+	// Returns the log-likelihood of the cell (cx,cy), updating the table:
+	auto cellLogLik = [&](const int cx, const int cy) -> float {
+		if (static_cast<unsigned>(cx) >= size_x_1 ||
+			static_cast<unsigned>(cy) >= size_y_1)
+			return minimumLogLik;
+		auto& cell = precomputedLogLikelihood[cx + cy * size_x];
+		float l = cell.load();
+		if (std::isnan(l))
+		{
+			l = static_cast<float>(
+				log(computeLikelihoodField_Thrun_cell(cx, cy)));
+			cell.store(l);
+		}
+		return l;
+	};
+
+	for (size_t i = 0; i < nPoses; i++)
+	{
+		const float ccos = static_cast<float>(cos(poses[i].phi));
+		const float ssin = static_cast<float>(sin(poses[i].phi));
+		// Pose translation, already in the map cell coordinates:
+		const float x0 = static_cast<float>(poses[i].x) - x_min;
+		const float y0 = static_cast<float>(poses[i].y) - y_min;
+
+		size_t j = 0;
+		double ret = 0;
+
+#if MRPT_HAS_SSE2
+		const __m128 cos4 = _mm_set1_ps(ccos), sin4 = _mm_set1_ps(ssin);
+		const __m128 x04 = _mm_set1_ps(x0), y04 = _mm_set1_ps(y0);
+		const __m128 res4 = _mm_set1_ps(resolution);
+		__m128 acc = _mm_setzero_ps();
+		alignas(MRPT_MAX_ALIGN_BYTES) int cxs[4], cys[4];
+
+		for (; j + 4 <= nPts; j += 4)
+		{
+			const __m128 lx = _mm_load_ps(&xs[j]);
+			const __m128 ly = _mm_load_ps(&ys[j]);
+			// gx = x0 + lx*c - ly*s , gy = y0 + lx*s + ly*c
+			const __m128 gx = _mm_add_ps(
+				x04, _mm_sub_ps(_mm_mul_ps(lx, cos4), _mm_mul_ps(ly, sin4)));
+			const __m128 gy = _mm_add_ps(
+				y04, _mm_add_ps(_mm_mul_ps(lx, sin4), _mm_mul_ps(ly, cos4)));
+			// Truncated cell indices, as in x2idx()/y2idx():
+			_mm_store_si128(
+				reinterpret_cast<__m128i*>(cxs),
+				_mm_cvttps_epi32(_mm_div_ps(gx, res4)));
+			_mm_store_si128(
+				reinterpret_cast<__m128i*>(cys),
+				_mm_cvttps_epi32(_mm_div_ps(gy, res4)));
+
+			acc = _mm_add_ps(
+				acc, _mm_set_ps(
+						 cellLogLik(cxs[3], cys[3]), cellLogLik(cxs[2], cys[2]),
+						 cellLogLik(cxs[1], cys[1]),
+						 cellLogLik(cxs[0], cys[0])));
+		}
+		alignas(MRPT_MAX_ALIGN_BYTES) float accs[4];
+		_mm_store_ps(accs, acc);
+		ret = double(accs[0]) + accs[1] + accs[2] + accs[3];
+#endif
+
+		// Remaining points (or all of them, without SSE2):
+		for (; j < nPts; j++)
+		{
+			const float gx = x0 + xs[j] * ccos - ys[j] * ssin;
+			const float gy = y0 + xs[j] * ssin + ys[j] * ccos;
+			ret += cellLogLik(
+				static_cast<int>(gx / resolution),
+				static_cast<int>(gy / resolution));
+		}
+		out_log_liks[i] = ret;
+	}
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+					computeObservationLikelihood_batch
+ ---------------------------------------------------------------*/
+bool COccupancyGridMap2D::computeObservationLikelihood_batch(
+	const CObservation* obs, const std::vector<TPose2D>& takenFrom,
+	std::vector<double>& out_log_liks)
+{
+	MRPT_START
+
+	if (!genericMapParams.enableObservationLikelihood ||
+		likelihoodOptions.likelihoodMethod != lmLikelihoodField_Thrun ||
+		!likelihoodOptions.enableLikelihoodCache ||
+		obs->GetRuntimeClass() != CLASS_ID(CObservation2DRangeScan))
+		return false;
+
+	// Same checks as in internal_computeObservationLikelihood() and
+	// computeObservationLikelihood_likelihoodField_Thrun():
+	const CObservation2DRangeScan* o =
+		static_cast<const CObservation2DRangeScan*>(obs);
+	if (!o->isPlanarScan(insertionOptions.horizontalTolerance) ||
+		(insertionOptions.useMapAltitude &&
+		 fabs(insertionOptions.mapAltitude - o->sensorPose.z()) > 0.01))
+	{
+		out_log_liks.assign(takenFrom.size(), -10);
+		return true;
+	}
+
+	CPointsMap::TInsertionOptions opts;
+	opts.minDistBetweenLaserPoints = resolution * 0.5f;
+	opts.isPlanarMap = true;  // Already filtered above!
+	opts.horizontalTolerance = insertionOptions.horizontalTolerance;
+
+	computeLikelihoodField_Thrun_batch(
+		o->buildAuxPointsMap<mrpt::maps::CPointsMap>(&opts), takenFrom,
+		out_log_liks);
+	return true;
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 					computeLikelihoodField_II
  ---------------------------------------------------------------*/
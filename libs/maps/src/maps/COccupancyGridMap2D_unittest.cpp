@@ -8,8 +8,11 @@
    +------------------------------------------------------------------------+ */
 
 #include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CObservation3DRangeScan.h>
 #include <gtest/gtest.h>
+#include <algorithm>
 
 using namespace mrpt;
 using namespace mrpt::maps;
@@ -104,3 +107,175 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 		// should have a high "freeness"
 	}
 }
+
+TEST(COccupancyGridMap2DTests, LikelihoodFieldBatch)
+{
+	const float res = 0.10f;
+	COccupancyGridMap2D grid(-10.0f, 10.0f, -10.0f, 10.0f, res);
+	// A square room, 8x8 m:
+	for (float t = -4.0f; t <= 4.0f; t += res)
+	{
+		grid.setPos(t, -4.0f, 0.0f);
+		grid.setPos(t, 4.0f, 0.0f);
+		grid.setPos(-4.0f, t, 0.0f);
+		grid.setPos(4.0f, t, 0.0f);
+	}
+
+	// Points close to the walls, at cell centers so the batch method, which
+	// uses float arithmetic, never falls into a different cell:
+	mrpt::maps::CSimplePointsMap pts;
+	for (int i = -30; i < 30; i++)
+	{
+		const float t = (i + 0.5f) * res;
+		pts.insertPoint(t, 3.85f, 0);
+		pts.insertPoint(3.75f, t, 0);
+		pts.insertPoint(t, -2.95f, 0);
+	}
+	grid.likelihoodOptions.LF_decimation = 3;
+
+	std::vector<TPose2D> poses;
+	for (int ix = -3; ix <= 3; ix++)
+		for (int iy = -3; iy <= 3; iy++)
+			for (int iphi = -1; iphi <= 2; iphi++)
+				poses.emplace_back(ix * res, iy * res, iphi * M_PI / 2);
+	// Some poses out of the map, too:
+	poses.emplace_back(15.0, 0.0, 0.0);
+	poses.emplace_back(-9.0, -9.0, 0.0);
+
+	std::vector<double> batch_log_liks;
+	grid.computeLikelihoodField_Thrun_batch(&pts, poses, batch_log_liks);
+	ASSERT_EQUAL_(batch_log_liks.size(), poses.size());
+
+	for (size_t i = 0; i < poses.size(); i++)
+	{
+		const CPose2D p(poses[i]);
+		const double log_lik = grid.computeLikelihoodField_Thrun(&pts, &p);
+		EXPECT_NEAR(batch_log_liks[i], log_lik, 1e-4 * std::abs(log_lik))
+			<< "pose: " << poses[i].asString();
+	}
+}
+
+TEST(COccupancyGridMap2DTests, ObservationLikelihoodBatch)
+{
+	// Walls at cell centers, so the batch method, which uses float
+	// arithmetic, never sees the scan points in a different cell:
+	const double W = 4.05;
+	COccupancyGridMap2D grid(-10.0f, 10.0f, -10.0f, 10.0f, 0.10f);
+	for (float t = -W; t <= W; t += 0.10f)
+	{
+		grid.setPos(t, -W, 0.0f);
+		grid.setPos(t, W, 0.0f);
+		grid.setPos(-W, t, 0.0f);
+		grid.setPos(W, t, 0.0f);
+	}
+	grid.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmLikelihoodField_Thrun;
+
+	// A scan taken at the center of the room, facing +X:
+	CObservation2DRangeScan scan;
+	scan.aperture = M_PIf;
+	const size_t nRays = 181;
+	scan.resizeScan(nRays);
+	for (size_t i = 0; i < nRays; i++)
+	{
+		const double a = -M_PI / 2 + M_PI * i / (nRays - 1);
+		// Distance to the nearest wall along this ray:
+		scan.setScanRange(
+			i, static_cast<float>(std::min(
+				   W / (std::abs(std::cos(a)) + 1e-9),
+				   W / (std::abs(std::sin(a)) + 1e-9))));
+		scan.setScanRangeValidity(i, true);
+	}
+
+	std::vector<TPose2D> poses;
+	for (int i = -5; i <= 5; i++)
+		poses.emplace_back(0.07 * i, -0.03 * i, 0.02 * i);
+
+	std::vector<double> batch_log_liks;
+	ASSERT_TRUE(
+		grid.computeObservationLikelihood_batch(&scan, poses, batch_log_liks));
+	ASSERT_EQ(batch_log_liks.size(), poses.size());
+	for (size_t i = 0; i < poses.size(); i++)
+	{
+		const double log_lik =
+			grid.computeObservationLikelihood(&scan, CPose2D(poses[i]));
+		EXPECT_NEAR(batch_log_liks[i], log_lik, 1e-2 * std::abs(log_lik))
+			<< "pose: " << poses[i].asString();
+	}
+	// The pose where the scan was taken is the most likely one:
+	EXPECT_EQ(
+		std::max_element(batch_log_liks.begin(), batch_log_liks.end()) -
+			batch_log_liks.begin(),
+		5);
+
+	// Not supported for other methods:
+	grid.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmRayTracing;
+	EXPECT_FALSE(
+		grid.computeObservationLikelihood_batch(&scan, poses, batch_log_liks));
+}
+
+TEST(COccupancyGridMap2DTests, ParallelInsertionIsIdenticalToSerial)
+{
+	// A synthetic scan, with some invalid ranges:
+	mrpt::obs::CObservation2DRangeScan scan;
+	scan.aperture = M_PIf;
+	scan.rightToLeft = true;
+	const size_t nRays = 361;
+	scan.resizeScan(nRays);
+	for (size_t i = 0; i < nRays; i++)
+	{
+		scan.setScanRange(i, 3.0f + 2.0f * std::sin(i * 0.05f) + (i % 7) * 0.1f);
+		scan.setScanRangeValidity(i, (i % 23) != 0);
+	}
+
+	for (unsigned int nThreads : {2, 3, 8})
+	{
+		COccupancyGridMap2D grid1(-5.0f, 5.0f, -5.0f, 5.0f, 0.05f);
+		COccupancyGridMap2D grid2(-5.0f, 5.0f, -5.0f, 5.0f, 0.05f);
+		grid2.insertionOptions.insertionThreads = nThreads;
+
+		for (int i = 0; i < 20; i++)
+		{
+			const CPose3D pose(
+				0.1 * i - 1.0, 0.05 * i, 0, mrpt::DEG2RAD(17.0 * i), 0, 0);
+			grid1.insertObservation(&scan, &pose);
+			grid2.insertObservation(&scan, &pose);
+		}
+
+		ASSERT_EQ(grid1.getSizeX(), grid2.getSizeX());
+		ASSERT_EQ(grid1.getSizeY(), grid2.getSizeY());
+		for (unsigned int cy = 0; cy < grid1.getSizeY(); cy++)
+			for (unsigned int cx = 0; cx < grid1.getSizeX(); cx++)
+				ASSERT_EQ(grid1.getRow(cy)[cx], grid2.getRow(cy)[cx])
+					<< "nThreads=" << nThreads << " cx=" << cx << " cy=" << cy;
+	}
+}
+
+TEST(COccupancyGridMap2DTests, insert3DScansOnlyIfEnabled)
+{
+	// A wall 2 m ahead of a depth camera:
+	CObservation3DRangeScan obs;
+	const int W = 40, H = 20;
+	obs.hasRangeImage = true;
+	obs.rangeImage_setSize(H, W);
+	obs.rangeImage.setConstant(2.0f);
+	obs.maxRange = 10.0f;
+	obs.cameraParams.ncols = W;
+	obs.cameraParams.nrows = H;
+	obs.cameraParams.fx(30);
+	obs.cameraParams.fy(30);
+	obs.cameraParams.cx(W / 2.0);
+	obs.cameraParams.cy(H / 2.0);
+
+	const CPose3D robotPose;
+	COccupancyGridMap2D grid(-5.0f, 5.0f, -5.0f, 5.0f, 0.05f);
+	EXPECT_FALSE(grid.insertObservation(&obs, &robotPose));
+	EXPECT_FLOAT_EQ(grid.getPos(1.0, 0.0), 0.5f);
+	EXPECT_FLOAT_EQ(grid.getPos(2.0, 0.0), 0.5f);
+
+	grid.insertionOptions.insert3DScansAs2D = true;
+	EXPECT_TRUE(grid.insertObservation(&obs, &robotPose));
+	EXPECT_GT(grid.getPos(1.0, 0.0), 0.5f);
+	EXPECT_LT(grid.getPos(2.0, 0.0), 0.5f);
+}
@@ -13,6 +13,7 @@
 #include <mrpt/system/CTicTac.h>
 #include <mrpt/system/CTimeLogger.h>
 #include <mrpt/system/os.h>
+#include <mrpt/system/TaskScheduler.h>
 #include <mrpt/math/geometry.h>
 #include <mrpt/serialization/CArchive.h>
 
@@ -54,6 +55,39 @@ using namespace std;
 
 IMPLEMENTS_VIRTUAL_SERIALIZABLE(CPointsMap, CMetricMap, mrpt::maps)
 
+/** Calls `matchPoints(k0,k1,out_pairs)` for consecutive ranges `[k0,k1)` of
+ * the `nPts` points to be matched, possibly in parallel, and appends all the
+ * pairings to `correspondences` in order of `k`, so the result does not depend
+ * on the number of threads. */
+template <class FUNC>
+static void runMatching(
+	const TMatchingParams& params, const size_t nPts, FUNC&& matchPoints,
+	TMatchingPairList& correspondences)
+{
+	size_t nThreads = TaskScheduler::Instance().concurrency();
+	if (params.matchingThreads)
+		nThreads = std::min<size_t>(nThreads, params.matchingThreads);
+	if (nThreads <= 1 || nPts < 2)
+	{
+		matchPoints(0, nPts, correspondences);
+		return;
+	}
+	// The first point goes alone, so the KD-tree is built before concurrent
+	// queries start:
+	matchPoints(0, 1, correspondences);
+
+	const size_t nChunks = std::min(nThreads, nPts - 1);
+	std::vector<TMatchingPairList> chunk_pairs(nChunks);
+	mrpt::system::parallel_for(0, nChunks, [&](const size_t c) {
+		matchPoints(
+			1 + ((nPts - 1) * c) / nChunks,
+			1 + ((nPts - 1) * (c + 1)) / nChunks, chunk_pairs[c]);
+	});
+	for (const auto& pairs : chunk_pairs)
+		correspondences.insert(
+			correspondences.end(), pairs.begin(), pairs.end());
+}
+
 /*---------------------------------------------------------------
 						Constructor
   ---------------------------------------------------------------*/
@@ -335,12 +369,6 @@ void CPointsMap::determineMatching2D(
 	float global_y_min = std::numeric_limits<float>::max(),
 		  global_y_max = -std::numeric_limits<float>::max();
 
-	double maxDistForCorrespondenceSquared;
-	float x_local, y_local;
-	unsigned int localIdx;
-
-	const float *x_other_it, *y_other_it, *z_other_it;
-
 	// Prepare output: no correspondences initially:
 	correspondences.clear();
 	correspondences.reserve(nLocalPoints);
@@ -469,70 +497,76 @@ void CPointsMap::determineMatching2D(
 
 	// Loop for each point in local map:
 	// --------------------------------------------------
-	for (localIdx = params.offset_other_map_points,
-		x_other_it = &otherMap->m_x[params.offset_other_map_points],
-		y_other_it = &otherMap->m_y[params.offset_other_map_points],
-		z_other_it = &otherMap->m_z[params.offset_other_map_points];
-		 localIdx < nLocalPoints;
-		 x_other_it += params.decimation_other_map_points,
-		y_other_it += params.decimation_other_map_points,
-		z_other_it += params.decimation_other_map_points,
-		localIdx += params.decimation_other_map_points)
-	{
-		// For speed-up:
-		x_local = x_locals[localIdx];  // *x_locals_it;
-		y_local = y_locals[localIdx];  // *y_locals_it;
+	const size_t nPtsToMatch =
+		(nLocalPoints - params.offset_other_map_points +
+		 params.decimation_other_map_points - 1) /
+		params.decimation_other_map_points;
+
+	auto matchPoints = [&](const size_t k0, const size_t k1,
+						   TMatchingPairList& out_pairs) {
+		for (size_t k = k0; k < k1; k++)
+		{
+			const size_t localIdx = params.offset_other_map_points +
+									k * params.decimation_other_map_points;
 
-		// Find all the matchings in the requested distance:
+			// For speed-up:
+			const float x_local = x_locals[localIdx];
+			const float y_local = y_locals[localIdx];
 
-		// KD-TREE implementation =================================
-		// Use a KD-tree to look for the nearnest neighbor of:
-		//   (x_local, y_local, z_local)
-		// In "this" (global/reference) points map.
+			// Find all the matchings in the requested distance:
 
-		float tentativ_err_sq;
-		unsigned int tentativ_this_idx = kdTreeClosestPoint2D(
-			x_local, y_local,  // Look closest to this guy
-			tentativ_err_sq  // save here the min. distance squared
-		);
+			// KD-TREE implementation =================================
+			// Use a KD-tree to look for the nearnest neighbor of:
+			//   (x_local, y_local, z_local)
+			// In "this" (global/reference) points map.
 
-		// Compute max. allowed distance:
-		maxDistForCorrespondenceSquared = square(
-			params.maxAngularDistForCorrespondence *
-				std::sqrt(
-					square(params.angularDistPivotPoint.x - x_local) +
-					square(params.angularDistPivotPoint.y - y_local)) +
-			params.maxDistForCorrespondence);
+			float tentativ_err_sq;
+			unsigned int tentativ_this_idx = kdTreeClosestPoint2D(
+				x_local, y_local,  // Look closest to this guy
+				tentativ_err_sq  // save here the min. distance squared
+			);
 
-		// Distance below the threshold??
-		if (tentativ_err_sq < maxDistForCorrespondenceSquared)
-		{
-			// Save all the correspondences:
-			_correspondences.resize(_correspondences.size() + 1);
+			// Compute max. allowed distance:
+			const double maxDistForCorrespondenceSquared = square(
+				params.maxAngularDistForCorrespondence *
+					std::sqrt(
+						square(params.angularDistPivotPoint.x - x_local) +
+						square(params.angularDistPivotPoint.y - y_local)) +
+				params.maxDistForCorrespondence);
 
-			TMatchingPair& p = _correspondences.back();
+			// Distance below the threshold??
+			if (tentativ_err_sq < maxDistForCorrespondenceSquared)
+			{
+				// Save all the correspondences:
+				out_pairs.resize(out_pairs.size() + 1);
 
-			p.this_idx = tentativ_this_idx;
-			p.this_x = m_x[tentativ_this_idx];
-			p.this_y = m_y[tentativ_this_idx];
-			p.this_z = m_z[tentativ_this_idx];
+				TMatchingPair& p = out_pairs.back();
 
-			p.other_idx = localIdx;
-			p.other_x = *x_other_it;
-			p.other_y = *y_other_it;
-			p.other_z = *z_other_it;
+				p.this_idx = tentativ_this_idx;
+				p.this_x = m_x[tentativ_this_idx];
+				p.this_y = m_y[tentativ_this_idx];
+				p.this_z = m_z[tentativ_this_idx];
 
-			p.errorSquareAfterTransformation = tentativ_err_sq;
+				p.other_idx = localIdx;
+				p.other_x = otherMap->m_x[localIdx];
+				p.other_y = otherMap->m_y[localIdx];
+				p.other_z = otherMap->m_z[localIdx];
 
-			// At least one:
-			nOtherMapPointsWithCorrespondence++;
+				p.errorSquareAfterTransformation = tentativ_err_sq;
+			}
+		}  // For each local point
+	};
+	runMatching(params, nPtsToMatch, matchPoints, _correspondences);
 
-			// Accumulate the MSE:
-			_sumSqrDist += p.errorSquareAfterTransformation;
-			_sumSqrCount++;
-		}
+	// At least one correspondence for each of these points:
+	nOtherMapPointsWithCorrespondence = _correspondences.size();
 
-	}  // For each local point
+	// Accumulate the MSE:
+	for (const auto& p : _correspondences)
+	{
+		_sumSqrDist += p.errorSquareAfterTransformation;
+		_sumSqrCount++;
+	}
 
 	// Additional consistency filter: "onlyKeepTheClosest" up to now
 	//  led to just one correspondence for each "local map" point, but
@@ -1099,8 +1133,6 @@ void CPointsMap::determineMatching3D(
 	float local_z_min = std::numeric_limits<float>::max(),
 		  local_z_max = -std::numeric_limits<float>::max();
 
-	double maxDistForCorrespondenceSquared;
-
 	// Prepare output: no correspondences initially:
 	correspondences.clear();
 	correspondences.reserve(nLocalPoints);
@@ -1153,16 +1185,23 @@ void CPointsMap::determineMatching3D(
 
 	// Loop for each point in local map:
 	// --------------------------------------------------
-	for (unsigned int localIdx = params.offset_other_map_points;
-		 localIdx < nLocalPoints;
-		 localIdx += params.decimation_other_map_points)
-	{
-		// For speed-up:
-		const float x_local = x_locals[localIdx];
-		const float y_local = y_locals[localIdx];
-		const float z_local = z_locals[localIdx];
-
+	const size_t nPtsToMatch =
+		(nLocalPoints - params.offset_other_map_points +
+		 params.decimation_other_map_points - 1) /
+		params.decimation_other_map_points;
+
+	auto matchPoints = [&](const size_t k0, const size_t k1,
+						   TMatchingPairList& out_pairs) {
+		for (size_t k = k0; k < k1; k++)
 		{
+			const size_t localIdx = params.offset_other_map_points +
+									k * params.decimation_other_map_points;
+
+			// For speed-up:
+			const float x_local = x_locals[localIdx];
+			const float y_local = y_locals[localIdx];
+			const float z_local = z_locals[localIdx];
+
 			// KD-TREE implementation
 			// Use a KD-tree to look for the nearnest neighbor of:
 			//   (x_local, y_local, z_local)
@@ -1175,7 +1214,7 @@ void CPointsMap::determineMatching3D(
 			);
 
 			// Compute max. allowed distance:
-			maxDistForCorrespondenceSquared = square(
+			const double maxDistForCorrespondenceSquared = square(
 				params.maxAngularDistForCorrespondence *
 					params.angularDistPivotPoint.distanceTo(
 						TPoint3D(x_local, y_local, z_local)) +
@@ -1185,9 +1224,9 @@ void CPointsMap::determineMatching3D(
 			if (tentativ_err_sq < maxDistForCorrespondenceSquared)
 			{
 				// Save all the correspondences:
-				_correspondences.resize(_correspondences.size() + 1);
+				out_pairs.resize(out_pairs.size() + 1);
 
-				TMatchingPair& p = _correspondences.back();
+				TMatchingPair& p = out_pairs.back();
 
 				p.this_idx = tentativ_this_idx;
 				p.this_x = m_x[tentativ_this_idx];
@@ -1200,17 +1239,20 @@ void CPointsMap::determineMatching3D(
 				p.other_z = otherMap->m_z[localIdx];
 
 				p.errorSquareAfterTransformation = tentativ_err_sq;
-
-				// At least one:
-				nOtherMapPointsWithCorrespondence++;
-
-				// Accumulate the MSE:
-				_sumSqrDist += p.errorSquareAfterTransformation;
-				_sumSqrCount++;
 			}
+		}  // For each local point
+	};
+	runMatching(params, nPtsToMatch, matchPoints, _correspondences);
 
-		}  // End of test_match
-	}  // For each local point
+	// At least one correspondence for each of these points:
+	nOtherMapPointsWithCorrespondence = _correspondences.size();
+
+	// Accumulate the MSE:
+	for (const auto& p : _correspondences)
+	{
+		_sumSqrDist += p.errorSquareAfterTransformation;
+		_sumSqrCount++;
+	}
 
 	// Additional consistency filter: "onlyKeepTheClosest" up to now
 	//  led to just one correspondence for each "local map" point, but
@@ -1448,6 +1490,81 @@ void CPointsMap::compute3DDistanceToMesh(
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+				getPointsNormals / getPointsCovariances
+---------------------------------------------------------------*/
+const std::vector<TPoint3Df>& CPointsMap::getPointsNormals(
+	const unsigned int kNeighbors) const
+{
+	if (m_normals_kNeighbors != kNeighbors || m_normals.size() != size())
+		computeLocalSurfaceGeometry(kNeighbors);
+	return m_normals;
+}
+
+const std::vector<CMatrixFloat33>& CPointsMap::getPointsCovariances(
+	const unsigned int kNeighbors) const
+{
+	if (m_normals_kNeighbors != kNeighbors || m_normals.size() != size())
+		computeLocalSurfaceGeometry(kNeighbors);
+	return m_local_covariances;
+}
+
+/*---------------------------------------------------------------
+				computeLocalSurfaceGeometry
+---------------------------------------------------------------*/
+void CPointsMap::computeLocalSurfaceGeometry(
+	const unsigned int kNeighbors) const
+{
+	MRPT_START
+	ASSERT_ABOVE_(kNeighbors, 2);
+
+	// Eigenvalues of the GICP covariances, along the normal and the surface:
+	const double GICP_EPSILON = 1e-3;
+
+	const size_t N = size();
+	m_normals.assign(N, TPoint3Df(0, 0, 0));
+	m_local_covariances.resize(N);
+	for (auto& c : m_local_covariances) c.setIdentity();
+	m_normals_kNeighbors = kNeighbors;
+	if (N < 3) return;
+
+	const size_t knn = std::min<size_t>(kNeighbors, N);
+	std::vector<size_t> idxs;
+	std::vector<float> dists_sq;
+	for (size_t i = 0; i < N; i++)
+	{
+		kdTreeNClosestPoint3DIdx(m_x[i], m_y[i], m_z[i], knn, idxs, dists_sq);
+		if (idxs.size() < 3) continue;
+
+		// Mean and covariance of the neighborhood:
+		Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+		for (const auto k : idxs)
+			mean += Eigen::Vector3d(m_x[k], m_y[k], m_z[k]);
+		mean /= idxs.size();
+
+		Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+		for (const auto k : idxs)
+		{
+			const Eigen::Vector3d d =
+				Eigen::Vector3d(m_x[k], m_y[k], m_z[k]) - mean;
+			cov += d * d.transpose();
+		}
+		cov /= idxs.size();
+
+		// Eigenvectors, sorted by ascending eigenvalues:
+		const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> es(cov);
+		if (es.info() != Eigen::Success) continue;
+		const Eigen::Matrix3d& V = es.eigenvectors();
+
+		m_normals[i] = TPoint3Df(V(0, 0), V(1, 0), V(2, 0));
+
+		const Eigen::Vector3d eigVals(GICP_EPSILON, 1.0, 1.0);
+		m_local_covariances[i] =
+			(V * eigVals.asDiagonal() * V.transpose()).cast<float>();
+	}
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
  Computes the likelihood that a given observation was taken from a given pose in
  the world being modeled with this map.
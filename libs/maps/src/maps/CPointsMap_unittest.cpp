@@ -11,6 +11,9 @@
 #include <mrpt/maps/CWeightedPointsMap.h>
 #include <mrpt/maps/CColouredPointsMap.h>
 #include <mrpt/poses/CPoint2D.h>
+#include <mrpt/poses/CPose2D.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random.h>
 #include <gtest/gtest.h>
 
 using namespace mrpt;
@@ -184,3 +187,58 @@ TEST(CColouredPointsMapTests, clipOutOfRange)
 {
 	do_test_clipOutOfRange<CColouredPointsMap>();
 }
+
+TEST(CSimplePointsMapTests, determineMatchingInParallel)
+{
+	// Two random clouds:
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+	CSimplePointsMap map1, map2;
+	for (int i = 0; i < 5000; i++)
+	{
+		const float x = rng.drawUniform(-10.0f, 10.0f),
+					y = rng.drawUniform(-10.0f, 10.0f),
+					z = rng.drawUniform(-1.0f, 1.0f);
+		map1.insertPoint(x, y, z);
+		map2.insertPoint(
+			x + rng.drawGaussian1D(0, 0.05), y + rng.drawGaussian1D(0, 0.05),
+			z + rng.drawGaussian1D(0, 0.05));
+	}
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.20f;
+	params.decimation_other_map_points = 3;
+	params.offset_other_map_points = 1;
+
+	const CPose2D pose2D(0.05, -0.03, DEG2RAD(1.0));
+	const CPose3D pose3D(0.05, -0.03, 0.02, DEG2RAD(1.0), 0, 0);
+
+	mrpt::tfest::TMatchingPairList corrs2D_serial, corrs3D_serial;
+	TMatchingExtraResults res2D_serial, res3D_serial;
+	params.matchingThreads = 1;
+	map1.determineMatching2D(
+		&map2, pose2D, corrs2D_serial, params, res2D_serial);
+	map1.determineMatching3D(
+		&map2, pose3D, corrs3D_serial, params, res3D_serial);
+	EXPECT_GT(corrs2D_serial.size(), 500U);
+	EXPECT_GT(corrs3D_serial.size(), 500U);
+
+	for (unsigned int nThreads : {2, 5})
+	{
+		// Use fresh copies, so the KD-trees are built with several threads:
+		CSimplePointsMap m1 = map1, m2 = map2;
+
+		mrpt::tfest::TMatchingPairList corrs2D, corrs3D;
+		TMatchingExtraResults res2D, res3D;
+		params.matchingThreads = nThreads;
+		m1.determineMatching2D(&m2, pose2D, corrs2D, params, res2D);
+		m1.determineMatching3D(&m2, pose3D, corrs3D, params, res3D);
+
+		EXPECT_TRUE(corrs2D == corrs2D_serial);
+		EXPECT_TRUE(corrs3D == corrs3D_serial);
+		EXPECT_EQ(res2D.sumSqrDist, res2D_serial.sumSqrDist);
+		EXPECT_EQ(res3D.sumSqrDist, res3D_serial.sumSqrDist);
+		EXPECT_EQ(res2D.correspondencesRatio, res2D_serial.correspondencesRatio);
+		EXPECT_EQ(res3D.correspondencesRatio, res3D_serial.correspondencesRatio);
+	}
+}
@@ -23,6 +23,7 @@
 #include <mrpt/opengl/CSetOfObjects.h>
 #include <mrpt/opengl/CSetOfTriangles.h>
 
+#include <cmath>
 #include <numeric>
 
 using namespace mrpt;
@@ -706,7 +707,9 @@ CRandomFieldGridMap2D::TInsertionOptionsCommon::TInsertionOptionsCommon()
 
 	  GMRF_saturate_min(-std::numeric_limits<double>::max()),
 	  GMRF_saturate_max(std::numeric_limits<double>::max()),
-	  GMRF_skip_variance(false)
+	  GMRF_skip_variance(false),
+	  GMRF_use_cholesky(true),
+	  GMRF_variance_time_budget(0)
 {
 }
 
@@ -765,6 +768,12 @@ void CRandomFieldGridMap2D::TInsertionOptionsCommon::
 	out << mrpt::format(
 		"GMRF_gridmap_image_cy                   = %u\n",
 		static_cast<unsigned int>(GMRF_gridmap_image_cy));
+	out << mrpt::format(
+		"GMRF_use_cholesky                       = %s\n",
+		GMRF_use_cholesky ? "YES" : "NO");
+	out << mrpt::format(
+		"GMRF_variance_time_budget               = %f\n",
+		GMRF_variance_time_budget);
 }
 
 /*---------------------------------------------------------------
@@ -811,6 +820,8 @@ void CRandomFieldGridMap2D::TInsertionOptionsCommon::
 		iniFile.read_int(section.c_str(), "gridmap_image_cx", 0, false);
 	GMRF_gridmap_image_cy =
 		iniFile.read_int(section.c_str(), "gridmap_image_cy", 0, false);
+	MRPT_LOAD_CONFIG_VAR(GMRF_use_cholesky, bool, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(GMRF_variance_time_budget, double, iniFile, section);
 }
 
 /*---------------------------------------------------------------
@@ -2573,6 +2584,13 @@ void CRandomFieldGridMap2D::insertObservation_GMRF(
   ---------------------------------------------------------------*/
 void CRandomFieldGridMap2D::updateMapEstimation_GMRF()
 {
+	m_gmrf.setSolver(
+		m_insertOptions_common->GMRF_use_cholesky
+			? mrpt::graphs::ScalarFactorGraph::solverCholesky
+			: mrpt::graphs::ScalarFactorGraph::solverSparseQR);
+	m_gmrf.setVarianceTimeBudget(
+		m_insertOptions_common->GMRF_variance_time_budget);
+
 	Eigen::VectorXd x_incr, x_var;
 	m_gmrf.updateEstimation(
 		x_incr, m_insertOptions_common->GMRF_skip_variance ? NULL : &x_var);
@@ -2585,9 +2603,10 @@ void CRandomFieldGridMap2D::updateMapEstimation_GMRF()
 	// Update Mean-Variance in the base grid class
 	for (size_t j = 0; j < m_map.size(); j++)
 	{
-		m_map[j].gmrf_std = m_insertOptions_common->GMRF_skip_variance
-								? .0
-								: std::sqrt(x_var[j]);
+		if (m_insertOptions_common->GMRF_skip_variance)
+			m_map[j].gmrf_std = .0;
+		else if (!std::isnan(x_var[j]))  // NaN: out of time budget
+			m_map[j].gmrf_std = std::sqrt(x_var[j]);
 		m_map[j].gmrf_mean += x_incr[j];
 
 		mrpt::saturate(
@@ -12,6 +12,7 @@
 #include <mrpt/maps/CRandomFieldGridMap3D.h>
 #include <mrpt/config/CConfigFileBase.h>
 #include <mrpt/system/CTicTac.h>
+#include <cmath>
 #include <fstream>
 #include <mrpt/config.h>
 
@@ -207,6 +208,12 @@ void CRandomFieldGridMap3D::TInsertionOptions::dumpToTextStream(
 	out << mrpt::format(
 		"GMRF_skip_variance                   = %s\n",
 		GMRF_skip_variance ? "true" : "false");
+	out << mrpt::format(
+		"GMRF_use_cholesky                    = %s\n",
+		GMRF_use_cholesky ? "true" : "false");
+	out << mrpt::format(
+		"GMRF_variance_time_budget            = %f\n",
+		GMRF_variance_time_budget);
 }
 
 void CRandomFieldGridMap3D::TInsertionOptions::loadFromConfigFile(
@@ -216,6 +223,11 @@ void CRandomFieldGridMap3D::TInsertionOptions::loadFromConfigFile(
 		section.c_str(), "GMRF_lambdaPrior", GMRF_lambdaPrior);
 	GMRF_skip_variance = iniFile.read_bool(
 		section.c_str(), "GMRF_skip_variance", GMRF_skip_variance);
+	GMRF_use_cholesky = iniFile.read_bool(
+		section.c_str(), "GMRF_use_cholesky", GMRF_use_cholesky);
+	GMRF_variance_time_budget = iniFile.read_double(
+		section.c_str(), "GMRF_variance_time_budget",
+		GMRF_variance_time_budget);
 }
 
 /** Save the current estimated grid to a VTK file (.vts) as a "structured grid".
@@ -313,6 +325,12 @@ void CRandomFieldGridMap3D::updateMapEstimation()
 		!m_mrf_factors_activeObs.empty(),
 		"Cannot update a map with no observations!");
 
+	m_gmrf.setSolver(
+		insertionOptions.GMRF_use_cholesky
+			? mrpt::graphs::ScalarFactorGraph::solverCholesky
+			: mrpt::graphs::ScalarFactorGraph::solverSparseQR);
+	m_gmrf.setVarianceTimeBudget(insertionOptions.GMRF_variance_time_budget);
+
 	Eigen::VectorXd x_incr, x_var;
 	m_gmrf.updateEstimation(
 		x_incr, insertionOptions.GMRF_skip_variance ? NULL : &x_var);
@@ -326,8 +344,10 @@ void CRandomFieldGridMap3D::updateMapEstimation()
 	for (size_t j = 0; j < m_map.size(); j++)
 	{
 		m_map[j].mean_value += x_incr[j];
-		m_map[j].stddev_value =
-			insertionOptions.GMRF_skip_variance ? .0 : std::sqrt(x_var[j]);
+		if (insertionOptions.GMRF_skip_variance)
+			m_map[j].stddev_value = .0;
+		else if (!std::isnan(x_var[j]))  // NaN: out of time budget
+			m_map[j].stddev_value = std::sqrt(x_var[j]);
 	}
 }
 
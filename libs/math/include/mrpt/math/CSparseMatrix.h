@@ -407,6 +407,27 @@ class CSparseMatrix
 		return sparse_matrix.nz < 0;
 	}  // <0 means "column compressed", ">=0" means triplet.
 
+	/** ONLY for COLUMN-COMPRESSED matrices: direct access to the non-zero
+	 * values, in the order they are kept in the compressed columns, that is,
+	 * the order in which they were inserted in the triplet matrix, sorted by
+	 * column. Useful to update the values of a matrix in place, without
+	 * building it again, as long as its sparse structure does not change
+	 * (e.g. before calling CholeskyDecomp::update()).
+	 * \sa getNonZeroCount
+	 */
+	inline double* getCompressedValues()
+	{
+		ASSERT_(isColumnCompressed());
+		return sparse_matrix.x;
+	}
+	/** Number of (structurally) non-zero entries in a column-compressed
+	 * matrix, i.e. the length of getCompressedValues(). */
+	inline size_t getNonZeroCount() const
+	{
+		ASSERT_(isColumnCompressed());
+		return sparse_matrix.p[sparse_matrix.n];
+	}
+
 	/** @} */
 
 	/** @name Cholesky factorization
@@ -9,6 +9,7 @@
 #pragma once
 
 #include <map>
+#include <stdexcept>
 #include <vector>
 
 namespace mrpt::math
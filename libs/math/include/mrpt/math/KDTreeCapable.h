@@ -134,10 +134,10 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
+		const num_t query_point[2] = {static_cast<num_t>(x0),
+									  static_cast<num_t>(y0)};
 		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
+			resultSet, &query_point[0],
 			nanoflann::SearchParams());
 
 		// Copy output to user vars:
@@ -162,10 +162,10 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
+		const num_t query_point[2] = {static_cast<num_t>(x0),
+									  static_cast<num_t>(y0)};
 		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
+			resultSet, &query_point[0],
 			nanoflann::SearchParams());
 
 		return ret_index;
@@ -236,10 +236,10 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_indexes[0], &ret_sqdist[0]);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
+		const num_t query_point[2] = {static_cast<num_t>(x0),
+									  static_cast<num_t>(y0)};
 		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
+			resultSet, &query_point[0],
 			nanoflann::SearchParams());
 
 		// Copy output to user vars:
@@ -305,10 +305,10 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
+		const num_t query_point[2] = {static_cast<num_t>(x0),
+									  static_cast<num_t>(y0)};
 		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
+			resultSet, &query_point[0],
 			nanoflann::SearchParams());
 
 		for (size_t i = 0; i < knn; i++)
@@ -367,10 +367,10 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
-		m_kdtree2d_data.query_point[0] = x0;
-		m_kdtree2d_data.query_point[1] = y0;
+		const num_t query_point[2] = {static_cast<num_t>(x0),
+									  static_cast<num_t>(y0)};
 		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &m_kdtree2d_data.query_point[0],
+			resultSet, &query_point[0],
 			nanoflann::SearchParams());
 		MRPT_END
 	}
@@ -417,11 +417,11 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
+		const num_t query_point[3] = {static_cast<num_t>(x0),
+									  static_cast<num_t>(y0),
+									  static_cast<num_t>(z0)};
 		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
+			resultSet, &query_point[0],
 			nanoflann::SearchParams());
 
 		// Copy output to user vars:
@@ -447,11 +447,11 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_index, &out_dist_sqr);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
+		const num_t query_point[3] = {static_cast<num_t>(x0),
+									  static_cast<num_t>(y0),
+									  static_cast<num_t>(z0)};
 		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
+			resultSet, &query_point[0],
 			nanoflann::SearchParams());
 
 		return ret_index;
@@ -513,11 +513,11 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
+		const num_t query_point[3] = {static_cast<num_t>(x0),
+									  static_cast<num_t>(y0),
+									  static_cast<num_t>(z0)};
 		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
+			resultSet, &query_point[0],
 			nanoflann::SearchParams());
 
 		for (size_t i = 0; i < knn; i++)
@@ -571,11 +571,11 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
+		const num_t query_point[3] = {static_cast<num_t>(x0),
+									  static_cast<num_t>(y0),
+									  static_cast<num_t>(z0)};
 		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
+			resultSet, &query_point[0],
 			nanoflann::SearchParams());
 
 		for (size_t i = 0; i < knn; i++)
@@ -705,11 +705,11 @@ class KDTreeCapable
 		nanoflann::KNNResultSet<num_t> resultSet(knn);
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
-		m_kdtree3d_data.query_point[0] = x0;
-		m_kdtree3d_data.query_point[1] = y0;
-		m_kdtree3d_data.query_point[2] = z0;
+		const num_t query_point[3] = {static_cast<num_t>(x0),
+									  static_cast<num_t>(y0),
+									  static_cast<num_t>(z0)};
 		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &m_kdtree3d_data.query_point[0],
+			resultSet, &query_point[0],
 			nanoflann::SearchParams());
 		MRPT_END
 	}
@@ -760,7 +760,6 @@ class KDTreeCapable
 		/** nullptr or the up-to-date index */
 		std::unique_ptr<kdtree_index_t> index;
 
-		std::vector<num_t> query_point;
 		/** Dimensionality. typ: 2,3 */
 		size_t m_dim = _DIM;
 		size_t m_num_points = 0;
@@ -793,7 +792,6 @@ class KDTreeCapable
 			const size_t N = derived().kdtree_get_point_count();
 			m_kdtree2d_data.m_num_points = N;
 			m_kdtree2d_data.m_dim = 2;
-			m_kdtree2d_data.query_point.resize(2);
 			if (N)
 			{
 				m_kdtree2d_data.index.reset(new tree2d_t(
@@ -827,7 +825,6 @@ class KDTreeCapable
 			const size_t N = derived().kdtree_get_point_count();
 			m_kdtree3d_data.m_num_points = N;
 			m_kdtree3d_data.m_dim = 3;
-			m_kdtree3d_data.query_point.resize(3);
 			if (N)
 			{
 				m_kdtree3d_data.index.reset(new tree3d_t(
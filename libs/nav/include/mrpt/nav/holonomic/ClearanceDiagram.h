@@ -10,6 +10,7 @@
 
 #include <vector>
 #include <map>
+#include <cstddef>
 #include <cstdint>
 #include <mrpt/opengl/opengl_frwds.h>
 #include <mrpt/serialization/serialization_frwds.h>
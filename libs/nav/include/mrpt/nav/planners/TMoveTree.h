@@ -11,11 +11,17 @@
 
 #include <mrpt/graphs/CDirectedTree.h>
 #include <mrpt/containers/traits_map.h>
+#include <mrpt/containers/CDynamicGrid.h>
 #include <mrpt/math/wrap2pi.h>
 #include <mrpt/poses/CPose2D.h>
 
 #include <mrpt/nav/tpspace/CParameterizedTrajectoryGenerator.h>
 
+#include <algorithm>
+#include <cmath>
+#include <set>
+#include <vector>
+
 namespace mrpt::nav
 {
 /** \addtogroup nav_planners Path planning
@@ -37,6 +43,10 @@ struct PoseDistanceMetric;
  *      - addEdge (from, to)
  *      - add here more instructions
  *
+ * Nodes are also kept in a spatial index (a grid over their (x,y)
+ * coordinates), so getNearestNode() only evaluates the metric for the nodes
+ * around the query, not for the whole tree. Its cell size can be tuned with
+ * setSpatialIndexResolution().
  *
  * <b>Changes history</b>
  *      - 06/MAR/2014: Creation (MB)
@@ -79,7 +89,15 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 	/** A topological path up-tree */
 	using path_t = std::list<node_t>;
 
-	/** Finds the nearest node to a given pose, using the given metric */
+	/** Finds the nearest node to a given pose, using the given metric.
+	 *
+	 * Grid cells are visited in rings of increasing size around the query,
+	 * until the metric's `cannotBeNearerThan()` tells that nodes in further
+	 * rings cannot improve the best distance found so far. It is assumed that
+	 * if `cannotBeNearerThan()` holds for a given offset in x or y, it also
+	 * holds for larger offsets, as with the metrics defined in this file.
+	 * Ties are resolved in favor of the lowest node ID.
+	 */
 	template <class NODE_TYPE_FOR_METRIC>
 	mrpt::graphs::TNodeID getNearestNode(
 		const NODE_TYPE_FOR_METRIC& query_pt,
@@ -90,28 +108,87 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 		ASSERT_(!m_nodes.empty());
 		double min_d = std::numeric_limits<double>::max();
 		mrpt::graphs::TNodeID min_id = INVALID_NODEID;
-		for (typename node_map_t::const_iterator it = m_nodes.begin();
-			 it != m_nodes.end(); ++it)
+		const NODE_TYPE_FOR_METRIC ptTo(query_pt.state);
+
+		const int sx = static_cast<int>(m_grid.getSizeX());
+		const int sy = static_cast<int>(m_grid.getSizeY());
+		const double res = m_grid.getResolution();
+		const int qcx = static_cast<int>(
+			std::floor((query_pt.state.x - m_grid.getXMin()) / res));
+		const int qcy = static_cast<int>(
+			std::floor((query_pt.state.y - m_grid.getYMin()) / res));
+		// Rings which intersect the grid:
+		const int r_min = std::max({0, -qcx, qcx - sx + 1, -qcy, qcy - sy + 1});
+		const int r_max = std::max({qcx, sx - 1 - qcx, qcy, sy - 1 - qcy});
+
+		for (int r = r_min; r <= r_max; r++)
 		{
-			if (ignored_nodes &&
-				ignored_nodes->find(it->first) != ignored_nodes->end())
-				continue;  // ignore it
-			const NODE_TYPE_FOR_METRIC ptTo(query_pt.state);
-			const NODE_TYPE_FOR_METRIC ptFrom(it->second.state);
-			if (distanceMetricEvaluator.cannotBeNearerThan(ptFrom, ptTo, min_d))
-				continue;  // Skip the more expensive calculation of exact
-			// distance
-			double d = distanceMetricEvaluator.distance(ptFrom, ptTo);
-			if (d < min_d)
+			const int cy_min = std::max(0, qcy - r);
+			const int cy_max = std::min(sy - 1, qcy + r);
+			for (int cy = cy_min; cy <= cy_max; cy++)
 			{
-				min_d = d;
-				min_id = it->first;
+				// Whole rows at the top and bottom of the ring, only the two
+				// ends of the row otherwise:
+				const bool full_row = (cy == qcy - r || cy == qcy + r);
+				const int step = full_row ? 1 : 2 * r;
+				for (int cx = qcx - r; cx <= qcx + r; cx += step)
+				{
+					if (cx < 0 || cx >= sx) continue;
+					for (const auto id : *m_grid.cellByIndex(cx, cy))
+					{
+						if (ignored_nodes &&
+							ignored_nodes->find(id) != ignored_nodes->end())
+							continue;  // ignore it
+						const NODE_TYPE_FOR_METRIC ptFrom(
+							m_nodes.find(id)->second.state);
+						if (distanceMetricEvaluator.cannotBeNearerThan(
+								ptFrom, ptTo, min_d))
+							continue;  // Skip the more expensive calculation
+						// of exact distance
+						double d = distanceMetricEvaluator.distance(
+							ptFrom, ptTo);
+						// Ties go to the lowest ID, but nodes at an infinite
+						// distance (e.g. out of the PTG domain) are never
+						// valid:
+						if (d < min_d ||
+							(d == min_d && id < min_id &&
+							 d < std::numeric_limits<double>::max()))
+						{
+							min_d = d;
+							min_id = id;
+						}
+					}
+				}
 			}
+			// Nodes in the next rings are further than `r*res` in x or y:
+			if (min_id == INVALID_NODEID) continue;
+			NODE_TYPE_FOR_METRIC probe_x(ptTo), probe_y(ptTo);
+			probe_x.state.x += r * res;
+			probe_y.state.y += r * res;
+			if (distanceMetricEvaluator.cannotBeNearerThan(
+					probe_x, ptTo, min_d) &&
+				distanceMetricEvaluator.cannotBeNearerThan(
+					probe_y, ptTo, min_d))
+				break;
 		}
 		if (out_distance) *out_distance = min_d;
 		return min_id;
 	}
 
+	/** Changes the cell size [meters] of the spatial index used in
+	 * getNearestNode(). Best performance is achieved with cells in the order
+	 * of the distance between neighboring nodes. (Default: 1 meter) */
+	void setSpatialIndexResolution(const double cell_size)
+	{
+		ASSERT_(cell_size > 0);
+		m_grid.setSize(0, 0, 0, 0, cell_size);
+		for (const auto& n : m_nodes) addToSpatialIndex(n.first, n.second);
+	}
+	double getSpatialIndexResolution() const
+	{
+		return m_grid.getResolution();
+	}
+
 	void insertNodeAndEdge(
 		const mrpt::graphs::TNodeID parent_id,
 		const mrpt::graphs::TNodeID new_child_id,
@@ -124,9 +201,9 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 		edges_of_parent.push_back(typename base_t::TEdgeInfo(
 			new_child_id, false /*direction_child_to_parent*/, new_edge_data));
 		// node:
-		m_nodes[new_child_id] = node_t(
+		setNode(node_t(
 			new_child_id, parent_id, &edges_of_parent.back().data,
-			new_child_node_data);
+			new_child_node_data));
 	}
 
 	/** Insert a node without edges (should be used only for a tree root node)
@@ -134,7 +211,7 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 	void insertNode(
 		const mrpt::graphs::TNodeID node_id, const NODE_TYPE_DATA& node_data)
 	{
-		m_nodes[node_id] = node_t(node_id, INVALID_NODEID, NULL, node_data);
+		setNode(node_t(node_id, INVALID_NODEID, NULL, node_data));
 	}
 
 	mrpt::graphs::TNodeID getNextFreeNodeID() const { return m_nodes.size(); }
@@ -177,6 +254,35 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
    private:
 	/** Info per node */
 	node_map_t m_nodes;
+	/** Spatial index: IDs of the nodes whose (x,y) fall in each cell */
+	mrpt::containers::CDynamicGrid<std::vector<mrpt::graphs::TNodeID>> m_grid{
+		0, 0, 0, 0, 1.0};
+
+	void setNode(const node_t& node)
+	{
+		auto it = m_nodes.find(node.node_id);
+		if (it != m_nodes.end())
+		{
+			// Replacing an existing node: remove it from the index first.
+			auto& cell = *m_grid.cellByPos(
+				it->second.state.x, it->second.state.y);
+			cell.erase(std::find(cell.begin(), cell.end(), node.node_id));
+		}
+		m_nodes[node.node_id] = node;
+		addToSpatialIndex(node.node_id, node);
+	}
+
+	void addToSpatialIndex(const mrpt::graphs::TNodeID id, const node_t& node)
+	{
+		const double x = node.state.x, y = node.state.y;
+		const double res = m_grid.getResolution();
+		m_grid.resize(
+			x - res, x + res, y - res, y + res,
+			std::vector<mrpt::graphs::TNodeID>(), 10 * res);
+		auto* cell = m_grid.cellByPos(x, y);
+		ASSERT_(cell != nullptr);
+		cell->push_back(id);
+	}
 
 };  // end TMoveTree
 
@@ -227,8 +333,9 @@ struct PoseDistanceMetric<TNodeSE2>
 	bool cannotBeNearerThan(
 		const TNodeSE2& a, const TNodeSE2& b, const double d) const
 	{
-		if (std::abs(a.state.x - b.state.x) > d) return true;
-		if (std::abs(a.state.y - b.state.y) > d) return true;
+		// distance() is a squared distance:
+		if (mrpt::square(a.state.x - b.state.x) > d) return true;
+		if (mrpt::square(a.state.y - b.state.y) > d) return true;
 		return false;
 	}
 
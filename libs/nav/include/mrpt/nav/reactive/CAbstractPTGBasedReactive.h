@@ -223,6 +223,12 @@ class CAbstractPTGBasedReactive : public CWaypointsNavigator
 		/** Max dist [meters] to use time-based path prediction for NOP
 		 * evaluation. */
 		double max_dist_for_timebased_path_prediction;
+		/** Max number of threads to evaluate the PTGs (and the "NOP" motion)
+		 * in each navigation step, in mrpt::system::TaskScheduler. `1` means
+		 * serial evaluation, and `0` as many threads as the scheduler has.
+		 * The selected motion does not depend on this value. (Default: 1)
+		 * \note [New in MRPT 2.0.0] */
+		unsigned int ptg_evaluation_threads;
 
 		virtual void loadFromConfigFile(
 			const mrpt::config::CConfigFileBase& c,
@@ -416,6 +422,9 @@ class CAbstractPTGBasedReactive : public CWaypointsNavigator
 		std::vector<double> TP_Obstacles;
 		/** Clearance for each path */
 		ClearanceDiagram clearance;
+		/** Measures for m_timelogger, registered once all PTGs are evaluated,
+		 * since it cannot be used from several threads at once. */
+		std::vector<std::pair<const char*, double>> profiler_measures;
 	};
 
 	/** Temporary buffers for working with each PTG during a navigationStep() */
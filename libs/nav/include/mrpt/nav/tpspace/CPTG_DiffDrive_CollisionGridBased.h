@@ -12,6 +12,7 @@
 #include <mrpt/containers/CDynamicGrid.h>
 #include <mrpt/math/CPolygon.h>
 #include <mrpt/typemeta/TEnumType.h>
+#include <memory>
 
 namespace mrpt
 {
@@ -45,6 +46,10 @@ mrpt::serialization::CArchive& operator>>(
  * look-up-table.
  * Regarding `initialize()`: in this this family of PTGs, the method builds the
  * collision grid or load it from a cache file.
+ * Cache files are memory-mapped: the collision grid is read straight from the
+ * file pages as they are needed, which are shared by all processes using the
+ * same file. Each file holds a hash of the PTG parameters and robot shape,
+ * and it is rebuilt if they do not match.
  * Collision grids must be calculated before calling getTPObstacle(). Robot
  * shape must be set before initializing with setRobotShape().
  * The rest of PTG parameters should have been set at the constructor.
@@ -100,6 +105,11 @@ class CPTG_DiffDrive_CollisionGridBased : public CPTG_RobotShape_Polygonal
 		double ox, double oy, std::vector<double>& tp_obstacles) const override;
 	void updateTPObstacleSingle(
 		double ox, double oy, uint16_t k, double& tp_obstacle_k) const override;
+	/** Looks up all points in the collision grid at once, updating each
+	 * run of consecutive "k" directions of a cell with SIMD instructions. */
+	void updateTPObstacles(
+		const double* ox, const double* oy, const size_t N,
+		std::vector<double>& tp_obstacles) const override;
 
 	/** This family of PTGs ignores the dynamic states */
 	virtual void onNewNavDynamicState() override
@@ -164,7 +174,16 @@ class CPTG_DiffDrive_CollisionGridBased : public CPTG_RobotShape_Polygonal
 	 */
 	using TCollisionCell = std::vector<std::pair<uint16_t, float>>;
 
-	/** An internal class for storing the collision grid  */
+	/** An internal class for storing the collision grid.
+	 * It is built cell by cell with updateCellInfo(), then compact() converts
+	 * it into a read-only, CSR-like layout: the pairs (k,d) of each cell are
+	 * sorted by `k` and grouped into "runs" of consecutive `k` values.
+	 * Cell `i` has the runs `[cell_runs[i],cell_runs[i+1])`, and the run `r`
+	 * comprises the paths `k=run_k[r], run_k[r]+1,...`, whose collision
+	 * distances are `dists[run_dists[r]]...dists[run_dists[r+1]-1]`.
+	 * These arrays are never modified once built, so copies of the grid
+	 * share them.
+	 */
 	class CCollisionGrid : public mrpt::containers::CDynamicGrid<TCollisionCell>
 	{
 	   private:
@@ -180,19 +199,25 @@ class CPTG_DiffDrive_CollisionGridBased : public CPTG_RobotShape_Polygonal
 		{
 		}
 		virtual ~CCollisionGrid() {}
-		/** Save to file, true = OK */
-		bool saveToFile(
-			mrpt::serialization::CArchive* fil,
-			const mrpt::math::CPolygon& computed_robotShape) const;
-		/** Load from file,  true = OK */
-		bool loadFromFile(
-			mrpt::serialization::CArchive* fil,
-			const mrpt::math::CPolygon& current_robotShape);
-
-		/** For an obstacle (x,y), returns a vector with all the pairs (a,d)
-		 * such as the robot collides */
-		const TCollisionCell& getTPObstacle(
-			const float obsX, const float obsY) const;
+
+		/** For an obstacle (x,y), returns the range of runs `[first,last)`
+		 * of all the pairs (k,d) such as the robot collides. The range is
+		 * empty for obstacles out of the grid. Requires compact(). */
+		void getTPObstacle(
+			const double obsX, const double obsY, uint32_t& first,
+			uint32_t& last) const
+		{
+			const int cx = x2idx(obsX), cy = y2idx(obsY);
+			if (cx < 0 || cx >= static_cast<int>(m_size_x) || cy < 0 ||
+				cy >= static_cast<int>(m_size_y) || !cell_runs)
+			{
+				first = last = 0;
+				return;
+			}
+			const size_t i = cx + cy * m_size_x;
+			first = cell_runs[i];
+			last = cell_runs[i + 1];
+		}
 
 		/** Updates the info into a cell: It updates the cell only if the
 		 *distance d for the path k is lower than the previous value:
@@ -204,15 +229,43 @@ class CPTG_DiffDrive_CollisionGridBased : public CPTG_RobotShape_Polygonal
 			const unsigned int icx, const unsigned int icy, const uint16_t k,
 			const float dist);
 
+		/** Builds the CSR layout from the cells filled in with
+		 * updateCellInfo(), whose memory is released afterwards. */
+		void compact();
+
+		/** CSR layout (see class description) */
+		const uint32_t *cell_runs{nullptr}, *run_dists{nullptr};
+		const uint16_t* run_k{nullptr};
+		const float* dists{nullptr};
+		/** Owner of the memory of the CSR arrays (built by compact() or a
+		 * memory-mapped cache file) */
+		std::shared_ptr<const void> csr_owner;
+
+		/** Number of cells, runs and (k,d) pairs in the CSR layout */
+		size_t getCellCount() const { return cell_runs ? m_map.size() : 0; }
+		size_t getRunCount() const
+		{
+			return cell_runs ? cell_runs[getCellCount()] : 0;
+		}
+		size_t getDistCount() const
+		{
+			return cell_runs ? run_dists[getRunCount()] : 0;
+		}
+
 	};  // end of class CCollisionGrid
 
-	// Save/Load from files.
-	bool saveColGridsToFile(
-		const std::string& filename,
-		const mrpt::math::CPolygon& computed_robotShape) const;  // true = OK
-	bool loadColGridsFromFile(
-		const std::string& filename,
-		const mrpt::math::CPolygon& current_robotShape);  // true = OK
+	/** Hash of all the PTG parameters and the robot shape, which determine
+	 * the trajectories and collision grid stored in cache files. */
+	uint64_t getCacheHash() const;
+	/** Saves the trajectories and collision grid to a cache file. The file
+	 * is written to a temporary file first, then renamed, so other processes
+	 * never read incomplete files. \return false on any error */
+	bool saveCacheFile(const std::string& filename) const;
+	/** Loads the trajectories and memory-maps the collision grid from a
+	 * cache file saved by saveCacheFile().
+	 * \return false if the file does not exist, it is corrupt, or it was
+	 * built for another PTG configuration (see getCacheHash()). */
+	bool loadCacheFile(const std::string& filename);
 
 	/** The collision grid */
 	CCollisionGrid m_collisionGrid;
@@ -257,6 +257,15 @@ class CParameterizedTrajectoryGenerator
 	virtual void updateTPObstacleSingle(
 		double ox, double oy, uint16_t k, double& tp_obstacle_k) const = 0;
 
+	/** Like updateTPObstacle() for a batch of `N` obstacle points, at
+	 * (ox[i],oy[i]). The outcome is the same than calling updateTPObstacle()
+	 * for each point, which is what the default implementation does; derived
+	 * classes may process all points at once more efficiently.
+	 * \note [New in MRPT 2.0.0] */
+	virtual void updateTPObstacles(
+		const double* ox, const double* oy, const size_t N,
+		std::vector<double>& tp_obstacles) const;
+
 	/** Loads a set of default parameters into the PTG. Users normally will call
 	 * `loadFromConfigFile()` instead, this method is provided
 	  * exclusively for the PTG-configurator tool. */
@@ -85,7 +85,7 @@ void PlannerTPS_VirtualBase::internal_initialize_PTG()
 
 		m_PTGs[i]->initialize(
 			mrpt::format(
-				"%s/TPRRT_PTG_%03u.dat.gz",
+				"%s/TPRRT_PTG_%03u.dat",
 				params.ptg_cache_files_directory.c_str(),
 				static_cast<unsigned int>(i)),
 			params.ptg_verbose);
@@ -195,6 +195,9 @@ void PlannerTPS_VirtualBase::spaceTransformer(
 		// Init obs ranges:
 		in_PTG->initTPObstacles(out_TPObstacles);
 
+		std::vector<double> oxs, oys;
+		oxs.reserve(nObs);
+		oys.reserve(nObs);
 		for (size_t obs = 0; obs < nObs; obs++)
 		{
 			const float ox = obs_xs[obs];
@@ -204,8 +207,11 @@ void PlannerTPS_VirtualBase::spaceTransformer(
 				continue;  // ignore this obstacle: anyway, I don't know how to
 			// map it to TP-Obs!
 
-			in_PTG->updateTPObstacle(ox, oy, out_TPObstacles);
+			oxs.push_back(ox);
+			oys.push_back(oy);
 		}
+		in_PTG->updateTPObstacles(
+			oxs.data(), oys.data(), oxs.size(), out_TPObstacles);
 
 		// Leave distances in out_TPObstacles un-normalized ([0,1]), so they
 		// just represent real distances in meters.
@@ -0,0 +1,171 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/nav/planners/TMoveTree.h>
+#include <mrpt/nav/tpspace/CPTG_DiffDrive_C.h>
+#include <mrpt/nav/tpspace/CPTG_Holo_Blend.h>
+#include <mrpt/config/CConfigFileMemory.h>
+#include <mrpt/random.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt::nav;
+using mrpt::graphs::TNodeID;
+
+// Reference implementation: exhaustive search
+static TNodeID brute_force_nearest(
+	const TMoveTreeSE2_TP& tree, const TNodeSE2& query,
+	const std::set<TNodeID>& ignored, double& out_dist)
+{
+	const PoseDistanceMetric<TNodeSE2> metric;
+	out_dist = std::numeric_limits<double>::max();
+	TNodeID best = INVALID_NODEID;
+	for (const auto& n : tree.getAllNodes())
+	{
+		if (ignored.count(n.first)) continue;
+		const double d = metric.distance(TNodeSE2(n.second.state), query);
+		if (d < out_dist)
+		{
+			out_dist = d;
+			best = n.first;
+		}
+	}
+	return best;
+}
+
+TEST(NavTests, TMoveTree_getNearestNode)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+
+	for (const double res : {0.1, 1.0, 5.0})
+	{
+		TMoveTreeSE2_TP tree;
+		tree.setSpatialIndexResolution(res);
+		tree.insertNode(0, TNodeSE2_TP(mrpt::math::TPose2D(0, 0, 0)));
+		for (TNodeID id = 1; id < 500; id++)
+		{
+			const mrpt::math::TPose2D p(
+				rng.drawUniform(-10.0, 10.0), rng.drawUniform(-5.0, 20.0),
+				rng.drawUniform(-M_PI, M_PI));
+			tree.insertNodeAndEdge(
+				rng.drawUniform32bit() % id, id, TNodeSE2_TP(p),
+				TMoveEdgeSE2_TP(0, p));
+		}
+		ASSERT_EQ(tree.getAllNodes().size(), 500U);
+
+		const PoseDistanceMetric<TNodeSE2> metric;
+		std::set<TNodeID> ignored;
+		for (TNodeID id = 0; id < 500; id += 7) ignored.insert(id);
+
+		for (int i = 0; i < 200; i++)
+		{
+			// Some queries fall outside of the area covered by the tree:
+			const TNodeSE2 q(mrpt::math::TPose2D(
+				rng.drawUniform(-30.0, 30.0), rng.drawUniform(-30.0, 30.0),
+				rng.drawUniform(-M_PI, M_PI)));
+			const bool use_ignored = (i % 2) == 0;
+
+			double d, d_ref;
+			const TNodeID id = tree.getNearestNode(
+				q, metric, &d, use_ignored ? &ignored : nullptr);
+			const TNodeID id_ref = brute_force_nearest(
+				tree, q, use_ignored ? ignored : std::set<TNodeID>(), d_ref);
+			EXPECT_EQ(id, id_ref) << "res=" << res;
+			EXPECT_DOUBLE_EQ(d, d_ref);
+		}
+	}
+}
+
+// Same than above, with the TP-Space metric:
+TEST(NavTests, TMoveTree_getNearestNode_TPSpaceMetric)
+{
+	mrpt::config::CConfigFileMemory cfg;
+	cfg.write("PTG", "refDistance", 3.0);
+	cfg.write("PTG", "num_paths", 60);
+	cfg.write("PTG", "T_ramp_max", 0.8);
+	cfg.write("PTG", "v_max_mps", 1.0);
+	cfg.write("PTG", "w_max_dps", 60);
+	cfg.write("PTG", "robot_radius", 0.35);
+	CPTG_Holo_Blend ptg(cfg, "PTG");
+	ptg.initialize(std::string(), false /*verbose*/);
+	const PoseDistanceMetric<TNodeSE2_TP> metric(ptg);
+
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(4321);
+
+	TMoveTreeSE2_TP tree;
+	tree.setSpatialIndexResolution(1.0);
+	tree.insertNode(0, TNodeSE2_TP(mrpt::math::TPose2D(0, 0, 0)));
+	for (TNodeID id = 1; id < 200; id++)
+	{
+		const mrpt::math::TPose2D p(
+			rng.drawUniform(-10.0, 10.0), rng.drawUniform(-10.0, 10.0),
+			rng.drawUniform(-M_PI, M_PI));
+		tree.insertNodeAndEdge(
+			rng.drawUniform32bit() % id, id, TNodeSE2_TP(p),
+			TMoveEdgeSE2_TP(0, p));
+	}
+
+	for (int i = 0; i < 200; i++)
+	{
+		const TNodeSE2_TP q(mrpt::math::TPose2D(
+			rng.drawUniform(-20.0, 20.0), rng.drawUniform(-20.0, 20.0),
+			rng.drawUniform(-M_PI, M_PI)));
+
+		// Exhaustive search:
+		double d_ref = std::numeric_limits<double>::max();
+		TNodeID id_ref = INVALID_NODEID;
+		for (const auto& n : tree.getAllNodes())
+		{
+			const double d = metric.distance(TNodeSE2_TP(n.second.state), q);
+			if (d < d_ref)
+			{
+				d_ref = d;
+				id_ref = n.first;
+			}
+		}
+
+		double d;
+		const TNodeID id = tree.getNearestNode(q, metric, &d);
+		EXPECT_EQ(id, id_ref);
+		EXPECT_DOUBLE_EQ(d, d_ref);
+	}
+}
+
+// The TP-Space metric returns an infinite distance for nodes out of the
+// domain of the PTG, which must never be returned as the nearest node:
+TEST(NavTests, TMoveTree_getNearestNode_NoReachableNode)
+{
+	// Forward-only circular arcs: a query straight behind all nodes is out
+	// of the domain of the PTG for all of them.
+	mrpt::config::CConfigFileMemory cfg;
+	cfg.write("PTG", "refDistance", 3.0);
+	cfg.write("PTG", "num_paths", 31);
+	cfg.write("PTG", "resolution", 0.05);
+	cfg.write("PTG", "v_max_mps", 1.0);
+	cfg.write("PTG", "w_max_dps", 60);
+	cfg.write("PTG", "K", 1.0);
+	CPTG_DiffDrive_C ptg(cfg, "PTG");
+	const PoseDistanceMetric<TNodeSE2_TP> metric(ptg);
+
+	TMoveTreeSE2_TP tree;
+	tree.insertNode(0, TNodeSE2_TP(mrpt::math::TPose2D(0, 0, 0)));
+	for (TNodeID id = 1; id < 5; id++)
+	{
+		const mrpt::math::TPose2D p(0.5 * id, 0, 0);
+		tree.insertNodeAndEdge(
+			id - 1, id, TNodeSE2_TP(p), TMoveEdgeSE2_TP(0, p));
+	}
+
+	double d;
+	const TNodeID id = tree.getNearestNode(
+		TNodeSE2_TP(mrpt::math::TPose2D(-5.0, 0, 0)), metric, &d);
+	EXPECT_EQ(id, INVALID_NODEID);
+	EXPECT_EQ(d, std::numeric_limits<double>::max());
+}
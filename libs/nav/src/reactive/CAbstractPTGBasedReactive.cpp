@@ -20,6 +20,7 @@
 #include <mrpt/io/CMemoryStream.h>
 #include <mrpt/maps/CPointCloudFilterByDistance.h>
 #include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/TaskScheduler.h>
 #include <limits>
 #include <iomanip>
 #include <array>
@@ -515,8 +516,9 @@ void CAbstractPTGBasedReactive::performNavigationStep()
 			nPTGs + 1);  // the last extra one is for the evaluation of "NOP
 		// motion command" choice.
 
-		for (size_t indexPTG = 0; indexPTG < nPTGs; indexPTG++)
-		{
+		// Round #1: Evaluate each PTG
+		// =========
+		auto eval_PTG = [&](const size_t indexPTG, CLogFileRecord& log) {
 			CParameterizedTrajectoryGenerator* ptg = getPTG(indexPTG);
 			TInfoPerPTG& ipf = m_infoPerPTG[indexPTG];
 
@@ -528,14 +530,201 @@ void CAbstractPTGBasedReactive::performNavigationStep()
 			// method below)
 			TCandidateMovementPTG& cm = candidate_movs[indexPTG];
 
-			ASSERT_(m_navigationParams);
 			build_movement_candidate(
 				ptg, indexPTG, relTargets, rel_pose_PTG_origin_wrt_sense, ipf,
-				cm, newLogRec, false /* this is a regular PTG reactive case */,
+				cm, log, false /* this is a regular PTG reactive case */,
 				*m_holonomicMethod[indexPTG], tim_start_iteration,
 				*m_navigationParams);
-		}  // end for each PTG
+		};
+
+		// Round #2: Evaluate dont sending any new velocity command ("NOP"
+		// motion)
+		// =========
+		mrpt::math::TPose2D rel_cur_pose_wrt_last_vel_cmd_NOP(0, 0, 0),
+			rel_pose_PTG_origin_wrt_sense_NOP(0, 0, 0);
 
+		auto eval_NOP = [&](CLogFileRecord& log) {
+			bool NOP_not_too_old = true;
+			bool NOP_not_too_close_and_have_to_slowdown = true;
+			double NOP_max_time = -1.0, NOP_At = -1.0;
+			double slowdowndist = .0;
+			CParameterizedTrajectoryGenerator* last_sent_ptg =
+				m_lastSentVelCmd.isValid() ? getPTG(m_lastSentVelCmd.ptg_index)
+										   : nullptr;
+			if (last_sent_ptg)
+			{
+				// So supportSpeedAtTarget() below is evaluated in the correct
+				// context:
+				last_sent_ptg->updateNavDynamicState(
+					m_lastSentVelCmd.ptg_dynState);
+			}
+
+			// This approach is only possible if:
+			const bool can_do_nop_motion =
+				(m_lastSentVelCmd.isValid() &&
+				 !target_changed_since_last_iteration && last_sent_ptg &&
+				 last_sent_ptg->supportVelCmdNOP()) &&
+				(NOP_not_too_old =
+					 (NOP_At = mrpt::system::timeDifference(
+						  m_lastSentVelCmd.tim_send_cmd_vel,
+						  tim_start_iteration)) <
+					 (NOP_max_time =
+						  last_sent_ptg->maxTimeInVelCmdNOP(
+							  m_lastSentVelCmd.ptg_alpha_index) /
+						  std::max(0.1, m_lastSentVelCmd.speed_scale))) &&
+				(NOP_not_too_close_and_have_to_slowdown =
+					 (last_sent_ptg->supportSpeedAtTarget() ||
+					  (relTargetDist >
+					   (slowdowndist =
+							m_holonomicMethod[m_lastSentVelCmd.ptg_index]
+								->getTargetApproachSlowDownDistance())
+					   // slowdowndist is assigned here, inside the if()
+					   // to be sure the index in m_lastSentVelCmd is valid!
+					   )));
+
+			if (!NOP_not_too_old)
+			{
+				log.additional_debug_msgs["PTG_cont"] = mrpt::format(
+					"PTG-continuation not allowed: previous command timed-out "
+					"(At=%.03f > Max_At=%.03f)",
+					NOP_At, NOP_max_time);
+			}
+			if (!NOP_not_too_close_and_have_to_slowdown)
+			{
+				log.additional_debug_msgs["PTG_cont_trgdst"] = mrpt::format(
+					"PTG-continuation not allowed: target too close and must "
+					"start slow-down (trgDist=%.03f < SlowDownDist=%.03f)",
+					relTargetDist, slowdowndist);
+			}
+
+			if (can_do_nop_motion)
+			{
+				// Add the estimation of how long it takes to run the
+				// changeSpeeds() callback (usually a tiny period):
+				const mrpt::system::TTimeStamp tim_send_cmd_vel_corrected =
+					mrpt::system::timestampAdd(
+						m_lastSentVelCmd.tim_send_cmd_vel,
+						tim_changeSpeed_avr.getLastOutput());
+
+				// Note: we use (uncorrected) raw odometry as basis to the
+				// following calculation since it's normally
+				// smoother than particle filter-based localization data, more
+				// accurate in the middle/long term,
+				// but not in the short term:
+				mrpt::math::TPose2D robot_pose_at_send_cmd,
+					robot_odom_at_send_cmd;
+				bool valid_odom, valid_pose;
+
+				m_latestOdomPoses.interpolate(
+					tim_send_cmd_vel_corrected, robot_odom_at_send_cmd,
+					valid_odom);
+				m_latestPoses.interpolate(
+					tim_send_cmd_vel_corrected, robot_pose_at_send_cmd,
+					valid_pose);
+
+				if (valid_odom && valid_pose)
+				{
+					ASSERT_(last_sent_ptg != nullptr);
+
+					std::vector<TPose2D> relTargets_NOPs;
+					std::transform(
+						targets.begin(), targets.end(),  // in
+						std::back_inserter(relTargets_NOPs),  // out
+						[robot_pose_at_send_cmd](
+							const CAbstractNavigator::TargetInfo& e) {
+							return e.target_coords - robot_pose_at_send_cmd;
+						});
+					ASSERT_EQUAL_(relTargets_NOPs.size(), targets.size());
+
+					rel_pose_PTG_origin_wrt_sense_NOP =
+						robot_odom_at_send_cmd -
+						(m_curPoseVel.rawOdometry + relPoseSense);
+					rel_cur_pose_wrt_last_vel_cmd_NOP =
+						m_curPoseVel.rawOdometry - robot_odom_at_send_cmd;
+
+					// Update PTG response to dynamic params:
+					last_sent_ptg->updateNavDynamicState(
+						m_lastSentVelCmd.ptg_dynState);
+
+					if (fill_log_record)
+					{
+						log.additional_debug_msgs
+							["rel_cur_pose_wrt_last_vel_cmd_NOP(interp)"] =
+							rel_cur_pose_wrt_last_vel_cmd_NOP.asString();
+						log.additional_debug_msgs
+							["robot_odom_at_send_cmd(interp)"] =
+							robot_odom_at_send_cmd.asString();
+					}
+
+					// No need to call setAssociatedPTG(), already correctly
+					// associated above.
+
+					ASSERT_(m_navigationParams);
+					build_movement_candidate(
+						last_sent_ptg, m_lastSentVelCmd.ptg_index,
+						relTargets_NOPs, rel_pose_PTG_origin_wrt_sense_NOP,
+						m_infoPerPTG[nPTGs],
+						candidate_movs[nPTGs], log,
+						true /* this is the PTG continuation (NOP) choice */,
+						*m_holonomicMethod[m_lastSentVelCmd.ptg_index],
+						tim_start_iteration, *m_navigationParams,
+						rel_cur_pose_wrt_last_vel_cmd_NOP);
+
+				}  // end valid interpolated origin pose
+				else
+				{
+					// Can't interpolate pose, hence can't evaluate NOP:
+					candidate_movs[nPTGs].speed =
+						-0.01;  // <0 means inviable movement
+				}
+			}  // end can_do_NOP_motion
+		};
+
+		ASSERT_(m_navigationParams);
+		const unsigned int nThreads =
+			params_abstract_ptg_navigator.ptg_evaluation_threads;
+		const bool run_in_parallel = (nThreads != 1 && nPTGs > 1);
+		if (!run_in_parallel)
+		{
+			for (size_t indexPTG = 0; indexPTG < nPTGs; indexPTG++)
+				eval_PTG(indexPTG, newLogRec);
+		}
+		else
+		{
+			// Each PTG writes to its own log record, merged below in the same
+			// order than in the serial evaluation, so the outcome is
+			// identical.
+			std::vector<CLogFileRecord> logs(nPTGs + 1);
+			for (size_t i = 0; i <= nPTGs; i++)
+			{
+				logs[i].infoPerPTG.resize(nPTGs + 1);
+				logs[i].infoPerPTG[i] = newLogRec.infoPerPTG[i];
+			}
+			// The NOP motion changes the dynamic state of the PTG of the last
+			// command, so it is evaluated right after that PTG, in the same
+			// task:
+			const size_t nop_ptg_idx = m_lastSentVelCmd.isValid()
+										   ? m_lastSentVelCmd.ptg_index
+										   : nPTGs;
+			mrpt::system::parallel_for_chunks(
+				nPTGs,
+				[&](const size_t first, const size_t last) {
+					for (size_t i = first; i < last; i++)
+					{
+						eval_PTG(i, logs[i]);
+						if (i == nop_ptg_idx) eval_NOP(logs[nPTGs]);
+					}
+				},
+				nThreads);
+			if (nop_ptg_idx >= nPTGs) eval_NOP(logs[nPTGs]);
+
+			for (size_t i = 0; i <= nPTGs; i++)
+			{
+				newLogRec.infoPerPTG[i] = std::move(logs[i].infoPerPTG[i]);
+				for (const auto& m : logs[i].additional_debug_msgs)
+					newLogRec.additional_debug_msgs[m.first] = m.second;
+			}
+		}
 		// check for collision, which is reflected by ALL TP-Obstacles being
 		// zero:
 		bool is_all_ptg_collision = true;
@@ -564,139 +753,11 @@ void CAbstractPTGBasedReactive::performNavigationStep()
 				std::ref(m_robot)));
 		}
 
-		// Round #2: Evaluate dont sending any new velocity command ("NOP"
-		// motion)
-		// =========
-		bool NOP_not_too_old = true;
-		bool NOP_not_too_close_and_have_to_slowdown = true;
-		double NOP_max_time = -1.0, NOP_At = -1.0;
-		double slowdowndist = .0;
-		CParameterizedTrajectoryGenerator* last_sent_ptg =
-			m_lastSentVelCmd.isValid() ? getPTG(m_lastSentVelCmd.ptg_index)
-									   : nullptr;
-		if (last_sent_ptg)
-		{
-			// So supportSpeedAtTarget() below is evaluated in the correct
-			// context:
-			last_sent_ptg->updateNavDynamicState(m_lastSentVelCmd.ptg_dynState);
-		}
-
-		// This approach is only possible if:
-		const bool can_do_nop_motion =
-			(m_lastSentVelCmd.isValid() &&
-			 !target_changed_since_last_iteration && last_sent_ptg &&
-			 last_sent_ptg->supportVelCmdNOP()) &&
-			(NOP_not_too_old =
-				 (NOP_At = mrpt::system::timeDifference(
-					  m_lastSentVelCmd.tim_send_cmd_vel, tim_start_iteration)) <
-				 (NOP_max_time =
-					  last_sent_ptg->maxTimeInVelCmdNOP(
-						  m_lastSentVelCmd.ptg_alpha_index) /
-					  std::max(0.1, m_lastSentVelCmd.speed_scale))) &&
-			(NOP_not_too_close_and_have_to_slowdown =
-				 (last_sent_ptg->supportSpeedAtTarget() ||
-				  (relTargetDist >
-				   (slowdowndist = m_holonomicMethod[m_lastSentVelCmd.ptg_index]
-									   ->getTargetApproachSlowDownDistance())
-				   // slowdowndist is assigned here, inside the if()
-				   // to be sure the index in m_lastSentVelCmd is valid!
-				   )));
-
-		if (!NOP_not_too_old)
-		{
-			newLogRec.additional_debug_msgs["PTG_cont"] = mrpt::format(
-				"PTG-continuation not allowed: previous command timed-out "
-				"(At=%.03f > Max_At=%.03f)",
-				NOP_At, NOP_max_time);
-		}
-		if (!NOP_not_too_close_and_have_to_slowdown)
-		{
-			newLogRec.additional_debug_msgs["PTG_cont_trgdst"] = mrpt::format(
-				"PTG-continuation not allowed: target too close and must start "
-				"slow-down (trgDist=%.03f < SlowDownDist=%.03f)",
-				relTargetDist, slowdowndist);
-		}
-
-		mrpt::math::TPose2D rel_cur_pose_wrt_last_vel_cmd_NOP(0, 0, 0),
-			rel_pose_PTG_origin_wrt_sense_NOP(0, 0, 0);
-
-		if (can_do_nop_motion)
-		{
-			// Add the estimation of how long it takes to run the changeSpeeds()
-			// callback (usually a tiny period):
-			const mrpt::system::TTimeStamp tim_send_cmd_vel_corrected =
-				mrpt::system::timestampAdd(
-					m_lastSentVelCmd.tim_send_cmd_vel,
-					tim_changeSpeed_avr.getLastOutput());
-
-			// Note: we use (uncorrected) raw odometry as basis to the following
-			// calculation since it's normally
-			// smoother than particle filter-based localization data, more
-			// accurate in the middle/long term,
-			// but not in the short term:
-			mrpt::math::TPose2D robot_pose_at_send_cmd, robot_odom_at_send_cmd;
-			bool valid_odom, valid_pose;
-
-			m_latestOdomPoses.interpolate(
-				tim_send_cmd_vel_corrected, robot_odom_at_send_cmd, valid_odom);
-			m_latestPoses.interpolate(
-				tim_send_cmd_vel_corrected, robot_pose_at_send_cmd, valid_pose);
-
-			if (valid_odom && valid_pose)
-			{
-				ASSERT_(last_sent_ptg != nullptr);
-
-				std::vector<TPose2D> relTargets_NOPs;
-				std::transform(
-					targets.begin(), targets.end(),  // in
-					std::back_inserter(relTargets_NOPs),  // out
-					[robot_pose_at_send_cmd](
-						const CAbstractNavigator::TargetInfo& e) {
-						return e.target_coords - robot_pose_at_send_cmd;
-					});
-				ASSERT_EQUAL_(relTargets_NOPs.size(), targets.size());
-
-				rel_pose_PTG_origin_wrt_sense_NOP =
-					robot_odom_at_send_cmd -
-					(m_curPoseVel.rawOdometry + relPoseSense);
-				rel_cur_pose_wrt_last_vel_cmd_NOP =
-					m_curPoseVel.rawOdometry - robot_odom_at_send_cmd;
-
-				// Update PTG response to dynamic params:
-				last_sent_ptg->updateNavDynamicState(
-					m_lastSentVelCmd.ptg_dynState);
+		if (!run_in_parallel) eval_NOP(newLogRec);
 
-				if (fill_log_record)
-				{
-					newLogRec.additional_debug_msgs
-						["rel_cur_pose_wrt_last_vel_cmd_NOP(interp)"] =
-						rel_cur_pose_wrt_last_vel_cmd_NOP.asString();
-					newLogRec.additional_debug_msgs
-						["robot_odom_at_send_cmd(interp)"] =
-						robot_odom_at_send_cmd.asString();
-				}
-
-				// No need to call setAssociatedPTG(), already correctly
-				// associated above.
-
-				ASSERT_(m_navigationParams);
-				build_movement_candidate(
-					last_sent_ptg, m_lastSentVelCmd.ptg_index, relTargets_NOPs,
-					rel_pose_PTG_origin_wrt_sense_NOP, m_infoPerPTG[nPTGs],
-					candidate_movs[nPTGs], newLogRec,
-					true /* this is the PTG continuation (NOP) choice */,
-					*m_holonomicMethod[m_lastSentVelCmd.ptg_index],
-					tim_start_iteration, *m_navigationParams,
-					rel_cur_pose_wrt_last_vel_cmd_NOP);
-
-			}  // end valid interpolated origin pose
-			else
-			{
-				// Can't interpolate pose, hence can't evaluate NOP:
-				candidate_movs[nPTGs].speed =
-					-0.01;  // <0 means inviable movement
-			}
-		}  // end can_do_NOP_motion
+		for (const auto& ipf : m_infoPerPTG)
+			for (const auto& m : ipf.profiler_measures)
+				m_timelogger.registerUserMeasure(m.first, m.second);
 
 		// Evaluate all the candidates and pick the "best" one, using
 		// the user-defined multiobjective optimizer
@@ -1551,6 +1612,8 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 	}
 
 	double timeForTPObsTransformation = .0, timeForHolonomicMethod = .0;
+	// Not the member `tictac`, since PTGs may be evaluated in parallel:
+	CTicTac stepTimer;
 
 	// Normal PTG validity filter: check if target falls into the PTG domain:
 	bool any_TPTarget_is_valid = false;
@@ -1587,7 +1650,7 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		//  STEP3(b): Build TP-Obstacles
 		// -----------------------------------------------------------------------------
 		{
-			tictac.Tic();
+			stepTimer.Tic();
 
 			// Initialize TP-Obstacles:
 			const size_t Ki = ptg->getAlphaValuesCount();
@@ -1612,18 +1675,17 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 			const double _refD = 1.0 / ptg->getRefDistance();
 			for (size_t i = 0; i < Ki; i++) ipf.TP_Obstacles[i] *= _refD;
 
-			timeForTPObsTransformation = tictac.Tac();
-			if (m_timelogger.isEnabled())
-				m_timelogger.registerUserMeasure(
-					"navigationStep.STEP3_WSpaceToTPSpace",
-					timeForTPObsTransformation);
+			timeForTPObsTransformation = stepTimer.Tac();
+			ipf.profiler_measures.emplace_back(
+				"navigationStep.STEP3_WSpaceToTPSpace",
+				timeForTPObsTransformation);
 		}
 
 		//  STEP4: Holonomic navigation method
 		// -----------------------------------------------------------------------------
 		if (!this_is_PTG_continuation)
 		{
-			tictac.Tic();
+			stepTimer.Tic();
 
 			// Slow down if we are approaching the final target, etc.
 			holoMethod.enableApproachTargetSlowDown(
@@ -1690,11 +1752,9 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 			// Scale:
 			cm.speed *= velScale;
 
-			timeForHolonomicMethod = tictac.Tac();
-			if (m_timelogger.isEnabled())
-				m_timelogger.registerUserMeasure(
-					"navigationStep.STEP4_HolonomicMethod",
-					timeForHolonomicMethod);
+			timeForHolonomicMethod = stepTimer.Tac();
+			ipf.profiler_measures.emplace_back(
+				"navigationStep.STEP4_HolonomicMethod", timeForHolonomicMethod);
 		}
 		else
 		{
@@ -1707,8 +1767,7 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		// STEP5: Evaluate each movement to assign them a "evaluation" value.
 		// ---------------------------------------------------------------------
 		{
-			CTimeLoggerEntry tle(
-				m_timelogger, "navigationStep.calc_move_candidate_scores");
+			stepTimer.Tic();
 
 			calc_move_candidate_scores(
 				cm, ipf.TP_Obstacles, ipf.clearance, relTargets, ipf.targets,
@@ -1723,6 +1782,9 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 
 			//  SAVE LOG
 			newLogRec.infoPerPTG[idx_in_log_infoPerPTGs].evalFactors = cm.props;
+
+			ipf.profiler_measures.emplace_back(
+				"navigationStep.calc_move_candidate_scores", stepTimer.Tac());
 		}
 
 	}  // end "valid_TP"
@@ -1777,6 +1839,7 @@ void CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR_CS(enable_obstacle_filtering, bool);
 	MRPT_LOAD_CONFIG_VAR_CS(evaluate_clearance, bool);
 	MRPT_LOAD_CONFIG_VAR_CS(max_dist_for_timebased_path_prediction, double);
+	MRPT_LOAD_CONFIG_VAR_CS(ptg_evaluation_threads, uint64_t);
 
 	MRPT_END;
 }
@@ -1853,6 +1916,10 @@ void CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::saveToConfigFile(
 		max_dist_for_timebased_path_prediction,
 		"Max dist [meters] to use time-based path prediction for NOP "
 		"evaluation");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		ptg_evaluation_threads,
+		"Max number of threads to evaluate PTGs in parallel (1=serial, "
+		"0=as many as mrpt::system::TaskScheduler threads) (default=1)");
 }
 
 CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::
@@ -1869,7 +1936,8 @@ CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::
 	  robot_absolute_speed_limits(),
 	  enable_obstacle_filtering(true),
 	  evaluate_clearance(false),
-	  max_dist_for_timebased_path_prediction(2.0)
+	  max_dist_for_timebased_path_prediction(2.0),
+	  ptg_evaluation_threads(1)
 {
 }
 
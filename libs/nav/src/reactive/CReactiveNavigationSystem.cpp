@@ -169,7 +169,7 @@ void CReactiveNavigationSystem::STEP1_InitPTGs()
 			// Init:
 			PTGs[i]->initialize(
 				format(
-					"%s/ReacNavGrid_%03u.dat.gz",
+					"%s/ReacNavGrid_%03u.dat",
 					params_abstract_ptg_navigator.ptg_cache_files_directory
 						.c_str(),
 					i),
@@ -240,6 +240,9 @@ void CReactiveNavigationSystem::STEP3_WSpaceToTPSpace(
 	const float *xs, *ys, *zs;
 	m_WS_Obstacles.getPointsBuffer(nObs, xs, ys, zs);
 
+	std::vector<double> oxs, oys;
+	oxs.reserve(nObs);
+	oys.reserve(nObs);
 	for (size_t obs = 0; obs < nObs; obs++)
 	{
 		double ox, oy, oz = zs[obs];
@@ -249,13 +252,17 @@ void CReactiveNavigationSystem::STEP3_WSpaceToTPSpace(
 			oy < OBS_MAX_XY && oz >= params_reactive_nav.min_obstacles_height &&
 			oz <= params_reactive_nav.max_obstacles_height)
 		{
-			ptg->updateTPObstacle(ox, oy, out_TPObstacles);
-			if (eval_clearance)
-			{
-				ptg->updateClearance(ox, oy, out_clearance);
-			}
+			oxs.push_back(ox);
+			oys.push_back(oy);
 		}
 	}
+
+	ptg->updateTPObstacles(oxs.data(), oys.data(), oxs.size(), out_TPObstacles);
+	if (eval_clearance)
+	{
+		for (size_t i = 0; i < oxs.size(); i++)
+			ptg->updateClearance(oxs[i], oys[i], out_clearance);
+	}
 }
 
 /** Generates a pointcloud of obstacles, and the robot shape, to be saved in the
@@ -182,7 +182,7 @@ void CReactiveNavigationSystem3D::STEP1_InitPTGs()
 
 				m_ptgmultilevel[j].PTGs[i]->initialize(
 					format(
-						"%s/ReacNavGrid_%03u_L%02u.dat.gz",
+						"%s/ReacNavGrid_%03u_L%02u.dat",
 						params_abstract_ptg_navigator.ptg_cache_files_directory
 							.c_str(),
 						i, j),
@@ -276,18 +276,19 @@ void CReactiveNavigationSystem3D::STEP3_WSpaceToTPSpace(
 		const float *xs, *ys, *zs;
 		m_WS_Obstacles_inlevels[j].getPointsBuffer(nObs, xs, ys, zs);
 
+		std::vector<double> oxs(nObs), oys(nObs);
 		for (size_t obs = 0; obs < nObs; obs++)
-		{
-			double ox, oy;
 			rel_pose_PTG_origin_wrt_sense.composePoint(
-				xs[obs], ys[obs], ox, oy);
-			m_ptgmultilevel[ptg_idx].PTGs[j]->updateTPObstacle(
-				ox, oy, out_TPObstacles);
-			if (eval_clearance)
-			{
-				m_ptgmultilevel[ptg_idx].PTGs[j]->updateClearance(
-					ox, oy, out_clearance);
-			}
+				xs[obs], ys[obs], oxs[obs], oys[obs]);
+
+		const CParameterizedTrajectoryGenerator* ptg =
+			m_ptgmultilevel[ptg_idx].PTGs[j];
+		ptg->updateTPObstacles(
+			oxs.data(), oys.data(), nObs, out_TPObstacles);
+		if (eval_clearance)
+		{
+			for (size_t obs = 0; obs < nObs; obs++)
+				ptg->updateClearance(oxs[obs], oys[obs], out_clearance);
 		}
 	}
 
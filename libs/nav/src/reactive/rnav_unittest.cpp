@@ -14,17 +14,27 @@
 #include <mrpt/kinematics/CVehicleSimul_DiffDriven.h>
 #include <mrpt/config/CConfigFile.h>
 #include <mrpt/system/filesystem.h>
+#include <mrpt/system/TaskScheduler.h>
 #include <gtest/gtest.h>
 
 using mrpt::math::TPoint2D;
 
+// The motion decided by the navigator in one iteration:
+struct TNavStepDecision
+{
+	int32_t nSelectedPTG{-1};
+	std::vector<double> cmd_vel;
+};
+
 template <typename RNAVCLASS>
 void run_rnav_test(
 	const std::string& sFilename, const std::string& sHoloMethod,
 	const TPoint2D& nav_target, const TPoint2D& world_topleft,
 	const TPoint2D& world_rightbottom,
 	const TPoint2D& block_obstacle_topleft = TPoint2D(0, 0),
-	const TPoint2D& block_obstacle_rightbottom = TPoint2D(0, 0))
+	const TPoint2D& block_obstacle_rightbottom = TPoint2D(0, 0),
+	const unsigned int ptg_evaluation_threads = 1,
+	std::vector<TNavStepDecision>* out_decisions = nullptr)
 {
 	using namespace std;
 	using namespace mrpt;
@@ -43,6 +53,9 @@ void run_rnav_test(
 
 	mrpt::config::CConfigFile cfg(sFil);
 	cfg.write("CAbstractPTGBasedReactive", "holonomic_method", sHoloMethod);
+	cfg.write(
+		"CAbstractPTGBasedReactive", "ptg_evaluation_threads",
+		ptg_evaluation_threads);
 	cfg.discardSavingChanges();
 
 	// Create a grid map with a synthetic test environment with a simple
@@ -131,6 +144,7 @@ void run_rnav_test(
 		// printf("[run_rnav_test] navlog dir: `%s`\n", sTmpDir.c_str());
 		rnav.setLogFileDirectory(sTmpDir);
 		rnav.enableLogFile(true);
+		rnav.enableKeepLogRecords(out_decisions != nullptr);
 	}
 
 	// Load options:
@@ -154,6 +168,18 @@ void run_rnav_test(
 		// Run nav:
 		rnav.navigationStep();
 
+		if (out_decisions)
+		{
+			mrpt::nav::CLogFileRecord lr;
+			rnav.getLastLogRecord(lr);
+			TNavStepDecision d;
+			d.nSelectedPTG = lr.nSelectedPTG;
+			if (lr.cmd_vel)
+				for (size_t k = 0; k < lr.cmd_vel->getVelCmdLength(); k++)
+					d.cmd_vel.push_back(lr.cmd_vel->getVelCmdElement(k));
+			out_decisions->push_back(d);
+		}
+
 		EXPECT_TRUE(rnav.getCurrentState() != CAbstractNavigator::NAV_ERROR);
 		if (rnav.getCurrentState() == CAbstractNavigator::IDLE) break;
 
@@ -250,3 +276,33 @@ TEST(CReactiveNavigationSystem3D, with_obstacle_nav_FullEval)
 		"reactive3d_config.ini", "CHolonomicFullEval", with_obs_trg,
 		with_obs_topleft, with_obs_bottomright, obs_tl, obs_br);
 }
+
+// Evaluating the PTGs in parallel must lead to the same motions: the robot
+// simulator is deterministic, so both navigators see the same obstacles at
+// each step and must choose exactly the same PTG and velocity command.
+TEST(CReactiveNavigationSystem, parallel_PTG_evaluation)
+{
+	// Make sure there are several threads, even on single-core machines:
+	mrpt::system::TaskSchedulerThreadsGuard threads(4);
+
+	std::vector<TNavStepDecision> steps_serial, steps_parallel;
+	run_rnav_test<mrpt::nav::CReactiveNavigationSystem>(
+		"reactive2d_config.ini", "CHolonomicFullEval", with_obs_trg,
+		with_obs_topleft, with_obs_bottomright, obs_tl, obs_br, 1,
+		&steps_serial);
+	run_rnav_test<mrpt::nav::CReactiveNavigationSystem>(
+		"reactive2d_config.ini", "CHolonomicFullEval", with_obs_trg,
+		with_obs_topleft, with_obs_bottomright, obs_tl, obs_br, 0,
+		&steps_parallel);
+
+	ASSERT_FALSE(steps_serial.empty());
+	ASSERT_EQ(steps_serial.size(), steps_parallel.size());
+	ASSERT_FALSE(steps_serial.front().cmd_vel.empty());
+	for (size_t i = 0; i < steps_serial.size(); i++)
+	{
+		EXPECT_EQ(steps_serial[i].nSelectedPTG, steps_parallel[i].nSelectedPTG)
+			<< "step: " << i;
+		EXPECT_EQ(steps_serial[i].cmd_vel, steps_parallel[i].cmd_vel)
+			<< "step: " << i;
+	}
+}
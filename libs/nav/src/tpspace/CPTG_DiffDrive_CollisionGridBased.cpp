@@ -11,14 +11,21 @@
 
 #include <mrpt/nav/tpspace/CPTG_DiffDrive_CollisionGridBased.h>
 
-#include <mrpt/io/CFileGZInputStream.h>
-#include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/config/CConfigFileMemory.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/CMemoryMappedFile.h>
 #include <mrpt/system/CTicTac.h>
+#include <mrpt/system/datetime.h>
+#include <mrpt/system/filesystem.h>
 #include <mrpt/math/geometry.h>
 #include <mrpt/serialization/stl_serialization.h>
 #include <mrpt/kinematics/CVehicleVelCmd_DiffDriven.h>
 #include <mrpt/serialization/CArchive.h>
+#include <mrpt/core/SSE_types.h>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <type_traits>
 
 using namespace mrpt::nav;
 
@@ -286,18 +293,6 @@ mrpt::kinematics::CVehicleVelCmd::Ptr
 	return mrpt::kinematics::CVehicleVelCmd::Ptr(cmd);
 }
 
-/*---------------------------------------------------------------
-					getTPObstacle
-  ---------------------------------------------------------------*/
-const CPTG_DiffDrive_CollisionGridBased::TCollisionCell&
-	CPTG_DiffDrive_CollisionGridBased::CCollisionGrid::getTPObstacle(
-		const float obsX, const float obsY) const
-{
-	static const TCollisionCell emptyCell;
-	const TCollisionCell* cell = cellByPos(obsX, obsY);
-	return cell != nullptr ? *cell : emptyCell;
-}
-
 /*---------------------------------------------------------------
 	Updates the info into a cell: It updates the cell only
 	  if the distance d for the path k is lower than the previous value:
@@ -329,215 +324,290 @@ void CPTG_DiffDrive_CollisionGridBased::CCollisionGrid::updateCellInfo(
 	}
 }
 
-/*---------------------------------------------------------------
-					Save to file
-  ---------------------------------------------------------------*/
-bool CPTG_DiffDrive_CollisionGridBased::saveColGridsToFile(
-	const std::string& filename,
-	const mrpt::math::CPolygon& computed_robotShape) const
+void CPTG_DiffDrive_CollisionGridBased::CCollisionGrid::compact()
 {
-	try
+	struct TArrays
 	{
-		mrpt::io::CFileGZOutputStream fo(filename);
-		if (!fo.fileOpenCorrectly()) return false;
-
-		const uint32_t n = 1;  // for backwards compatibility...
-		auto arch = mrpt::serialization::archiveFrom(fo);
-		arch << n;
-		return m_collisionGrid.saveToFile(&arch, computed_robotShape);
-	}
-	catch (...)
+		std::vector<uint32_t> cell_runs, run_dists;
+		std::vector<uint16_t> run_k;
+		std::vector<float> dists;
+	};
+	auto a = std::make_shared<TArrays>();
+	a->cell_runs.reserve(m_map.size() + 1);
+	a->cell_runs.push_back(0);
+	for (auto& cell : m_map)
 	{
-		return false;
+		std::sort(cell.begin(), cell.end());
+		for (size_t j = 0; j < cell.size(); j++)
+		{
+			// Start a new run unless "k" follows the previous one:
+			if (j == 0 || cell[j].first != cell[j - 1].first + 1)
+			{
+				a->run_k.push_back(cell[j].first);
+				a->run_dists.push_back(static_cast<uint32_t>(a->dists.size()));
+			}
+			a->dists.push_back(cell[j].second);
+		}
+		a->cell_runs.push_back(static_cast<uint32_t>(a->run_k.size()));
+		TCollisionCell().swap(cell);
 	}
+	a->run_dists.push_back(static_cast<uint32_t>(a->dists.size()));
+
+	cell_runs = a->cell_runs.data();
+	run_dists = a->run_dists.data();
+	run_k = a->run_k.data();
+	dists = a->dists.data();
+	csr_owner = a;
 }
 
-/*---------------------------------------------------------------
-					Load from file
-  ---------------------------------------------------------------*/
-bool CPTG_DiffDrive_CollisionGridBased::loadColGridsFromFile(
-	const std::string& filename, const mrpt::math::CPolygon& current_robotShape)
+// Cache files: a TCacheFileHeader, followed by these arrays, each one
+// starting at an offset multiple of 8 bytes:
+//  - Index of the first point of each path (uint32_t), plus the total count.
+//  - All trajectory points (TCPoint).
+//  - The collision grid arrays: cell_runs, run_dists, run_k, dists.
+//  - The cells of m_lambdaFunctionOptimizer.
+// Numbers are stored in the native format: files from platforms with another
+// endianness are detected by the hash, and rebuilt.
+namespace
 {
-	try
-	{
-		mrpt::io::CFileGZInputStream fi(filename);
-		if (!fi.fileOpenCorrectly()) return false;
-		auto arch = mrpt::serialization::archiveFrom(fi);
+const uint32_t CACHE_FILE_VERSION = 3;  // v1,v2: gz-compressed CArchive
+const char CACHE_FILE_MAGIC[8] = {'M', 'R', 'P', 'T', 'P', 'T', 'G', 'C'};
 
-		uint32_t n;
-		arch >> n;
-		if (n != 1)
-			return false;  // Incompatible (old) format, just discard and
-		// recompute.
+struct TCacheFileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t num_paths, num_points, num_cells, num_runs, num_dists;
+	uint32_t num_lambda_cells, reserved;
+	uint64_t hash;
+	/** x_min,x_max,y_min,y_max,resolution of each grid */
+	double col_grid[5], lambda_grid[5];
+	double step_time_duration;
+};
+
+inline size_t alignTo8(const size_t n) { return (n + 7) & ~size_t(7); }
+/** Size of each of the arrays following the header, in bytes */
+template <class T>
+inline size_t arraySize(const size_t n)
+{
+	return alignTo8(n * sizeof(T));
+}
 
-		return m_collisionGrid.loadFromFile(&arch, current_robotShape);
-	}
-	catch (...)
+/** FNV-1a hash */
+void hashBytes(uint64_t& h, const void* data, const size_t len)
+{
+	const auto* p = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < len; i++)
 	{
-		return false;
+		h ^= p[i];
+		h *= 0x100000001b3ULL;
 	}
 }
-
-const uint32_t COLGRID_FILE_MAGIC = 0xC0C0C0C3;
-
-/*---------------------------------------------------------------
-					Save to file
-  ---------------------------------------------------------------*/
-bool CPTG_DiffDrive_CollisionGridBased::CCollisionGrid::saveToFile(
-	mrpt::serialization::CArchive* f,
-	const mrpt::math::CPolygon& computed_robotShape) const
+template <class T>
+void hashValue(uint64_t& h, const T& v)
 {
-	try
-	{
-		if (!f) return false;
-
-		const uint8_t serialize_version =
-			2;  // v1: As of jun 2012, v2: As of dec-2013
-
-		// Save magic signature && serialization version:
-		*f << COLGRID_FILE_MAGIC << serialize_version;
-
-		// Robot shape:
-		*f << computed_robotShape;
-
-		// and standard PTG data:
-		*f << m_parent->getDescription() << m_parent->getAlphaValuesCount()
-		   << static_cast<float>(m_parent->getMax_V())
-		   << static_cast<float>(m_parent->getMax_W());
-
-		*f << m_x_min << m_x_max << m_y_min << m_y_max;
-		*f << m_resolution;
-
-		// v1 was:  *f << m_map;
-		uint32_t N = m_map.size();
-		*f << N;
-		for (uint32_t i = 0; i < N; i++)
-		{
-			uint32_t M = m_map[i].size();
-			*f << M;
-			for (uint32_t k = 0; k < M; k++)
-				*f << m_map[i][k].first << m_map[i][k].second;
-		}
+	hashBytes(h, &v, sizeof(v));
+}
+}  // namespace
 
-		return true;
-	}
-	catch (...)
+uint64_t CPTG_DiffDrive_CollisionGridBased::getCacheHash() const
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	hashValue(h, CACHE_FILE_VERSION);
+	hashValue(h, uint32_t(0x01020304));  // Endianness
+	hashValue(h, uint32_t(sizeof(TCPoint)));
+	hashValue(h, uint32_t(sizeof(TCellForLambdaFunction)));
+
+	// Parameters of derived classes are only reachable via the config file:
+	mrpt::config::CConfigFileMemory cfg;
+	saveToConfigFile(cfg, "PTG");
+	const std::string sCfg = getDescription() + cfg.getContent();
+	hashBytes(h, sCfg.data(), sCfg.size());
+
+	// Numeric values of the main parameters, in case they were rounded in
+	// the config file:
+	hashValue(h, m_alphaValuesCount);
+	hashValue(h, refDistance);
+	hashValue(h, V_MAX);
+	hashValue(h, W_MAX);
+	hashValue(h, turningRadiusReference);
+	hashValue(h, m_resolution);
+	for (const auto& v : m_robotShape)
 	{
-		return false;
+		hashValue(h, v.x);
+		hashValue(h, v.y);
 	}
+	return h;
 }
 
-/*---------------------------------------------------------------
-						loadFromFile
-  ---------------------------------------------------------------*/
-bool CPTG_DiffDrive_CollisionGridBased::CCollisionGrid::loadFromFile(
-	mrpt::serialization::CArchive* f,
-	const mrpt::math::CPolygon& current_robotShape)
+bool CPTG_DiffDrive_CollisionGridBased::saveCacheFile(
+	const std::string& filename) const
 {
-	try
+	static_assert(
+		std::is_trivially_copyable<TCPoint>::value &&
+			std::is_trivially_copyable<TCellForLambdaFunction>::value,
+		"Cache file arrays are saved as raw memory");
+	const CCollisionGrid& g = m_collisionGrid;
+	if (filename.empty() || !g.cell_runs) return false;
+
+	TCacheFileHeader hdr;
+	std::memset(&hdr, 0, sizeof(hdr));
+	std::memcpy(hdr.magic, CACHE_FILE_MAGIC, sizeof(hdr.magic));
+	hdr.version = CACHE_FILE_VERSION;
+	hdr.hash = getCacheHash();
+	hdr.num_paths = m_trajectory.size();
+	std::vector<uint32_t> traj_idx(1, 0);
+	for (const auto& t : m_trajectory)
+		traj_idx.push_back(traj_idx.back() + t.size());
+	hdr.num_points = traj_idx.back();
+	hdr.num_cells = g.getCellCount();
+	hdr.num_runs = g.getRunCount();
+	hdr.num_dists = g.getDistCount();
+	const auto& lg = m_lambdaFunctionOptimizer;
+	hdr.num_lambda_cells = lg.getSizeX() * lg.getSizeY();
+	const double col_grid[5] = {g.getXMin(), g.getXMax(), g.getYMin(),
+								g.getYMax(), g.getResolution()};
+	const double lambda_grid[5] = {lg.getXMin(), lg.getXMax(), lg.getYMin(),
+								   lg.getYMax(), lg.getResolution()};
+	std::copy(col_grid, col_grid + 5, hdr.col_grid);
+	std::copy(lambda_grid, lambda_grid + 5, hdr.lambda_grid);
+	hdr.step_time_duration = m_stepTimeDuration;
+
+	// Write to a temporary file first, so other processes never map an
+	// incomplete file:
+	const std::string tmpFile = mrpt::format(
+		"%s.%llu.tmp", filename.c_str(),
+		static_cast<unsigned long long>(mrpt::system::now()));
+	bool ok = true;
 	{
-		if (!f) return false;
-
-		// Return false if the file contents doesn't match what we expected:
-		uint32_t file_magic;
-		*f >> file_magic;
+		mrpt::io::CFileOutputStream f;
+		if (!f.open(tmpFile)) return false;
+		// Writes `len` bytes, then zeros up to the next multiple of 8:
+		const uint64_t zeros = 0;
+		auto writeArray = [&](const void* data, const size_t len) {
+			if (len) ok = ok && f.Write(data, len) == len;
+			const size_t pad = alignTo8(len) - len;
+			if (pad) ok = ok && f.Write(&zeros, pad) == pad;
+		};
+		writeArray(&hdr, sizeof(hdr));
+		writeArray(&traj_idx[0], traj_idx.size() * sizeof(uint32_t));
+		std::vector<TCPoint> all_points;
+		all_points.reserve(hdr.num_points);
+		for (const auto& t : m_trajectory)
+			all_points.insert(all_points.end(), t.begin(), t.end());
+		writeArray(all_points.data(), all_points.size() * sizeof(TCPoint));
+		writeArray(g.cell_runs, (hdr.num_cells + 1) * sizeof(uint32_t));
+		writeArray(g.run_dists, (hdr.num_runs + 1) * sizeof(uint32_t));
+		writeArray(g.run_k, hdr.num_runs * sizeof(uint16_t));
+		writeArray(g.dists, hdr.num_dists * sizeof(float));
+		writeArray(
+			hdr.num_lambda_cells ? lg.cellByIndex(0, 0) : nullptr,
+			hdr.num_lambda_cells * sizeof(TCellForLambdaFunction));
+	}
+	if (ok) ok = mrpt::system::renameFile(tmpFile, filename);
+	if (!ok) mrpt::system::deleteFile(tmpFile);
+	return ok;
+}
 
-		// It doesn't seem to be a valid file or was in an old format, just
-		// recompute the grid:
-		if (COLGRID_FILE_MAGIC != file_magic) return false;
+bool CPTG_DiffDrive_CollisionGridBased::loadCacheFile(
+	const std::string& filename)
+{
+	if (filename.empty() || !mrpt::system::fileExists(filename)) return false;
+	auto mmf = std::make_shared<mrpt::io::CMemoryMappedFile>();
+	if (!mmf->open(filename) || mmf->size() < sizeof(TCacheFileHeader))
+		return false;
 
-		uint8_t serialized_version;
-		*f >> serialized_version;
+	TCacheFileHeader hdr;
+	std::memcpy(&hdr, mmf->data(), sizeof(hdr));
+	if (std::memcmp(hdr.magic, CACHE_FILE_MAGIC, sizeof(hdr.magic)) != 0 ||
+		hdr.version != CACHE_FILE_VERSION || hdr.hash != getCacheHash() ||
+		hdr.num_paths != m_alphaValuesCount)
+		return false;
 
-		switch (serialized_version)
+	// Locate all arrays, checking the file size:
+	const size_t off_traj_idx = alignTo8(sizeof(hdr));
+	const size_t off_traj =
+		off_traj_idx + arraySize<uint32_t>(hdr.num_paths + 1);
+	const size_t off_cell_runs = off_traj + arraySize<TCPoint>(hdr.num_points);
+	const size_t off_run_dists =
+		off_cell_runs + arraySize<uint32_t>(hdr.num_cells + 1);
+	const size_t off_run_k =
+		off_run_dists + arraySize<uint32_t>(hdr.num_runs + 1);
+	const size_t off_dists = off_run_k + arraySize<uint16_t>(hdr.num_runs);
+	const size_t off_lambda = off_dists + arraySize<float>(hdr.num_dists);
+	const size_t total =
+		off_lambda + arraySize<TCellForLambdaFunction>(hdr.num_lambda_cells);
+	if (mmf->size() != total) return false;
+
+	const uint8_t* base = mmf->data();
+	const auto* traj_idx =
+		reinterpret_cast<const uint32_t*>(base + off_traj_idx);
+	const auto* traj = reinterpret_cast<const TCPoint*>(base + off_traj);
+	const auto* cell_runs =
+		reinterpret_cast<const uint32_t*>(base + off_cell_runs);
+	const auto* run_dists =
+		reinterpret_cast<const uint32_t*>(base + off_run_dists);
+	if (traj_idx[0] != 0 || traj_idx[hdr.num_paths] != hdr.num_points ||
+		cell_runs[0] != 0 || cell_runs[hdr.num_cells] != hdr.num_runs ||
+		run_dists[hdr.num_runs] != hdr.num_dists)
+		return false;
+	for (uint32_t k = 0; k < hdr.num_paths; k++)
+		if (traj_idx[k] > traj_idx[k + 1]) return false;
+
+	// The collision grid arrays are used without bound checks: each cell
+	// must have a sorted list of non-overlapping runs, with at least one
+	// distance each, whose "k" values are all valid path indices.
+	const auto* run_k = reinterpret_cast<const uint16_t*>(base + off_run_k);
+	for (uint32_t c = 0; c < hdr.num_cells; c++)
+	{
+		if (cell_runs[c] > cell_runs[c + 1]) return false;
+		uint32_t next_k = 0;
+		for (uint32_t r = cell_runs[c]; r < cell_runs[c + 1]; r++)
 		{
-			case 2:
-			{
-				mrpt::math::CPolygon stored_shape;
-				*f >> stored_shape;
-
-				const bool shapes_match =
-					(stored_shape.size() == current_robotShape.size() &&
-					 std::equal(
-						 stored_shape.begin(), stored_shape.end(),
-						 current_robotShape.begin()));
-
-				if (!shapes_match)
-					return false;  // Must recompute if the robot shape changed.
-			}
-			break;
-
-			case 1:
-			default:
-				// Unknown version: Maybe we are loading a file from a more
-				// recent version of MRPT? Whatever, we can't read it: It's
-				// safer just to re-generate the PTG data
+			if (run_dists[r] >= run_dists[r + 1]) return false;
+			const uint32_t len = run_dists[r + 1] - run_dists[r];
+			if (run_k[r] < next_k || run_k[r] >= hdr.num_paths ||
+				len > hdr.num_paths - run_k[r])
 				return false;
-		};
-
-		// Standard PTG data:
-		const std::string expected_desc = m_parent->getDescription();
-		std::string desc;
-		*f >> desc;
-		if (desc != expected_desc) return false;
-
-// and standard PTG data:
-#define READ_UINT16_CHECK_IT_MATCHES_STORED(_VAR) \
-	{                                             \
-		uint16_t ff;                              \
-		*f >> ff;                                 \
-		if (ff != _VAR) return false;             \
-	}
-#define READ_FLOAT_CHECK_IT_MATCHES_STORED(_VAR)       \
-	{                                                  \
-		float ff;                                      \
-		*f >> ff;                                      \
-		if (std::abs(ff - _VAR) > 1e-4f) return false; \
-	}
-#define READ_DOUBLE_CHECK_IT_MATCHES_STORED(_VAR)     \
-	{                                                 \
-		double ff;                                    \
-		*f >> ff;                                     \
-		if (std::abs(ff - _VAR) > 1e-6) return false; \
-	}
-
-		READ_UINT16_CHECK_IT_MATCHES_STORED(m_parent->getAlphaValuesCount())
-		READ_FLOAT_CHECK_IT_MATCHES_STORED(m_parent->getMax_V())
-		READ_FLOAT_CHECK_IT_MATCHES_STORED(m_parent->getMax_W())
-
-		// Cell dimensions:
-		READ_DOUBLE_CHECK_IT_MATCHES_STORED(m_x_min)
-		READ_DOUBLE_CHECK_IT_MATCHES_STORED(m_x_max)
-		READ_DOUBLE_CHECK_IT_MATCHES_STORED(m_y_min)
-		READ_DOUBLE_CHECK_IT_MATCHES_STORED(m_y_max)
-		READ_DOUBLE_CHECK_IT_MATCHES_STORED(m_resolution)
-
-		// OK, all parameters seem to be exactly the same than when we
-		// precomputed the table: load it.
-		// v1 was:  *f >> m_map;
-		uint32_t N;
-		*f >> N;
-		m_map.resize(N);
-		for (uint32_t i = 0; i < N; i++)
-		{
-			uint32_t M;
-			*f >> M;
-			m_map[i].resize(M);
-			for (uint32_t k = 0; k < M; k++)
-				*f >> m_map[i][k].first >> m_map[i][k].second;
+			next_k = run_k[r] + len;
 		}
-
-		return true;
 	}
-	catch (std::exception& e)
-	{
-		std::cerr << "[CCollisionGrid::loadFromFile] " << e.what();
+
+	// Grids geometry must match the stored arrays:
+	CCollisionGrid& g = m_collisionGrid;
+	g.setSize(
+		hdr.col_grid[0], hdr.col_grid[1], hdr.col_grid[2], hdr.col_grid[3],
+		hdr.col_grid[4]);
+	auto& lg = m_lambdaFunctionOptimizer;
+	const TCellForLambdaFunction defaultCell;
+	lg.setSize(
+		hdr.lambda_grid[0], hdr.lambda_grid[1], hdr.lambda_grid[2],
+		hdr.lambda_grid[3], hdr.lambda_grid[4], &defaultCell);
+	if (g.getSizeX() * g.getSizeY() != hdr.num_cells ||
+		lg.getSizeX() * lg.getSizeY() != hdr.num_lambda_cells)
 		return false;
-	}
-	catch (...)
+
+	// Trajectories and the (small) lambda grid are copied, the collision
+	// grid is used from the mapped memory:
+	m_trajectory.resize(hdr.num_paths);
+	for (uint32_t k = 0; k < hdr.num_paths; k++)
+		m_trajectory[k].assign(traj + traj_idx[k], traj + traj_idx[k + 1]);
+	if (hdr.num_lambda_cells)
 	{
-		return false;
+		const auto* lambda_cells =
+			reinterpret_cast<const TCellForLambdaFunction*>(base + off_lambda);
+		std::copy(
+			lambda_cells, lambda_cells + hdr.num_lambda_cells,
+			lg.cellByIndex(0, 0));
 	}
+	m_stepTimeDuration = hdr.step_time_duration;
+
+	g.cell_runs = cell_runs;
+	g.run_dists = run_dists;
+	g.run_k = run_k;
+	g.dists = reinterpret_cast<const float*>(base + off_dists);
+	g.csr_owner = mmf;
+	return true;
 }
 
 bool CPTG_DiffDrive_CollisionGridBased::inverseMap_WS2TP(
@@ -712,6 +782,14 @@ void CPTG_DiffDrive_CollisionGridBased::internal_initialize(
 
 	if (verbose) cout << "Initializing PTG '" << cacheFilename << "'...";
 
+	// Load the cached version, if possible
+	if (loadCacheFile(cacheFilename))
+	{
+		if (verbose)
+			cout << format("loaded from file OK [%.03f sec]\n", tictac.Tac());
+		return;
+	}
+
 	// Simulate paths:
 	const float min_dist = 0.015f;
 	simulateTrajectories(
@@ -733,20 +811,7 @@ void CPTG_DiffDrive_CollisionGridBased::internal_initialize(
 	const size_t Ki = getAlphaValuesCount();
 	ASSERTMSG_(Ki > 0, "The PTG seems to be not initialized!");
 
-	// Load the cached version, if possible
-	if (loadColGridsFromFile(cacheFilename, m_robotShape))
-	{
-		if (verbose) cout << "loaded from file OK" << endl;
-	}
-	else
 	{
-		// BUGFIX: In case we start reading the file and in the end detected an
-		// error,
-		//         we must make sure that there's space enough for the grid:
-		m_collisionGrid.setSize(
-			-refDistance, refDistance, -refDistance, refDistance,
-			m_collisionGrid.getResolution());
-
 		const int grid_cx_max = m_collisionGrid.getSizeX() - 1;
 		const int grid_cy_max = m_collisionGrid.getSizeY() - 1;
 		const double half_cell = m_collisionGrid.getResolution() * 0.5;
@@ -829,10 +894,13 @@ void CPTG_DiffDrive_CollisionGridBased::internal_initialize(
 
 		if (verbose) cout << format("Done! [%.03f sec]\n", tictac.Tac());
 
+		m_collisionGrid.compact();
+
 		// save it to the cache file for the next run:
-		saveColGridsToFile(cacheFilename, m_robotShape);
+		if (!saveCacheFile(cacheFilename) && verbose)
+			cout << "Could not save cache file: " << cacheFilename << endl;
 
-	}  // "else" recompute all PTG
+	}  // recompute all PTG
 
 	MRPT_END
 }
@@ -887,29 +955,80 @@ bool CPTG_DiffDrive_CollisionGridBased::getPathStepForDist(
 
 void CPTG_DiffDrive_CollisionGridBased::updateTPObstacle(
 	double ox, double oy, std::vector<double>& tp_obstacles) const
+{
+	updateTPObstacles(&ox, &oy, 1, tp_obstacles);
+}
+
+void CPTG_DiffDrive_CollisionGridBased::updateTPObstacleSingle(
+	double ox, double oy, uint16_t k, double& tp_obstacle_k) const
 {
 	ASSERTMSG_(!m_trajectory.empty(), "PTG has not been initialized!");
-	const TCollisionCell& cell = m_collisionGrid.getTPObstacle(ox, oy);
-	// Keep the minimum distance:
-	for (TCollisionCell::const_iterator i = cell.begin(); i != cell.end(); ++i)
+	const CCollisionGrid& g = m_collisionGrid;
+	uint32_t r0, r1;
+	g.getTPObstacle(ox, oy, r0, r1);
+	// Look for the run, if any, with this "k":
+	for (uint32_t r = r0; r < r1; r++)
 	{
-		const double dist = i->second;
-		internal_TPObsDistancePostprocess(ox, oy, dist, tp_obstacles[i->first]);
+		if (k < g.run_k[r]) break;
+		const uint32_t j = g.run_dists[r] + (k - g.run_k[r]);
+		if (j >= g.run_dists[r + 1]) continue;
+		internal_TPObsDistancePostprocess(ox, oy, g.dists[j], tp_obstacle_k);
+		break;
 	}
 }
 
-void CPTG_DiffDrive_CollisionGridBased::updateTPObstacleSingle(
-	double ox, double oy, uint16_t k, double& tp_obstacle_k) const
+/** Does `out[i]=min(out[i],d[i])` for `i=0,...,n-1` */
+static void keepMinRun(double* out, const float* d, const size_t n)
+{
+	size_t i = 0;
+#if MRPT_HAS_SSE2
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 d4 = _mm_loadu_ps(d + i);  // *Unaligned* load
+		const __m128d d_lo = _mm_cvtps_pd(d4);
+		const __m128d d_hi = _mm_cvtps_pd(_mm_movehl_ps(d4, d4));
+		// min_pd(a,b) returns "b" unless a<b, as keep_min(b,a) does:
+		_mm_storeu_pd(out + i, _mm_min_pd(d_lo, _mm_loadu_pd(out + i)));
+		_mm_storeu_pd(
+			out + i + 2, _mm_min_pd(d_hi, _mm_loadu_pd(out + i + 2)));
+	}
+#endif
+	for (; i < n; i++) mrpt::keep_min(out[i], static_cast<double>(d[i]));
+}
+
+void CPTG_DiffDrive_CollisionGridBased::updateTPObstacles(
+	const double* ox, const double* oy, const size_t N,
+	std::vector<double>& tp_obstacles) const
 {
 	ASSERTMSG_(!m_trajectory.empty(), "PTG has not been initialized!");
-	const TCollisionCell& cell = m_collisionGrid.getTPObstacle(ox, oy);
-	// Keep the minimum distance:
-	for (TCollisionCell::const_iterator i = cell.begin(); i != cell.end(); ++i)
-		if (i->first == k)
+	const CCollisionGrid& g = m_collisionGrid;
+	// Obstacles farther than this can't be inside the robot shape:
+	const double R2 = mrpt::square(getMaxRobotRadius());
+
+	for (size_t i = 0; i < N; i++)
+	{
+		uint32_t r0, r1;
+		g.getTPObstacle(ox[i], oy[i], r0, r1);
+		if (r0 == r1) continue;
+
+		if (mrpt::square(ox[i]) + mrpt::square(oy[i]) <= R2 &&
+			isPointInsideRobotShape(ox[i], oy[i]))
 		{
-			const double dist = i->second;
-			internal_TPObsDistancePostprocess(ox, oy, dist, tp_obstacle_k);
+			// Rare case: let the base class handle the collision behavior
+			for (uint32_t r = r0; r < r1; r++)
+				for (uint32_t j = g.run_dists[r]; j < g.run_dists[r + 1]; j++)
+					internal_TPObsDistancePostprocess(
+						ox[i], oy[i], g.dists[j],
+						tp_obstacles[g.run_k[r] + j - g.run_dists[r]]);
+			continue;
 		}
+
+		// Keep the minimum distance:
+		for (uint32_t r = r0; r < r1; r++)
+			keepMinRun(
+				&tp_obstacles[g.run_k[r]], &g.dists[g.run_dists[r]],
+				g.run_dists[r + 1] - g.run_dists[r]);
+	}
 }
 
 void CPTG_DiffDrive_CollisionGridBased::internal_readFromStream(
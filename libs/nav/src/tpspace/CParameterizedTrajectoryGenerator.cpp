@@ -269,6 +269,13 @@ void CParameterizedTrajectoryGenerator::initTPObstacleSingle(
 						 : this->getPathDist(k, this->getPathStepCount(k) - 1));
 }
 
+void CParameterizedTrajectoryGenerator::updateTPObstacles(
+	const double* ox, const double* oy, const size_t N,
+	std::vector<double>& tp_obstacles) const
+{
+	for (size_t i = 0; i < N; i++) updateTPObstacle(ox[i], oy[i], tp_obstacles);
+}
+
 bool CParameterizedTrajectoryGenerator::debugDumpInFiles(
 	const std::string& ptg_name) const
 {
@@ -401,7 +408,7 @@ void CParameterizedTrajectoryGenerator::initialize(
 			? cacheFilename
 			: std::string("cache_") +
 				  mrpt::system::fileNameStripInvalidChars(getDescription()) +
-				  std::string(".bin.gz");
+				  std::string(".bin");
 
 	this->internal_initialize(sCache, verbose);
 	m_is_initialized = true;
@@ -184,6 +184,34 @@ TEST(NavTests, PTGs_tests)
 			EXPECT_TRUE(any_change_all);
 		}
 
+		// TEST: TP_obstacles for a batch of points, wrt each direction alone
+		{
+			std::vector<double> oxs, oys;
+			for (double ox = -refDist; ox < refDist; ox += 0.07)
+				for (double oy = -refDist; oy < refDist; oy += 0.07)
+				{
+					if (std::abs(ox) < 1e-2 && std::abs(oy) < 1e-2) continue;
+					oxs.push_back(ox);
+					oys.push_back(oy);
+				}
+
+			std::vector<double> TP_obstacles;
+			ptg->initTPObstacles(TP_obstacles);
+			ptg->updateTPObstacles(
+				&oxs[0], &oys[0], oxs.size(), TP_obstacles);
+
+			for (size_t k = 0; k < num_paths; k++)
+			{
+				double tp_obs_k;
+				ptg->initTPObstacleSingle(k, tp_obs_k);
+				for (size_t i = 0; i < oxs.size(); i++)
+					ptg->updateTPObstacleSingle(oxs[i], oys[i], k, tp_obs_k);
+				EXPECT_EQ(tp_obs_k, TP_obstacles[k])
+					<< "PTG: " << sPTGDesc << " k=" << k << endl;
+				num_tests_run++;
+			}
+		}
+
 		printf(
 			"PTG `%50s` run %6u tests.\n", sPTGDesc.c_str(),
 			(unsigned int)num_tests_run);
@@ -193,3 +221,94 @@ TEST(NavTests, PTGs_tests)
 	// Clean up:
 	for (unsigned int n = 0; n < PTG_COUNT; n++) delete PTGs[n];
 }
+
+TEST(NavTests, PTGs_cache_files)
+{
+	using namespace std;
+	using namespace mrpt;
+	using namespace mrpt::nav;
+
+	const string sFil = mrpt::MRPT_GLOBAL_UNITTEST_SRC_DIR +
+						string("/tests/PTGs_for_tests.ini");
+	if (!mrpt::system::fileExists(sFil))
+	{
+		cerr << "**WARNING* Skipping tests since file cannot be found: '"
+			 << sFil << "'\n";
+		return;
+	}
+	mrpt::config::CConfigFile cfg(sFil);
+	const unsigned int PTG_COUNT =
+		cfg.read_int("PTG_UNIT_TESTS", "PTG_COUNT", 0, true);
+
+	for (unsigned int n = 0; n < PTG_COUNT; n++)
+	{
+		const string sPTGName = cfg.read_string(
+			"PTG_UNIT_TESTS", format("PTG%u_Type", n), "", true);
+		if (sPTGName.find("DiffDrive") == string::npos) continue;
+		auto createPTG = [&]() {
+			return CParameterizedTrajectoryGenerator::Ptr(
+				CParameterizedTrajectoryGenerator::CreatePTG(
+					sPTGName, cfg, "PTG_UNIT_TESTS", format("PTG%u_", n)));
+		};
+
+		const string sCache = mrpt::system::getTempFileName();
+		mrpt::system::deleteFile(sCache);
+
+		// Built from scratch, then loaded from the cache:
+		auto ptg1 = createPTG(), ptg2 = createPTG();
+		ptg1->initialize(sCache, false);
+		ASSERT_TRUE(mrpt::system::fileExists(sCache));
+		ptg2->initialize(sCache, false);
+
+		const auto nPaths = ptg1->getPathCount();
+		ASSERT_EQ(nPaths, ptg2->getPathCount());
+		for (uint16_t k = 0; k < nPaths; k++)
+		{
+			const size_t nSteps = ptg1->getPathStepCount(k);
+			ASSERT_EQ(nSteps, ptg2->getPathStepCount(k));
+			mrpt::math::TPose2D p1, p2;
+			ptg1->getPathPose(k, nSteps - 1, p1);
+			ptg2->getPathPose(k, nSteps - 1, p2);
+			EXPECT_EQ(p1, p2);
+		}
+
+		// Obstacles away from the robot shapes tested below:
+		std::vector<double> oxs, oys;
+		const double refDist = ptg1->getRefDistance();
+		for (double a = -M_PI; a < M_PI; a += 0.05)
+		{
+			oxs.push_back(0.6 * refDist * cos(a));
+			oys.push_back(0.6 * refDist * sin(a));
+		}
+		std::vector<double> tp1, tp2;
+		ptg1->initTPObstacles(tp1);
+		ptg2->initTPObstacles(tp2);
+		ptg1->updateTPObstacles(&oxs[0], &oys[0], oxs.size(), tp1);
+		ptg2->updateTPObstacles(&oxs[0], &oys[0], oxs.size(), tp2);
+		EXPECT_EQ(tp1, tp2) << sPTGName;
+		EXPECT_NE(tp1, std::vector<double>(tp1.size(), .0));
+
+		int k1, k2;
+		double d1, d2;
+		const bool ok1 = ptg1->inverseMap_WS2TP(1.0, 0.5, k1, d1);
+		const bool ok2 = ptg2->inverseMap_WS2TP(1.0, 0.5, k2, d2);
+		EXPECT_EQ(ok1, ok2);
+		EXPECT_EQ(k1, k2);
+		EXPECT_EQ(d1, d2);
+
+		// Another robot shape must not use the same cache:
+		auto ptg3 = createPTG();
+		auto* ptg3_poly = dynamic_cast<CPTG_RobotShape_Polygonal*>(ptg3.get());
+		ASSERT_TRUE(ptg3_poly != nullptr);
+		mrpt::math::CPolygon shape = ptg3_poly->getRobotShape();
+		for (auto& v : shape) v *= 2.0;
+		ptg3_poly->setRobotShape(shape);
+		ptg3->initialize(sCache, false);
+		std::vector<double> tp3;
+		ptg3->initTPObstacles(tp3);
+		ptg3->updateTPObstacles(&oxs[0], &oys[0], oxs.size(), tp3);
+		EXPECT_NE(tp1, tp3) << sPTGName;
+
+		mrpt::system::deleteFile(sCache);
+	}
+}
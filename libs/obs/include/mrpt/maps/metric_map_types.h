@@ -40,6 +40,11 @@ struct TMatchingParams
 	/** The point used to calculate angular distances: e.g. the coordinates of
 	 * the sensor for a 2D laser scanner. */
 	mrpt::math::TPoint3D angularDistPivotPoint;
+	/** Maximum number of threads for finding the correspondences, in the
+	 * process-wide mrpt::system::TaskScheduler (1=serial, 0=as many as the
+	 * scheduler threads). The resulting pairings and their order do not
+	 * depend on this value (Default=1) */
+	unsigned int matchingThreads;
 
 	/** Ctor: default values */
 	TMatchingParams()
@@ -49,7 +54,8 @@ struct TMatchingParams
 		  onlyUniqueRobust(false),
 		  decimation_other_map_points(1),
 		  offset_other_map_points(0),
-		  angularDistPivotPoint(0, 0, 0)
+		  angularDistPivotPoint(0, 0, 0),
+		  matchingThreads(1)
 	{
 	}
 };
@@ -42,17 +42,28 @@ struct T3DPointsProjectionParams
 	 * <b>and</b> with different camera parameter matrices. In all other cases,
 	 * it is a good idea to left it enabled. */
 	bool PROJ3D_USE_LUT;
-	/** (Default:true) If possible, use SSE2 optimized code. */
+	/** (Default:true) If possible, use SSE2 optimized code. Images of any
+	 * width are supported. */
 	bool USE_SSE2;
 	/** (Default:true) set to false if you want to preserve the organization of
-	 * the point cloud */
+	 * the point cloud: the output then has one point per pixel, in row-major
+	 * order, and filtered out pixels become invalid points. Only destination
+	 * point clouds able to hold invalid points (e.g. PCL clouds) support it;
+	 * the rest (mrpt::maps::CPointsMap, mrpt::opengl::CPointCloud,
+	 * CObservation3DRangeScan) throw if any pixel is filtered out. */
 	bool MAKE_DENSE;
+	/** (Default:0) Number of threads among which image rows are split: 0
+	 * means as many as the TaskScheduler concurrency, 1 runs everything in
+	 * the calling thread. The output does not depend on this value.
+	 * \note [New in MRPT 2.0.0] */
+	unsigned int num_threads;
 	T3DPointsProjectionParams()
 		: takeIntoAccountSensorPoseOnRobot(false),
 		  robotPoseInTheWorld(nullptr),
 		  PROJ3D_USE_LUT(true),
 		  USE_SSE2(true),
-		  MAKE_DENSE(true)
+		  MAKE_DENSE(true),
+		  num_threads(0)
 	{
 	}
 };
@@ -91,6 +102,15 @@ void project3DPointsFromDepthImageInto(
 	mrpt::obs::CObservation3DRangeScan& src_obs, POINTMAP& dest_pointcloud,
 	const mrpt::obs::T3DPointsProjectionParams& projectParams,
 	const mrpt::obs::TRangeImageFilterParams& filterParams);
+// Same, but only storing the pixel (column,row) of each point into
+// idxs_x/idxs_y (arrays of rows*cols elements) if they are not nullptr:
+template <class POINTMAP>
+void project3DPointsFromDepthImageInto(
+	const mrpt::obs::CObservation3DRangeScan& src_obs,
+	POINTMAP& dest_pointcloud,
+	const mrpt::obs::T3DPointsProjectionParams& projectParams,
+	const mrpt::obs::TRangeImageFilterParams& filterParams, uint16_t* idxs_x,
+	uint16_t* idxs_y);
 }  // namespace detail
 
 /** Declares a class derived from "CObservation" that encapsules a 3D range scan
@@ -379,7 +399,7 @@ class CObservation3DRangeScan : public CObservation
 		mrpt::obs::CObservation2DRangeScan& out_scan2d,
 		const T3DPointsTo2DScanParams& scanParams,
 		const TRangeImageFilterParams& filterParams =
-			TRangeImageFilterParams());
+			TRangeImageFilterParams()) const;
 
 	/** Whether external files (3D points, range and confidence) are to be
 	 * saved as `.txt` text files (MATLAB compatible) or `*.bin` binary
@@ -10,301 +10,348 @@
 #define CObservation3DRangeScan_project3D_impl_H
 
 #include <mrpt/core/round.h>  // round()
+#include <mrpt/core/SSE_types.h>
+#include <mrpt/system/TaskScheduler.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
 
 namespace mrpt::obs::detail
 {
-// Auxiliary functions which implement SSE-optimized proyection of 3D point
-// cloud:
-template <class POINTMAP>
-void do_project_3d_pointcloud(
-	const int H, const int W, const float* kys, const float* kzs,
-	const mrpt::math::CMatrix& rangeImage,
-	mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
-	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
-	const mrpt::obs::TRangeImageFilterParams& filterParams, bool MAKE_DENSE);
-template <class POINTMAP>
-void do_project_3d_pointcloud_SSE2(
-	const int H, const int W, const float* kys, const float* kzs,
-	const mrpt::math::CMatrix& rangeImage,
-	mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
-	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
-	const mrpt::obs::TRangeImageFilterParams& filterParams, bool MAKE_DENSE);
-
-template <class POINTMAP>
-void project3DPointsFromDepthImageInto(
-	mrpt::obs::CObservation3DRangeScan& src_obs, POINTMAP& dest_pointcloud,
-	const mrpt::obs::T3DPointsProjectionParams& projectParams,
-	const mrpt::obs::TRangeImageFilterParams& filterParams)
+/** Evaluates TRangeImageFilter::do_range_filter() for the `W` pixels of row
+ * `r`, with ranges `D`, and stores the results (0 or 1) in `valid`.
+ * \return The number of valid pixels */
+inline size_t range_filter_row(
+	const mrpt::obs::TRangeImageFilterParams& fp, const bool USE_SSE2,
+	const int r, const int W, const float* D, uint8_t* valid)
 {
-	using namespace mrpt::math;
-
-	if (!src_obs.hasRangeImage) return;
-
-	mrpt::opengl::PointCloudAdapter<POINTMAP> pca(dest_pointcloud);
-
-	// ------------------------------------------------------------
-	// Stage 1/3: Create 3D point cloud local coordinates
-	// ------------------------------------------------------------
-	const int W = src_obs.rangeImage.cols();
-	const int H = src_obs.rangeImage.rows();
-	ASSERT_(W != 0 && H != 0);
-	const size_t WH = W * H;
-
-	src_obs.resizePoints3DVectors(WH);  // This is to make sure
-	// points3D_idxs_{x,y} have the expected
-	// sizes.
-	pca.resize(WH);  // Reserve memory for 3D points. It will be later resized
-	// again to the actual number of valid points
-
-	if (src_obs.range_is_depth)
+	size_t nValid = 0;
+	int c = 0;
+#if MRPT_HAS_SSE2
+	if (USE_SSE2)
 	{
-		// range_is_depth = true
-
-		// Use cached tables?
-		if (projectParams.PROJ3D_USE_LUT)
+		// Same logic than do_range_filter(), 4 pixels at a time and without
+		// alignment requirements:
+		const float* Dmin_ptr =
+			fp.rangeMask_min ? &fp.rangeMask_min->coeffRef(r, 0) : nullptr;
+		const float* Dmax_ptr =
+			fp.rangeMask_max ? &fp.rangeMask_max->coeffRef(r, 0) : nullptr;
+		const __m128 zeros = _mm_setzero_ps();
+		const __m128 invert = fp.rangeCheckBetween
+								  ? zeros
+								  : _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (; c + 4 <= W; c += 4)
 		{
-			// Use LUT:
-			if (src_obs.get_3dproj_lut().prev_camParams !=
-					src_obs.cameraParams ||
-				WH != size_t(src_obs.get_3dproj_lut().Kys.size()))
+			const __m128 d = _mm_loadu_ps(D + c);
+			// "!(D<=0)": NaN ranges pass, as in do_range_filter()
+			__m128 ok = _mm_cmpnle_ps(d, zeros);
+			__m128 has_min = zeros, has_max = zeros;
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			if (Dmin_ptr)
 			{
-				src_obs.get_3dproj_lut().prev_camParams = src_obs.cameraParams;
-				src_obs.get_3dproj_lut().Kys.resize(WH);
-				src_obs.get_3dproj_lut().Kzs.resize(WH);
-
-				const float r_cx = src_obs.cameraParams.cx();
-				const float r_cy = src_obs.cameraParams.cy();
-				const float r_fx_inv = 1.0f / src_obs.cameraParams.fx();
-				const float r_fy_inv = 1.0f / src_obs.cameraParams.fy();
-
-				float* kys = &src_obs.get_3dproj_lut().Kys[0];
-				float* kzs = &src_obs.get_3dproj_lut().Kzs[0];
-				for (int r = 0; r < H; r++)
-					for (int c = 0; c < W; c++)
-					{
-						*kys++ = (r_cx - c) * r_fx_inv;
-						*kzs++ = (r_cy - r) * r_fy_inv;
-					}
-			}  // end update LUT.
-
-			ASSERT_EQUAL_(WH, size_t(src_obs.get_3dproj_lut().Kys.size()));
-			ASSERT_EQUAL_(WH, size_t(src_obs.get_3dproj_lut().Kzs.size()));
-			float* kys = &src_obs.get_3dproj_lut().Kys[0];
-			float* kzs = &src_obs.get_3dproj_lut().Kzs[0];
-
-			if (filterParams.rangeMask_min)
-			{  // sanity check:
-				ASSERT_EQUAL_(
-					filterParams.rangeMask_min->cols(),
-					src_obs.rangeImage.cols());
-				ASSERT_EQUAL_(
-					filterParams.rangeMask_min->rows(),
-					src_obs.rangeImage.rows());
+				const __m128 dmin = _mm_loadu_ps(Dmin_ptr + c);
+				has_min = _mm_cmpneq_ps(dmin, zeros);
+				inside = _mm_or_ps(
+					_mm_cmpeq_ps(dmin, zeros), _mm_cmpge_ps(d, dmin));
 			}
-			if (filterParams.rangeMask_max)
-			{  // sanity check:
-				ASSERT_EQUAL_(
-					filterParams.rangeMask_max->cols(),
-					src_obs.rangeImage.cols());
-				ASSERT_EQUAL_(
-					filterParams.rangeMask_max->rows(),
-					src_obs.rangeImage.rows());
+			if (Dmax_ptr)
+			{
+				const __m128 dmax = _mm_loadu_ps(Dmax_ptr + c);
+				has_max = _mm_cmpneq_ps(dmax, zeros);
+				inside = _mm_and_ps(
+					inside, _mm_or_ps(
+								_mm_cmpeq_ps(dmax, zeros),
+								_mm_cmple_ps(d, dmax)));
+			}
+			// With both filters, optionally invert the selection:
+			inside = _mm_xor_ps(
+				inside, _mm_and_ps(_mm_and_ps(has_min, has_max), invert));
+			ok = _mm_and_ps(ok, inside);
+
+			const int bits = _mm_movemask_ps(ok);
+			for (int q = 0; q < 4; q++)
+			{
+				valid[c + q] = (bits >> q) & 1;
+				nValid += valid[c + q];
 			}
-#if MRPT_HAS_SSE2
-			if ((W & 0x07) == 0 && projectParams.USE_SSE2)
-				do_project_3d_pointcloud_SSE2(
-					H, W, kys, kzs, src_obs.rangeImage, pca,
-					src_obs.points3D_idxs_x, src_obs.points3D_idxs_y,
-					filterParams, projectParams.MAKE_DENSE);
-			else
-				do_project_3d_pointcloud(
-					H, W, kys, kzs, src_obs.rangeImage, pca,
-					src_obs.points3D_idxs_x, src_obs.points3D_idxs_y,
-					filterParams, projectParams.MAKE_DENSE);  // if image width
-// is not 8*N, use
-// standard method
-#else
-			do_project_3d_pointcloud(
-				H, W, kys, kzs, src_obs.rangeImage, pca,
-				src_obs.points3D_idxs_x, src_obs.points3D_idxs_y, filterParams,
-				projectParams.MAKE_DENSE);
-#endif
-		}
-		else
-		{
-			// Without LUT:
-			const float r_cx = src_obs.cameraParams.cx();
-			const float r_cy = src_obs.cameraParams.cy();
-			const float r_fx_inv = 1.0f / src_obs.cameraParams.fx();
-			const float r_fy_inv = 1.0f / src_obs.cameraParams.fy();
-			TRangeImageFilter rif(filterParams);
-			size_t idx = 0;
-			for (int r = 0; r < H; r++)
-				for (int c = 0; c < W; c++)
-				{
-					const float D = src_obs.rangeImage.coeff(r, c);
-					if (rif.do_range_filter(r, c, D))
-					{
-						const float Kz = (r_cy - r) * r_fy_inv;
-						const float Ky = (r_cx - c) * r_fx_inv;
-						pca.setPointXYZ(
-							idx,
-							D,  // x
-							Ky * D,  // y
-							Kz * D  // z
-							);
-						src_obs.points3D_idxs_x[idx] = c;
-						src_obs.points3D_idxs_y[idx] = r;
-						++idx;
-					}
-				}
-			pca.resize(idx);  // Actual number of valid pts
 		}
 	}
-	else
+#else
+	MRPT_UNUSED_PARAM(USE_SSE2);
+#endif
+	// The rest of pixels (or all of them, without SSE2):
+	const TRangeImageFilter rif(fp);
+	for (; c < W; c++)
 	{
-		/* range_is_depth = false :
-		 *   Ky = (r_cx - c)/r_fx
-		 *   Kz = (r_cy - r)/r_fy
-		 *
-		 *   x(i) = rangeImage(r,c) / sqrt( 1 + Ky^2 + Kz^2 )
-		 *   y(i) = Ky * x(i)
-		 *   z(i) = Kz * x(i)
-		 */
-		const float r_cx = src_obs.cameraParams.cx();
-		const float r_cy = src_obs.cameraParams.cy();
-		const float r_fx_inv = 1.0f / src_obs.cameraParams.fx();
-		const float r_fy_inv = 1.0f / src_obs.cameraParams.fy();
-		TRangeImageFilter rif(filterParams);
-		size_t idx = 0;
-		for (int r = 0; r < H; r++)
-			for (int c = 0; c < W; c++)
-			{
-				const float D = src_obs.rangeImage.coeff(r, c);
-				if (rif.do_range_filter(r, c, D))
-				{
-					const float Ky = (r_cx - c) * r_fx_inv;
-					const float Kz = (r_cy - r) * r_fy_inv;
-					pca.setPointXYZ(
-						idx,
-						D / std::sqrt(1 + Ky * Ky + Kz * Kz),  // x
-						Ky * D,  // y
-						Kz * D  // z
-						);
-					src_obs.points3D_idxs_x[idx] = c;
-					src_obs.points3D_idxs_y[idx] = r;
-					++idx;
-				}
-			}
-		pca.resize(idx);  // Actual number of valid pts
+		valid[c] = rif.do_range_filter(r, c, D[c]) ? 1 : 0;
+		nValid += valid[c];
 	}
+	return nValid;
+}
 
-	// -------------------------------------------------------------
-	// Stage 2/3: Project local points into RGB image to get colors
-	// -------------------------------------------------------------
-	if (src_obs.hasIntensityImage)
+/** Projects the rows [r0,r1) of the range image and writes their points
+ * to `pca`, starting at index `idx`. Filtering, projection, colors and the
+ * 6D transformation are all done in this single pass.
+ * `ky`: For each column, Y of the ray with unit X. `kz`: Z of the ray of
+ * each row, with a stride of `kz_stride` floats.
+ * `mask`: Precomputed range_filter_row() results, or nullptr to compute them
+ * here. `HM`: Transformation for the points, or nullptr for local
+ * coordinates. */
+template <class POINTMAP>
+void do_project_3d_pointcloud_rows(
+	const mrpt::obs::CObservation3DRangeScan& src_obs,
+	mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
+	const mrpt::obs::T3DPointsProjectionParams& pp,
+	const mrpt::obs::TRangeImageFilterParams& fp, const float* ky,
+	const float* kz, const size_t kz_stride, const uint8_t* mask,
+	const float* HM, const int r0, const int r1, size_t idx,
+	uint16_t* idxs_x, uint16_t* idxs_y)
+{
+	const int W = src_obs.rangeImage.cols();
+	const bool range_is_depth = src_obs.range_is_depth;
+
+	// Colors: either the same pixel of the intensity image, or the
+	// projection of each point onto it.
+	const bool hasColor = src_obs.hasIntensityImage;
+	const mrpt::img::CImage& img = src_obs.intensityImage;  // const access!
+	const bool isDirectCorresp =
+		hasColor && src_obs.doDepthAndIntensityCamerasCoincide();
+	const bool hasColorIntensityImg = hasColor && img.isColor();
+	const int imgW = hasColor ? static_cast<int>(img.getWidth()) : 0;
+	const int imgH = hasColor ? static_cast<int>(img.getHeight()) : 0;
+	const float cx = src_obs.cameraParamsIntensity.cx();
+	const float cy = src_obs.cameraParamsIntensity.cy();
+	const float fx = src_obs.cameraParamsIntensity.fx();
+	const float fy = src_obs.cameraParamsIntensity.fy();
+	// Inverse of the pose of the intensity camera wrt the depth camera:
+	float T[3][4];
+	if (hasColor && !isDirectCorresp)
 	{
-		const int imgW = src_obs.intensityImage.getWidth();
-		const int imgH = src_obs.intensityImage.getHeight();
-		const bool hasColorIntensityImg = src_obs.intensityImage.isColor();
-
-		const float cx = src_obs.cameraParamsIntensity.cx();
-		const float cy = src_obs.cameraParamsIntensity.cy();
-		const float fx = src_obs.cameraParamsIntensity.fx();
-		const float fy = src_obs.cameraParamsIntensity.fy();
-
-		// Unless we are in a special case (both depth & RGB images coincide)...
-		const bool isDirectCorresp =
-			src_obs.doDepthAndIntensityCamerasCoincide();
-
-		// ...precompute the inverse of the pose transformation out of the loop,
-		//  store as a 4x4 homogeneous matrix to exploit SSE optimizations
-		//  below:
-		mrpt::math::CMatrixFixedNumeric<float, 4, 4> T_inv;
-		if (!isDirectCorresp)
+		mrpt::math::CMatrixFixedNumeric<double, 3, 3> R_inv;
+		mrpt::math::CMatrixFixedNumeric<double, 3, 1> t_inv;
+		mrpt::math::homogeneousMatrixInverse(
+			src_obs.relativePoseIntensityWRTDepth.getRotationMatrix(),
+			src_obs.relativePoseIntensityWRTDepth.m_coords, R_inv, t_inv);
+		for (int i = 0; i < 3; i++)
 		{
-			mrpt::math::CMatrixFixedNumeric<double, 3, 3> R_inv;
-			mrpt::math::CMatrixFixedNumeric<double, 3, 1> t_inv;
-			mrpt::math::homogeneousMatrixInverse(
-				src_obs.relativePoseIntensityWRTDepth.getRotationMatrix(),
-				src_obs.relativePoseIntensityWRTDepth.m_coords, R_inv, t_inv);
-
-			T_inv(3, 3) = 1;
-			T_inv.block<3, 3>(0, 0) = R_inv.cast<float>();
-			T_inv.block<3, 1>(0, 3) = t_inv.cast<float>();
+			for (int j = 0; j < 3; j++)
+				T[i][j] = static_cast<float>(R_inv(i, j));
+			T[i][3] = static_cast<float>(t_inv[i]);
 		}
+	}
 
-		Eigen::Matrix<float, 4, 1> pt_wrt_color, pt_wrt_depth;
-		pt_wrt_depth[3] = 1;
+	std::vector<uint8_t> row_mask(mask ? 0 : W);
+	alignas(MRPT_MAX_ALIGN_BYTES) float xs[4], ys[4], zs[4];
 
-		mrpt::img::TColor pCol;
+	for (int r = r0; r < r1; r++)
+	{
+		const float* D = &src_obs.rangeImage.coeffRef(r, 0);
+		const float Kz = kz[r * kz_stride];
+		const uint8_t* valid = mask ? mask + size_t(r) * W : &row_mask[0];
+		if (!mask) range_filter_row(fp, pp.USE_SSE2, r, W, D, &row_mask[0]);
 
-		// For each local point:
-		const size_t nPts = pca.size();
-		for (size_t i = 0; i < nPts; i++)
+		for (int c0 = 0; c0 < W; c0 += 4)
 		{
-			int img_idx_x, img_idx_y;  // projected pixel coordinates, in the
-			// RGB image plane
-			bool pointWithinImage = false;
-			if (isDirectCorresp)
+			const int nq = std::min(4, W - c0);
+			// Local coordinates, 4 pixels at a time:
+#if MRPT_HAS_SSE2
+			if (pp.USE_SSE2 && nq == 4 && range_is_depth)
 			{
-				pointWithinImage = true;
-				img_idx_x = src_obs.points3D_idxs_x[i];
-				img_idx_y = src_obs.points3D_idxs_y[i];
+				const __m128 d = _mm_loadu_ps(D + c0);
+				_mm_store_ps(xs, d);
+				_mm_store_ps(ys, _mm_mul_ps(_mm_loadu_ps(ky + c0), d));
+				_mm_store_ps(zs, _mm_mul_ps(_mm_set1_ps(Kz), d));
 			}
 			else
+#endif
 			{
-				// Project point, which is now in "pca" in local coordinates wrt
-				// the depth camera, into the intensity camera:
-				pca.getPointXYZ(
-					i, pt_wrt_depth[0], pt_wrt_depth[1], pt_wrt_depth[2]);
-				pt_wrt_color = T_inv * pt_wrt_depth;
-
-				// Project to image plane:
-				if (pt_wrt_color[2])
+				for (int q = 0; q < nq; q++)
 				{
-					img_idx_x = mrpt::round(
-						cx + fx * pt_wrt_color[0] / pt_wrt_color[2]);
-					img_idx_y = mrpt::round(
-						cy + fy * pt_wrt_color[1] / pt_wrt_color[2]);
-					pointWithinImage = img_idx_x >= 0 && img_idx_x < imgW &&
-									   img_idx_y >= 0 && img_idx_y < imgH;
+					const float d = D[c0 + q], Ky = ky[c0 + q];
+					xs[q] = range_is_depth
+								? d
+								: d / std::sqrt(1 + Ky * Ky + Kz * Kz);
+					ys[q] = Ky * d;
+					zs[q] = Kz * d;
 				}
 			}
 
-			if (pointWithinImage)
+			for (int q = 0; q < nq; q++)
 			{
-				if (hasColorIntensityImg)
+				const int c = c0 + q;
+				if (!valid[c])
 				{
-					const uint8_t* c = src_obs.intensityImage.get_unsafe(
-						img_idx_x, img_idx_y, 0);
-					pCol.R = c[2];
-					pCol.G = c[1];
-					pCol.B = c[0];
+					if (!pp.MAKE_DENSE)
+					{
+						pca.setInvalidPoint(idx);
+						if (idxs_x)
+						{
+							idxs_x[idx] = c;
+							idxs_y[idx] = r;
+						}
+						++idx;
+					}
+					continue;
 				}
-				else
+				float x = xs[q], y = ys[q], z = zs[q];
+
+				if (hasColor)
 				{
-					uint8_t c = *src_obs.intensityImage.get_unsafe(
-						img_idx_x, img_idx_y, 0);
-					pCol.R = pCol.G = pCol.B = c;
+					int img_idx_x = c, img_idx_y = r;
+					bool pointWithinImage = isDirectCorresp;
+					if (!isDirectCorresp)
+					{
+						// Project the point, in local coordinates wrt the
+						// depth camera, onto the intensity image plane:
+						const float px =
+							T[0][0] * x + T[0][1] * y + T[0][2] * z + T[0][3];
+						const float py =
+							T[1][0] * x + T[1][1] * y + T[1][2] * z + T[1][3];
+						const float pz =
+							T[2][0] * x + T[2][1] * y + T[2][2] * z + T[2][3];
+						if (pz)
+						{
+							img_idx_x = mrpt::round(cx + fx * px / pz);
+							img_idx_y = mrpt::round(cy + fy * py / pz);
+							pointWithinImage =
+								img_idx_x >= 0 && img_idx_x < imgW &&
+								img_idx_y >= 0 && img_idx_y < imgH;
+						}
+					}
+					uint8_t R = 255, G = 255, B = 255;
+					if (pointWithinImage)
+					{
+						const uint8_t* pix =
+							img.get_unsafe(img_idx_x, img_idx_y, 0);
+						if (hasColorIntensityImg)
+						{
+							R = pix[2];
+							G = pix[1];
+							B = pix[0];
+						}
+						else
+							R = G = B = pix[0];
+					}
+					pca.setPointRGBu8(idx, R, G, B);
 				}
+
+				if (HM)
+				{
+					const float gx = HM[0] * x + HM[1] * y + HM[2] * z + HM[3];
+					const float gy = HM[4] * x + HM[5] * y + HM[6] * z + HM[7];
+					const float gz =
+						HM[8] * x + HM[9] * y + HM[10] * z + HM[11];
+					x = gx;
+					y = gy;
+					z = gz;
+				}
+
+				pca.setPointXYZ(idx, x, y, z);
+				if (idxs_x)
+				{
+					idxs_x[idx] = c;
+					idxs_y[idx] = r;
+				}
+				++idx;
 			}
-			else
-			{
-				pCol.R = pCol.G = pCol.B = 255;
-			}
-			// Set color:
-			pca.setPointRGBu8(i, pCol.R, pCol.G, pCol.B);
-		}  // end for each point
-	}  // end if src_obs has intensity image
+		}
+	}
+}
+
+template <class POINTMAP>
+void project3DPointsFromDepthImageInto(
+	const mrpt::obs::CObservation3DRangeScan& src_obs,
+	POINTMAP& dest_pointcloud,
+	const mrpt::obs::T3DPointsProjectionParams& projectParams,
+	const mrpt::obs::TRangeImageFilterParams& filterParams, uint16_t* idxs_x,
+	uint16_t* idxs_y)
+{
+	using namespace mrpt::math;
+
+	if (!src_obs.hasRangeImage) return;
+
+	mrpt::opengl::PointCloudAdapter<POINTMAP> pca(dest_pointcloud);
+
+	const int W = src_obs.rangeImage.cols();
+	const int H = src_obs.rangeImage.rows();
+	ASSERT_(W != 0 && H != 0);
+	const size_t WH = W * H;
+
+	if (filterParams.rangeMask_min)
+	{  // sanity check:
+		ASSERT_EQUAL_(
+			filterParams.rangeMask_min->cols(), src_obs.rangeImage.cols());
+		ASSERT_EQUAL_(
+			filterParams.rangeMask_min->rows(), src_obs.rangeImage.rows());
+	}
+	if (filterParams.rangeMask_max)
+	{  // sanity check:
+		ASSERT_EQUAL_(
+			filterParams.rangeMask_max->cols(), src_obs.rangeImage.cols());
+		ASSERT_EQUAL_(
+			filterParams.rangeMask_max->rows(), src_obs.rangeImage.rows());
+	}
 
-	// ...
+	pca.resize(WH);  // Reserve memory for 3D points. It will be later resized
+	// again to the actual number of valid points
 
 	// ------------------------------------------------------------
-	// Stage 3/3: Apply 6D transformations
+	// Direction of the ray of each pixel, with unit X:
+	//   Ky = (r_cx - c)/r_fx
+	//   Kz = (r_cy - r)/r_fy
+	// If range_is_depth=true, the point is (D, Ky*D, Kz*D). Otherwise,
+	//   x = D / sqrt( 1 + Ky^2 + Kz^2 ), y = Ky * D, z = Kz * D
 	// ------------------------------------------------------------
-	if (projectParams.takeIntoAccountSensorPoseOnRobot ||
-		projectParams.robotPoseInTheWorld)
+	const float r_cx = src_obs.cameraParams.cx();
+	const float r_cy = src_obs.cameraParams.cy();
+	const float r_fx_inv = 1.0f / src_obs.cameraParams.fx();
+	const float r_fy_inv = 1.0f / src_obs.cameraParams.fy();
+	std::vector<float> own_ky, own_kz;
+	const float *ky, *kz;
+	size_t kz_stride;
+	if (src_obs.range_is_depth && projectParams.PROJ3D_USE_LUT)
+	{
+		// Use cached tables:
+		auto& lut = src_obs.get_3dproj_lut();
+		if (lut.prev_camParams != src_obs.cameraParams ||
+			WH != size_t(lut.Kys.size()))
+		{
+			lut.prev_camParams = src_obs.cameraParams;
+			lut.Kys.resize(WH);
+			lut.Kzs.resize(WH);
+			float* kys = &lut.Kys[0];
+			float* kzs = &lut.Kzs[0];
+			for (int r = 0; r < H; r++)
+				for (int c = 0; c < W; c++)
+				{
+					*kys++ = (r_cx - c) * r_fx_inv;
+					*kzs++ = (r_cy - r) * r_fy_inv;
+				}
+		}  // end update LUT.
+		ASSERT_EQUAL_(WH, size_t(lut.Kys.size()));
+		ASSERT_EQUAL_(WH, size_t(lut.Kzs.size()));
+		// All rows of Kys are equal, and so are all columns of Kzs:
+		ky = &lut.Kys[0];
+		kz = &lut.Kzs[0];
+		kz_stride = W;
+	}
+	else
+	{
+		own_ky.resize(W);
+		own_kz.resize(H);
+		for (int c = 0; c < W; c++) own_ky[c] = (r_cx - c) * r_fx_inv;
+		for (int r = 0; r < H; r++) own_kz[r] = (r_cy - r) * r_fy_inv;
+		ky = &own_ky[0];
+		kz = &own_kz[0];
+		kz_stride = 1;
+	}
+
+	// 6D transformation, if any, as a 3x4 row-major matrix:
+	float HM[12];
+	const bool apply_transf = projectParams.takeIntoAccountSensorPoseOnRobot ||
+							  projectParams.robotPoseInTheWorld;
+	if (apply_transf)
 	{
 		mrpt::poses::CPose3D transf_to_apply;  // Either ROBOTPOSE or
 		// ROBOTPOSE(+)SENSORPOSE or
@@ -315,188 +362,72 @@ void project3DPointsFromDepthImageInto(
 			transf_to_apply.composeFrom(
 				*projectParams.robotPoseInTheWorld,
 				mrpt::poses::CPose3D(transf_to_apply));
-
-		const Eigen::Matrix<float, 4, 4> HM =
+		const auto M =
 			transf_to_apply
-				.getHomogeneousMatrixVal<mrpt::math::CMatrixDouble44>()
-				.cast<float>();
-		Eigen::Matrix<float, 4, 1> pt, pt_transf;
-		pt[3] = 1;
+				.getHomogeneousMatrixVal<mrpt::math::CMatrixDouble44>();
+		for (int i = 0; i < 3; i++)
+			for (int j = 0; j < 4; j++)
+				HM[i * 4 + j] = static_cast<float>(M(i, j));
+	}
 
-		const size_t nPts = pca.size();
-		for (size_t i = 0; i < nPts; i++)
-		{
-			pca.getPointXYZ(i, pt[0], pt[1], pt[2]);
-			pt_transf = HM * pt;
-			pca.setPointXYZ(i, pt_transf[0], pt_transf[1], pt_transf[2]);
-		}
+	// ------------------------------------------------------------
+	// Rows are split among threads. Each one needs to know where its points
+	// go: with MAKE_DENSE=false, each row takes exactly W points; otherwise,
+	// the valid pixels of all rows are found first.
+	// ------------------------------------------------------------
+	const size_t maxChunks = projectParams.num_threads;
+	std::vector<uint8_t> mask;
+	std::vector<size_t> row_first_idx(H + 1);
+	if (projectParams.MAKE_DENSE)
+	{
+		mask.resize(WH);
+		std::vector<size_t> row_count(H);
+		mrpt::system::parallel_for_chunks(
+			H,
+			[&](const size_t r0, const size_t r1) {
+				for (size_t r = r0; r < r1; r++)
+					row_count[r] = range_filter_row(
+						filterParams, projectParams.USE_SSE2, r, W,
+						&src_obs.rangeImage.coeffRef(r, 0), &mask[r * W]);
+			},
+			maxChunks);
+		row_first_idx[0] = 0;
+		for (int r = 0; r < H; r++)
+			row_first_idx[r + 1] = row_first_idx[r] + row_count[r];
+	}
+	else
+	{
+		for (int r = 0; r <= H; r++) row_first_idx[r] = size_t(r) * W;
 	}
+
+	mrpt::system::parallel_for_chunks(
+		H,
+		[&](const size_t r0, const size_t r1) {
+			do_project_3d_pointcloud_rows(
+				src_obs, pca, projectParams, filterParams, ky, kz, kz_stride,
+				mask.empty() ? nullptr : &mask[0], apply_transf ? HM : nullptr,
+				r0, r1, row_first_idx[r0], idxs_x, idxs_y);
+		},
+		maxChunks);
+
+	pca.resize(row_first_idx[H]);  // Actual number of valid pts
 }  // end of project3DPointsFromDepthImageInto
 
-// Auxiliary functions which implement proyection of 3D point clouds:
 template <class POINTMAP>
-inline void do_project_3d_pointcloud(
-	const int H, const int W, const float* kys, const float* kzs,
-	const mrpt::math::CMatrix& rangeImage,
-	mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
-	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
-	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_DENSE)
+void project3DPointsFromDepthImageInto(
+	mrpt::obs::CObservation3DRangeScan& src_obs, POINTMAP& dest_pointcloud,
+	const mrpt::obs::T3DPointsProjectionParams& projectParams,
+	const mrpt::obs::TRangeImageFilterParams& filterParams)
 {
-	TRangeImageFilter rif(fp);
-	// Preconditions: minRangeMask() has the right size
-	size_t idx = 0;
-	for (int r = 0; r < H; r++)
-		for (int c = 0; c < W; c++)
-		{
-			const float D = rangeImage.coeff(r, c);
-			if (!rif.do_range_filter(r, c, D))
-			{
-				if (!MAKE_DENSE)
-				{
-					pca.setInvalidPoint(idx);
-					++idx;
-				}
-				continue;
-			}
-
-			pca.setPointXYZ(idx, D /*x*/, *kys++ * D /*y*/, *kzs++ * D /*z*/);
-			idxs_x[idx] = c;
-			idxs_y[idx] = r;
-			++idx;
-		}
-	pca.resize(idx);
+	if (!src_obs.hasRangeImage) return;
+	// Make sure points3D_idxs_{x,y} have the expected sizes:
+	src_obs.resizePoints3DVectors(
+		src_obs.rangeImage.cols() * src_obs.rangeImage.rows());
+	project3DPointsFromDepthImageInto(
+		static_cast<const mrpt::obs::CObservation3DRangeScan&>(src_obs),
+		dest_pointcloud, projectParams, filterParams,
+		src_obs.points3D_idxs_x.data(), src_obs.points3D_idxs_y.data());
 }
 
-// Auxiliary functions which implement proyection of 3D point clouds:
-template <class POINTMAP>
-inline void do_project_3d_pointcloud_SSE2(
-	const int H, const int W, const float* kys, const float* kzs,
-	const mrpt::math::CMatrix& rangeImage,
-	mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
-	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
-	const mrpt::obs::TRangeImageFilterParams& filterParams, bool MAKE_DENSE)
-{
-#if MRPT_HAS_SSE2
-	// Preconditions: minRangeMask() has the right size
-	// Use optimized version:
-	const int W_4 = W >> 2;  // /=4 , since we process 4 values at a time.
-	size_t idx = 0;
-	alignas(MRPT_MAX_ALIGN_BYTES) float xs[4], ys[4], zs[4];
-	const __m128 D_zeros = _mm_set_ps(.0f, .0f, .0f, .0f);
-	const __m128 xormask =
-		(filterParams.rangeCheckBetween)
-			? _mm_cmpneq_ps(D_zeros, D_zeros)
-			:  // want points BETWEEN min and max to be valid
-			_mm_cmpeq_ps(
-				D_zeros,
-				D_zeros);  // want points OUTSIDE of min and max to be valid
-	for (int r = 0; r < H; r++)
-	{
-		const float* D_ptr =
-			&rangeImage.coeffRef(r, 0);  // Matrices are 16-aligned
-		const float* Dgt_ptr =
-			!filterParams.rangeMask_min
-				? nullptr
-				: &filterParams.rangeMask_min->coeffRef(r, 0);
-		const float* Dlt_ptr =
-			!filterParams.rangeMask_max
-				? nullptr
-				: &filterParams.rangeMask_max->coeffRef(r, 0);
-
-		for (int c = 0; c < W_4; c++)
-		{
-			const __m128 D = _mm_load_ps(D_ptr);
-			const __m128 nz_mask = _mm_cmpgt_ps(D, D_zeros);
-			__m128 valid_range_mask;
-			if (!filterParams.rangeMask_min && !filterParams.rangeMask_max)
-			{  // No filter: just skip D=0 points
-				valid_range_mask = nz_mask;
-			}
-			else
-			{
-				if (!filterParams.rangeMask_min || !filterParams.rangeMask_max)
-				{  // Only one filter
-					if (filterParams.rangeMask_min)
-					{
-						const __m128 Dmin = _mm_load_ps(Dgt_ptr);
-						valid_range_mask = _mm_and_ps(
-							_mm_cmpgt_ps(D, Dmin), _mm_cmpgt_ps(Dmin, D_zeros));
-					}
-					else
-					{
-						const __m128 Dmax = _mm_load_ps(Dlt_ptr);
-						valid_range_mask = _mm_and_ps(
-							_mm_cmplt_ps(D, Dmax), _mm_cmpgt_ps(Dmax, D_zeros));
-					}
-					valid_range_mask = _mm_and_ps(
-						valid_range_mask, nz_mask);  // Filter out D=0 points
-				}
-				else
-				{
-					// We have both: D>Dmin and D<Dmax conditions, with XOR to
-					// optionally invert the selection:
-					const __m128 Dmin = _mm_load_ps(Dgt_ptr);
-					const __m128 Dmax = _mm_load_ps(Dlt_ptr);
-
-					const __m128 gt_mask = _mm_cmpgt_ps(D, Dmin);
-					const __m128 lt_mask = _mm_and_ps(
-						_mm_cmplt_ps(D, Dmax), nz_mask);  // skip points at zero
-					valid_range_mask =
-						_mm_and_ps(gt_mask, lt_mask);  // (D>Dmin && D<Dmax)
-					valid_range_mask = _mm_xor_ps(valid_range_mask, xormask);
-					// Add the case of D_min & D_max = 0 (no filtering)
-					valid_range_mask = _mm_or_ps(
-						valid_range_mask, _mm_and_ps(
-											  _mm_cmpeq_ps(Dmin, D_zeros),
-											  _mm_cmpeq_ps(Dmax, D_zeros)));
-					// Finally, ensure no invalid ranges get thru:
-					valid_range_mask = _mm_and_ps(valid_range_mask, nz_mask);
-				}
-			}
-			const int valid_range_maski = _mm_movemask_epi8(
-				_mm_castps_si128(valid_range_mask));  // 0x{f|0}{f|0}{f|0}{f|0}
-			if (valid_range_maski != 0)  // Any of the 4 values is valid?
-			{
-				const __m128 KY = _mm_load_ps(kys);
-				const __m128 KZ = _mm_load_ps(kzs);
-
-				_mm_storeu_ps(xs, D);
-				_mm_storeu_ps(ys, _mm_mul_ps(KY, D));
-				_mm_storeu_ps(zs, _mm_mul_ps(KZ, D));
-
-				for (int q = 0; q < 4; q++)
-					if ((valid_range_maski & (1 << (q * 4))) != 0)
-					{
-						pca.setPointXYZ(idx, xs[q], ys[q], zs[q]);
-						idxs_x[idx] = (c << 2) + q;
-						idxs_y[idx] = r;
-						++idx;
-					}
-					else if (!MAKE_DENSE)
-					{
-						pca.setInvalidPoint(idx);
-						++idx;
-					}
-			}
-			else if (!MAKE_DENSE)
-			{
-				for (int q = 0; q < 4; q++)
-				{
-					pca.setInvalidPoint(idx);
-					++idx;
-				}
-			}
-			D_ptr += 4;
-			if (Dgt_ptr) Dgt_ptr += 4;
-			if (Dlt_ptr) Dlt_ptr += 4;
-			kys += 4;
-			kzs += 4;
-		}
-	}
-	pca.resize(idx);
-#endif
-}
-}  // namespace mrpt
+}  // namespace mrpt::obs::detail
 #endif
-
-
@@ -254,6 +254,11 @@ class CObservationVelodyneScan : public CObservation
 		bool generatePerPointTimestamp{false};
 		/** (Default:false) If `true`, populate the vector azimuth */
 		bool generatePerPointAzimuth{false};
+		/** (Default:0) Number of threads used to decode the packets: 0 means
+		 * as many as the TaskScheduler concurrency, 1 runs everything in the
+		 * calling thread. The output does not depend on this value.
+		 * \note [New in MRPT 2.0.0] */
+		unsigned int num_threads{0};
 	};
 
 	/** Generates the point cloud into the point cloud data fields in \a
@@ -266,6 +271,8 @@ class CObservationVelodyneScan : public CObservation
 	 * generatePointCloudAlongSE3Trajectory()
 	 * \note Points with ranges out of [minRange,maxRange] are discarded; as
 	 * well, other filters are available in \a params.
+	 * \note Packets are decoded in parallel, see
+	 * TGeneratePointCloudParameters::num_threads.
 	 * \sa generatePointCloudAlongSE3Trajectory(),
 	 * TGeneratePointCloudParameters
 	 */
@@ -273,6 +280,13 @@ class CObservationVelodyneScan : public CObservation
 		const TGeneratePointCloudParameters& params =
 			TGeneratePointCloudParameters());
 
+	/** Like generatePointCloud(), but stores the points into \a out_cloud
+	 * instead of CObservationVelodyneScan::point_cloud, leaving this object
+	 * unmodified. */
+	void generatePointCloud(
+		TPointCloud& out_cloud, const TGeneratePointCloudParameters& params =
+									TGeneratePointCloudParameters()) const;
+
 	/** Results for generatePointCloudAlongSE3Trajectory() */
 	struct TGeneratePointCloudSE3Results
 	{
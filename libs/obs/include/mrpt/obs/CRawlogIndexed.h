@@ -0,0 +1,156 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt/io/CMemoryMappedFile.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mrpt::obs
+{
+/** Random-access, read-only view of an (uncompressed) rawlog file, which
+ * avoids loading the whole dataset into memory.
+ *
+ * The rawlog file is memory-mapped (see mrpt::io::CMemoryMappedFile) and a
+ * small sidecar index file (`<rawlog>.idx`, see getIndexFileName()) stores,
+ * for each serialized object in the rawlog, its byte offset and length, its
+ * timestamp, its class name and its sensor label. Opening a rawlog with an
+ * existing index is therefore almost instantaneous regardless of its size,
+ * and objects are only deserialized when requested, e.g. with
+ * getAsObservation(), which is O(1) in the number of entries.
+ *
+ * If the index file does not exist, or it does not match the rawlog file
+ * (its size, or a hash of its first and last blocks, changed), it is built
+ * (which requires reading the whole rawlog once) and saved when calling
+ * open(). Indices can also be generated offline with buildIndex() or
+ * with the `rawlog-edit --generate-index` command.
+ *
+ * Both rawlog formats (action/sensory-frame pairs and observations-only) are
+ * supported. Gz-compressed rawlogs cannot be memory-mapped and must be
+ * decompressed first.
+ *
+ * Deserialized objects are not cached: each call to getAsGeneric() or its
+ * typed variants returns a new object. All const methods can be called
+ * concurrently from different threads.
+ *
+ * \code
+ * mrpt::obs::CRawlogIndexed rawlog;
+ * if (!rawlog.open("dataset.rawlog")) { ... }
+ * std::vector<size_t> idxs;
+ * rawlog.findEntriesInTimeRange(t0, t1, idxs);
+ * for (size_t i : idxs)
+ *   if (rawlog.getType(i) == CRawlog::etObservation)
+ *     auto obs = rawlog.getAsObservation(i);
+ * \endcode
+ *
+ * \sa CRawlog
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_obs_grp
+ */
+class CRawlogIndexed
+{
+   public:
+	/** Information stored in the index for each object in the rawlog */
+	struct TEntry
+	{
+		/** Position of the serialized object in the rawlog file (bytes) */
+		uint64_t offset{0};
+		/** Length of the serialized object (bytes) */
+		uint64_t length{0};
+		/** Timestamp of the observation; for sensory frames and action
+		 * collections, that of its first element. May be INVALID_TIMESTAMP */
+		mrpt::system::TTimeStamp timestamp{INVALID_TIMESTAMP};
+		/** Class name, e.g. "CObservation2DRangeScan" */
+		std::string className;
+		/** Sensor label, for observations only. */
+		std::string sensorLabel;
+	};
+
+	CRawlogIndexed() = default;
+
+	/** Opens a rawlog file, loading its index file, or building and saving
+	 * it if it does not exist yet, it does not correspond to the rawlog
+	 * file, or `rebuildIndex` is true.
+	 * \return false on any error (e.g. file not found, or compressed file).
+	 */
+	bool open(const std::string& rawlogFile, bool rebuildIndex = false);
+	/** Closes the rawlog file and clears the index */
+	void close();
+	/** Returns true if a rawlog file is open */
+	bool isOpen() const { return m_file.isOpen(); }
+
+	/** Number of entries (actions, sensory frames or observations) */
+	size_t size() const { return m_entries.size(); }
+	/** Returns the index information for the i'th entry.
+	 * \exception std::exception If index is out of bounds */
+	const TEntry& getEntryInfo(size_t index) const;
+	/** Returns the type of the i'th entry, without deserializing it.
+	 * \exception std::exception If index is out of bounds */
+	CRawlog::TEntryType getType(size_t index) const;
+
+	/** Deserializes and returns the i'th entry, whatever its class.
+	 * \exception std::exception If index is out of bounds */
+	mrpt::serialization::CSerializable::Ptr getAsGeneric(size_t index) const;
+	/** Deserializes and returns the i'th entry as an observation.
+	 * \exception std::exception If index is out of bounds or the entry is
+	 * not a CObservation */
+	CObservation::Ptr getAsObservation(size_t index) const;
+	/** Deserializes and returns the i'th entry as a sensory frame.
+	 * \exception std::exception If index is out of bounds or the entry is
+	 * not a CSensoryFrame */
+	CSensoryFrame::Ptr getAsObservations(size_t index) const;
+	/** Deserializes and returns the i'th entry as an action collection.
+	 * \exception std::exception If index is out of bounds or the entry is
+	 * not a CActionCollection */
+	CActionCollection::Ptr getAsAction(size_t index) const;
+
+	/** Returns the indices of all entries with a timestamp in the range
+	 * `[t0, t1]`, in ascending order of timestamps (in O(log N + M) time).
+	 * Entries with INVALID_TIMESTAMP are never returned. */
+	void findEntriesInTimeRange(
+		mrpt::system::TTimeStamp t0, mrpt::system::TTimeStamp t1,
+		std::vector<size_t>& outIndices) const;
+
+	/** Builds the index of an uncompressed rawlog file and saves it to
+	 * `indexFile`, or to getIndexFileName() if empty.
+	 * \return false on any error.
+	 */
+	static bool buildIndex(
+		const std::string& rawlogFile, const std::string& indexFile =
+										   std::string());
+	/** Returns the default index file name of a rawlog: `<rawlog>.idx` */
+	static std::string getIndexFileName(const std::string& rawlogFile);
+	/** Saves a CRawlog as an uncompressed rawlog file, along with its index.
+	 * \return false on any error.
+	 */
+	static bool saveRawlogWithIndex(
+		const CRawlog& rawlog, const std::string& rawlogFile);
+
+   private:
+	mrpt::io::CMemoryMappedFile m_file;
+	std::vector<TEntry> m_entries;
+	/** Indices of entries with valid timestamps, sorted by timestamp */
+	std::vector<size_t> m_sortedByTime;
+
+	static bool buildIndex(
+		const mrpt::io::CMemoryMappedFile& f, std::vector<TEntry>& entries);
+	static bool saveIndex(
+		const std::string& indexFile, const mrpt::io::CMemoryMappedFile& rawlog,
+		const std::vector<TEntry>& entries);
+	/** Returns false if the index file does not exist, or if it is stale,
+	 * i.e. the size or the fingerprint (a hash of the first and last blocks)
+	 * of `rawlog` do not match those stored in the index. */
+	static bool loadIndex(
+		const std::string& indexFile, const mrpt::io::CMemoryMappedFile& rawlog,
+		std::vector<TEntry>& entries);
+};
+
+}  // namespace mrpt::obs
@@ -945,7 +945,8 @@ bool CObservation3DRangeScan::doDepthAndIntensityCamerasCoincide() const
 
 void CObservation3DRangeScan::convertTo2DScan(
 	mrpt::obs::CObservation2DRangeScan& out_scan2d,
-	const T3DPointsTo2DScanParams& sp, const TRangeImageFilterParams& fp)
+	const T3DPointsTo2DScanParams& sp,
+	const TRangeImageFilterParams& fp) const
 {
 	out_scan2d.sensorLabel = sensorLabel;
 	out_scan2d.timestamp = this->timestamp;
@@ -1084,12 +1085,14 @@ void CObservation3DRangeScan::convertTo2DScan(
 		T3DPointsProjectionParams projParams;
 		projParams.takeIntoAccountSensorPoseOnRobot = true;
 
-		mrpt::opengl::CPointCloud::Ptr pc =
-			mrpt::make_aligned_shared<mrpt::opengl::CPointCloud>();
-		this->project3DPointsFromDepthImageInto(*pc, projParams, fp);
+		// Project without storing the pixel indices of the points, which
+		// would modify this observation:
+		mrpt::opengl::CPointCloud pc;
+		detail::project3DPointsFromDepthImageInto(
+			*this, pc, projParams, fp, nullptr, nullptr);
 
-		const std::vector<float>&xs = pc->getArrayX(), &ys = pc->getArrayY(),
-			  &zs = pc->getArrayZ();
+		const std::vector<float>&xs = pc.getArrayX(), &ys = pc.getArrayY(),
+			  &zs = pc.getArrayZ();
 		const size_t N = xs.size();
 
 		const double A_ang = FOV_equiv / (nLaserRays - 1);
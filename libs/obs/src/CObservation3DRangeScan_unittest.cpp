@@ -7,9 +7,13 @@
    | Released under BSD License. See details in http://www.mrpt.org/License |
    +------------------------------------------------------------------------+ */
 
+#include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/CObservation3DRangeScan.h>
+#include <mrpt/system/TaskScheduler.h>
 
 #include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
 
 using namespace mrpt;
 using namespace std;
@@ -51,6 +55,39 @@ TEST(CObservation3DRangeScan, Project3D_noFilter)
 	}
 }
 
+TEST(CObservation3DRangeScan, convertTo2DScanKeepsThePoints)
+{
+	mrpt::obs::T3DPointsProjectionParams pp;
+	mrpt::obs::CObservation3DRangeScan o;
+	fillSampleObs(o, pp, 1);
+	o.cameraParams.fx(30);
+	o.cameraParams.fy(30);
+	o.cameraParams.cx(TEST_RANGEIMG_WIDTH / 2.0);
+	o.cameraParams.cy(TEST_RANGEIMG_HEIGHT / 2.0);
+	o.maxRange = 10;
+	o.sensorPose = mrpt::poses::CPose3D(0.1, 0.2, 0.3, 0, 0, 0);
+	// The points of the observation, projected from a different image:
+	o.project3DPointsFromDepthImage();
+	const auto xs = o.points3D_x;
+	const auto idxs_x = o.points3D_idxs_x, idxs_y = o.points3D_idxs_y;
+	o.rangeImage.setConstant(2.0f);
+
+	// Reprojecting to the robot origin must not touch them:
+	mrpt::obs::T3DPointsTo2DScanParams sp;
+	sp.use_origin_sensor_pose = true;
+	mrpt::obs::CObservation2DRangeScan scan;
+	const auto& co = o;
+	co.convertTo2DScan(scan, sp);
+
+	EXPECT_TRUE(o.points3D_x == xs);
+	EXPECT_TRUE(o.points3D_idxs_x == idxs_x);
+	EXPECT_TRUE(o.points3D_idxs_y == idxs_y);
+	size_t nValid = 0;
+	for (size_t i = 0; i < scan.scan.size(); i++)
+		if (scan.validRange[i]) nValid++;
+	EXPECT_GT(nValid, 0U);
+}
+
 TEST(CObservation3DRangeScan, Project3D_filterMinMax1)
 {
 	mrpt::math::CMatrix fMax(TEST_RANGEIMG_HEIGHT, TEST_RANGEIMG_WIDTH),
@@ -183,3 +220,207 @@ TEST(CObservation3DRangeScan, Project3D_filterMax)
 										   << std::endl;
 	}
 }
+
+// An organized, colored point cloud, to test MAKE_DENSE=false:
+struct TTestPointCloud
+{
+	std::vector<float> x, y, z;
+	std::vector<uint8_t> R, G, B;
+	std::vector<bool> valid;
+};
+
+namespace mrpt::opengl
+{
+template <>
+class PointCloudAdapter<TTestPointCloud>
+{
+	TTestPointCloud& m_obj;
+
+   public:
+	using coords_t = float;
+	static const int HAS_RGB = 1;
+	static const int HAS_RGBf = 0;
+	static const int HAS_RGBu8 = 1;
+
+	PointCloudAdapter(TTestPointCloud& obj) : m_obj(obj) {}
+	size_t size() const { return m_obj.x.size(); }
+	void resize(const size_t N)
+	{
+		m_obj.x.resize(N);
+		m_obj.y.resize(N);
+		m_obj.z.resize(N);
+		m_obj.R.resize(N, 0);
+		m_obj.G.resize(N, 0);
+		m_obj.B.resize(N, 0);
+		m_obj.valid.resize(N, true);
+	}
+	void setPointXYZ(
+		const size_t idx, const coords_t x, const coords_t y, const coords_t z)
+	{
+		m_obj.x[idx] = x;
+		m_obj.y[idx] = y;
+		m_obj.z[idx] = z;
+	}
+	void setPointRGBu8(
+		const size_t idx, const uint8_t r, const uint8_t g, const uint8_t b)
+	{
+		m_obj.R[idx] = r;
+		m_obj.G[idx] = g;
+		m_obj.B[idx] = b;
+	}
+	void setInvalidPoint(const size_t idx) { m_obj.valid[idx] = false; }
+};
+}  // namespace mrpt::opengl
+
+TEST(CObservation3DRangeScan, Project3D_anyWidthAndThreads)
+{
+	// Width not multiple of 4, ranges and filters with random values:
+	const int W = 37, H = 21;
+	mrpt::math::CMatrix fMax(H, W), fMin(H, W);
+	fMin.setZero();
+	fMax.setZero();
+
+	mrpt::obs::CObservation3DRangeScan o;
+	o.hasRangeImage = true;
+	o.rangeImage_setSize(H, W);
+	o.cameraParams.fx(30);
+	o.cameraParams.fy(31);
+	o.cameraParams.cx(W / 2.0);
+	o.cameraParams.cy(H / 2.0);
+	unsigned int seed = 123;
+	auto rnd = [&seed]() {
+		seed = seed * 1103515245 + 12345;
+		return ((seed >> 16) & 0x7fff) / 32768.0f;
+	};
+	for (int r = 0; r < H; r++)
+		for (int c = 0; c < W; c++)
+		{
+			o.rangeImage(r, c) = rnd() < 0.2f ? 0 : 0.5f + 5 * rnd();
+			if (rnd() < 0.5f) fMin(r, c) = 0.5f + 2.5f * rnd();
+			if (rnd() < 0.5f) fMax(r, c) = 2.0f + 3 * rnd();
+		}
+#if MRPT_HAS_OPENCV  // CImage has no pixels without OpenCV
+	// A color image, with the same pixels than the depth image:
+	o.hasIntensityImage = true;
+	o.intensityImage = mrpt::img::CImage(W, H, mrpt::img::CH_RGB);
+	for (int r = 0; r < H; r++)
+		for (int c = 0; c < W; c++)
+		{
+			uint8_t* pix = o.intensityImage(c, r);
+			pix[0] = static_cast<uint8_t>(c);  // Blue
+			pix[1] = static_cast<uint8_t>(r);  // Green
+			pix[2] = static_cast<uint8_t>(c + r);  // Red
+		}
+	o.relativePoseIntensityWRTDepth = mrpt::poses::CPose3D(
+		0, 0, 0, mrpt::DEG2RAD(-90), 0, mrpt::DEG2RAD(-90));
+	ASSERT_TRUE(o.doDepthAndIntensityCamerasCoincide());
+#endif
+	const mrpt::poses::CPose3D sensorPose(0.1, 0.2, 0.3, 0.4, 0.5, 0.6);
+	o.sensorPose = sensorPose;
+
+	mrpt::obs::TRangeImageFilterParams fp;
+	fp.rangeMask_min = &fMin;
+	fp.rangeMask_max = &fMax;
+
+	// Make sure there are worker threads, even on single-core machines:
+	mrpt::system::TaskSchedulerThreadsGuard threads(4);
+
+	for (int i = 0; i < 32; i++)  // test all combinations of flags
+	{
+		mrpt::obs::T3DPointsProjectionParams pp;
+		pp.PROJ3D_USE_LUT = (i & 1) != 0;
+		pp.takeIntoAccountSensorPoseOnRobot = (i & 2) != 0;
+		fp.rangeCheckBetween = (i & 4) != 0;
+		o.range_is_depth = (i & 8) != 0;
+		pp.MAKE_DENSE = (i & 16) == 0;
+
+		// Reference: no SSE2, one thread
+		pp.USE_SSE2 = false;
+		pp.num_threads = 1;
+		mrpt::obs::CObservation3DRangeScan refObs = o;
+		TTestPointCloud ref;
+		refObs.project3DPointsFromDepthImageInto(ref, pp, fp);
+
+		// Check the points against their analytic values:
+		const mrpt::obs::TRangeImageFilter rif(fp);
+		size_t nValid = 0, k = 0;
+		for (int r = 0; r < H; r++)
+			for (int c = 0; c < W; c++)
+			{
+				const float D = o.rangeImage(r, c);
+				const bool valid = rif.do_range_filter(r, c, D);
+				if (!valid && pp.MAKE_DENSE) continue;
+				ASSERT_LT(k, ref.x.size()) << " testcase: i=" << i;
+				EXPECT_EQ(refObs.points3D_idxs_x[k], c);
+				EXPECT_EQ(refObs.points3D_idxs_y[k], r);
+				ASSERT_EQ(ref.valid[k], valid) << " testcase: i=" << i;
+				if (valid)
+				{
+					nValid++;
+					const double Ky = (W / 2.0 - c) / 30.0,
+								 Kz = (H / 2.0 - r) / 31.0;
+					const double x = o.range_is_depth
+										 ? D
+										 : D / std::sqrt(1 + Ky * Ky + Kz * Kz);
+					mrpt::math::TPoint3D pt(x, Ky * D, Kz * D);
+					if (pp.takeIntoAccountSensorPoseOnRobot)
+						sensorPose.composePoint(pt, pt);
+					const double tol = 1e-4 * (1 + D);
+					EXPECT_NEAR(ref.x[k], pt.x, tol) << "i=" << i << " k=" << k;
+					EXPECT_NEAR(ref.y[k], pt.y, tol) << "i=" << i << " k=" << k;
+					EXPECT_NEAR(ref.z[k], pt.z, tol) << "i=" << i << " k=" << k;
+#if MRPT_HAS_OPENCV
+					EXPECT_EQ(ref.R[k], c + r);
+					EXPECT_EQ(ref.G[k], r);
+					EXPECT_EQ(ref.B[k], c);
+#endif
+				}
+				k++;
+			}
+		EXPECT_EQ(ref.x.size(), k) << " testcase: i=" << i;
+		EXPECT_EQ(ref.x.size(), pp.MAKE_DENSE ? nValid : size_t(W * H));
+
+		pp.USE_SSE2 = true;
+		for (const unsigned int nThreads : {1U, 0U, 4U})
+		{
+			pp.num_threads = nThreads;
+			mrpt::obs::CObservation3DRangeScan o2 = o;
+			TTestPointCloud pc;
+			o2.project3DPointsFromDepthImageInto(pc, pp, fp);
+			ASSERT_EQ(pc.x.size(), ref.x.size())
+				<< " testcase: i=" << i << " nThreads=" << nThreads;
+			for (size_t k = 0; k < ref.x.size(); k++)
+			{
+				EXPECT_EQ(pc.valid[k], ref.valid[k]);
+				EXPECT_EQ(o2.points3D_idxs_x[k], refObs.points3D_idxs_x[k]);
+				EXPECT_EQ(o2.points3D_idxs_y[k], refObs.points3D_idxs_y[k]);
+				if (!ref.valid[k]) continue;
+				EXPECT_EQ(pc.x[k], ref.x[k]);
+				EXPECT_EQ(pc.y[k], ref.y[k]);
+				EXPECT_EQ(pc.z[k], ref.z[k]);
+				EXPECT_EQ(pc.R[k], ref.R[k]);
+				EXPECT_EQ(pc.G[k], ref.G[k]);
+				EXPECT_EQ(pc.B[k], ref.B[k]);
+			}
+		}
+
+		// Point clouds which must be dense:
+		if (pp.MAKE_DENSE)
+		{
+			mrpt::obs::CObservation3DRangeScan o3 = o;
+			o3.project3DPointsFromDepthImageInto(o3, pp, fp);
+			ASSERT_EQ(o3.points3D_x.size(), nValid);
+			for (size_t k = 0; k < nValid; k++)
+			{
+				EXPECT_EQ(o3.points3D_x[k], ref.x[k]);
+				EXPECT_EQ(o3.points3D_y[k], ref.y[k]);
+				EXPECT_EQ(o3.points3D_z[k], ref.z[k]);
+			}
+		}
+		else
+		{
+			mrpt::obs::CObservation3DRangeScan o3 = o;
+			EXPECT_ANY_THROW(o3.project3DPointsFromDepthImageInto(o3, pp, fp));
+		}
+	}
+}
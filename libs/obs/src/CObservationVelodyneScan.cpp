@@ -13,6 +13,9 @@
 #include <mrpt/poses/CPose3DInterpolator.h>
 #include <mrpt/core/round.h>
 #include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/TaskScheduler.h>
+#include <algorithm>
+#include <array>
 #include <iostream>
 
 using namespace std;
@@ -136,21 +139,56 @@ double VLP16AdjustTimeStamp(int firingblock, int dsr, int firingwithinblock)
 		   (firingwithinblock * VLP16_FIRING_TOFFSET);
 }
 
-/** Auxiliary class used to refactor
- * CObservationVelodyneScan::generatePointCloud() */
-struct PointCloudStorageWrapper
+namespace
 {
-	/** Process the insertion of a new (x,y,z) point to the cloud, in
-	 * sensor-centric coordinates, with the exact timestamp of that LIDAR ray */
-	virtual void add_point(
-		double pt_x, double pt_y, double pt_z, uint8_t pt_intensity,
-		const mrpt::system::TTimeStamp& tim, const float azimuth) = 0;
+/** Max. number of points decoded from one packet */
+constexpr size_t MAX_POINTS_PER_PACKET =
+	CObservationVelodyneScan::BLOCKS_PER_PACKET * SCANS_PER_FIRING;
+
+/** Preallocated buffers (structure of arrays) where
+ * velodyne_scan_to_pointcloud() writes the points, in sensor-centric
+ * coordinates. The i'th packet writes its points starting at index
+ * `i*MAX_POINTS_PER_PACKET`. `azimuth` may be nullptr if not needed. */
+struct TDecodedPoints
+{
+	float *x, *y, *z, *azimuth;
+	uint8_t* intensity;
 };
+}  // namespace
+
+/** Timestamp of one packet */
+static mrpt::system::TTimeStamp velodyne_packet_timestamp(
+	const CObservationVelodyneScan& scan, const size_t iPkt)
+{
+	const uint32_t us_pkt0 = scan.scan_packets[0].gps_timestamp;
+	const uint32_t us_pkt_this = scan.scan_packets[iPkt].gps_timestamp;
+	// Handle the case of time counter reset by new hour 00:00:00
+	const uint32_t us_ellapsed =
+		(us_pkt_this >= us_pkt0)
+			? (us_pkt_this - us_pkt0)
+			: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
+	return mrpt::system::timestampAdd(scan.timestamp, us_ellapsed * 1e-6);
+}
+
+/** Max. number of parallel tasks to process `nPkts` packets: each task
+ * takes several packets, so it is worth the scheduling overhead. */
+static size_t velodyne_max_chunks(
+	const CObservationVelodyneScan::TGeneratePointCloudParameters& params,
+	const size_t nPkts)
+{
+	const size_t MIN_PACKETS_PER_CHUNK = 16;
+	size_t maxChunks = std::max<size_t>(1, nPkts / MIN_PACKETS_PER_CHUNK);
+	if (params.num_threads != 0)
+		maxChunks = std::min<size_t>(maxChunks, params.num_threads);
+	return maxChunks;
+}
 
+/** Decodes all packets, in parallel, into `out`. Upon return,
+ * `out_counts[i]` holds the number of points of the i'th packet. */
 static void velodyne_scan_to_pointcloud(
 	const CObservationVelodyneScan& scan,
 	const CObservationVelodyneScan::TGeneratePointCloudParameters& params,
-	PointCloudStorageWrapper& out_pc)
+	const TDecodedPoints& out, std::vector<size_t>& out_counts)
 {
 	// Initially based on code from ROS velodyne & from
 	// vtkVelodyneHDLReader::vtkInternal::ProcessHDLPacket().
@@ -165,6 +203,8 @@ static void velodyne_scan_to_pointcloud(
 	// deg ... -180 deg]
 	const CSinCosLookUpTableFor2DScans::TSinCosValues& lut_sincos =
 		velodyne_sincos_tables.getSinCosForScan(scan_props);
+	const float* lut_cos = &lut_sincos.ccos[0];
+	const float* lut_sin = &lut_sincos.csin[0];
 
 	const int minAzimuth_int = round(params.minAzimuth_deg * 100);
 	const int maxAzimuth_int = round(params.maxAzimuth_deg * 100);
@@ -179,52 +219,54 @@ static void velodyne_scan_to_pointcloud(
 	// This is: 16,32,64 depending on the LIDAR model
 	const size_t num_lasers = scan.calibration.laser_corrections.size();
 
-	for (size_t iPkt = 0; iPkt < scan.scan_packets.size(); iPkt++)
+	// Per-laser calibration, in contiguous arrays and with the same data
+	// types used below to compute the points:
+	std::vector<double> calib_dist(num_lasers);
+	std::vector<float> calib_cos_vert(num_lasers), calib_sin_vert(num_lasers),
+		calib_horz_offset(num_lasers), calib_vert_offset(num_lasers);
+	for (size_t i = 0; i < num_lasers; i++)
 	{
+		const auto& c = scan.calibration.laser_corrections[i];
+		calib_dist[i] = c.distanceCorrection;
+		calib_cos_vert[i] = c.cosVertCorrection;
+		calib_sin_vert[i] = c.sinVertCorrection;
+		calib_horz_offset[i] = c.horizontalOffsetCorrection;
+		calib_vert_offset[i] = c.verticalOffsetCorrection;
+	}
+
+	const size_t nPkts = scan.scan_packets.size();
+	out_counts.assign(nPkts, 0);
+
+	auto decode_packet = [&](const size_t iPkt) {
 		const CObservationVelodyneScan::TVelodyneRawPacket* raw =
 			&scan.scan_packets[iPkt];
+		const size_t first_idx = iPkt * MAX_POINTS_PER_PACKET;
+		size_t nPts = 0;
 
-		mrpt::system::TTimeStamp pkt_tim;  // Find out timestamp of this pkt
-		{
-			const uint32_t us_pkt0 = scan.scan_packets[0].gps_timestamp;
-			const uint32_t us_pkt_this = raw->gps_timestamp;
-			// Handle the case of time counter reset by new hour 00:00:00
-			const uint32_t us_ellapsed =
-				(us_pkt_this >= us_pkt0)
-					? (us_pkt_this - us_pkt0)
-					: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
-			pkt_tim =
-				mrpt::system::timestampAdd(scan.timestamp, us_ellapsed * 1e-6);
-		}
+		// In dual return, the azimuth rate is actually twice this
+		// estimation:
+		const bool dual_mode =
+			(raw->laser_return_mode == CObservationVelodyneScan::RETMODE_DUAL);
 
 		// Take the median rotational speed as a good value for interpolating
 		// the missing azimuths:
 		int median_azimuth_diff;
 		{
-			// In dual return, the azimuth rate is actually twice this
-			// estimation:
-			const int nBlocksPerAzimuth =
-				(raw->laser_return_mode ==
-				 CObservationVelodyneScan::RETMODE_DUAL)
-					? 2
-					: 1;
-			std::vector<int> diffs(
-				CObservationVelodyneScan::BLOCKS_PER_PACKET -
-				nBlocksPerAzimuth);
-			for (int i = 0; i < CObservationVelodyneScan::BLOCKS_PER_PACKET -
-									nBlocksPerAzimuth;
-				 ++i)
+			const int nBlocksPerAzimuth = dual_mode ? 2 : 1;
+			const int nDiffs =
+				CObservationVelodyneScan::BLOCKS_PER_PACKET - nBlocksPerAzimuth;
+			std::array<int, CObservationVelodyneScan::BLOCKS_PER_PACKET> diffs;
+			for (int i = 0; i < nDiffs; ++i)
 			{
-				int localDiff = (CObservationVelodyneScan::ROTATION_MAX_UNITS +
-								 raw->blocks[i + nBlocksPerAzimuth].rotation -
-								 raw->blocks[i].rotation) %
-								CObservationVelodyneScan::ROTATION_MAX_UNITS;
-				diffs[i] = localDiff;
+				diffs[i] = (CObservationVelodyneScan::ROTATION_MAX_UNITS +
+							raw->blocks[i + nBlocksPerAzimuth].rotation -
+							raw->blocks[i].rotation) %
+						   CObservationVelodyneScan::ROTATION_MAX_UNITS;
 			}
 			std::nth_element(
 				diffs.begin(),
 				diffs.begin() + CObservationVelodyneScan::BLOCKS_PER_PACKET / 2,
-				diffs.end());  // Calc median
+				diffs.begin() + nDiffs);  // Calc median
 			median_azimuth_diff =
 				diffs[CObservationVelodyneScan::BLOCKS_PER_PACKET / 2];
 		}
@@ -232,46 +274,37 @@ static void velodyne_scan_to_pointcloud(
 		for (int block = 0; block < CObservationVelodyneScan::BLOCKS_PER_PACKET;
 			 block++)  // Firings per packet
 		{
+			const CObservationVelodyneScan::raw_block_t& blk =
+				raw->blocks[block];
 			// ignore packets with mangled or otherwise different contents
 			if ((num_lasers != 64 &&
-				 CObservationVelodyneScan::UPPER_BANK !=
-					 raw->blocks[block].header) ||
-				(raw->blocks[block].header !=
-					 CObservationVelodyneScan::UPPER_BANK &&
-				 raw->blocks[block].header !=
-					 CObservationVelodyneScan::LOWER_BANK))
+				 CObservationVelodyneScan::UPPER_BANK != blk.header) ||
+				(blk.header != CObservationVelodyneScan::UPPER_BANK &&
+				 blk.header != CObservationVelodyneScan::LOWER_BANK))
 			{
 				cerr << "[CObservationVelodyneScan] skipping invalid packet: "
 						"block "
-					 << block << " header value is "
-					 << raw->blocks[block].header;
+					 << block << " header value is " << blk.header;
 				continue;
 			}
 
-			const int dsr_offset = (raw->blocks[block].header ==
-									CObservationVelodyneScan::LOWER_BANK)
-									   ? 32
-									   : 0;
-			const float azimuth_raw_f = (float)(raw->blocks[block].rotation);
+			const int dsr_offset =
+				(blk.header == CObservationVelodyneScan::LOWER_BANK) ? 32 : 0;
+			const float azimuth_raw_f = (float)(blk.rotation);
 			const bool block_is_dual_2nd_ranges =
-				(raw->laser_return_mode ==
-					 CObservationVelodyneScan::RETMODE_DUAL &&
-				 ((block & 0x01) != 0));
+				(dual_mode && ((block & 0x01) != 0));
 			const bool block_is_dual_last_ranges =
-				(raw->laser_return_mode ==
-					 CObservationVelodyneScan::RETMODE_DUAL &&
-				 ((block & 0x01) == 0));
-
-			for (int dsr = 0, k = 0; dsr < SCANS_PER_FIRING; dsr++, k++)
+				(dual_mode && ((block & 0x01) == 0));
+
+			// Laser ids, and azimuth correction for the laser rotation as a
+			// function of timing during the firings. They are the same for
+			// all the returns of a laser within this block:
+			uint8_t laser_ids[SCANS_PER_FIRING];
+			int azimuth_adjustments[SCANS_PER_FIRING];
+			bool known_model = true;
+			for (int dsr = 0; dsr < SCANS_PER_FIRING; dsr++)
 			{
-				if (!raw->blocks[block]
-						 .laser_returns[k]
-						 .distance)  // Invalid return?
-					continue;
-
-				const uint8_t rawLaserId =
-					static_cast<uint8_t>(dsr + dsr_offset);
-				uint8_t laserId = rawLaserId;
+				uint8_t laserId = static_cast<uint8_t>(dsr + dsr_offset);
 
 				// Detect VLP-16 data and adjust laser id if necessary
 				bool firingWithinBlock = false;
@@ -283,16 +316,53 @@ static void velodyne_scan_to_pointcloud(
 						firingWithinBlock = true;
 					}
 				}
+				laser_ids[dsr] = laserId;
 
+				double timestampadjustment =
+					0.0;  // [us] since beginning of scan
+				double blockdsr0 = 0.0;
+				double nextblockdsr0 = 1.0;
+				switch (num_lasers)
+				{
+					// VLP-16
+					case 16:
+					{
+						const int fblock = dual_mode ? block / 2 : block;
+						timestampadjustment = VLP16AdjustTimeStamp(
+							fblock, laserId, firingWithinBlock);
+						nextblockdsr0 = VLP16AdjustTimeStamp(fblock + 1, 0, 0);
+						blockdsr0 = VLP16AdjustTimeStamp(fblock, 0, 0);
+					}
+					break;
+					// HDL-32:
+					case 32:
+						timestampadjustment = HDL32AdjustTimeStamp(block, dsr);
+						nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
+						blockdsr0 = HDL32AdjustTimeStamp(block, 0);
+						break;
+					case 64:
+						break;
+					default:
+						known_model = false;
+				};
+				azimuth_adjustments[dsr] = mrpt::round(
+					median_azimuth_diff * ((timestampadjustment - blockdsr0) /
+										   (nextblockdsr0 - blockdsr0)));
+			}
+
+			for (int dsr = 0, k = 0; dsr < SCANS_PER_FIRING; dsr++, k++)
+			{
+				const uint16_t raw_dist = blk.laser_returns[k].distance;
+				if (!raw_dist) continue;  // Invalid return?
+
+				const uint8_t laserId = laser_ids[dsr];
 				ASSERT_BELOW_(laserId, num_lasers);
-				const mrpt::obs::VelodyneCalibration::PerLaserCalib& calib =
-					scan.calibration.laser_corrections[laserId];
 
 				// In dual return, if the distance is equal in both ranges,
 				// ignore one of them:
 				if (block_is_dual_2nd_ranges)
 				{
-					if (raw->blocks[block].laser_returns[k].distance ==
+					if (raw_dist ==
 						raw->blocks[block - 1].laser_returns[k].distance)
 						continue;  // duplicated point
 					if (!params.dualKeepStrongest) continue;
@@ -301,21 +371,19 @@ static void velodyne_scan_to_pointcloud(
 
 				// Return distance:
 				const float distance =
-					raw->blocks[block].laser_returns[k].distance *
-						CObservationVelodyneScan::DISTANCE_RESOLUTION +
-					calib.distanceCorrection;
+					raw_dist * CObservationVelodyneScan::DISTANCE_RESOLUTION +
+					calib_dist[laserId];
 				if (distance < realMinDist || distance > realMaxDist) continue;
 
 				// Isolated points filtering:
 				if (params.filterOutIsolatedPoints)
 				{
 					bool pass_filter = true;
-					const int16_t dist_this =
-						raw->blocks[block].laser_returns[k].distance;
+					const int16_t dist_this = raw_dist;
 					if (k > 0)
 					{
 						const int16_t dist_prev =
-							raw->blocks[block].laser_returns[k - 1].distance;
+							blk.laser_returns[k - 1].distance;
 						if (!dist_prev ||
 							std::abs(dist_this - dist_prev) >
 								isolatedPointsFilterDistance_units)
@@ -324,7 +392,7 @@ static void velodyne_scan_to_pointcloud(
 					if (k < (SCANS_PER_FIRING - 1))
 					{
 						const int16_t dist_next =
-							raw->blocks[block].laser_returns[k + 1].distance;
+							blk.laser_returns[k + 1].distance;
 						if (!dist_next ||
 							std::abs(dist_this - dist_next) >
 								isolatedPointsFilterDistance_units)
@@ -333,56 +401,11 @@ static void velodyne_scan_to_pointcloud(
 					if (!pass_filter) continue;  // Filter out this point
 				}
 
-				// Azimuth correction: correct for the laser rotation as a
-				// function of timing during the firings
-				double timestampadjustment =
-					0.0;  // [us] since beginning of scan
-				double blockdsr0 = 0.0;
-				double nextblockdsr0 = 1.0;
-				switch (num_lasers)
-				{
-					// VLP-16
-					case 16:
-					{
-						if (raw->laser_return_mode ==
-							CObservationVelodyneScan::RETMODE_DUAL)
-						{
-							timestampadjustment = VLP16AdjustTimeStamp(
-								block / 2, laserId, firingWithinBlock);
-							nextblockdsr0 =
-								VLP16AdjustTimeStamp(block / 2 + 1, 0, 0);
-							blockdsr0 = VLP16AdjustTimeStamp(block / 2, 0, 0);
-						}
-						else
-						{
-							timestampadjustment = VLP16AdjustTimeStamp(
-								block, laserId, firingWithinBlock);
-							nextblockdsr0 =
-								VLP16AdjustTimeStamp(block + 1, 0, 0);
-							blockdsr0 = VLP16AdjustTimeStamp(block, 0, 0);
-						}
-					}
-					break;
-					// HDL-32:
-					case 32:
-						timestampadjustment = HDL32AdjustTimeStamp(block, dsr);
-						nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
-						blockdsr0 = HDL32AdjustTimeStamp(block, 0);
-						break;
-					case 64:
-						break;
-					default:
-					{
-						THROW_EXCEPTION("Error: unhandled LIDAR model!");
-					}
-				};
-
-				const int azimuthadjustment = mrpt::round(
-					median_azimuth_diff * ((timestampadjustment - blockdsr0) /
-										   (nextblockdsr0 - blockdsr0)));
+				if (!known_model)
+					THROW_EXCEPTION("Error: unhandled LIDAR model!");
 
 				const float azimuth_corrected_f =
-					azimuth_raw_f + azimuthadjustment;
+					azimuth_raw_f + azimuth_adjustments[dsr];
 				const int azimuth_corrected =
 					((int)round(azimuth_corrected_f)) %
 					CObservationVelodyneScan::ROTATION_MAX_UNITS;
@@ -397,10 +420,10 @@ static void velodyne_scan_to_pointcloud(
 					continue;
 
 				// Vertical axis mis-alignment calibration:
-				const float cos_vert_angle = calib.cosVertCorrection;
-				const float sin_vert_angle = calib.sinVertCorrection;
-				const float horz_offset = calib.horizontalOffsetCorrection;
-				const float vert_offset = calib.verticalOffsetCorrection;
+				const float cos_vert_angle = calib_cos_vert[laserId];
+				const float sin_vert_angle = calib_sin_vert[laserId];
+				const float horz_offset = calib_horz_offset[laserId];
+				const float vert_offset = calib_vert_offset[laserId];
 
 				float xy_distance = distance * cos_vert_angle;
 				if (vert_offset) xy_distance += vert_offset * sin_vert_angle;
@@ -409,86 +432,121 @@ static void velodyne_scan_to_pointcloud(
 					(azimuth_corrected +
 					 (CObservationVelodyneScan::ROTATION_MAX_UNITS / 2)) %
 					CObservationVelodyneScan::ROTATION_MAX_UNITS;
-				const float cos_azimuth =
-					lut_sincos.ccos[azimuth_corrected_for_lut];
-				const float sin_azimuth =
-					lut_sincos.csin[azimuth_corrected_for_lut];
+				const float cos_azimuth = lut_cos[azimuth_corrected_for_lut];
+				const float sin_azimuth = lut_sin[azimuth_corrected_for_lut];
 
 				// Compute raw position
-				const mrpt::math::TPoint3Df pt(
+				const float pt_x =
 					xy_distance * cos_azimuth +
-						horz_offset * sin_azimuth,  // MRPT +X = Velodyne +Y
+					horz_offset * sin_azimuth;  // MRPT +X = Velodyne +Y
+				const float pt_y =
 					-(xy_distance * sin_azimuth -
-					  horz_offset * cos_azimuth),  // MRPT +Y = Velodyne -X
-					distance * sin_vert_angle + vert_offset);
+					  horz_offset * cos_azimuth);  // MRPT +Y = Velodyne -X
+				const float pt_z = distance * sin_vert_angle + vert_offset;
 
-				bool add_point = true;
 				if (params.filterByROI &&
-					(pt.x > params.ROI_x_max || pt.x < params.ROI_x_min ||
-					 pt.y > params.ROI_y_max || pt.y < params.ROI_y_min ||
-					 pt.z > params.ROI_z_max || pt.z < params.ROI_z_min))
-					add_point = false;
+					(pt_x > params.ROI_x_max || pt_x < params.ROI_x_min ||
+					 pt_y > params.ROI_y_max || pt_y < params.ROI_y_min ||
+					 pt_z > params.ROI_z_max || pt_z < params.ROI_z_min))
+					continue;
 
 				if (params.filterBynROI &&
-					(pt.x <= params.nROI_x_max && pt.x >= params.nROI_x_min &&
-					 pt.y <= params.nROI_y_max && pt.y >= params.nROI_y_min &&
-					 pt.z <= params.nROI_z_max && pt.z >= params.nROI_z_min))
-					add_point = false;
-
-				if (!add_point) continue;
+					(pt_x <= params.nROI_x_max && pt_x >= params.nROI_x_min &&
+					 pt_y <= params.nROI_y_max && pt_y >= params.nROI_y_min &&
+					 pt_z <= params.nROI_z_max && pt_z >= params.nROI_z_min))
+					continue;
 
 				// Insert point:
-				out_pc.add_point(
-					pt.x, pt.y, pt.z,
-					raw->blocks[block].laser_returns[k].intensity, pkt_tim,
-					azimuth_corrected_f);
-
+				const size_t idx = first_idx + nPts++;
+				out.x[idx] = pt_x;
+				out.y[idx] = pt_y;
+				out.z[idx] = pt_z;
+				out.intensity[idx] = blk.laser_returns[k].intensity;
+				if (out.azimuth)
+					out.azimuth[idx] =
+						azimuth_corrected *
+						CObservationVelodyneScan::ROTATION_RESOLUTION;
 			}  // end for k,dsr=[0,31]
 		}  // end for each block [0,11]
-	}  // end for each data packet
+
+		out_counts[iPkt] = nPts;
+	};
+
+	// Packets are independent, and each one writes to its own slot of the
+	// output buffers, so the result does not depend on the number of threads:
+	mrpt::system::parallel_for_chunks(
+		nPkts,
+		[&](const size_t first, const size_t last) {
+			for (size_t iPkt = first; iPkt < last; iPkt++)
+				decode_packet(iPkt);
+		},
+		velodyne_max_chunks(params, nPkts));
 }
 
-void CObservationVelodyneScan::generatePointCloud(
-	const TGeneratePointCloudParameters& params)
+/** Moves the points of each packet in `v` (see TDecodedPoints) right after
+ * those of the previous packet, and drops the unused space at the end. */
+template <typename T>
+static void compact_packet_slots(
+	std::vector<T>& v, const std::vector<size_t>& counts)
 {
-	struct PointCloudStorageWrapper_Inner : public PointCloudStorageWrapper
+	size_t n = 0;
+	for (size_t iPkt = 0; iPkt < counts.size(); iPkt++)
 	{
-		CObservationVelodyneScan& me_;
-		const TGeneratePointCloudParameters& params_;
-		PointCloudStorageWrapper_Inner(
-			CObservationVelodyneScan& me,
-			const TGeneratePointCloudParameters& p)
-			: me_(me), params_(p)
-		{
-			// Reset point cloud:
-			me_.point_cloud.clear();
-		}
-		void add_point(
-			double pt_x, double pt_y, double pt_z, uint8_t pt_intensity,
-			const mrpt::system::TTimeStamp& tim, const float azimuth) override
-		{
-			me_.point_cloud.x.push_back(pt_x);
-			me_.point_cloud.y.push_back(pt_y);
-			me_.point_cloud.z.push_back(pt_z);
-			me_.point_cloud.intensity.push_back(pt_intensity);
-			if (params_.generatePerPointTimestamp)
-			{
-				me_.point_cloud.timestamp.push_back(tim);
-			}
-			if (params_.generatePerPointAzimuth)
-			{
-				const int azimuth_corrected =
-					((int)round(azimuth)) %
-					CObservationVelodyneScan::ROTATION_MAX_UNITS;
-				me_.point_cloud.azimuth.push_back(
-					azimuth_corrected * ROTATION_RESOLUTION);
-			}
-		}
-	};
+		const size_t first = iPkt * MAX_POINTS_PER_PACKET;
+		if (n != first)
+			std::copy(
+				v.begin() + first, v.begin() + first + counts[iPkt],
+				v.begin() + n);
+		n += counts[iPkt];
+	}
+	v.resize(n);
+}
 
-	PointCloudStorageWrapper_Inner my_pc_wrap(*this, params);
+void CObservationVelodyneScan::generatePointCloud(
+	const TGeneratePointCloudParameters& params)
+{
+	generatePointCloud(point_cloud, params);
+}
 
-	velodyne_scan_to_pointcloud(*this, params, my_pc_wrap);
+void CObservationVelodyneScan::generatePointCloud(
+	TPointCloud& out_cloud, const TGeneratePointCloudParameters& params) const
+{
+	// Decode straight into the point cloud vectors:
+	const size_t nPkts = scan_packets.size();
+	const size_t nMaxPts = nPkts * MAX_POINTS_PER_PACKET;
+	out_cloud.clear();
+	out_cloud.x.resize(nMaxPts);
+	out_cloud.y.resize(nMaxPts);
+	out_cloud.z.resize(nMaxPts);
+	out_cloud.intensity.resize(nMaxPts);
+	if (params.generatePerPointAzimuth) out_cloud.azimuth.resize(nMaxPts);
+
+	TDecodedPoints out;
+	out.x = out_cloud.x.data();
+	out.y = out_cloud.y.data();
+	out.z = out_cloud.z.data();
+	out.intensity = out_cloud.intensity.data();
+	out.azimuth =
+		params.generatePerPointAzimuth ? out_cloud.azimuth.data() : nullptr;
+
+	std::vector<size_t> counts;
+	velodyne_scan_to_pointcloud(*this, params, out, counts);
+
+	compact_packet_slots(out_cloud.x, counts);
+	compact_packet_slots(out_cloud.y, counts);
+	compact_packet_slots(out_cloud.z, counts);
+	compact_packet_slots(out_cloud.intensity, counts);
+	if (params.generatePerPointAzimuth)
+		compact_packet_slots(out_cloud.azimuth, counts);
+
+	if (params.generatePerPointTimestamp)
+	{
+		out_cloud.timestamp.reserve(out_cloud.x.size());
+		for (size_t iPkt = 0; iPkt < nPkts; iPkt++)
+			out_cloud.timestamp.insert(
+				out_cloud.timestamp.end(), counts[iPkt],
+				velodyne_packet_timestamp(*this, iPkt));
+	}
 }
 
 void CObservationVelodyneScan::generatePointCloudAlongSE3Trajectory(
@@ -497,64 +555,74 @@ void CObservationVelodyneScan::generatePointCloudAlongSE3Trajectory(
 	TGeneratePointCloudSE3Results& results_stats,
 	const TGeneratePointCloudParameters& params)
 {
-	// Pre-alloc mem:
-	out_points.reserve(
-		out_points.size() +
-		scan_packets.size() * BLOCKS_PER_PACKET * SCANS_PER_BLOCK + 16);
-
-	struct PointCloudStorageWrapper_SE3_Interp : public PointCloudStorageWrapper
+	// 1) Points in sensor-centric coordinates:
+	const size_t nPkts = scan_packets.size();
+	const size_t nMaxPts = nPkts * MAX_POINTS_PER_PACKET;
+	std::vector<float> xs(nMaxPts), ys(nMaxPts), zs(nMaxPts);
+	std::vector<uint8_t> intensities(nMaxPts);
+	TDecodedPoints pts;
+	pts.x = xs.data();
+	pts.y = ys.data();
+	pts.z = zs.data();
+	pts.intensity = intensities.data();
+	pts.azimuth = nullptr;
+
+	std::vector<size_t> counts;
+	velodyne_scan_to_pointcloud(*this, params, pts, counts);
+
+	// 2) All the points of a packet share the same timestamp, so the vehicle
+	// path is interpolated once per packet:
+	std::vector<mrpt::poses::CPose3D> sensor_poses(nPkts);
+	std::vector<uint8_t> pose_valid(nPkts, 0);
+	std::vector<size_t> out_offsets(nPkts, 0);
+	size_t nOut = out_points.size();
+	for (size_t iPkt = 0; iPkt < nPkts; iPkt++)
 	{
-		CObservationVelodyneScan& me_;
-		const mrpt::poses::CPose3DInterpolator& vehicle_path_;
-		std::vector<mrpt::math::TPointXYZIu8>& out_points_;
-		TGeneratePointCloudSE3Results& results_stats_;
-		mrpt::system::TTimeStamp last_query_tim_;
-		mrpt::poses::CPose3D last_query_;
-		bool last_query_valid_;
-
-		PointCloudStorageWrapper_SE3_Interp(
-			CObservationVelodyneScan& me,
-			const mrpt::poses::CPose3DInterpolator& vehicle_path,
-			std::vector<mrpt::math::TPointXYZIu8>& out_points,
-			TGeneratePointCloudSE3Results& results_stats)
-			: me_(me),
-			  vehicle_path_(vehicle_path),
-			  out_points_(out_points),
-			  results_stats_(results_stats),
-			  last_query_tim_(INVALID_TIMESTAMP),
-			  last_query_valid_(false)
-		{
-		}
-		void add_point(
-			double pt_x, double pt_y, double pt_z, uint8_t pt_intensity,
-			const mrpt::system::TTimeStamp& tim, const float azimuth) override
-		{
-			// Use a cache since it's expected that the same timestamp is
-			// queried several times in a row:
-			if (last_query_tim_ != tim)
-			{
-				last_query_tim_ = tim;
-				vehicle_path_.interpolate(tim, last_query_, last_query_valid_);
-			}
+		results_stats.num_points += counts[iPkt];
+		if (!counts[iPkt]) continue;
+
+		mrpt::poses::CPose3D vehicle_pose;
+		bool valid = false;
+		vehicle_path.interpolate(
+			velodyne_packet_timestamp(*this, iPkt), vehicle_pose, valid);
+		if (!valid) continue;
+
+		pose_valid[iPkt] = 1;
+		sensor_poses[iPkt].composeFrom(vehicle_pose, sensorPose);
+		out_offsets[iPkt] = nOut;
+		nOut += counts[iPkt];
+		results_stats.num_correctly_inserted_points += counts[iPkt];
+	}
 
-			if (last_query_valid_)
+	// 3) Transform the points to the global frame:
+	out_points.resize(nOut);
+	mrpt::system::parallel_for_chunks(
+		nPkts,
+		[&](const size_t firstPkt, const size_t lastPkt) {
+			for (size_t iPkt = firstPkt; iPkt < lastPkt; iPkt++)
 			{
-				mrpt::poses::CPose3D global_sensor_pose(
-					mrpt::poses::UNINITIALIZED_POSE);
-				global_sensor_pose.composeFrom(last_query_, me_.sensorPose);
-				double gx, gy, gz;
-				global_sensor_pose.composePoint(pt_x, pt_y, pt_z, gx, gy, gz);
-				out_points_.push_back(
-					mrpt::math::TPointXYZIu8(gx, gy, gz, pt_intensity));
-				++results_stats_.num_correctly_inserted_points;
+				if (!pose_valid[iPkt] || !counts[iPkt]) continue;
+				const mrpt::poses::CPose3D& p = sensor_poses[iPkt];
+				const auto& R = p.getRotationMatrix();
+				const double r00 = R(0, 0), r01 = R(0, 1), r02 = R(0, 2),
+							 r10 = R(1, 0), r11 = R(1, 1), r12 = R(1, 2),
+							 r20 = R(2, 0), r21 = R(2, 1), r22 = R(2, 2);
+				const double tx = p.x(), ty = p.y(), tz = p.z();
+				const size_t first = iPkt * MAX_POINTS_PER_PACKET;
+				mrpt::math::TPointXYZIu8* dst =
+					out_points.data() + out_offsets[iPkt];
+				for (size_t i = first; i < first + counts[iPkt]; i++, dst++)
+				{
+					// Same operations than CPose3D::composePoint():
+					const double lx = xs[i], ly = ys[i], lz = zs[i];
+					dst->pt.x = r00 * lx + r01 * ly + r02 * lz + tx;
+					dst->pt.y = r10 * lx + r11 * ly + r12 * lz + ty;
+					dst->pt.z = r20 * lx + r21 * ly + r22 * lz + tz;
+					dst->intensity = intensities[i];
+				}
 			}
-			++results_stats_.num_points;
-		}
-	};
-
-	PointCloudStorageWrapper_SE3_Interp my_pc_wrap(
-		*this, vehicle_path, out_points, results_stats);
-	velodyne_scan_to_pointcloud(*this, params, my_pc_wrap);
+		},
+		velodyne_max_chunks(params, nPkts));
 }
 
 void CObservationVelodyneScan::TPointCloud::clear()
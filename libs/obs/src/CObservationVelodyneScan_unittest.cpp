@@ -0,0 +1,385 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/obs/CObservationVelodyneScan.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/core/round.h>
+#include <mrpt/system/TaskScheduler.h>
+#include <mrpt/system/datetime.h>
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace std;
+
+using TParams = CObservationVelodyneScan::TGeneratePointCloudParameters;
+
+namespace
+{
+// Azimuth increment between consecutive firings, in 1/100 deg. It is chosen
+// so no azimuth correction lies halfway between two integers.
+const int AZIMUTH_STEP = 37;
+const int RETURNS_PER_BLOCK = 16;  // Returns decoded per block
+
+/** Simple deterministic pseudo-random numbers in [0,n) */
+struct TLCG
+{
+	uint32_t state{12345};
+	uint32_t operator()(const uint32_t n)
+	{
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) % n;
+	}
+};
+
+/** A synthetic scan of `nPkts` packets, rotating AZIMUTH_STEP per firing,
+ * whose packets timestamps wrap around the top of the hour. */
+CObservationVelodyneScan makeScan(
+	const std::string& model, const bool dual, const size_t nPkts)
+{
+	CObservationVelodyneScan scan;
+	scan.calibration = VelodyneCalibration::LoadDefaultCalibration(model);
+	scan.timestamp = mrpt::system::time_tToTimestamp(1.5e9);
+	scan.scan_packets.resize(nPkts);
+	TLCG rnd;
+	int firing = 0;
+	for (size_t p = 0; p < nPkts; p++)
+	{
+		auto& pkt = scan.scan_packets[p];
+		std::memset(&pkt, 0, sizeof(pkt));
+		pkt.gps_timestamp = (3599990000UL + p * 1327) % 3600000000UL;
+		pkt.laser_return_mode = dual ? CObservationVelodyneScan::RETMODE_DUAL
+									 : CObservationVelodyneScan::RETMODE_LAST;
+		for (int b = 0; b < CObservationVelodyneScan::BLOCKS_PER_PACKET; b++)
+		{
+			auto& blk = pkt.blocks[b];
+			blk.header = CObservationVelodyneScan::UPPER_BANK;
+			// In dual mode, pairs of blocks have the same azimuth:
+			if (!dual || (b & 1) == 0) firing++;
+			blk.rotation = static_cast<uint16_t>(
+				(2000 + firing * AZIMUTH_STEP) %
+				CObservationVelodyneScan::ROTATION_MAX_UNITS);
+			// Smooth ranges along the lasers, with some outliers and
+			// invalid returns:
+			const int base = 600 + rnd(20000);
+			for (int k = 0; k < CObservationVelodyneScan::SCANS_PER_BLOCK; k++)
+			{
+				auto& ret = blk.laser_returns[k];
+				int d = base + 40 * k + static_cast<int>(rnd(200));
+				if (rnd(10) == 0) d += 5000;
+				if (rnd(12) == 0) d = 0;
+				if (dual && (b & 1) && rnd(3) == 0)
+					d = pkt.blocks[b - 1].laser_returns[k].distance;
+				ret.distance = static_cast<uint16_t>(d);
+				ret.intensity = static_cast<uint8_t>(rnd(256));
+			}
+		}
+	}
+	return scan;
+}
+
+/** One decoded point */
+struct TRefPoint
+{
+	double x, y, z;
+	float distance;
+	float azimuth;
+	uint8_t intensity;
+	mrpt::system::TTimeStamp timestamp;
+};
+
+/** Reference decoder, independent of the one in the library: point by
+ * point, with exact trigonometry, and applying all filters in `params`
+ * except the ROI ones. */
+std::vector<TRefPoint> referenceDecode(
+	const CObservationVelodyneScan& scan, const TParams& params)
+{
+	const size_t nLasers = scan.calibration.laser_corrections.size();
+	const int16_t isolatedUnits = static_cast<int16_t>(
+		params.isolatedPointsFilterDistance /
+		CObservationVelodyneScan::DISTANCE_RESOLUTION);
+	const float minDist =
+		std::max(static_cast<float>(scan.minRange), params.minDistance);
+	const float maxDist =
+		std::min(params.maxDistance, static_cast<float>(scan.maxRange));
+	const int minAz = mrpt::round(params.minAzimuth_deg * 100);
+	const int maxAz = mrpt::round(params.maxAzimuth_deg * 100);
+
+	std::vector<TRefPoint> pts;
+	for (const auto& pkt : scan.scan_packets)
+	{
+		const bool dual =
+			pkt.laser_return_mode == CObservationVelodyneScan::RETMODE_DUAL;
+		const uint32_t us0 = scan.scan_packets[0].gps_timestamp;
+		const uint32_t us = pkt.gps_timestamp >= us0
+								? pkt.gps_timestamp - us0
+								: 3600000000UL + pkt.gps_timestamp - us0;
+		const auto tim = mrpt::system::timestampAdd(scan.timestamp, us * 1e-6);
+
+		for (int b = 0; b < CObservationVelodyneScan::BLOCKS_PER_PACKET; b++)
+		{
+			const auto& blk = pkt.blocks[b];
+			if (dual && (b & 1) && !params.dualKeepStrongest) continue;
+			if (dual && !(b & 1) && !params.dualKeepLast) continue;
+			for (int k = 0; k < RETURNS_PER_BLOCK; k++)
+			{
+				const uint16_t raw = blk.laser_returns[k].distance;
+				if (!raw) continue;
+				if (dual && (b & 1) &&
+					raw == pkt.blocks[b - 1].laser_returns[k].distance)
+					continue;
+				const auto& calib = scan.calibration.laser_corrections[k];
+				const float distance =
+					raw * CObservationVelodyneScan::DISTANCE_RESOLUTION +
+					calib.distanceCorrection;
+				if (distance < minDist || distance > maxDist) continue;
+
+				if (params.filterOutIsolatedPoints)
+				{
+					auto isolatedFrom = [&](const int k2) {
+						const int16_t d2 = blk.laser_returns[k2].distance;
+						return !d2 || std::abs(static_cast<int16_t>(raw) - d2) >
+										  isolatedUnits;
+					};
+					if ((k > 0 && isolatedFrom(k - 1)) ||
+						(k < RETURNS_PER_BLOCK - 1 && isolatedFrom(k + 1)))
+						continue;
+				}
+
+				// Lasers fire one after the other while the head rotates:
+				const double firingFraction =
+					nLasers == 16 ? k * 2.304 / 110.592 : k * 1.152 / 46.08;
+				const int az =
+					(blk.rotation +
+					 mrpt::round(AZIMUTH_STEP * firingFraction)) %
+					CObservationVelodyneScan::ROTATION_MAX_UNITS;
+				if (minAz < maxAz ? (az < minAz || az > maxAz)
+								  : (az > maxAz && az < minAz))
+					continue;
+
+				const double a = mrpt::DEG2RAD(az * 0.01);
+				double xy = distance * calib.cosVertCorrection;
+				if (calib.verticalOffsetCorrection)
+					xy += calib.verticalOffsetCorrection *
+						  calib.sinVertCorrection;
+				const double h = calib.horizontalOffsetCorrection;
+				TRefPoint p;
+				p.x = xy * std::cos(a) + h * std::sin(a);
+				p.y = -(xy * std::sin(a) - h * std::cos(a));
+				p.z = distance * calib.sinVertCorrection +
+					  calib.verticalOffsetCorrection;
+				p.distance = distance;
+				p.azimuth = az * CObservationVelodyneScan::ROTATION_RESOLUTION;
+				p.intensity = blk.laser_returns[k].intensity;
+				p.timestamp = tim;
+				pts.push_back(p);
+			}
+		}
+	}
+	return pts;
+}
+
+bool insideBox(
+	const float x, const float y, const float z, const float x0,
+	const float x1, const float y0, const float y1, const float z0,
+	const float z1)
+{
+	return x >= x0 && x <= x1 && y >= y0 && y <= y1 && z >= z0 && z <= z1;
+}
+
+CObservationVelodyneScan::TPointCloud decode(
+	const CObservationVelodyneScan& scan, TParams params,
+	const unsigned int num_threads)
+{
+	params.generatePerPointTimestamp = true;
+	params.generatePerPointAzimuth = true;
+	params.num_threads = num_threads;
+	CObservationVelodyneScan::TPointCloud pc;
+	scan.generatePointCloud(pc, params);
+	return pc;
+}
+
+void checkPointClouds(
+	const CObservationVelodyneScan::TPointCloud& a,
+	const CObservationVelodyneScan::TPointCloud& b)
+{
+	EXPECT_EQ(a.x, b.x);
+	EXPECT_EQ(a.y, b.y);
+	EXPECT_EQ(a.z, b.z);
+	EXPECT_EQ(a.intensity, b.intensity);
+	EXPECT_EQ(a.timestamp, b.timestamp);
+	EXPECT_EQ(a.azimuth, b.azimuth);
+}
+
+void testDecoding(const std::string& model, const bool dual)
+{
+	SCOPED_TRACE(model + (dual ? " dual" : " single"));
+	// Enough packets to be split among threads:
+	const auto scan = makeScan(model, dual, 100);
+
+	// Make sure there are worker threads, even on single-core machines:
+	mrpt::system::TaskSchedulerThreadsGuard threads(4);
+
+	// 1) No filters (except the default range limits): all points must match
+	// the reference values.
+	const TParams defaults;
+	const auto all = decode(scan, defaults, 1);
+	const auto ref = referenceDecode(scan, defaults);
+	ASSERT_EQ(all.size(), ref.size());
+	ASSERT_EQ(all.timestamp.size(), ref.size());
+	ASSERT_EQ(all.azimuth.size(), ref.size());
+	EXPECT_GT(ref.size(), 100U * 12 * RETURNS_PER_BLOCK / 2);
+	for (size_t i = 0; i < ref.size(); i++)
+	{
+		// The library uses a sin/cos look-up table of azimuths:
+		const double tol = 1e-3 + 2e-4 * ref[i].distance;
+		ASSERT_NEAR(all.x[i], ref[i].x, tol) << "i=" << i;
+		ASSERT_NEAR(all.y[i], ref[i].y, tol) << "i=" << i;
+		ASSERT_NEAR(all.z[i], ref[i].z, 1e-4) << "i=" << i;
+		ASSERT_EQ(all.intensity[i], ref[i].intensity) << "i=" << i;
+		ASSERT_EQ(all.timestamp[i], ref[i].timestamp) << "i=" << i;
+		ASSERT_EQ(all.azimuth[i], ref[i].azimuth) << "i=" << i;
+	}
+	checkPointClouds(decode(scan, defaults, 0), all);
+
+	// 2) Each filter:
+	std::vector<std::pair<std::string, TParams>> tests;
+	{
+		TParams p;
+		p.minAzimuth_deg = 40;
+		p.maxAzimuth_deg = 170.5;
+		tests.emplace_back("azimuth", p);
+		p.minAzimuth_deg = 300;
+		p.maxAzimuth_deg = 60;
+		tests.emplace_back("azimuth wrap", p);
+	}
+	{
+		TParams p;
+		p.minDistance = 5;
+		p.maxDistance = 25;
+		tests.emplace_back("distance", p);
+	}
+	{
+		TParams p;
+		p.filterByROI = true;
+		p.ROI_x_min = -10;
+		p.ROI_x_max = 20;
+		p.ROI_y_min = -5;
+		p.ROI_y_max = 30;
+		p.ROI_z_min = -1;
+		p.ROI_z_max = 2;
+		tests.emplace_back("ROI", p);
+	}
+	{
+		TParams p;
+		p.filterBynROI = true;
+		p.nROI_x_min = -15;
+		p.nROI_x_max = 15;
+		p.nROI_y_min = -20;
+		p.nROI_y_max = 10;
+		p.nROI_z_min = -3;
+		p.nROI_z_max = 3;
+		tests.emplace_back("nROI", p);
+	}
+	{
+		TParams p;
+		p.filterOutIsolatedPoints = true;
+		tests.emplace_back("isolated", p);
+	}
+	{
+		TParams p;
+		p.dualKeepStrongest = false;
+		tests.emplace_back("dual keep last", p);
+		p.dualKeepStrongest = true;
+		p.dualKeepLast = false;
+		tests.emplace_back("dual keep strongest", p);
+	}
+
+	for (const auto& t : tests)
+	{
+		SCOPED_TRACE(t.first);
+		const TParams& p = t.second;
+		const auto pc = decode(scan, p, 1);
+		checkPointClouds(decode(scan, p, 0), pc);
+
+		// Expected points: the reference ones for this filter, with the
+		// (non-ROI) filters applied in the reference decoder.
+		const auto ref_p = referenceDecode(scan, p);
+		// ROI filters: checked with the decoded coordinates, to avoid
+		// mismatches for points at the box boundaries.
+		std::vector<size_t> expected;
+		size_t j = 0;
+		for (size_t i = 0; i < ref_p.size(); i++)
+		{
+			// Find this point in the unfiltered cloud:
+			while (j < ref.size() && !(ref[j].timestamp == ref_p[i].timestamp &&
+									   ref[j].x == ref_p[i].x &&
+									   ref[j].y == ref_p[i].y &&
+									   ref[j].z == ref_p[i].z))
+				j++;
+			ASSERT_LT(j, ref.size());
+			const float x = all.x[j], y = all.y[j], z = all.z[j];
+			if (p.filterByROI &&
+				!insideBox(
+					x, y, z, p.ROI_x_min, p.ROI_x_max, p.ROI_y_min,
+					p.ROI_y_max, p.ROI_z_min, p.ROI_z_max))
+				continue;
+			if (p.filterBynROI &&
+				insideBox(
+					x, y, z, p.nROI_x_min, p.nROI_x_max, p.nROI_y_min,
+					p.nROI_y_max, p.nROI_z_min, p.nROI_z_max))
+				continue;
+			expected.push_back(j);
+		}
+		ASSERT_EQ(pc.size(), expected.size());
+		if (t.first.find("dual") == std::string::npos || dual)
+			EXPECT_LT(pc.size(), all.size());
+		for (size_t i = 0; i < expected.size(); i++)
+		{
+			const size_t e = expected[i];
+			ASSERT_EQ(pc.x[i], all.x[e]) << "i=" << i;
+			ASSERT_EQ(pc.y[i], all.y[e]) << "i=" << i;
+			ASSERT_EQ(pc.z[i], all.z[e]) << "i=" << i;
+			ASSERT_EQ(pc.intensity[i], all.intensity[e]) << "i=" << i;
+			ASSERT_EQ(pc.timestamp[i], all.timestamp[e]) << "i=" << i;
+			ASSERT_EQ(pc.azimuth[i], all.azimuth[e]) << "i=" << i;
+		}
+	}
+
+	// The in-place version gives the same result:
+	auto scan2 = scan;
+	TParams p = defaults;
+	p.generatePerPointTimestamp = true;
+	p.generatePerPointAzimuth = true;
+	scan2.generatePointCloud(p);
+	checkPointClouds(scan2.point_cloud, all);
+}
+}  // namespace
+
+TEST(CObservationVelodyneScan, generatePointCloud_VLP16_single)
+{
+	testDecoding("VLP16", false);
+}
+TEST(CObservationVelodyneScan, generatePointCloud_VLP16_dual)
+{
+	testDecoding("VLP16", true);
+}
+TEST(CObservationVelodyneScan, generatePointCloud_HDL32_single)
+{
+	testDecoding("HDL32", false);
+}
+TEST(CObservationVelodyneScan, generatePointCloud_HDL32_dual)
+{
+	testDecoding("HDL32", true);
+}
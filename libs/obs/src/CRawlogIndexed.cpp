@@ -0,0 +1,381 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+
+#include <mrpt/obs/CRawlogIndexed.h>
+#include <mrpt/io/CFileInputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <algorithm>
+
+using namespace mrpt;
+using namespace mrpt::io;
+using namespace mrpt::obs;
+using namespace mrpt::serialization;
+
+// Signature and version of the index file format:
+static const std::string RAWLOG_INDEX_MAGIC("MRPT_RAWLOG_INDEX");
+static const uint32_t RAWLOG_INDEX_VERSION = 1;
+
+/** Fingerprint of a rawlog file, stored in its index to detect stale
+ * indices: a FNV-1a hash of the file size and of its first and last
+ * `BLOCK` bytes, so it is cheap to compute even for huge files. Appending
+ * to, truncating or rewriting the rawlog (even keeping its size) changes
+ * its first or last blocks and, hence, the fingerprint. */
+static uint64_t rawlogFingerprint(const CMemoryMappedFile& f)
+{
+	const uint64_t BLOCK = 64 * 1024;
+	const uint64_t len = f.size();
+	uint64_t h = 0xcbf29ce484222325ULL;
+	auto hashBytes = [&h](const uint8_t* p, const uint64_t n) {
+		for (uint64_t i = 0; i < n; i++)
+		{
+			h ^= p[i];
+			h *= 0x100000001b3ULL;
+		}
+	};
+	hashBytes(reinterpret_cast<const uint8_t*>(&len), sizeof(len));
+	if (len <= 2 * BLOCK)
+		hashBytes(f.data(), len);
+	else
+	{
+		hashBytes(f.data(), BLOCK);
+		hashBytes(f.data() + len - BLOCK, BLOCK);
+	}
+	return h;
+}
+
+std::string CRawlogIndexed::getIndexFileName(const std::string& rawlogFile)
+{
+	return rawlogFile + std::string(".idx");
+}
+
+bool CRawlogIndexed::open(const std::string& rawlogFile, bool rebuildIndex)
+{
+	close();
+	if (!m_file.open(rawlogFile)) return false;
+
+	// Compressed files cannot be randomly accessed:
+	if (m_file.size() >= 2 && m_file.data()[0] == 0x1f &&
+		m_file.data()[1] == 0x8b)
+	{
+		std::cerr << "[CRawlogIndexed::open] Error: '" << rawlogFile
+				  << "' is gz-compressed. Decompress it first.\n";
+		close();
+		return false;
+	}
+
+	const std::string indexFile = getIndexFileName(rawlogFile);
+	if (rebuildIndex || !loadIndex(indexFile, m_file, m_entries))
+	{
+		if (!buildIndex(m_file, m_entries))
+		{
+			close();
+			return false;
+		}
+		// Failing to save the index is not fatal (e.g. read-only dirs):
+		if (!saveIndex(indexFile, m_file, m_entries))
+			std::cerr << "[CRawlogIndexed::open] Warning: could not save "
+						 "index file: '"
+					  << indexFile << "'\n";
+	}
+
+	for (size_t i = 0; i < m_entries.size(); i++)
+		if (m_entries[i].timestamp != INVALID_TIMESTAMP)
+			m_sortedByTime.push_back(i);
+	std::stable_sort(
+		m_sortedByTime.begin(), m_sortedByTime.end(),
+		[this](size_t a, size_t b) {
+			return m_entries[a].timestamp < m_entries[b].timestamp;
+		});
+	return true;
+}
+
+void CRawlogIndexed::close()
+{
+	m_file.close();
+	m_entries.clear();
+	m_sortedByTime.clear();
+}
+
+const CRawlogIndexed::TEntry& CRawlogIndexed::getEntryInfo(size_t index) const
+{
+	MRPT_START
+	if (index >= m_entries.size()) THROW_EXCEPTION("Index out of bounds");
+	return m_entries[index];
+	MRPT_END
+}
+
+CRawlog::TEntryType CRawlogIndexed::getType(size_t index) const
+{
+	MRPT_START
+	const auto* cls = mrpt::rtti::findRegisteredClass(
+		getEntryInfo(index).className);
+	if (!cls) return CRawlog::etOther;
+
+	if (cls->derivedFrom(CLASS_ID(CObservation)))
+		return CRawlog::etObservation;
+	else if (cls == CLASS_ID(CActionCollection))
+		return CRawlog::etActionCollection;
+	else if (cls == CLASS_ID(CSensoryFrame))
+		return CRawlog::etSensoryFrame;
+	else
+		return CRawlog::etOther;
+	MRPT_END
+}
+
+CSerializable::Ptr CRawlogIndexed::getAsGeneric(size_t index) const
+{
+	MRPT_START
+	const TEntry& e = getEntryInfo(index);
+	ASSERT_(e.offset + e.length <= m_file.size());
+
+	// Deserialize straight from the mapped memory, without copying it:
+	CMemoryStream buf;
+	buf.assignMemoryNotOwn(m_file.data() + e.offset, e.length);
+	auto arch = archiveFrom(buf);
+	return arch.ReadObject();
+	MRPT_END
+}
+
+CObservation::Ptr CRawlogIndexed::getAsObservation(size_t index) const
+{
+	MRPT_START
+	auto obj = getAsGeneric(index);
+	if (obj->GetRuntimeClass()->derivedFrom(CLASS_ID(CObservation)))
+		return std::dynamic_pointer_cast<CObservation>(obj);
+	else
+		THROW_EXCEPTION_FMT(
+			"Element at index %i is not a CObservation", (int)index);
+	MRPT_END
+}
+
+CSensoryFrame::Ptr CRawlogIndexed::getAsObservations(size_t index) const
+{
+	MRPT_START
+	auto obj = getAsGeneric(index);
+	if (obj->GetRuntimeClass()->derivedFrom(CLASS_ID(CSensoryFrame)))
+		return std::dynamic_pointer_cast<CSensoryFrame>(obj);
+	else
+		THROW_EXCEPTION_FMT(
+			"Element at index %i is not a CSensoryFrame", (int)index);
+	MRPT_END
+}
+
+CActionCollection::Ptr CRawlogIndexed::getAsAction(size_t index) const
+{
+	MRPT_START
+	auto obj = getAsGeneric(index);
+	if (obj->GetRuntimeClass()->derivedFrom(CLASS_ID(CActionCollection)))
+		return std::dynamic_pointer_cast<CActionCollection>(obj);
+	else
+		THROW_EXCEPTION_FMT(
+			"Element at index %i is not a CActionCollection", (int)index);
+	MRPT_END
+}
+
+void CRawlogIndexed::findEntriesInTimeRange(
+	mrpt::system::TTimeStamp t0, mrpt::system::TTimeStamp t1,
+	std::vector<size_t>& outIndices) const
+{
+	outIndices.clear();
+	if (t1 < t0) return;
+	const auto it0 = std::lower_bound(
+		m_sortedByTime.begin(), m_sortedByTime.end(), t0,
+		[this](size_t i, mrpt::system::TTimeStamp t) {
+			return m_entries[i].timestamp < t;
+		});
+	const auto it1 = std::upper_bound(
+		it0, m_sortedByTime.end(), t1,
+		[this](mrpt::system::TTimeStamp t, size_t i) {
+			return t < m_entries[i].timestamp;
+		});
+	outIndices.assign(it0, it1);
+}
+
+bool CRawlogIndexed::buildIndex(
+	const std::string& rawlogFile, const std::string& indexFile)
+{
+	try
+	{
+		CMemoryMappedFile f;
+		if (!f.open(rawlogFile)) return false;
+		std::vector<TEntry> entries;
+		if (!buildIndex(f, entries)) return false;
+		return saveIndex(
+			indexFile.empty() ? getIndexFileName(rawlogFile) : indexFile,
+			f, entries);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[CRawlogIndexed::buildIndex] " << e.what() << "\n";
+		return false;
+	}
+}
+
+bool CRawlogIndexed::buildIndex(
+	const CMemoryMappedFile& f, std::vector<TEntry>& entries)
+{
+	entries.clear();
+	if (!f.size()) return true;
+	// Compressed files cannot be randomly accessed:
+	if (f.size() >= 2 && f.data()[0] == 0x1f && f.data()[1] == 0x8b)
+		return false;
+
+	CMemoryStream buf;
+	buf.assignMemoryNotOwn(f.data(), f.size());
+	auto arch = archiveFrom(buf);
+
+	while (buf.getPosition() < f.size())
+	{
+		TEntry e;
+		e.offset = buf.getPosition();
+		CSerializable::Ptr obj;
+		try
+		{
+			obj = arch.ReadObject();
+		}
+		catch (const std::exception& ex)
+		{
+			// Truncated last object? Index all the valid ones before it:
+			std::cerr << "[CRawlogIndexed::buildIndex] Stopping at offset "
+					  << e.offset << ": " << ex.what() << "\n";
+			break;
+		}
+		if (!obj) break;
+		e.length = buf.getPosition() - e.offset;
+
+		// Rawlogs saved as a single CRawlog object are not indexable:
+		if (IS_CLASS(obj, CRawlog))
+		{
+			std::cerr << "[CRawlogIndexed::buildIndex] Rawlogs stored as a "
+						 "single CRawlog object are not supported.\n";
+			return false;
+		}
+
+		e.className = obj->GetRuntimeClass()->className;
+		if (IS_DERIVED(obj, CObservation))
+		{
+			const auto o = std::dynamic_pointer_cast<CObservation>(obj);
+			e.timestamp = o->timestamp;
+			e.sensorLabel = o->sensorLabel;
+		}
+		else if (IS_CLASS(obj, CSensoryFrame))
+		{
+			const auto sf = std::dynamic_pointer_cast<CSensoryFrame>(obj);
+			if (sf->size()) e.timestamp = (*sf->begin())->timestamp;
+		}
+		else if (IS_CLASS(obj, CActionCollection))
+		{
+			const auto acts = std::dynamic_pointer_cast<CActionCollection>(obj);
+			if (acts->size()) e.timestamp = (*acts->begin())->timestamp;
+		}
+		entries.push_back(std::move(e));
+	}
+	return true;
+}
+
+bool CRawlogIndexed::saveIndex(
+	const std::string& indexFile, const CMemoryMappedFile& rawlog,
+	const std::vector<TEntry>& entries)
+{
+	try
+	{
+		CFileOutputStream fo;
+		if (!fo.open(indexFile)) return false;
+		auto out = archiveFrom(fo);
+		out << RAWLOG_INDEX_MAGIC << RAWLOG_INDEX_VERSION
+			<< static_cast<uint64_t>(rawlog.size())
+			<< rawlogFingerprint(rawlog);
+		out.WriteAs<uint64_t>(entries.size());
+		for (const auto& e : entries)
+			out << e.offset << e.length << e.timestamp << e.className
+				<< e.sensorLabel;
+		return true;
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+}
+
+bool CRawlogIndexed::loadIndex(
+	const std::string& indexFile, const CMemoryMappedFile& rawlog,
+	std::vector<TEntry>& entries)
+{
+	const uint64_t rawlogSize = rawlog.size();
+	entries.clear();
+	try
+	{
+		CFileInputStream fi;
+		if (!fi.open(indexFile)) return false;
+		auto in = archiveFrom(fi);
+
+		std::string magic;
+		uint32_t version;
+		uint64_t fileSize, fingerprint, N;
+		in >> magic >> version;
+		if (magic != RAWLOG_INDEX_MAGIC || version != RAWLOG_INDEX_VERSION)
+			return false;
+		// Detect stale indices from a different (or modified) rawlog:
+		in >> fileSize >> fingerprint;
+		if (fileSize != rawlogSize ||
+			fingerprint != rawlogFingerprint(rawlog))
+			return false;
+		in >> N;
+		entries.resize(N);
+		for (auto& e : entries)
+		{
+			in >> e.offset >> e.length >> e.timestamp >> e.className >>
+				e.sensorLabel;
+			if (e.offset + e.length > rawlogSize)
+			{
+				entries.clear();
+				return false;
+			}
+		}
+		return true;
+	}
+	catch (const std::exception&)
+	{
+		entries.clear();
+		return false;
+	}
+}
+
+bool CRawlogIndexed::saveRawlogWithIndex(
+	const CRawlog& rawlog, const std::string& rawlogFile)
+{
+	try
+	{
+		{
+			CFileOutputStream fo;
+			if (!fo.open(rawlogFile)) return false;
+			auto f = archiveFrom(fo);
+			const std::string comments = rawlog.getCommentText();
+			if (!comments.empty())
+			{
+				CObservationComment obsComment;
+				obsComment.text = comments;
+				f << obsComment;
+			}
+			for (size_t i = 0; i < rawlog.size(); i++)
+				f << *rawlog.getAsGeneric(i);
+		}
+		return buildIndex(rawlogFile);
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[CRawlogIndexed::saveRawlogWithIndex] " << e.what()
+				  << "\n";
+		return false;
+	}
+}
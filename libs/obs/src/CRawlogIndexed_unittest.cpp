@@ -0,0 +1,157 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/obs/CRawlogIndexed.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/system/filesystem.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt::obs;
+
+TEST(CRawlogIndexed, RandomAccessAndTimeRanges)
+{
+	const size_t N = 50;
+	const mrpt::system::TTimeStamp t0 = 1000000;  // arbitrary
+
+	// Observations-only rawlog, with decreasing timestamps to test sorting:
+	CRawlog rawlog;
+	for (size_t i = 0; i < N; i++)
+	{
+		CObservationOdometry obs;
+		obs.sensorLabel = "ODO";
+		obs.timestamp = t0 + (N - i) * 100;
+		obs.odometry = mrpt::poses::CPose2D(i, 0, 0);
+		rawlog.addObservationMemoryReference(
+			CObservation::Ptr(new CObservationOdometry(obs)));
+	}
+	const std::string fil = mrpt::system::getTempFileName();
+	ASSERT_TRUE(CRawlogIndexed::saveRawlogWithIndex(rawlog, fil));
+	ASSERT_TRUE(
+		mrpt::system::fileExists(CRawlogIndexed::getIndexFileName(fil)));
+
+	CRawlogIndexed ri;
+	ASSERT_TRUE(ri.open(fil));
+	ASSERT_EQ(ri.size(), N);
+
+	for (size_t i : {size_t(N - 1), size_t(0), size_t(N / 2)})
+	{
+		EXPECT_EQ(ri.getType(i), CRawlog::etObservation);
+		EXPECT_EQ(ri.getEntryInfo(i).sensorLabel, "ODO");
+		const auto o =
+			std::dynamic_pointer_cast<CObservationOdometry>(
+				ri.getAsObservation(i));
+		ASSERT_TRUE(o);
+		EXPECT_EQ(o->timestamp, t0 + (N - i) * 100);
+		EXPECT_NEAR(o->odometry.x(), double(i), 1e-9);
+	}
+	EXPECT_THROW(ri.getAsObservations(0), std::exception);
+	EXPECT_THROW(ri.getAsGeneric(N), std::exception);
+
+	// Entries with t in [t0+1000, t0+1500] <=> i in [N-15, N-10]:
+	std::vector<size_t> idxs;
+	ri.findEntriesInTimeRange(t0 + 1000, t0 + 1500, idxs);
+	ASSERT_EQ(idxs.size(), 6U);
+	for (size_t k = 0; k < idxs.size(); k++) EXPECT_EQ(idxs[k], N - 10 - k);
+
+	// Reopening must reuse the existing index:
+	ri.close();
+	ASSERT_TRUE(ri.open(fil));
+	EXPECT_EQ(ri.size(), N);
+	ri.close();
+
+	mrpt::system::deleteFile(fil);
+	mrpt::system::deleteFile(CRawlogIndexed::getIndexFileName(fil));
+}
+
+TEST(CRawlogIndexed, ActionsAndSensoryFrames)
+{
+	CRawlog rawlog;
+	for (size_t i = 0; i < 10; i++)
+	{
+		CActionCollection acts;
+		CActionRobotMovement2D act;
+		act.computeFromOdometry(
+			mrpt::poses::CPose2D(0.1, 0, 0),
+			CActionRobotMovement2D::TMotionModelOptions());
+		act.timestamp = 5000 + i;
+		acts.insert(act);
+		rawlog.addActions(acts);
+
+		CSensoryFrame sf;
+		auto obs = CObservationOdometry::Create();
+		obs->timestamp = 5000 + i;
+		sf.insert(obs);
+		rawlog.addObservations(sf);
+	}
+	const std::string fil = mrpt::system::getTempFileName();
+	ASSERT_TRUE(CRawlogIndexed::saveRawlogWithIndex(rawlog, fil));
+
+	CRawlogIndexed ri;
+	ASSERT_TRUE(ri.open(fil));
+	ASSERT_EQ(ri.size(), 20U);
+	EXPECT_EQ(ri.getType(6), CRawlog::etActionCollection);
+	EXPECT_EQ(ri.getType(7), CRawlog::etSensoryFrame);
+	EXPECT_TRUE(ri.getAsAction(6));
+	EXPECT_EQ(ri.getAsObservations(7)->size(), 1U);
+	EXPECT_EQ(ri.getEntryInfo(7).timestamp, 5003U);
+
+	std::vector<size_t> idxs;
+	ri.findEntriesInTimeRange(5003, 5003, idxs);
+	EXPECT_EQ(idxs, std::vector<size_t>({6, 7}));
+	ri.close();
+
+	mrpt::system::deleteFile(fil);
+	mrpt::system::deleteFile(CRawlogIndexed::getIndexFileName(fil));
+}
+
+TEST(CRawlogIndexed, StaleIndexWithSameFileSize)
+{
+	// Two rawlogs with exactly the same size, but different contents:
+	auto makeRawlog = [](mrpt::system::TTimeStamp t0) {
+		CRawlog rawlog;
+		for (size_t i = 0; i < 10; i++)
+		{
+			auto obs = CObservationOdometry::Create();
+			obs->timestamp = t0 + i;
+			rawlog.addObservationMemoryReference(obs);
+		}
+		return rawlog;
+	};
+	const std::string fil = mrpt::system::getTempFileName();
+	ASSERT_TRUE(CRawlogIndexed::saveRawlogWithIndex(makeRawlog(1000), fil));
+	const uint64_t size1 = mrpt::system::getFileSize(fil);
+
+	// Overwrite the rawlog, keeping its (now stale) index:
+	const std::string idxFile = CRawlogIndexed::getIndexFileName(fil);
+	const std::string idxBackup = idxFile + ".bak";
+	ASSERT_TRUE(mrpt::system::copyFile(idxFile, idxBackup));
+	ASSERT_TRUE(CRawlogIndexed::saveRawlogWithIndex(makeRawlog(2000), fil));
+	ASSERT_EQ(mrpt::system::getFileSize(fil), size1);
+	ASSERT_TRUE(mrpt::system::copyFile(idxBackup, idxFile));
+
+	CRawlogIndexed ri;
+	ASSERT_TRUE(ri.open(fil));
+	ASSERT_EQ(ri.size(), 10U);
+	EXPECT_EQ(ri.getEntryInfo(9).timestamp, 2009U);
+	std::vector<size_t> idxs;
+	ri.findEntriesInTimeRange(1000, 1009, idxs);
+	EXPECT_TRUE(idxs.empty());
+	ri.close();
+
+	// The index must have been rebuilt and saved:
+	CRawlogIndexed ri2;
+	ASSERT_TRUE(ri2.open(fil));
+	EXPECT_EQ(ri2.getEntryInfo(0).timestamp, 2000U);
+	ri2.close();
+
+	mrpt::system::deleteFile(fil);
+	mrpt::system::deleteFile(idxFile);
+	mrpt::system::deleteFile(idxBackup);
+}
@@ -26,3 +26,17 @@ TEST(Random, Randomize)
 	auto r1abis = rnd.drawUniform32bit();
 	EXPECT_EQ(r1a, r1abis);
 }
+
+TEST(Random, RandomizeGaussian)
+{
+	using namespace mrpt::random;
+
+	CRandomGenerator rnd;
+	rnd.randomize(1);
+	const double g1 = rnd.drawGaussian1D_normalized();
+	// Leave a pending sample in the generator, then re-seed:
+	rnd.drawGaussian1D_normalized();
+	rnd.drawGaussian1D_normalized();
+	rnd.randomize(1);
+	EXPECT_EQ(g1, rnd.drawGaussian1D_normalized());
+}
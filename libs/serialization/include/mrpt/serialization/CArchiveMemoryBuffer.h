@@ -0,0 +1,80 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/serialization/CArchive.h>
+#include <cstdint>
+
+namespace mrpt::serialization
+{
+/** A CArchive over a contiguous block of memory owned by the caller (e.g. a
+ * shared memory segment, or the buffer of a network message), without any
+ * intermediary stream or buffer.
+ *
+ * Two modes exist, depending on the factory method used to create the
+ * archive:
+ * - Write: objects are serialized into a buffer of fixed capacity. Passing
+ * a nullptr buffer only counts the bytes, which is useful to find out the
+ * buffer size required to serialize an object (see getPosition()).
+ * - Read, from memory not owned by the archive, which must exist while the
+ * archive is in use.
+ *
+ * This avoids the intermediary copies of CMemoryStream, but it is not
+ * zero-copy: deserialized objects never keep views into the buffer, and
+ * their arrays (point clouds, range images, image pixels,...) are always
+ * copied into memory owned by the objects.
+ *
+ * \code
+ * // Serialize:
+ * auto counter = CArchiveMemoryBuffer::createForWriting(nullptr, 0);
+ * counter << obj;
+ * std::vector<uint8_t> buf(counter.getPosition());
+ * auto out = CArchiveMemoryBuffer::createForWriting(buf.data(), buf.size());
+ * out << obj;
+ * // Deserialize:
+ * auto in = CArchiveMemoryBuffer::createForReading(buf.data(), buf.size());
+ * in >> obj2;
+ * \endcode
+ *
+ * \sa archiveFrom()
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_serialization_grp
+ */
+class CArchiveMemoryBuffer : public CArchive
+{
+   public:
+	/** Write mode: serializes into `buf`, which can hold up to `capacity`
+	 * bytes. If `buf` is nullptr, written bytes are only counted. */
+	static CArchiveMemoryBuffer createForWriting(void* buf, size_t capacity);
+	/** Read mode: deserializes from memory not owned by this object, which
+	 * must exist while the archive is in use. */
+	static CArchiveMemoryBuffer createForReading(
+		const void* buf, size_t length);
+
+	/** Number of bytes written or read so far */
+	size_t getPosition() const { return m_pos; }
+	/** Capacity of the buffer (write mode) or its length (read mode). */
+	size_t size() const { return m_size; }
+
+   protected:
+	size_t write(const void* buf, size_t len) override;
+	size_t read(void* buf, size_t len) override;
+
+   private:
+	CArchiveMemoryBuffer(uint8_t* buf, size_t size, bool write_mode);
+
+	/** Start of the buffer */
+	uint8_t* m_begin{nullptr};
+	size_t m_size{0};
+	/** Bytes written or read so far */
+	size_t m_pos{0};
+	bool m_write_mode{false};
+};
+
+}  // namespace mrpt::serialization
@@ -0,0 +1,64 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "serialization-precomp.h"  // Precompiled headers
+
+#include <mrpt/serialization/CArchiveMemoryBuffer.h>
+#include <mrpt/core/exceptions.h>
+#include <cstring>
+
+using namespace mrpt::serialization;
+
+CArchiveMemoryBuffer::CArchiveMemoryBuffer(
+	uint8_t* buf, size_t size, bool write_mode)
+	: m_begin(buf), m_size(buf ? size : 0), m_write_mode(write_mode)
+{
+}
+
+CArchiveMemoryBuffer CArchiveMemoryBuffer::createForWriting(
+	void* buf, size_t capacity)
+{
+	return CArchiveMemoryBuffer(static_cast<uint8_t*>(buf), capacity, true);
+}
+
+CArchiveMemoryBuffer CArchiveMemoryBuffer::createForReading(
+	const void* buf, size_t length)
+{
+	ASSERT_(buf != nullptr || length == 0);
+	// The buffer is never written in read mode:
+	return CArchiveMemoryBuffer(
+		static_cast<uint8_t*>(const_cast<void*>(buf)), length, false);
+}
+
+size_t CArchiveMemoryBuffer::write(const void* buf, size_t len)
+{
+	if (!m_write_mode)
+		THROW_EXCEPTION("Attempt to write to a read-only memory archive.");
+	if (m_begin)
+	{
+		if (len > m_size - m_pos)
+			THROW_EXCEPTION_FMT(
+				"Memory archive overflow: writing %u bytes at position %u, "
+				"with capacity=%u",
+				static_cast<unsigned>(len), static_cast<unsigned>(m_pos),
+				static_cast<unsigned>(m_size));
+		::memcpy(m_begin + m_pos, buf, len);
+	}
+	m_pos += len;
+	return len;
+}
+
+size_t CArchiveMemoryBuffer::read(void* buf, size_t len)
+{
+	// Returning 0 makes CArchive::ReadBuffer() report EOF:
+	if (m_write_mode || len > m_size - m_pos) return 0;
+	::memcpy(buf, m_begin + m_pos, len);
+	m_pos += len;
+	return len;
+}
@@ -0,0 +1,80 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/serialization/CSerializable.h>
+#include <mrpt/serialization/CArchiveMemoryBuffer.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt::serialization;
+
+namespace MyNS
+{
+class Blob : public CSerializable
+{
+	DEFINE_SERIALIZABLE(Blob)
+   public:
+	std::vector<uint8_t> data;
+};
+}  // namespace MyNS
+
+IMPLEMENTS_SERIALIZABLE(Blob, CSerializable, MyNS);
+
+uint8_t MyNS::Blob::serializeGetVersion() const { return 0; }
+void MyNS::Blob::serializeTo(CArchive& out) const
+{
+	out.WriteAs<uint32_t>(data.size());
+	if (!data.empty()) out.WriteBuffer(&data[0], data.size());
+}
+void MyNS::Blob::serializeFrom(CArchive& in, uint8_t)
+{
+	uint32_t n;
+	in >> n;
+	data.resize(n);
+	if (n) in.ReadBuffer(&data[0], n);
+}
+
+TEST(CArchiveMemoryBuffer, WriteAndRead)
+{
+	mrpt::rtti::registerClass(CLASS_ID(MyNS::Blob));
+	MyNS::Blob a;
+	a.data.resize(1000);
+	for (size_t i = 0; i < a.data.size(); i++) a.data[i] = uint8_t(i);
+	const double d = 3.0;
+
+	// Count bytes:
+	auto counter = CArchiveMemoryBuffer::createForWriting(nullptr, 0);
+	counter << d << a;
+	const size_t len = counter.getPosition();
+	EXPECT_GT(len, sizeof(d) + a.data.size());
+
+	// Too small buffer:
+	{
+		std::vector<uint8_t> buf(len - 1);
+		auto out =
+			CArchiveMemoryBuffer::createForWriting(buf.data(), buf.size());
+		EXPECT_THROW(out << d << a, std::exception);
+	}
+
+	std::vector<uint8_t> buf(len);
+	{
+		auto out = CArchiveMemoryBuffer::createForWriting(buf.data(), len);
+		out << d << a;
+		EXPECT_EQ(out.getPosition(), len);
+	}
+
+	auto in = CArchiveMemoryBuffer::createForReading(buf.data(), len);
+	double d2;
+	MyNS::Blob b;
+	in >> d2 >> b;
+	EXPECT_EQ(d2, d);
+	EXPECT_EQ(b.data, a.data);
+	EXPECT_EQ(in.getPosition(), len);
+	EXPECT_THROW(in >> d2, std::exception);
+	EXPECT_THROW(in << d2, std::exception);
+}
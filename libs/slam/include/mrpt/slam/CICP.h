@@ -20,7 +20,14 @@ namespace mrpt::slam
 enum TICPAlgorithm
 {
 	icpClassic = 0,
-	icpLevenbergMarquardt
+	icpLevenbergMarquardt,
+	/** Point-to-plane ICP (3D only): minimizes the distances from the points
+	   to the local planes of their correspondences in the reference map */
+	icpPointToPlane,
+	/** Generalized-ICP, or plane-to-plane ICP (3D only): minimizes the
+	   Mahalanobis distances between correspondences, using the local surface
+	   covariances of both maps */
+	icpGICP
 };
 
 /** ICP covariance estimation methods, used in mrpt::slam::CICP::options
@@ -148,7 +155,8 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		/** @} */
 
 		/** Cauchy kernel rho, for estimating the optimal transformation
-		 * covariance, in meters (default = 0.07m) */
+		 * covariance, in meters (default = 0.07m). It is also the scale of the
+		 * robust kernel of the icpPointToPlane and icpGICP solvers. */
 		double kernel_rho{0.07};
 		/** Whether to use kernel_rho to smooth distances, or use distances
 		 * directly (default=true) */
@@ -174,6 +182,23 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		 * queries,
 		 *  the most expensive step in ICP */
 		uint32_t corresponding_points_decimation{5};
+		/** Maximum number of threads for finding the point correspondences at
+		 * each iteration (1=serial, 0=as many as in
+		 * mrpt::system::TaskScheduler). Results do not depend
+		 * on this value. See mrpt::maps::TMatchingParams::matchingThreads
+		 * (default=1) */
+		uint32_t matchingThreads{1};
+
+		/** @name Options for icpPointToPlane and icpGICP (ICP-3D only)
+			@{ */
+		/** Number of neighbors used to estimate the normal and covariance of
+		 * the local surface around each point. See
+		 * mrpt::maps::CPointsMap::getPointsNormals() (default=10) */
+		uint32_t normals_kNeighbors{10};
+		/** Maximum number of iterations of the robust Gauss-Newton solver for
+		 * each set of correspondences (default=5) */
+		uint32_t robust_solver_maxIterations{5};
+		/** @} */
 	};
 
 	/** The options employed by the ICP align. */
@@ -257,6 +282,8 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
 		const mrpt::poses::CPosePDFGaussian& initialEstimationPDF,
 		TReturnInfo& outInfo);
+	/** ICP-3D, with point-to-point (icpClassic), point-to-plane
+	 * (icpPointToPlane) or plane-to-plane (icpGICP) errors. */
 	mrpt::poses::CPose3DPDF::Ptr ICP3D_Method_Classic(
 		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
 		const mrpt::poses::CPose3DPDFGaussian& initialEstimationPDF,
@@ -267,6 +294,8 @@ MRPT_ENUM_TYPE_BEGIN(mrpt::slam::TICPAlgorithm)
 using namespace mrpt::slam;
 MRPT_FILL_ENUM(icpClassic);
 MRPT_FILL_ENUM(icpLevenbergMarquardt);
+MRPT_FILL_ENUM(icpPointToPlane);
+MRPT_FILL_ENUM(icpGICP);
 MRPT_ENUM_TYPE_END()
 
 MRPT_ENUM_TYPE_BEGIN(mrpt::slam::TICPCovarianceMethod)
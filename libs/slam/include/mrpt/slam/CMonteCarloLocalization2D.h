@@ -159,6 +159,14 @@ class CMonteCarloLocalization2D
 		const size_t particleIndexForMap,
 		const mrpt::obs::CSensoryFrame& observation,
 		const mrpt::poses::CPose3D& x) const override;
+	/** Uses COccupancyGridMap2D::computeObservationLikelihood_batch() if the
+	 * map is a grid (alone or as the only map of a
+	 * mrpt::maps::CMultiMetricMap) shared by all particles. */
+	bool PF_SLAM_computeObservationLikelihoodForParticles(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::obs::CSensoryFrame& observation,
+		const std::vector<mrpt::poses::CPose3D>& poses,
+		std::vector<double>& out_log_liks) const override;
 	/** @} */
 
 };  // End of class def.
@@ -359,18 +359,31 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		//	UPDATE STAGE
 		// ----------------------------------------------------------------------
 		// Compute all the likelihood values & update particles weight:
-		for (size_t i = 0; i < M; i++)
-		{
-			bool pose_is_valid;
-			const mrpt::math::TPose3D partPose =
-				getLastPose(i, pose_is_valid);  // Take the particle data:
-			mrpt::poses::CPose3D partPose2 = mrpt::poses::CPose3D(partPose);
-			const double obs_log_likelihood =
-				PF_SLAM_computeObservationLikelihoodForParticle(
-					PF_options, i, *sf, partPose2);
-			me->m_particles[i].log_w +=
-				obs_log_likelihood * PF_options.powFactor;
-		}  // for each particle "i"
+		// (possibly in parallel, each particle only touches its own weight)
+		PF_SLAM_implementation_forEachParticleChunk(
+			PF_options, 0, M, [&](const size_t i0, const size_t i1) {
+				std::vector<mrpt::poses::CPose3D> partPoses;
+				partPoses.reserve(i1 - i0);
+				for (size_t i = i0; i < i1; i++)
+				{
+					bool pose_is_valid;
+					partPoses.emplace_back(getLastPose(i, pose_is_valid));
+				}
+				// All particles at once, if possible, or one by one:
+				std::vector<double> obs_log_likelihoods;
+				if (!PF_SLAM_computeObservationLikelihoodForParticles(
+						PF_options, *sf, partPoses, obs_log_likelihoods))
+				{
+					obs_log_likelihoods.resize(i1 - i0);
+					for (size_t i = i0; i < i1; i++)
+						obs_log_likelihoods[i - i0] =
+							PF_SLAM_computeObservationLikelihoodForParticle(
+								PF_options, i, *sf, partPoses[i - i0]);
+				}
+				for (size_t i = i0; i < i1; i++)
+					me->m_particles[i].log_w +=
+						obs_log_likelihoods[i - i0] * PF_options.powFactor;
+			});  // for each particle "i"
 
 		// Normalization of weights is done outside of this method
 		// automatically.
@@ -422,12 +435,83 @@ double PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
 		const void* action, const void* observation)
 {
-	MRPT_UNUSED_PARAM(action);
 	MRPT_START
 
-	// const PF_implementation<PARTICLE_TYPE,MYSELF> *myObj =
-	// reinterpret_cast<const PF_implementation<PARTICLE_TYPE,MYSELF>*>( obj );
 	const MYSELF* me = static_cast<const MYSELF*>(obj);
+	return me->PF_SLAM_aux_computeFirstStageWeight(
+		PF_options, index, true /*Optimal PF*/,
+		*static_cast<const mrpt::poses::CPose3D*>(action),
+		*static_cast<const mrpt::obs::CSensoryFrame*>(observation), nullptr);
+
+	MRPT_END
+}  // end of PF_SLAM_particlesEvaluator_AuxPFOptimal
+
+/**  Compute w[i]*p(z_t | mu_t^i), with mu_t^i being
+ *    the mean of the new robot pose
+ *
+ * \param action MUST be a "const mrpt::poses::CPose3D*"
+ * \param observation MUST be a "const CSensoryFrame*"
+ */
+template <class PARTICLE_TYPE, class MYSELF,
+	mrpt::bayes::particle_storage_mode STORAGE>
+template <class BINTYPE>
+double PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
+	PF_SLAM_particlesEvaluator_AuxPFStandard(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
+		const void* action, const void* observation)
+{
+	MRPT_START
+
+	const MYSELF* myObj = static_cast<const MYSELF*>(obj);
+	return myObj->PF_SLAM_aux_computeFirstStageWeight(
+		PF_options, index, false /*APF*/,
+		*static_cast<const mrpt::poses::CPose3D*>(action),
+		*static_cast<const mrpt::obs::CSensoryFrame*>(observation), nullptr);
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+			PF_SLAM_aux_computeFirstStageWeight
+ ---------------------------------------------------------------*/
+template <class PARTICLE_TYPE, class MYSELF,
+	mrpt::bayes::particle_storage_mode STORAGE>
+double PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
+	PF_SLAM_aux_computeFirstStageWeight(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const std::size_t index, const bool USE_OPTIMAL_SAMPLING,
+		const mrpt::poses::CPose3D& meanRobotMovement,
+		const mrpt::obs::CSensoryFrame& sf,
+		const mrpt::poses::CPose3D* drawnMovements) const
+{
+	MRPT_START
+
+	const MYSELF* me = static_cast<const MYSELF*>(this);
+
+	// Take the previous particle weight:
+	const double cur_logweight = me->m_particles[index].log_w;
+	bool pose_is_valid;
+	const mrpt::poses::CPose3D oldPose =
+		mrpt::poses::CPose3D(getLastPose(index, pose_is_valid));
+
+	if (!USE_OPTIMAL_SAMPLING &&
+		!PF_options.pfAuxFilterStandard_FirstStageWeightsMonteCarlo)
+	{
+		// Just use the mean:
+		// , take the mean of the posterior density:
+		mrpt::poses::CPose3D x_predict;
+		x_predict.composeFrom(oldPose, meanRobotMovement);
+
+		// and compute the obs. likelihood:
+		// --------------------------------------------
+		m_pfAuxiliaryPFStandard_estimatedProb[index] =
+			PF_SLAM_computeObservationLikelihoodForParticle(
+				PF_options, index, sf, x_predict);
+
+		// Combined log_likelihood: Previous weight * obs_likelihood:
+		return cur_logweight + m_pfAuxiliaryPFStandard_estimatedProb[index];
+	}
 
 	// Compute the quantity:
 	//     w[i]*p(zt|z^{t-1},x^{[i],t-1})
@@ -435,25 +519,23 @@ double PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 	// --------------------------------------------
 	double indivLik, maxLik = -1e300;
 	mrpt::poses::CPose3D maxLikDraw;
-	size_t N = PF_options.pfAuxFilterOptimal_MaximumSearchSamples;
+	const size_t N = PF_options.pfAuxFilterOptimal_MaximumSearchSamples;
 	ASSERT_(N > 1);
 
-	bool pose_is_valid;
-	const mrpt::poses::CPose3D oldPose =
-		mrpt::poses::CPose3D(me->getLastPose(index, pose_is_valid));
 	mrpt::math::CVectorDouble vectLiks(
 		N, 0);  // The vector with the individual log-likelihoods.
 	mrpt::poses::CPose3D drawnSample;
 	for (size_t q = 0; q < N; q++)
 	{
-		me->m_movementDrawer.drawSample(drawnSample);
+		if (drawnMovements)
+			drawnSample = drawnMovements[q];
+		else
+			m_movementDrawer.drawSample(drawnSample);
 		mrpt::poses::CPose3D x_predict = oldPose + drawnSample;
 
 		// Estimate the mean...
-		indivLik = me->PF_SLAM_computeObservationLikelihoodForParticle(
-			PF_options, index,
-			*static_cast<const mrpt::obs::CSensoryFrame*>(observation),
-			x_predict);
+		indivLik = PF_SLAM_computeObservationLikelihoodForParticle(
+			PF_options, index, sf, x_predict);
 
 		MRPT_CHECK_NORMAL_NUMBER(indivLik);
 		vectLiks[q] = indivLik;
@@ -467,127 +549,82 @@ double PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 	// This is done to avoid floating point overflow!!
 	//      average_lik    =      \sum(e^liks)   * e^maxLik  /     N
 	// log( average_lik  ) = log( \sum(e^liks) ) + maxLik   - log( N )
-	double avrgLogLik = math::averageLogLikelihood(vectLiks);
+	const double avrgLogLik = math::averageLogLikelihood(vectLiks);
 
 	// Save into the object:
-	me->m_pfAuxiliaryPFOptimal_estimatedProb[index] =
-		avrgLogLik;  // log( accum / N );
-	me->m_pfAuxiliaryPFOptimal_maxLikelihood[index] = maxLik;
+	auto& estimatedProb = USE_OPTIMAL_SAMPLING
+							  ? m_pfAuxiliaryPFOptimal_estimatedProb
+							  : m_pfAuxiliaryPFStandard_estimatedProb;
+	estimatedProb[index] = avrgLogLik;  // log( accum / N );
+	m_pfAuxiliaryPFOptimal_maxLikelihood[index] = maxLik;
 
 	if (PF_options.pfAuxFilterOptimal_MLE)
-		me->m_pfAuxiliaryPFOptimal_maxLikDrawnMovement[index] =
+		m_pfAuxiliaryPFOptimal_maxLikDrawnMovement[index] =
 			maxLikDraw.asTPose();
 
 	// and compute the resulting probability of this particle:
 	// ------------------------------------------------------------
-	return me->m_particles[index].log_w +
-		   me->m_pfAuxiliaryPFOptimal_estimatedProb[index];
+	return cur_logweight + estimatedProb[index];
 
 	MRPT_END
-}  // end of PF_SLAM_particlesEvaluator_AuxPFOptimal
+}
 
-/**  Compute w[i]*p(z_t | mu_t^i), with mu_t^i being
- *    the mean of the new robot pose
- *
- * \param action MUST be a "const mrpt::poses::CPose3D*"
- * \param observation MUST be a "const CSensoryFrame*"
- */
+/*---------------------------------------------------------------
+		PF_SLAM_aux_computeFirstStageWeightsInParallel
+ ---------------------------------------------------------------*/
 template <class PARTICLE_TYPE, class MYSELF,
 	mrpt::bayes::particle_storage_mode STORAGE>
-template <class BINTYPE>
-double PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
-	PF_SLAM_particlesEvaluator_AuxPFStandard(
+void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
+	PF_SLAM_aux_computeFirstStageWeightsInParallel(
 		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
-		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
-		const void* action, const void* observation)
+		const bool USE_OPTIMAL_SAMPLING,
+		const mrpt::poses::CPose3D& meanRobotMovement,
+		const mrpt::obs::CSensoryFrame& sf)
 {
 	MRPT_START
 
-	// const PF_implementation<PARTICLE_TYPE,MYSELF> *myObj =
-	// reinterpret_cast<const PF_implementation<PARTICLE_TYPE,MYSELF>*>( obj );
-	const MYSELF* myObj = static_cast<const MYSELF*>(obj);
-
-	// Take the previous particle weight:
-	const double cur_logweight = myObj->m_particles[index].log_w;
-	bool pose_is_valid;
-	const mrpt::poses::CPose3D oldPose =
-		mrpt::poses::CPose3D(myObj->getLastPose(index, pose_is_valid));
+	MYSELF* me = static_cast<MYSELF*>(this);
+	const size_t M = me->m_particles.size();
+	m_pfAuxiliaryPF_firstStageWeights.resize(M);
 
-	if (!PF_options.pfAuxFilterStandard_FirstStageWeightsMonteCarlo)
+	if (!USE_OPTIMAL_SAMPLING &&
+		!PF_options.pfAuxFilterStandard_FirstStageWeightsMonteCarlo)
 	{
-		// Just use the mean:
-		// , take the mean of the posterior density:
-		mrpt::poses::CPose3D x_predict;
-		x_predict.composeFrom(
-			oldPose, *static_cast<const mrpt::poses::CPose3D*>(action));
-
-		// and compute the obs. likelihood:
-		// --------------------------------------------
-		myObj->m_pfAuxiliaryPFStandard_estimatedProb[index] =
-			myObj->PF_SLAM_computeObservationLikelihoodForParticle(
-				PF_options, index,
-				*static_cast<const mrpt::obs::CSensoryFrame*>(observation),
-				x_predict);
-
-		// Combined log_likelihood: Previous weight * obs_likelihood:
-		return cur_logweight +
-			   myObj->m_pfAuxiliaryPFStandard_estimatedProb[index];
+		// No random samples involved: just evaluate all particles:
+		PF_SLAM_implementation_forEachParticle(
+			PF_options, 0, M, [&](const size_t i) {
+				m_pfAuxiliaryPF_firstStageWeights[i] =
+					PF_SLAM_aux_computeFirstStageWeight(
+						PF_options, i, USE_OPTIMAL_SAMPLING, meanRobotMovement,
+						sf, nullptr);
+			});
+		return;
 	}
-	else
-	{
-		// Do something similar to in Optimal sampling:
-		// Compute the quantity:
-		//     w[i]*p(zt|z^{t-1},x^{[i],t-1})
-		// As the Monte-Carlo approximation of the integral over all posible
-		// $x_t$.
-		// --------------------------------------------
-		double indivLik, maxLik = -1e300;
-		mrpt::poses::CPose3D maxLikDraw;
-		size_t N = PF_options.pfAuxFilterOptimal_MaximumSearchSamples;
-		ASSERT_(N > 1);
-
-		mrpt::math::CVectorDouble vectLiks(
-			N, 0);  // The vector with the individual log-likelihoods.
-		mrpt::poses::CPose3D drawnSample;
-		for (size_t q = 0; q < N; q++)
-		{
-			myObj->m_movementDrawer.drawSample(drawnSample);
-			mrpt::poses::CPose3D x_predict = oldPose + drawnSample;
-
-			// Estimate the mean...
-			indivLik = myObj->PF_SLAM_computeObservationLikelihoodForParticle(
-				PF_options, index,
-				*static_cast<const mrpt::obs::CSensoryFrame*>(observation),
-				x_predict);
-
-			MRPT_CHECK_NORMAL_NUMBER(indivLik);
-			vectLiks[q] = indivLik;
-			if (indivLik > maxLik)
-			{  // Keep the maximum value:
-				maxLikDraw = drawnSample;
-				maxLik = indivLik;
-			}
-		}
-
-		// This is done to avoid floating point overflow!!
-		//      average_lik    =      \sum(e^liks)   * e^maxLik  /     N
-		// log( average_lik  ) = log( \sum(e^liks) ) + maxLik   - log( N )
-		double avrgLogLik = math::averageLogLikelihood(vectLiks);
 
-		// Save into the object:
-		myObj->m_pfAuxiliaryPFStandard_estimatedProb[index] =
-			avrgLogLik;  // log( accum / N );
-
-		myObj->m_pfAuxiliaryPFOptimal_maxLikelihood[index] = maxLik;
-		if (PF_options.pfAuxFilterOptimal_MLE)
-			myObj->m_pfAuxiliaryPFOptimal_maxLikDrawnMovement[index] =
-				maxLikDraw.asTPose();
+	// Monte-Carlo approximation: draw the movement samples here, in the very
+	// same order than the serial implementation does, so the random number
+	// sequence (and hence the result) is identical. Particles are processed
+	// in batches to bound the memory used by the pre-drawn samples:
+	const size_t N = PF_options.pfAuxFilterOptimal_MaximumSearchSamples;
+	ASSERT_(N > 1);
+	const size_t batchSize = std::max<size_t>(1, 16384 / N);
 
-		// and compute the resulting probability of this particle:
-		// ------------------------------------------------------------
-		return cur_logweight +
-			   myObj->m_pfAuxiliaryPFOptimal_estimatedProb[index];
+	std::vector<mrpt::poses::CPose3D> drawnMovements;
+	for (size_t first = 0; first < M; first += batchSize)
+	{
+		const size_t last = std::min(M, first + batchSize);
+		drawnMovements.resize((last - first) * N);
+		for (auto& d : drawnMovements) m_movementDrawer.drawSample(d);
+
+		PF_SLAM_implementation_forEachParticle(
+			PF_options, first, last, [&](const size_t i) {
+				m_pfAuxiliaryPF_firstStageWeights[i] =
+					PF_SLAM_aux_computeFirstStageWeight(
+						PF_options, i, USE_OPTIMAL_SAMPLING, meanRobotMovement,
+						sf, &drawnMovements[(i - first) * N]);
+			});
 	}
+
 	MRPT_END
 }
 
@@ -647,9 +684,22 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 	auto funcStd =
 		&TMyClass::template PF_SLAM_particlesEvaluator_AuxPFStandard<BINTYPE>;
 
-	me->prepareFastDrawSample(
-		PF_options, USE_OPTIMAL_SAMPLING ? funcOpt : funcStd,
-		&meanRobotMovement, sf);
+	if (PF_SLAM_implementation_numThreads(PF_options) > 1)
+	{
+		// Evaluate the particles in parallel first, then just pass the
+		// precomputed values:
+		PF_SLAM_aux_computeFirstStageWeightsInParallel(
+			PF_options, USE_OPTIMAL_SAMPLING, meanRobotMovement, *sf);
+		me->prepareFastDrawSample(
+			PF_options, &TMyClass::PF_SLAM_particlesEvaluator_precomputed,
+			&meanRobotMovement, sf);
+	}
+	else
+	{
+		me->prepareFastDrawSample(
+			PF_options, USE_OPTIMAL_SAMPLING ? funcOpt : funcStd,
+			&meanRobotMovement, sf);
+	}
 
 	// For USE_OPTIMAL_SAMPLING=1,  m_pfAuxiliaryPFOptimal_maxLikelihood is now
 	// computed.
@@ -18,6 +18,8 @@
 #include <mrpt/poses/CPoseRandomSampler.h>
 #include <mrpt/slam/TKLDParams.h>
 #include <mrpt/system/COutputLogger.h>
+#include <mrpt/system/TaskScheduler.h>
+#include <memory>
 
 namespace mrpt::slam
 {
@@ -67,6 +69,73 @@ class PF_implementation : public mrpt::system::COutputLogger
 	mutable std::vector<mrpt::math::TPose3D>
 		m_pfAuxiliaryPFOptimal_maxLikDrawnMovement;
 	std::vector<bool> m_pfAuxiliaryPFOptimal_maxLikMovementDrawHasBeenUsed;
+	/** Auxiliary variable used in the APF algorithms when the first stage
+	 * weights are evaluated in parallel (see
+	 * TParticleFilterOptions::parallelLikelihoodThreads) */
+	mutable mrpt::math::CVectorDouble m_pfAuxiliaryPF_firstStageWeights;
+	/** Returns the maximum number of threads to use for evaluating particle
+	 * likelihoods, as set in PF_options and limited by the process-wide
+	 * mrpt::system::TaskScheduler. A value of 1 means serial evaluation. */
+	std::size_t PF_SLAM_implementation_numThreads(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options)
+		const
+	{
+		const std::size_t nMax =
+			mrpt::system::TaskScheduler::Instance().concurrency();
+		const std::size_t n = PF_options.parallelLikelihoodThreads;
+		return (n == 0 || n > nMax) ? nMax : n;
+	}
+
+	/** Calls `func(i)` for each particle index `i` in `[first,last)`, using
+	 * several threads if so set in `PF_options`. The first index is always
+	 * evaluated alone in the calling thread, so lazily-built data in maps and
+	 * observations (kd-trees, auxiliary points maps,...) exist before
+	 * concurrent calls start. */
+	template <class FUNC>
+	void PF_SLAM_implementation_forEachParticle(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const std::size_t first, const std::size_t last, FUNC&& func) const
+	{
+		PF_SLAM_implementation_forEachParticleChunk(
+			PF_options, first, last, [&](std::size_t i0, std::size_t i1) {
+				for (std::size_t i = i0; i < i1; i++) func(i);
+			});
+	}
+
+	/** Like PF_SLAM_implementation_forEachParticle(), but calls
+	 * `func(i0,i1)` for consecutive chunks of particle indices `[i0,i1)`:
+	 * first `[first,first+1)`, then the rest split in one chunk per
+	 * thread. */
+	template <class FUNC>
+	void PF_SLAM_implementation_forEachParticleChunk(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const std::size_t first, const std::size_t last, FUNC&& func) const
+	{
+		if (first >= last) return;
+		func(first, first + 1);
+		mrpt::system::parallel_for_chunks(
+			last - first - 1,
+			[&](std::size_t i0, std::size_t i1) {
+				func(first + 1 + i0, first + 1 + i1);
+			},
+			PF_SLAM_implementation_numThreads(PF_options));
+	}
+
+	/** Computes the first stage weight of the "index"-th particle for the APF
+	 * algorithms, that is, w[i]*p(z_t|...), and saves the intermediary
+	 * likelihood values into the m_pfAuxiliaryPF* member vectors.
+	 * \param drawnMovements If the Monte-Carlo approximation is used, this
+	 * must be either nullptr (samples are drawn here from m_movementDrawer) or
+	 * a pointer to `pfAuxFilterOptimal_MaximumSearchSamples` pre-drawn
+	 * movement samples.
+	 * \sa PF_SLAM_particlesEvaluator_AuxPFOptimal,
+	 * PF_SLAM_particlesEvaluator_AuxPFStandard */
+	double PF_SLAM_aux_computeFirstStageWeight(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const std::size_t index, const bool USE_OPTIMAL_SAMPLING,
+		const mrpt::poses::CPose3D& meanRobotMovement,
+		const mrpt::obs::CSensoryFrame& sf,
+		const mrpt::poses::CPose3D* drawnMovements) const;
 
 	/**  Compute w[i]*p(z_t | mu_t^i), with mu_t^i being
 	  *    the mean of the new robot pose
@@ -88,6 +157,20 @@ class PF_implementation : public mrpt::system::COutputLogger
 		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
 		const void* action, const void* observation);
 
+	/** Returns the first stage weights already computed in parallel into
+	 * m_pfAuxiliaryPF_firstStageWeights */
+	static double PF_SLAM_particlesEvaluator_precomputed(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::bayes::CParticleFilterCapable* obj, size_t index,
+		const void* action, const void* observation)
+	{
+		MRPT_UNUSED_PARAM(PF_options);
+		MRPT_UNUSED_PARAM(action);
+		MRPT_UNUSED_PARAM(observation);
+		return static_cast<const MYSELF*>(obj)
+			->m_pfAuxiliaryPF_firstStageWeights[index];
+	}
+
 	/** @} */
 
 	/** \name The generic PF implementations for localization & SLAM.
@@ -288,6 +371,27 @@ class PF_implementation : public mrpt::system::COutputLogger
 		const mrpt::obs::CSensoryFrame& observation,
 		const mrpt::poses::CPose3D& x) const = 0;
 
+	/** Evaluate the observation likelihood for several particles at once,
+	 * sharing one metric map, if the derived class can do it faster than one
+	 * by one (e.g. with COccupancyGridMap2D::computeLikelihoodField_Thrun_batch).
+	 * It may be called concurrently for different chunks of particles.
+	 * eturn false (the default) if not supported for these observations
+	 * or maps, then PF_SLAM_computeObservationLikelihoodForParticle() is used
+	 * instead.
+	 */
+	virtual bool PF_SLAM_computeObservationLikelihoodForParticles(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const mrpt::obs::CSensoryFrame& observation,
+		const std::vector<mrpt::poses::CPose3D>& poses,
+		std::vector<double>& out_log_liks) const
+	{
+		MRPT_UNUSED_PARAM(PF_options);
+		MRPT_UNUSED_PARAM(observation);
+		MRPT_UNUSED_PARAM(poses);
+		MRPT_UNUSED_PARAM(out_log_liks);
+		return false;
+	}
+
 	/** @} */
 
 	/** Auxiliary method called by PF implementations: return true if we have
@@ -315,6 +419,15 @@ class PF_implementation : public mrpt::system::COutputLogger
 		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
 		const TKLDParams& KLD_options, const bool USE_OPTIMAL_SAMPLING);
 
+	/** Fills m_pfAuxiliaryPF_firstStageWeights with the output of
+	 * PF_SLAM_aux_computeFirstStageWeight() for all particles, using the
+	 * worker threads. The result is identical to the serial evaluation. */
+	void PF_SLAM_aux_computeFirstStageWeightsInParallel(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const bool USE_OPTIMAL_SAMPLING,
+		const mrpt::poses::CPose3D& meanRobotMovement,
+		const mrpt::obs::CSensoryFrame& sf);
+
 	template <class BINTYPE>
 	void PF_SLAM_aux_perform_one_rejection_sampling_step(
 		const bool USE_OPTIMAL_SAMPLING, const bool doResample,
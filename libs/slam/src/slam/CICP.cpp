@@ -53,6 +53,11 @@ CPosePDF::Ptr CICP::AlignPDF(
 		case icpLevenbergMarquardt:
 			resultPDF = ICP_Method_LM(m1, mm2, initialEstimationPDF, outInfo);
 			break;
+		case icpPointToPlane:
+		case icpGICP:
+			THROW_EXCEPTION(
+				"icpPointToPlane and icpGICP are only implemented for ICP-3D");
+			break;
 		default:
 			THROW_EXCEPTION_FMT(
 				"Invalid value for ICP_algorithm: %i",
@@ -118,6 +123,9 @@ void CICP::TConfigParams::loadFromConfigFile(
 
 	MRPT_LOAD_CONFIG_VAR(
 		corresponding_points_decimation, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(matchingThreads, uint64_t, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(normals_kNeighbors, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(robust_solver_maxIterations, int, iniFile, section);
 }
 
 void CICP::TConfigParams::saveToConfigFile(
@@ -166,6 +174,15 @@ void CICP::TConfigParams::saveToConfigFile(
 	MRPT_SAVE_CONFIG_VAR_COMMENT(skip_cov_calculation, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(skip_quality_calculation, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(corresponding_points_decimation, "");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		matchingThreads,
+		"Threads for finding correspondences (1=serial, 0=all cores)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		normals_kNeighbors,
+		"Neighbors for estimating normals (icpPointToPlane, icpGICP)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		robust_solver_maxIterations,
+		"Solver iterations per ICP iteration (icpPointToPlane, icpGICP)");
 }
 
 float CICP::kernel(const float& x2, const float& rho2)
@@ -228,6 +245,7 @@ CPosePDF::Ptr CICP::ICP_Method_Classic(
 	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.matchingThreads = options.matchingThreads;
 
 	// Asure maps are not empty!
 	// ------------------------------------------------------
@@ -598,6 +616,7 @@ CPosePDF::Ptr CICP::ICP_Method_LM(
 	matchParams.onlyUniqueRobust = onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.matchingThreads = options.matchingThreads;
 
 	// The gaussian PDF to estimate:
 	// ------------------------------------------------------
@@ -930,11 +949,14 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 	switch (options.ICP_algorithm)
 	{
 		case icpClassic:
+		case icpPointToPlane:
+		case icpGICP:
 			resultPDF =
 				ICP3D_Method_Classic(m1, mm2, initialEstimationPDF, outInfo);
 			break;
 		case icpLevenbergMarquardt:
-			THROW_EXCEPTION("Only icpClassic is implemented for ICP-3D");
+			THROW_EXCEPTION(
+				"icpLevenbergMarquardt is not implemented for ICP-3D");
 			break;
 		default:
 			THROW_EXCEPTION_FMT(
@@ -958,6 +980,75 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 	MRPT_END
 }
 
+/** Iteratively reweighted Gauss-Newton refinement of the pose of the "other"
+ * map in ICP-3D, minimizing point-to-plane errors (if `normals1` is given) or
+ * plane-to-plane GICP errors (with `covs1` and `covs2`) for a fixed set of
+ * correspondences, with a Cauchy robust kernel of scale `rho` (if `rho>0`).
+ * Pose increments are applied on the left: `pose = exp(delta) (+) pose`.
+ */
+static void se3_robust_gauss_newton(
+	const TMatchingPairList& corrs, const std::vector<TPoint3Df>* normals1,
+	const std::vector<CMatrixFloat33>* covs1,
+	const std::vector<CMatrixFloat33>* covs2, const unsigned int maxIters,
+	const double rho, CPose3D& pose)
+{
+	const double rho2 = mrpt::square(rho);
+	for (unsigned int iter = 0; iter < maxIters; iter++)
+	{
+		Eigen::Matrix<double, 6, 6> H = Eigen::Matrix<double, 6, 6>::Zero();
+		Eigen::Matrix<double, 6, 1> g = Eigen::Matrix<double, 6, 1>::Zero();
+		const Eigen::Matrix3d R = pose.getRotationMatrix();
+
+		for (const auto& c : corrs)
+		{
+			TPoint3D p;
+			pose.composePoint(c.other_x, c.other_y, c.other_z, p.x, p.y, p.z);
+			const Eigen::Vector3d err(
+				p.x - c.this_x, p.y - c.this_y, p.z - c.this_z);
+
+			// Jacobian of the transformed point wrt the increment
+			// (dx,dy,dz,wx,wy,wz):  [ I_3 | -[p]_x ]
+			Eigen::Matrix<double, 3, 6> Jp;
+			Jp.leftCols<3>().setIdentity();
+			Jp.rightCols<3>() << 0, p.z, -p.y, -p.z, 0, p.x, p.y, -p.x, 0;
+
+			if (normals1)
+			{
+				const TPoint3Df& n = (*normals1)[c.this_idx];
+				const Eigen::Vector3d nv(n.x, n.y, n.z);
+				if (nv.squaredNorm() == 0) continue;
+				const double r = nv.dot(err);
+				const double w = rho2 > 0 ? 1.0 / (1.0 + r * r / rho2) : 1.0;
+				const Eigen::Matrix<double, 1, 6> J = nv.transpose() * Jp;
+				H.noalias() += w * J.transpose() * J;
+				g.noalias() += (w * r) * J.transpose();
+			}
+			else
+			{
+				const Eigen::Matrix3d C =
+					(*covs1)[c.this_idx].cast<double>() +
+					R * (*covs2)[c.other_idx].cast<double>() * R.transpose();
+				const Eigen::Matrix3d M = C.inverse();
+				const double r2 = err.squaredNorm();
+				const double w = rho2 > 0 ? 1.0 / (1.0 + r2 / rho2) : 1.0;
+				H.noalias() += w * Jp.transpose() * M * Jp;
+				g.noalias() += w * Jp.transpose() * (M * err);
+			}
+		}
+
+		// Small damping for directions not constrained by the data:
+		H.diagonal().array() += 1e-9 * (1.0 + H.diagonal().maxCoeff());
+		const Eigen::Matrix<double, 6, 1> delta = -H.ldlt().solve(g);
+		if (!delta.allFinite()) break;
+
+		CArrayDouble<6> incr;
+		for (int i = 0; i < 6; i++) incr[i] = delta[i];
+		pose = CPose3D::exp(incr, true /*pseudo-exponential*/) + pose;
+
+		if (delta.squaredNorm() < 1e-16) break;
+	}
+}
+
 CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* mm2,
 	const CPose3DPDFGaussian& initialEstimationPDF, TReturnInfo& outInfo)
@@ -978,6 +1069,22 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	ASSERT_(mm2->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)));
 	const CPointsMap* m2 = (CPointsMap*)mm2;
 
+	// Local surface normals or covariances for icpPointToPlane and icpGICP:
+	const std::vector<TPoint3Df>* normals1 = nullptr;
+	const std::vector<CMatrixFloat33>*covs1 = nullptr, *covs2 = nullptr;
+	if (options.ICP_algorithm != icpClassic)
+	{
+		ASSERT_(m1->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)));
+		const CPointsMap* m1pts = static_cast<const CPointsMap*>(m1);
+		if (options.ICP_algorithm == icpPointToPlane)
+			normals1 = &m1pts->getPointsNormals(options.normals_kNeighbors);
+		else
+		{
+			covs1 = &m1pts->getPointsCovariances(options.normals_kNeighbors);
+			covs2 = &m2->getPointsCovariances(options.normals_kNeighbors);
+		}
+	}
+
 	// Asserts:
 	// -----------------
 	ASSERT_(options.ALFA > 0 && options.ALFA < 1);
@@ -1007,6 +1114,7 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.matchingThreads = options.matchingThreads;
 
 	// Asure maps are not empty!
 	// ------------------------------------------------------
@@ -1039,14 +1147,26 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 			}
 			else
 			{
-				// Compute the estimated pose, using Horn's method.
-				// ----------------------------------------------------------------------
-				mrpt::poses::CPose3DQuat estPoseQuat;
-				double transf_scale;
-				mrpt::tfest::se3_l2(
-					correspondences, estPoseQuat, transf_scale,
-					false /* dont force unit scale */);
-				gaussPdf->mean = mrpt::poses::CPose3D(estPoseQuat);
+				if (options.ICP_algorithm == icpClassic)
+				{
+					// Compute the estimated pose, using Horn's method.
+					// ----------------------------------------------------------------------
+					mrpt::poses::CPose3DQuat estPoseQuat;
+					double transf_scale;
+					mrpt::tfest::se3_l2(
+						correspondences, estPoseQuat, transf_scale,
+						false /* dont force unit scale */);
+					gaussPdf->mean = mrpt::poses::CPose3D(estPoseQuat);
+				}
+				else
+				{
+					// Refine the pose with point-to-plane or GICP errors:
+					se3_robust_gauss_newton(
+						correspondences, normals1, covs1, covs2,
+						options.robust_solver_maxIterations,
+						options.use_kernel ? options.kernel_rho : 0,
+						gaussPdf->mean);
+				}
 
 				// If matching has not changed, decrease the thresholds:
 				// --------------------------------------------------------
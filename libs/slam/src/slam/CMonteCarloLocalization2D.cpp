@@ -13,6 +13,7 @@
 
 #include <mrpt/system/CTicTac.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CMultiMetricMap.h>
 #include <mrpt/obs/CActionCollection.h>
 #include <mrpt/obs/CSensoryFrame.h>
 
@@ -187,6 +188,49 @@ double
 	return ret;
 }
 
+/*---------------------------------------------------------------
+			PF_SLAM_computeObservationLikelihoodForParticles
+ ---------------------------------------------------------------*/
+bool CMonteCarloLocalization2D::PF_SLAM_computeObservationLikelihoodForParticles(
+	const CParticleFilter::TParticleFilterOptions& PF_options,
+	const CSensoryFrame& observation, const std::vector<CPose3D>& poses,
+	std::vector<double>& out_log_liks) const
+{
+	MRPT_UNUSED_PARAM(PF_options);
+	if (!options.metricMap) return false;  // One map per particle
+
+	// Look for a grid map, maybe within a multi-metric map:
+	CMetricMap* map = options.metricMap;
+	auto* multiMap = dynamic_cast<CMultiMetricMap*>(map);
+	if (multiMap)
+	{
+		if (multiMap->maps.size() != 1 ||
+			!multiMap->genericMapParams.enableObservationLikelihood)
+			return false;
+		map = multiMap->maps[0].get();
+	}
+	auto* grid = dynamic_cast<COccupancyGridMap2D*>(map);
+	if (!grid) return false;
+
+	std::vector<TPose2D> poses2D;
+	poses2D.reserve(poses.size());
+	for (const auto& p : poses) poses2D.emplace_back(p.x(), p.y(), p.yaw());
+
+	// Same as PF_SLAM_computeObservationLikelihoodForParticle(), for all the
+	// observations in the SF or none:
+	std::vector<double> obs_log_liks;
+	out_log_liks.assign(poses.size(), 1.0);
+	for (const auto& obs : observation)
+	{
+		if (!grid->computeObservationLikelihood_batch(
+				obs.get(), poses2D, obs_log_liks))
+			return false;
+		for (size_t i = 0; i < poses.size(); i++)
+			out_log_liks[i] += obs_log_liks[i];
+	}
+	return true;
+}
+
 // Specialization for my kind of particles:
 void CMonteCarloLocalization2D::
 	PF_SLAM_implementation_custom_update_particle_with_new_pose(
@@ -15,6 +15,7 @@
 #include <mrpt/obs/CRawlog.h>
 #include <mrpt/system/filesystem.h>
 #include <mrpt/system/os.h>
+#include <mrpt/system/TaskScheduler.h>
 #include <mrpt/random.h>
 #include <gtest/gtest.h>
 
@@ -313,3 +314,95 @@ TEST(MonteCarlo2D, RunSampleDataset)
 
 	FAIL() << "Failed to converge after 3 opportunities!!" << endl;
 }
+
+// Runs a few PF steps with a fixed random seed and returns the final particles
+static void run_pf_few_steps(
+	const CMultiMetricMap& metricMap, const CRawlog& rawlog,
+	const CParticleFilter::TParticleFilterOptions& pfOptions,
+	std::vector<std::pair<TPose2D, double>>& outParticles)
+{
+	getRandomGenerator().randomize(1234);
+
+	CMonteCarloLocalization2D pdf(500);
+	pdf.options.metricMap = const_cast<CMultiMetricMap*>(&metricMap);
+	pdf.options.KLD_params.KLD_minSampleSize = 500;
+	pdf.resetUniform(-10, 10, -15, -5, -M_PI, M_PI, 500);
+
+	CParticleFilter PF;
+	PF.m_options = pfOptions;
+
+	CActionCollection::Ptr action;
+	CSensoryFrame::Ptr observations;
+	size_t rawlogEntry = 0;
+	for (int step = 0; step < 8; step++)
+	{
+		ASSERT_TRUE(
+			rawlog.getActionObservationPair(action, observations, rawlogEntry));
+		PF.executeOn(pdf, action.get(), observations.get());
+	}
+
+	outParticles.clear();
+	for (size_t i = 0; i < pdf.particlesCount(); i++)
+		outParticles.emplace_back(pdf.getParticlePose(i), pdf.getW(i));
+}
+
+TEST(MonteCarlo2D, ParallelLikelihoodIsIdenticalToSerial)
+{
+	const string ini_fil =
+		MRPT_GLOBAL_UNITTEST_SRC_DIR + string("/tests/montecarlo_test1.ini");
+	if (!mrpt::system::fileExists(ini_fil))
+	{
+		cerr << "WARNING: Skipping test due to missing file: " << ini_fil
+			 << "\n";
+		return;
+	}
+	CConfigFile iniFile(ini_fil);
+
+	TSetOfMetricMapInitializers mapList;
+	mapList.loadFromConfigFile(iniFile, "MetricMap");
+	CMultiMetricMap metricMap;
+	metricMap.setListOfMaps(&mapList);
+	{
+		CSimpleMap simpleMap;
+		CFileGZInputStream f(
+			MRPT_GLOBAL_UNITTEST_SRC_DIR +
+			string("/share/mrpt/datasets/localization_demo.simplemap.gz"));
+		mrpt::serialization::archiveFrom(f) >> simpleMap;
+		metricMap.loadFromProbabilisticPosesAndObservations(simpleMap);
+	}
+	CRawlog rawlog;
+	ASSERT_TRUE(rawlog.loadFromRawLogFile(
+		MRPT_GLOBAL_UNITTEST_SRC_DIR +
+		string("/share/mrpt/datasets/localization_demo.rawlog")));
+
+	for (const auto alg : {CParticleFilter::pfStandardProposal,
+						   CParticleFilter::pfAuxiliaryPFStandard,
+						   CParticleFilter::pfAuxiliaryPFOptimal})
+	{
+		SCOPED_TRACE(mrpt::format("PF_algorithm=%i", static_cast<int>(alg)));
+		CParticleFilter::TParticleFilterOptions pfOptions;
+		pfOptions.PF_algorithm = alg;
+		pfOptions.pfAuxFilterOptimal_MaximumSearchSamples = 10;
+
+		std::vector<std::pair<TPose2D, double>> serial, parallel;
+		pfOptions.parallelLikelihoodThreads = 1;
+		run_pf_few_steps(metricMap, rawlog, pfOptions, serial);
+		pfOptions.parallelLikelihoodThreads = 4;
+		{
+			// The number of chunks is capped by the scheduler concurrency:
+			// force 4 threads, so the likelihoods are actually evaluated in
+			// parallel even on single-core machines.
+			mrpt::system::TaskSchedulerThreadsGuard threads(4);
+			run_pf_few_steps(metricMap, rawlog, pfOptions, parallel);
+		}
+
+		ASSERT_EQ(serial.size(), parallel.size());
+		for (size_t i = 0; i < serial.size(); i++)
+		{
+			EXPECT_EQ(serial[i].first.x, parallel[i].first.x);
+			EXPECT_EQ(serial[i].first.y, parallel[i].first.y);
+			EXPECT_EQ(serial[i].first.phi, parallel[i].first.phi);
+			EXPECT_EQ(serial[i].second, parallel[i].second);
+		}
+	}
+}
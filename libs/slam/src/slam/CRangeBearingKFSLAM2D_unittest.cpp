@@ -0,0 +1,198 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/slam/CRangeBearingKFSLAM2D.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CObservationBearingRange.h>
+#include <mrpt/random.h>
+#include <mrpt/system/TaskScheduler.h>
+#include <gtest/gtest.h>
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace mrpt::slam;
+using namespace mrpt::maps;
+using namespace mrpt::poses;
+using namespace mrpt::math;
+using namespace mrpt::random;
+using namespace mrpt::obs;
+using namespace std;
+
+// Simulates a robot moving in circles within a grid of landmarks, with
+// known IDs, and returns the final estimate of the robot pose and the map.
+static void run_kf_slam_2d(
+	const TKFMethod method, CPose2D& gt_pose, CPosePDFGaussian& est_pose,
+	vector<TPoint2D>& gt_lms, vector<TPoint2D>& est_lms,
+	CRangeBearingKFSLAM2D& slam)
+{
+	auto& rnd = getRandomGenerator();
+	rnd.randomize(1234);
+
+	// The robot starts at the origin and turns around (0,3), with a radius of
+	// 3 m, so it gets closer than max_range to all these landmarks:
+	gt_lms.clear();
+	for (int ix = -3; ix <= 3; ix++)
+		for (int iy = -3; iy <= 3; iy++)
+			gt_lms.emplace_back(ix * 1.5 + 0.3 * iy, 3 + iy * 1.5 - 0.2 * ix);
+
+	slam.KF_options.method = method;
+	slam.KF_options.SEIF_max_active_landmarks = 6;
+	slam.options.std_sensor_range = 0.02f;
+	slam.options.std_sensor_yaw = DEG2RAD(0.5f);
+	slam.reset();
+
+	const double std_odo_xy = 0.01, std_odo_phi = DEG2RAD(0.5);
+	const double max_range = 4.0;
+	gt_pose = CPose2D(0, 0, 0);
+
+	for (int step = 0; step < 150; step++)
+	{
+		const CPose2D incr(step ? 0.15 : 0.0, 0, step ? 0.05 : 0.0);
+		gt_pose = gt_pose + incr;
+
+		CActionRobotMovement2D actmov;
+		CActionRobotMovement2D::TMotionModelOptions odo_opts;
+		odo_opts.modelSelection = CActionRobotMovement2D::mmGaussian;
+		odo_opts.gaussianModel.a1 = 0;
+		odo_opts.gaussianModel.a2 = 0;
+		odo_opts.gaussianModel.a3 = 0;
+		odo_opts.gaussianModel.a4 = 0;
+		odo_opts.gaussianModel.minStdXY = std_odo_xy;
+		odo_opts.gaussianModel.minStdPHI = std_odo_phi;
+		CPose2D noisy_incr = incr;
+		noisy_incr.x_incr(rnd.drawGaussian1D(0, std_odo_xy));
+		noisy_incr.y_incr(rnd.drawGaussian1D(0, std_odo_xy));
+		noisy_incr.phi_incr(rnd.drawGaussian1D(0, std_odo_phi));
+		actmov.computeFromOdometry(noisy_incr, odo_opts);
+		auto act = mrpt::make_aligned_shared<CActionCollection>();
+		act->insert(actmov);
+
+		CObservationBearingRange obs;
+		obs.minSensorDistance = 0;
+		obs.maxSensorDistance = max_range;
+		obs.fieldOfView_yaw = 2 * M_PI;
+		for (size_t i = 0; i < gt_lms.size(); i++)
+		{
+			const CPoint2D rel = CPoint2D(gt_lms[i]) - gt_pose;
+			const double r = rel.norm();
+			if (r > max_range) continue;
+			CObservationBearingRange::TMeasurement m;
+			m.range = r + rnd.drawGaussian1D(0, slam.options.std_sensor_range);
+			m.yaw = atan2(rel.y(), rel.x()) +
+					rnd.drawGaussian1D(0, slam.options.std_sensor_yaw);
+			m.pitch = 0;
+			m.landmarkID = static_cast<int32_t>(i);
+			obs.sensedData.push_back(m);
+		}
+		auto sf = mrpt::make_aligned_shared<CSensoryFrame>();
+		sf->insert(mrpt::make_aligned_shared<CObservationBearingRange>(obs));
+
+		slam.processActionObservation(act, sf);
+	}
+
+	map<unsigned int, CLandmark::TLandmarkID> ids;
+	CVectorDouble full_state;
+	CMatrixDouble full_cov;
+	vector<TPoint2D> lms;
+	slam.getCurrentState(est_pose, lms, ids, full_state, full_cov);
+	EXPECT_EQ(full_cov.rows(), full_state.size());
+
+	// Sort by landmark ID:
+	est_lms.assign(gt_lms.size(), TPoint2D(0, 0));
+	for (const auto& id : ids) est_lms.at(id.second) = lms.at(id.first);
+}
+
+TEST(CRangeBearingKFSLAM2D, SEIF_vs_EKF)
+{
+	CRangeBearingKFSLAM2D ekf, seif;
+	CPose2D gt_pose;
+	CPosePDFGaussian pose_ekf, pose_seif;
+	vector<TPoint2D> gt_lms, lms_ekf, lms_seif;
+
+	run_kf_slam_2d(kfEKFNaive, gt_pose, pose_ekf, gt_lms, lms_ekf, ekf);
+	run_kf_slam_2d(kfSEIF, gt_pose, pose_seif, gt_lms, lms_seif, seif);
+	ASSERT_EQ(seif.getNumberOfLandmarksInTheMap(), gt_lms.size());
+
+	// Both filters must be close to the ground truth and to each other:
+	for (const auto* p : {&pose_ekf, &pose_seif})
+	{
+		EXPECT_NEAR(p->mean.x(), gt_pose.x(), 0.15);
+		EXPECT_NEAR(p->mean.y(), gt_pose.y(), 0.15);
+		EXPECT_NEAR(
+			mrpt::math::wrapToPi(p->mean.phi() - gt_pose.phi()), 0.0,
+			DEG2RAD(3.0));
+	}
+	EXPECT_NEAR(pose_seif.mean.x(), pose_ekf.mean.x(), 0.05);
+	EXPECT_NEAR(pose_seif.mean.y(), pose_ekf.mean.y(), 0.05);
+	for (size_t i = 0; i < gt_lms.size(); i++)
+	{
+		EXPECT_NEAR(lms_ekf[i].x, gt_lms[i].x, 0.2);
+		EXPECT_NEAR(lms_ekf[i].y, gt_lms[i].y, 0.2);
+		EXPECT_NEAR(lms_seif[i].x, lms_ekf[i].x, 0.1);
+		EXPECT_NEAR(lms_seif[i].y, lms_ekf[i].y, 0.1);
+	}
+
+	// The sparsification makes SEIF somewhat overconfident, but its
+	// covariances must stay close to those of the EKF:
+	for (int i = 0; i < 3; i++)
+	{
+		EXPECT_GE(pose_seif.cov(i, i), 0.7 * pose_ekf.cov(i, i));
+		EXPECT_LT(pose_seif.cov(i, i), 10 * pose_ekf.cov(i, i));
+	}
+	const auto eig_seif = pose_seif.cov.eigenvalues().real().eval();
+	const auto eig_ekf = pose_ekf.cov.eigenvalues().real().eval();
+	EXPECT_GE(eig_seif.minCoeff(), 0.7 * eig_ekf.minCoeff());
+
+	for (size_t i = 0; i < gt_lms.size(); i++)
+	{
+		CRangeBearingKFSLAM2D::KFMatrix_FxF cov_ekf, cov_seif;
+		ekf.getLandmarkCov(i, cov_ekf);
+		seif.getLandmarkCov(i, cov_seif);
+		EXPECT_GE(cov_seif(0, 0), 0.7 * cov_ekf(0, 0));
+		EXPECT_GE(cov_seif(1, 1), 0.7 * cov_ekf(1, 1));
+	}
+}
+
+// The batch mode must give the same estimate than the serial one, and
+// exactly the same one for any number of threads:
+TEST(CRangeBearingKFSLAM2D, BatchMode)
+{
+	// Make sure there are worker threads, even on single-core machines:
+	mrpt::system::TaskSchedulerThreadsGuard threads(4);
+
+	for (const TKFMethod method : {kfEKFNaive, kfIKFFull})
+		for (const bool analytic : {true, false})
+		{
+			const unsigned int nThreads[3] = {1, 0, 2};
+			CVectorDouble state[3];
+			CMatrixDouble cov[3];
+			for (int k = 0; k < 3; k++)
+			{
+				CRangeBearingKFSLAM2D slam;
+				slam.KF_options.num_threads = nThreads[k];
+				slam.KF_options.use_analytic_observation_jacobian = analytic;
+				CPose2D gt_pose;
+				CPosePDFGaussian pose;
+				vector<TPoint2D> gt_lms, lms;
+				run_kf_slam_2d(method, gt_pose, pose, gt_lms, lms, slam);
+
+				map<unsigned int, CLandmark::TLandmarkID> ids;
+				slam.getCurrentState(pose, lms, ids, state[k], cov[k]);
+				ASSERT_EQ(slam.getNumberOfLandmarksInTheMap(), gt_lms.size());
+			}
+			ASSERT_EQ(state[1].size(), state[0].size());
+			EXPECT_LT((state[1] - state[0]).array().abs().maxCoeff(), 1e-6)
+				<< "method=" << method << " analytic=" << analytic;
+			EXPECT_LT((cov[1] - cov[0]).array().abs().maxCoeff(), 1e-9)
+				<< "method=" << method << " analytic=" << analytic;
+			EXPECT_TRUE(state[2] == state[1]);
+			EXPECT_TRUE(cov[2] == cov[1]);
+			EXPECT_TRUE(cov[1] == cov[1].transpose());
+		}
+}
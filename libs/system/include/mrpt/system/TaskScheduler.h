@@ -0,0 +1,343 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace mrpt::system
+{
+class CTimeLogger;
+
+/** A work-stealing scheduler of short, CPU-bound tasks, meant to be shared by
+ * all the parallel algorithms running in a process.
+ *
+ * Each worker thread owns a queue of tasks: tasks spawned from a worker are
+ * pushed into its own queue and run in LIFO order, while idle workers steal
+ * the oldest tasks from other queues. Tasks spawned from any other thread go
+ * into a shared FIFO queue. Threads waiting for a TaskGroup or a future run
+ * pending tasks meanwhile, so parallel loops can be nested without
+ * deadlocks nor creating additional threads.
+ *
+ * Algorithms should normally use the process-wide instance (Instance()),
+ * through TaskGroup, parallel_for() or parallel_for_chunks(), so that
+ * several MRPT components working at once in the same process do not
+ * oversubscribe the CPU cores.
+ *
+ * The number of threads of the process-wide instance is, by order of
+ * preference:
+ * - The last value passed to setNumThreads(), which can be loaded from a
+ * config file with mrpt::config::loadTaskSchedulerConfig().
+ * - The environment variable `MRPT_NUM_THREADS`. `MRPT_NUM_THREADS=1`
+ * disables all parallelism, which is useful while debugging.
+ * - The number of hardware threads.
+ *
+ * \sa TaskGroup, parallel_for()
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_system_grp
+ */
+class TaskScheduler
+{
+   public:
+	/** Creates a scheduler with `concurrency` threads in total: the calling
+	 * thread of each parallel algorithm, plus `concurrency-1` worker threads.
+	 * A value of `0` means as many as DefaultConcurrency(). */
+	explicit TaskScheduler(std::size_t concurrency = 0);
+	/** Runs all pending tasks, then stops all worker threads. */
+	~TaskScheduler();
+
+	TaskScheduler(const TaskScheduler&) = delete;
+	TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+	/** The process-wide scheduler, created upon first call. */
+	static TaskScheduler& Instance();
+
+	/** Value of the environment variable `MRPT_NUM_THREADS` if defined and
+	 * valid, or the number of hardware threads otherwise. */
+	static std::size_t DefaultConcurrency();
+
+	/** Changes the number of threads (see the constructor). It must not be
+	 * called while any parallel algorithm is running in the scheduler,
+	 * typically it is called once at program start up. */
+	void setNumThreads(std::size_t concurrency);
+
+	/** Number of worker threads. */
+	std::size_t size() const { return m_workers.size(); }
+	/** Maximum number of threads running tasks at once, that is, the
+	 * worker threads plus the thread waiting for them. */
+	std::size_t concurrency() const { return m_workers.size() + 1; }
+
+	/** Number of tasks waiting in any queue to be picked up. */
+	std::size_t pendingTasks() const;
+
+	/** Enqueues a task, which must not throw. TaskGroup and async() are
+	 * higher-level alternatives to this method. */
+	void spawn(std::function<void()> task);
+
+	/** Enqueues a task and returns a future for its result, or for the
+	 * exception it throws. Use wait() to wait for the result while helping
+	 * with other tasks. */
+	template <class F>
+	auto async(F&& f) -> std::future<std::invoke_result_t<F>>
+	{
+		using return_type = std::invoke_result_t<F>;
+		auto task = std::make_shared<std::packaged_task<return_type()>>(
+			std::forward<F>(f));
+		std::future<return_type> res = task->get_future();
+		spawn([task]() { (*task)(); });
+		return res;
+	}
+
+	/** Waits for a future to become ready, running pending tasks meanwhile.
+	 * This avoids deadlocks if called from a task, or if there are no worker
+	 * threads at all. */
+	template <class T>
+	void wait(const std::future<T>& f)
+	{
+		while (f.wait_for(std::chrono::seconds(0)) !=
+			   std::future_status::ready)
+			if (!runPendingTask()) f.wait_for(std::chrono::milliseconds(1));
+	}
+
+	/** Runs one pending task in the calling thread, if there is any.
+	 * \return false if there were no pending tasks. */
+	bool runPendingTask();
+
+   private:
+	struct Worker;
+	std::vector<std::unique_ptr<Worker>> m_workers;
+	/** Tasks spawned from threads other than the workers */
+	std::deque<std::function<void()>> m_injected;
+	mutable std::mutex m_injected_mtx;
+	/** Protects m_pending and m_stop, used to put idle workers to sleep */
+	mutable std::mutex m_sleep_mtx;
+	std::condition_variable m_wakeup;
+	std::size_t m_pending{0};
+	bool m_stop{false};
+
+	void start(std::size_t concurrency);
+	void stop();
+	void workerMain(std::size_t index);
+	bool popTask(std::function<void()>& task);
+};
+
+/** Sets the number of threads of TaskScheduler::Instance() for as long as
+ * this object lives, and restores the previous value upon destruction, even
+ * if an exception is thrown meanwhile. Useful in unit tests, which need
+ * worker threads to run the parallel code paths even on single-core machines.
+ * The restrictions of TaskScheduler::setNumThreads() apply to both the
+ * constructor and the destructor.
+ *
+ * \code
+ * {
+ *   mrpt::system::TaskSchedulerThreadsGuard threads(4);
+ *   runParallelAlgorithm();
+ * }  // The former number of threads is restored here
+ * \endcode
+ *
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_system_grp
+ */
+class TaskSchedulerThreadsGuard
+{
+   public:
+	explicit TaskSchedulerThreadsGuard(std::size_t concurrency)
+		: m_prevConcurrency(TaskScheduler::Instance().concurrency())
+	{
+		TaskScheduler::Instance().setNumThreads(concurrency);
+	}
+	~TaskSchedulerThreadsGuard()
+	{
+		TaskScheduler::Instance().setNumThreads(m_prevConcurrency);
+	}
+
+	TaskSchedulerThreadsGuard(const TaskSchedulerThreadsGuard&) = delete;
+	TaskSchedulerThreadsGuard& operator=(const TaskSchedulerThreadsGuard&) =
+		delete;
+
+   private:
+	const std::size_t m_prevConcurrency;
+};
+
+/** A group of tasks run in a TaskScheduler, which can be waited for as a
+ * whole. Exceptions thrown by the tasks are rethrown by wait().
+ *
+ * \code
+ * mrpt::system::TaskGroup tg;
+ * tg.run([&]() { computeA(); });
+ * tg.run([&]() { computeB(); });
+ * tg.wait();  // The calling thread helps running tasks
+ * \endcode
+ *
+ * If a CTimeLogger is set with setProfiler(), the wall time from the first
+ * run() until wait() returns is logged as a section with the given name, and
+ * the number of tasks and the achieved speed-up (sum of times of all tasks,
+ * divided by the wall time) as user measures named `<name>.tasks` and
+ * `<name>.speedup`, respectively.
+ *
+ * \sa TaskScheduler, parallel_for()
+ * \note [New in MRPT 2.0.0]
+ * \ingroup mrpt_system_grp
+ */
+class TaskGroup
+{
+   public:
+	explicit TaskGroup(TaskScheduler& sched = TaskScheduler::Instance())
+		: m_sched(sched)
+	{
+	}
+	/** Waits for all tasks, discarding their exceptions, if any. */
+	~TaskGroup();
+
+	TaskGroup(const TaskGroup&) = delete;
+	TaskGroup& operator=(const TaskGroup&) = delete;
+
+	/** Enqueues `f()` for execution in the scheduler. */
+	template <class F>
+	void run(F&& f)
+	{
+		taskStarting();
+		m_sched.spawn([this, f = std::forward<F>(f)]() mutable {
+			const auto t0 = std::chrono::steady_clock::now();
+			std::exception_ptr e;
+			try
+			{
+				f();
+			}
+			catch (...)
+			{
+				e = std::current_exception();
+			}
+			taskFinished(
+				std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - t0)
+					.count(),
+				e);
+		});
+	}
+
+	/** Waits for all tasks run so far, running pending tasks meanwhile, and
+	 * rethrows the first exception thrown by any of them. */
+	void wait();
+
+	/** Logs the group statistics into `profiler`, which can be `nullptr`.
+	 * Must be called before run(). */
+	void setProfiler(CTimeLogger* profiler, const std::string& name);
+
+   private:
+	TaskScheduler& m_sched;
+	std::mutex m_mtx;
+	std::condition_variable m_done;
+	std::size_t m_pending{0}, m_numTasks{0};
+	double m_tasksTime{0};
+	std::exception_ptr m_exception;
+	CTimeLogger* m_profiler{nullptr};
+	std::string m_profilerName;
+
+	void taskStarting();
+	void taskFinished(double elapsed, std::exception_ptr e);
+};
+
+/** Runs `func(first, last)` on consecutive, disjoint sub-ranges of the index
+ * range `[0, N)` in the process-wide TaskScheduler, and waits for all of them
+ * to finish. The calling thread processes the first sub-range.
+ *
+ * \param maxChunks Maximum number of sub-ranges. `0` means as many as the
+ * scheduler concurrency, while `1` runs `func(0, N)` serially in the calling
+ * thread. This is normally given by a per-algorithm parameter.
+ *
+ * Since each index is processed exactly once by the same code regardless of
+ * the thread, the outcome is identical to the serial loop as long as `func`
+ * only writes to per-index outputs.
+ *
+ * Exceptions thrown by `func` are rethrown in the calling thread.
+ * \ingroup mrpt_system_grp
+ */
+template <class FUNC>
+void parallel_for_chunks(
+	const std::size_t N, FUNC&& func, const std::size_t maxChunks = 0,
+	TaskScheduler& sched = TaskScheduler::Instance())
+{
+	std::size_t nChunks = sched.concurrency();
+	if (maxChunks) nChunks = std::min(nChunks, maxChunks);
+	nChunks = std::min(nChunks, N);
+	if (nChunks <= 1)
+	{
+		func(std::size_t(0), N);
+		return;
+	}
+	// The destructor of "tg" waits for all chunks before leaving this scope,
+	// also if func() throws in this thread:
+	TaskGroup tg(sched);
+	for (std::size_t c = 1; c < nChunks; c++)
+	{
+		const std::size_t first = (N * c) / nChunks,
+						  last = (N * (c + 1)) / nChunks;
+		tg.run([&func, first, last]() { func(first, last); });
+	}
+	func(std::size_t(0), N / nChunks);
+	tg.wait();
+}
+
+/** Calls `body(i)` for each index `i` in `[first, last)`, in parallel in the
+ * process-wide TaskScheduler, and waits for all calls to finish.
+ *
+ * The range is split into tasks of `grainSize` consecutive indices, which
+ * the scheduler balances among threads. A `grainSize` of `0` picks a size
+ * that makes a few tasks per thread, which suits loops whose iterations have
+ * similar costs. Exceptions thrown by `body` are rethrown in the calling
+ * thread.
+ *
+ * \code
+ * mrpt::system::parallel_for(0, v.size(), [&](std::size_t i) {
+ *     out[i] = f(v[i]);
+ * });
+ * \endcode
+ * \sa parallel_for_chunks(), TaskGroup
+ * \ingroup mrpt_system_grp
+ */
+template <class FUNC>
+void parallel_for(
+	const std::size_t first, const std::size_t last, FUNC&& body,
+	std::size_t grainSize = 0,
+	TaskScheduler& sched = TaskScheduler::Instance())
+{
+	if (last <= first) return;
+	const std::size_t N = last - first;
+	if (!grainSize)
+		grainSize = std::max<std::size_t>(1, N / (4 * sched.concurrency()));
+	if (sched.concurrency() <= 1 || grainSize >= N)
+	{
+		for (std::size_t i = first; i < last; i++) body(i);
+		return;
+	}
+	TaskGroup tg(sched);
+	for (std::size_t i0 = first + grainSize; i0 < last; i0 += grainSize)
+	{
+		const std::size_t i1 = std::min(last, i0 + grainSize);
+		tg.run([&body, i0, i1]() {
+			for (std::size_t i = i0; i < i1; i++) body(i);
+		});
+	}
+	for (std::size_t i = first; i < first + grainSize; i++) body(i);
+	tg.wait();
+}
+
+}  // namespace mrpt::system
@@ -0,0 +1,265 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "system-precomp.h"  // Precompiled headers
+
+#include <mrpt/system/TaskScheduler.h>
+#include <mrpt/system/CTimeLogger.h>
+#include <cstdlib>
+#include <iostream>
+
+using namespace mrpt::system;
+
+struct TaskScheduler::Worker
+{
+	/** Own tasks: pushed and popped at the back, stolen from the front */
+	std::deque<std::function<void()>> tasks;
+	std::mutex mtx;
+	std::thread thread;
+};
+
+// The scheduler and index of the worker running in this thread, if any:
+static thread_local TaskScheduler* tl_scheduler = nullptr;
+static thread_local std::size_t tl_worker_index = 0;
+
+TaskScheduler::TaskScheduler(std::size_t concurrency) { start(concurrency); }
+TaskScheduler::~TaskScheduler() { stop(); }
+TaskScheduler& TaskScheduler::Instance()
+{
+	static TaskScheduler sched;
+	return sched;
+}
+
+std::size_t TaskScheduler::DefaultConcurrency()
+{
+	if (const char* env = ::getenv("MRPT_NUM_THREADS"); env != nullptr)
+	{
+		const int n = ::atoi(env);
+		if (n > 0) return static_cast<std::size_t>(n);
+		std::cerr << "[TaskScheduler] Ignoring invalid value of "
+					 "MRPT_NUM_THREADS: '"
+				  << env << "'\n";
+	}
+	return std::max(1U, std::thread::hardware_concurrency());
+}
+
+void TaskScheduler::setNumThreads(std::size_t concurrency)
+{
+	if (!concurrency) concurrency = DefaultConcurrency();
+	if (concurrency == this->concurrency()) return;
+	stop();
+	start(concurrency);
+}
+
+void TaskScheduler::start(std::size_t concurrency)
+{
+	if (!concurrency) concurrency = DefaultConcurrency();
+	m_stop = false;
+	m_workers.resize(concurrency - 1);
+	for (auto& w : m_workers) w = std::make_unique<Worker>();
+	// Launch threads once all Worker structures exist, since they are
+	// accessed by other workers to steal tasks:
+	for (std::size_t i = 0; i < m_workers.size(); i++)
+		m_workers[i]->thread = std::thread([this, i]() { workerMain(i); });
+}
+
+void TaskScheduler::stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_sleep_mtx);
+		m_stop = true;
+	}
+	m_wakeup.notify_all();
+	for (auto& w : m_workers)
+		if (w->thread.joinable()) w->thread.join();
+	m_workers.clear();
+	// Without workers, tasks still pending must be run here:
+	while (runPendingTask())
+	{
+	}
+}
+
+std::size_t TaskScheduler::pendingTasks() const
+{
+	std::unique_lock<std::mutex> lock(m_sleep_mtx);
+	return m_pending;
+}
+
+void TaskScheduler::spawn(std::function<void()> task)
+{
+	// Account for the task first, so an idle worker woken up below never
+	// misses it:
+	{
+		std::unique_lock<std::mutex> lock(m_sleep_mtx);
+		m_pending++;
+	}
+	if (tl_scheduler == this)
+	{
+		Worker& w = *m_workers[tl_worker_index];
+		std::unique_lock<std::mutex> lock(w.mtx);
+		w.tasks.emplace_back(std::move(task));
+	}
+	else
+	{
+		std::unique_lock<std::mutex> lock(m_injected_mtx);
+		m_injected.emplace_back(std::move(task));
+	}
+	m_wakeup.notify_one();
+}
+
+bool TaskScheduler::popTask(std::function<void()>& task)
+{
+	const std::size_t N = m_workers.size();
+	const bool isWorker = (tl_scheduler == this);
+	const std::size_t self = isWorker ? tl_worker_index : 0;
+
+	bool found = false;
+	// 1) Own tasks, newest first (better cache locality):
+	if (isWorker)
+	{
+		Worker& w = *m_workers[self];
+		std::unique_lock<std::mutex> lock(w.mtx);
+		if (!w.tasks.empty())
+		{
+			task = std::move(w.tasks.back());
+			w.tasks.pop_back();
+			found = true;
+		}
+	}
+	// 2) Tasks from non-worker threads, in FIFO order:
+	if (!found)
+	{
+		std::unique_lock<std::mutex> lock(m_injected_mtx);
+		if (!m_injected.empty())
+		{
+			task = std::move(m_injected.front());
+			m_injected.pop_front();
+			found = true;
+		}
+	}
+	// 3) Steal the oldest task of another worker:
+	for (std::size_t k = isWorker ? 1 : 0; !found && k < N; k++)
+	{
+		Worker& w = *m_workers[(self + k) % N];
+		std::unique_lock<std::mutex> lock(w.mtx);
+		if (!w.tasks.empty())
+		{
+			task = std::move(w.tasks.front());
+			w.tasks.pop_front();
+			found = true;
+		}
+	}
+	if (found)
+	{
+		std::unique_lock<std::mutex> lock(m_sleep_mtx);
+		m_pending--;
+	}
+	return found;
+}
+
+bool TaskScheduler::runPendingTask()
+{
+	std::function<void()> task;
+	if (!popTask(task)) return false;
+	task();
+	return true;
+}
+
+void TaskScheduler::workerMain(std::size_t index)
+{
+	tl_scheduler = this;
+	tl_worker_index = index;
+	for (;;)
+	{
+		if (runPendingTask()) continue;
+		std::unique_lock<std::mutex> lock(m_sleep_mtx);
+		m_wakeup.wait(lock, [this]() { return m_stop || m_pending > 0; });
+		// Finish all pending tasks before quitting:
+		if (m_stop && !m_pending) break;
+	}
+	tl_scheduler = nullptr;
+}
+
+TaskGroup::~TaskGroup()
+{
+	try
+	{
+		wait();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[TaskGroup] Exception ignored in destructor: "
+				  << e.what() << "\n";
+	}
+	catch (...)
+	{
+	}
+}
+
+void TaskGroup::setProfiler(CTimeLogger* profiler, const std::string& name)
+{
+	m_profiler = profiler;
+	m_profilerName = name;
+}
+
+void TaskGroup::taskStarting()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+	if (m_profiler && !m_pending && !m_numTasks)
+		m_profiler->enter(m_profilerName.c_str());
+	m_pending++;
+	m_numTasks++;
+}
+
+void TaskGroup::taskFinished(double elapsed, std::exception_ptr e)
+{
+	// Notify while holding the lock, since "this" may be destroyed as soon
+	// as the waiting thread acquires it:
+	std::unique_lock<std::mutex> lock(m_mtx);
+	m_tasksTime += elapsed;
+	if (e && !m_exception) m_exception = e;
+	if (--m_pending == 0) m_done.notify_all();
+}
+
+void TaskGroup::wait()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			if (!m_pending) break;
+		}
+		if (m_sched.runPendingTask()) continue;
+		// Our tasks are running in other threads. Wake up periodically in
+		// case they spawn nested tasks we can help with:
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_done.wait_for(lock, std::chrono::milliseconds(1), [this]() {
+			return m_pending == 0;
+		});
+	}
+
+	std::exception_ptr e;
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if (m_profiler && m_numTasks)
+		{
+			const double wallTime = m_profiler->leave(m_profilerName.c_str());
+			m_profiler->registerUserMeasure(
+				(m_profilerName + ".tasks").c_str(), double(m_numTasks));
+			if (wallTime > 0)
+				m_profiler->registerUserMeasure(
+					(m_profilerName + ".speedup").c_str(),
+					m_tasksTime / wallTime);
+		}
+		m_numTasks = 0;
+		m_tasksTime = 0;
+		std::swap(e, m_exception);
+	}
+	if (e) std::rethrow_exception(e);
+}
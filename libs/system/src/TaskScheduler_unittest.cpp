@@ -0,0 +1,117 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/system/TaskScheduler.h>
+#include <mrpt/system/CTimeLogger.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+
+using mrpt::system::TaskScheduler;
+
+TEST(TaskScheduler, TaskGroup)
+{
+	TaskScheduler sched(4);
+	EXPECT_EQ(sched.size(), 3u);
+	EXPECT_EQ(sched.concurrency(), 4u);
+
+	std::vector<int> out(100, 0);
+	{
+		mrpt::system::TaskGroup tg(sched);
+		for (int i = 0; i < 100; i++) tg.run([&out, i]() { out[i] = i * i; });
+		tg.wait();
+	}
+	for (int i = 0; i < 100; i++) EXPECT_EQ(out[i], i * i);
+
+	mrpt::system::TaskGroup tg(sched);
+	tg.run([]() { throw std::runtime_error("test error"); });
+	EXPECT_THROW(tg.wait(), std::runtime_error);
+	// The exception is only reported once:
+	EXPECT_NO_THROW(tg.wait());
+
+	auto fut = sched.async([]() { return 42; });
+	sched.wait(fut);
+	EXPECT_EQ(fut.get(), 42);
+}
+
+TEST(TaskScheduler, ThreadsGuard)
+{
+	auto& sched = TaskScheduler::Instance();
+	const std::size_t prev = sched.concurrency();
+	{
+		mrpt::system::TaskSchedulerThreadsGuard threads(prev + 2);
+		EXPECT_EQ(sched.concurrency(), prev + 2);
+	}
+	EXPECT_EQ(sched.concurrency(), prev);
+	// Also restored if an exception is thrown:
+	try
+	{
+		mrpt::system::TaskSchedulerThreadsGuard threads(prev + 1);
+		throw std::runtime_error("test error");
+	}
+	catch (const std::runtime_error&)
+	{
+	}
+	EXPECT_EQ(sched.concurrency(), prev);
+}
+
+TEST(TaskScheduler, parallel_for)
+{
+	// No worker threads at all: also must work, in the calling thread.
+	for (const std::size_t nThreads : {1, 2, 4})
+	{
+		TaskScheduler sched(nThreads);
+		for (const std::size_t N : {0, 1, 3, 4, 1000})
+		{
+			std::vector<int> visits(N, 0);
+			mrpt::system::parallel_for(
+				0, N, [&](std::size_t i) { visits[i]++; }, 0, sched);
+			for (std::size_t i = 0; i < N; i++) EXPECT_EQ(visits[i], 1);
+
+			std::atomic<int> nCalls{0};
+			mrpt::system::parallel_for_chunks(
+				N,
+				[&](std::size_t first, std::size_t last) {
+					nCalls++;
+					for (std::size_t i = first; i < last; i++) visits[i]++;
+				},
+				3, sched);
+			for (std::size_t i = 0; i < N; i++) EXPECT_EQ(visits[i], 2);
+			EXPECT_LE(nCalls, 3);
+		}
+	}
+}
+
+TEST(TaskScheduler, nestedLoopsAndProfiler)
+{
+	TaskScheduler sched(3);
+	const std::size_t N = 20, M = 50;
+	std::vector<std::atomic<int>> sums(N);
+	mrpt::system::CTimeLogger tl(true, "test");
+	tl.setMinLoggingLevel(mrpt::system::LVL_ERROR);  // Don't dump stats
+	{
+		mrpt::system::TaskGroup tg(sched);
+		tg.setProfiler(&tl, "outer");
+		for (std::size_t i = 0; i < N; i++)
+			tg.run([&, i]() {
+				mrpt::system::parallel_for(
+					0, M, [&](std::size_t j) { sums[i] += int(j); }, 1,
+					sched);
+			});
+		tg.wait();
+	}
+	for (std::size_t i = 0; i < N; i++)
+		EXPECT_EQ(sums[i], int(M * (M - 1) / 2));
+
+	std::map<std::string, mrpt::system::CTimeLogger::TCallStats> stats;
+	tl.getStats(stats);
+	EXPECT_EQ(stats.count("outer"), 1u);
+	ASSERT_EQ(stats.count("outer.tasks"), 1u);
+	EXPECT_EQ(stats["outer.tasks"].last_t, double(N));
+}
@@ -310,6 +310,40 @@ class CFeatureExtraction
 			bool rotationInvariance;  // = true,
 			int half_ssd_size;  // = 3
 		} LATCHOptions;
+
+		/** Tiled multi-scale detection: if enabled, detectFeatures() builds an
+		 * image pyramid, splits each octave into tiles, runs the detector
+		 * selected in \a featsType on all tiles in parallel, and spreads the
+		 * resulting features evenly over the image by keeping the best ones
+		 * of each cell of a regular grid ("bucketing").
+		 * Detectors which already build their own scale space (SIFT, SURF,
+		 * ORB, AKAZE) are better used with \a octaves=1.
+		 * \note [New in MRPT 2.0.0] */
+		struct TTiledPyramidOptions
+		{
+			/** Use tiled multi-scale detection (default=false) */
+			bool enable{false};
+			/** Number of pyramid octaves: 1=only the original image
+			 * (default=1) */
+			unsigned int octaves{1};
+			/** Number of tiles along each direction of the 1st octave. Each
+			 * octave halves them (down to 1), so that all tiles have
+			 * similar sizes (default=4x4) */
+			unsigned int tiles_x{4}, tiles_y{4};
+			/** Pixels added around each tile, so detectors which ignore the
+			 * image borders can find features near tile boundaries
+			 * (default=16) */
+			unsigned int tile_overlap{16};
+			/** Side of the bucketing cells, in (full resolution) pixels
+			 * (default=32) */
+			unsigned int bucket_size{32};
+			/** Max. number of features kept per bucket, 0=unlimited
+			 * (default=4) */
+			unsigned int max_feats_per_bucket{4};
+			/** Max. number of threads: 0=as many as
+			 * mrpt::system::TaskScheduler threads, 1=serial (default=0) */
+			unsigned int num_threads{0};
+		} tiledPyramidOptions;
 	};
 
 	TOptions options;  //!< Set all the parameters of the desired method here
@@ -326,6 +360,9 @@ class CFeatureExtraction
 	* \param nDesiredFeatures (op. input) Number of features to be extracted.
 	* Default: all possible.
 	*
+	* If options.tiledPyramidOptions.enable is set, the image is processed
+	* by tiles and octaves in parallel (see TOptions::TTiledPyramidOptions).
+	*
 	* \sa computeDescriptors
 	*/
 	void detectFeatures(
@@ -434,6 +471,19 @@ class CFeatureExtraction
 	/** @} */
 
    private:
+	/** Runs the detector selected in options.featsType on one image */
+	void internal_detectFeatures(
+		const mrpt::img::CImage& img, CFeatureList& feats,
+		const unsigned int init_ID, const unsigned int nDesiredFeatures,
+		const TImageROI& ROI) const;
+
+	/** Tiled, multi-scale version of detectFeatures()
+	 * \sa TOptions::TTiledPyramidOptions */
+	void internal_detectFeaturesTiledPyramid(
+		const mrpt::img::CImage& img, CFeatureList& feats,
+		const unsigned int init_ID, const unsigned int nDesiredFeatures,
+		const TImageROI& ROI) const;
+
 	/** Compute the SIFT descriptor of the provided features into the input
 	image
 	* \param in_img (input) The image from where to compute the descriptors.
@@ -13,6 +13,7 @@
 #include <mrpt/vision/types.h>
 
 #include <mrpt/vision/CFeature.h>
+#include <mrpt/vision/CImagePyramid.h>
 #include <mrpt/vision/TSimpleFeature.h>
 #include <mrpt/img/CImage.h>
 #include <mrpt/system/CTimeLogger.h>
@@ -133,6 +134,11 @@ namespace mrpt::vision
  * be automatically removed from the list of features.
   *            Otherwise, the user will have to manually remove them by checking
  * the track_status field. </td> </tr>
+  *   <tr><td align="center" > num_threads  </td>  <td align="center" >
+ * 0 </td>
+  *      <td> Max. number of threads to track features and compute their KLT
+ * responses: 0=as many as mrpt::system::TaskScheduler threads, 1=serial.
+ * </td> </tr>
   * </table>
   *
   *  This class also offers a time profiler, disabled by default (see
@@ -302,18 +308,24 @@ using CGenericFeatureTrackerAutoPtr = std::unique_ptr<CGenericFeatureTracker>;
   *CGenericFeatureTracker) accepted by this class:
   *		- "window_width"  (Default=15)
   *		- "window_height" (Default=15)
-  *		- "LK_levels" (Default=3) Number of pyramids to build for LK tracking
-  *(this
-  *parameter only has effects when tracking with CImage's, not with
-  *CImagePyramid's).
+  *		- "LK_levels" (Default=3) Number of pyramid levels above the original
+  *image used for LK tracking (0=no pyramid).
   *		- "LK_max_iters" (Default=10) Max. number of iterations in LK tracking.
   *		- "LK_epsilon" (Default=0.1) Minimum epsilon step in interations of
   *LK_tracking.
   *		- "LK_max_tracking_error" (Default=150.0) The maximum "tracking error"
   *of
-  *LK tracking such as a feature is marked as "lost".
+  *LK tracking such as a feature is marked as "lost". The error is the mean
+  *absolute difference of intensities between the windows around the feature
+  *in both images.
+  *
+  *  The pyramidal LK method is implemented natively (with SSE2 bilinear
+  *interpolation and gradient accumulation), tracking features in parallel
+  *(see the "num_threads" parameter). The pyramid of the new image is kept
+  *and reused in the next call if its old image is the same, as it happens
+  *when tracking a video.
   *
-  *  \sa OpenCV's method cvCalcOpticalFlowPyrLK
+  *  \sa CImagePyramid
   */
 struct CFeatureTracker_KL : public CGenericFeatureTracker
 {
@@ -337,6 +349,9 @@ struct CFeatureTracker_KL : public CGenericFeatureTracker
 		TSimpleFeaturefList& inout_featureList) override;
 
    private:
+	/** Pyramids of the old and new images of the last call */
+	CImagePyramid m_prev_pyr, m_cur_pyr;
+
 	template <typename FEATLIST>
 	void trackFeatures_impl_templ(
 		const mrpt::img::CImage& old_img, const mrpt::img::CImage& new_img,
@@ -38,6 +38,17 @@ struct sort_pred
 void CFeatureExtraction::detectFeatures(
 	const CImage& img, CFeatureList& feats, const unsigned int init_ID,
 	const unsigned int nDesiredFeatures, const TImageROI& ROI) const
+{
+	if (options.tiledPyramidOptions.enable)
+		internal_detectFeaturesTiledPyramid(
+			img, feats, init_ID, nDesiredFeatures, ROI);
+	else
+		internal_detectFeatures(img, feats, init_ID, nDesiredFeatures, ROI);
+}
+
+void CFeatureExtraction::internal_detectFeatures(
+	const CImage& img, CFeatureList& feats, const unsigned int init_ID,
+	const unsigned int nDesiredFeatures, const TImageROI& ROI) const
 {
 	switch (options.featsType)
 	{
@@ -472,6 +483,15 @@ void CFeatureExtraction::TOptions::dumpToTextStream(std::ostream& out) const
 	LOADABLEOPTS_DUMP_VAR(LATCHOptions.half_ssd_size, int)
 	LOADABLEOPTS_DUMP_VAR(LATCHOptions.rotationInvariance, bool)
 
+	LOADABLEOPTS_DUMP_VAR(tiledPyramidOptions.enable, bool)
+	LOADABLEOPTS_DUMP_VAR(tiledPyramidOptions.octaves, int)
+	LOADABLEOPTS_DUMP_VAR(tiledPyramidOptions.tiles_x, int)
+	LOADABLEOPTS_DUMP_VAR(tiledPyramidOptions.tiles_y, int)
+	LOADABLEOPTS_DUMP_VAR(tiledPyramidOptions.tile_overlap, int)
+	LOADABLEOPTS_DUMP_VAR(tiledPyramidOptions.bucket_size, int)
+	LOADABLEOPTS_DUMP_VAR(tiledPyramidOptions.max_feats_per_bucket, int)
+	LOADABLEOPTS_DUMP_VAR(tiledPyramidOptions.num_threads, int)
+
 	out << mrpt::format("\n");
 }
 
@@ -560,4 +580,21 @@ void CFeatureExtraction::TOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(LATCHOptions.half_ssd_size, int, iniFile, section)
 	MRPT_LOAD_CONFIG_VAR(
 		LATCHOptions.rotationInvariance, bool, iniFile, section)
+
+	MRPT_LOAD_CONFIG_VAR(tiledPyramidOptions.enable, bool, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(
+		tiledPyramidOptions.octaves, uint64_t, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(
+		tiledPyramidOptions.tiles_x, uint64_t, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(
+		tiledPyramidOptions.tiles_y, uint64_t, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(
+		tiledPyramidOptions.tile_overlap, uint64_t, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(
+		tiledPyramidOptions.bucket_size, uint64_t, iniFile, section)
+	MRPT_LOAD_CONFIG_VAR(
+		tiledPyramidOptions.max_feats_per_bucket, uint64_t, iniFile,
+		section)
+	MRPT_LOAD_CONFIG_VAR(
+		tiledPyramidOptions.num_threads, uint64_t, iniFile, section)
 }
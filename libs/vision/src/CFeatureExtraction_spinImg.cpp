@@ -93,7 +93,7 @@ void CFeatureExtraction::internal_computeSpinImageDescriptors(
 		py1 = min(img_h - 1, py1);
 
 		uint8_t pix_val;
-		uint8_t* aux_pix_ptr;
+		const uint8_t* aux_pix_ptr;
 
 		for (int px = px0; px <= px1; px++)
 		{
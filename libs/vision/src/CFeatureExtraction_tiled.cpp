@@ -0,0 +1,222 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"  // Precompiled headers
+
+#include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/vision/CImagePyramid.h>
+#include <mrpt/system/TaskScheduler.h>
+#include <mrpt/core/round.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace mrpt;
+using namespace mrpt::vision;
+using namespace mrpt::img;
+using namespace std;
+
+namespace
+{
+/** One unit of work: a tile of one octave. Coordinates are in pixels of
+ * that octave. */
+struct TTileTask
+{
+	size_t octave;
+	/** The tile itself: features are kept only if they fall in here */
+	int x0, x1, y0, y1;
+	/** The tile plus the overlap margins: the image given to the detector */
+	int cx0, cx1, cy0, cy1;
+};
+}  // namespace
+
+void CFeatureExtraction::internal_detectFeaturesTiledPyramid(
+	const CImage& img, CFeatureList& feats, const unsigned int init_ID,
+	const unsigned int nDesiredFeatures, const TImageROI& ROI) const
+{
+	MRPT_START
+
+	const auto& opts = options.tiledPyramidOptions;
+	ASSERT_(opts.octaves >= 1);
+	ASSERT_(opts.tiles_x >= 1 && opts.tiles_y >= 1);
+
+	const int W = static_cast<int>(img.getWidth()),
+			  H = static_cast<int>(img.getHeight());
+
+	// Region to look for features, in full resolution pixels:
+	int rx0 = 0, rx1 = W, ry0 = 0, ry1 = H;
+	if (!(ROI.xMin == 0 && ROI.xMax == 0 && ROI.yMin == 0 && ROI.yMax == 0))
+	{
+		rx0 = std::max(0, static_cast<int>(ROI.xMin));
+		rx1 = std::min(W, static_cast<int>(ROI.xMax) + 1);
+		ry0 = std::max(0, static_cast<int>(ROI.yMin));
+		ry1 = std::min(H, static_cast<int>(ROI.yMax) + 1);
+	}
+
+	// 1) Octaves: the original image is used as is for the first one.
+	CImagePyramid pyr;
+	std::vector<const CImage*> octaves(1, &img);
+	if (opts.octaves > 1)
+	{
+		pyr.buildPyramid(img, opts.octaves);
+		for (size_t o = 1; o < pyr.images.size(); o++)
+			octaves.push_back(&pyr.images[o]);
+	}
+
+	// 2) Tiles: each octave has half the tiles of the previous one along
+	// each direction, so all tasks take roughly the same time.
+	std::vector<TTileTask> tasks;
+	const int ov = static_cast<int>(opts.tile_overlap);
+	for (size_t o = 0; o < octaves.size(); o++)
+	{
+		const int oW = static_cast<int>(octaves[o]->getWidth()),
+				  oH = static_cast<int>(octaves[o]->getHeight());
+		const int ox0 = rx0 >> o, oy0 = ry0 >> o;
+		const int ox1 = std::min(oW, (rx1 + (1 << o) - 1) >> o),
+				  oy1 = std::min(oH, (ry1 + (1 << o) - 1) >> o);
+		if (ox1 - ox0 < 1 || oy1 - oy0 < 1) continue;
+
+		const int ntx = std::max(1U, opts.tiles_x >> o),
+				  nty = std::max(1U, opts.tiles_y >> o);
+		for (int ty = 0; ty < nty; ty++)
+		{
+			for (int tx = 0; tx < ntx; tx++)
+			{
+				TTileTask t;
+				t.octave = o;
+				t.x0 = ox0 + ((ox1 - ox0) * tx) / ntx;
+				t.x1 = ox0 + ((ox1 - ox0) * (tx + 1)) / ntx;
+				t.y0 = oy0 + ((oy1 - oy0) * ty) / nty;
+				t.y1 = oy0 + ((oy1 - oy0) * (ty + 1)) / nty;
+				if (t.x1 <= t.x0 || t.y1 <= t.y0) continue;
+				t.cx0 = std::max(0, t.x0 - ov);
+				t.cx1 = std::min(oW, t.x1 + ov);
+				t.cy0 = std::max(0, t.y0 - ov);
+				t.cy1 = std::min(oH, t.y1 + ov);
+				tasks.push_back(t);
+			}
+		}
+	}
+
+	// 3) Run the detector on all tiles. Patches are only extracted at the
+	// end, from the full resolution image, for the features that survive.
+	CFeatureExtraction tileDetector;
+	tileDetector.options = options;
+	tileDetector.options.tiledPyramidOptions.enable = false;
+	tileDetector.options.patchSize = 0;
+	tileDetector.options.addNewFeatures = false;
+
+	const int patch_half = static_cast<int>(options.patchSize) / 2;
+	std::vector<std::vector<CFeature::Ptr>> tileFeats(tasks.size());
+
+	mrpt::system::parallel_for_chunks(
+		tasks.size(),
+		[&](const size_t first, const size_t last) {
+			CImage crop(UNINITIALIZED_IMAGE);
+			CFeatureList lst;
+			for (size_t i = first; i < last; i++)
+			{
+				const TTileTask& t = tasks[i];
+				const CImage& oImg = *octaves[t.octave];
+				const bool whole_img =
+					t.cx0 == 0 && t.cy0 == 0 &&
+					t.cx1 == static_cast<int>(oImg.getWidth()) &&
+					t.cy1 == static_cast<int>(oImg.getHeight());
+				// A view: the pixels of the tile are not copied.
+				if (!whole_img)
+					crop = oImg.makeView(
+						t.cx0, t.cy0, t.cx1 - t.cx0, t.cy1 - t.cy0);
+
+				lst.clear();
+				tileDetector.internal_detectFeatures(
+					whole_img ? oImg : crop, lst, 0, 0, TImageROI());
+
+				const float s = static_cast<float>(1 << t.octave);
+				auto& out = tileFeats[i];
+				for (const auto& f : lst)
+				{
+					const float ox = f->x + t.cx0, oy = f->y + t.cy0;
+					if (ox < t.x0 || ox >= t.x1 || oy < t.y0 || oy >= t.y1)
+						continue;  // It belongs to a neighbor tile.
+
+					// Pixel centers of octave "o" are at (i+0.5)*2^o-0.5:
+					f->x = (ox + 0.5f) * s - 0.5f;
+					f->y = (oy + 0.5f) * s - 0.5f;
+					f->scale = (f->scale > 0 ? f->scale : 1.0f) * s;
+					if (patch_half > 0)
+					{
+						const int px = mrpt::round(f->x) - patch_half,
+								  py = mrpt::round(f->y) - patch_half;
+						if (px < 0 || py < 0 ||
+							px + static_cast<int>(options.patchSize) > W ||
+							py + static_cast<int>(options.patchSize) > H)
+							continue;  // Its patch does not fit.
+					}
+					out.push_back(f);
+				}
+			}
+		},
+		opts.num_threads);
+
+	// Merge, in a deterministic order regardless of the number of threads:
+	std::vector<CFeature::Ptr> all;
+	for (auto& tf : tileFeats)
+		for (auto& f : tf) all.push_back(std::move(f));
+
+	// 4) Grid bucketing: rank features within each cell by their response,
+	// then take the best 1st-ranked ones of all cells, then the 2nd-ranked
+	// ones, etc. so that features spread evenly over the image.
+	const size_t N = all.size();
+	std::vector<size_t> bucket(N, 0), rank(N, 0), idxs(N);
+	for (size_t i = 0; i < N; i++) idxs[i] = i;
+	if (opts.bucket_size > 0)
+	{
+		const size_t bs = opts.bucket_size;
+		const size_t nBucketsX = 1 + W / bs;
+		for (size_t i = 0; i < N; i++)
+			bucket[i] = static_cast<size_t>(std::max(0.f, all[i]->y)) / bs *
+							nBucketsX +
+						static_cast<size_t>(std::max(0.f, all[i]->x)) / bs;
+		std::stable_sort(idxs.begin(), idxs.end(), [&](size_t a, size_t b) {
+			if (bucket[a] != bucket[b]) return bucket[a] < bucket[b];
+			return all[a]->response > all[b]->response;
+		});
+		for (size_t k = 1; k < N; k++)
+			if (bucket[idxs[k]] == bucket[idxs[k - 1]])
+				rank[idxs[k]] = rank[idxs[k - 1]] + 1;
+	}
+	std::stable_sort(idxs.begin(), idxs.end(), [&](size_t a, size_t b) {
+		if (rank[a] != rank[b]) return rank[a] < rank[b];
+		return all[a]->response > all[b]->response;
+	});
+
+	// 5) Output:
+	if (!options.addNewFeatures) feats.clear();
+	TFeatureID nextID = init_ID;
+	size_t nAdded = 0;
+	for (const size_t i : idxs)
+	{
+		if (nDesiredFeatures != 0 && nAdded >= nDesiredFeatures) break;
+		if (opts.max_feats_per_bucket != 0 && opts.bucket_size != 0 &&
+			rank[i] >= opts.max_feats_per_bucket)
+			break;  // All remaining ones have an even worse rank.
+
+		CFeature::Ptr& f = all[i];
+		f->ID = nextID++;
+		f->patchSize = options.patchSize;
+		if (options.patchSize > 0)
+			img.extract_patch(
+				f->patch, mrpt::round(f->x) - patch_half,
+				mrpt::round(f->y) - patch_half, options.patchSize,
+				options.patchSize);
+		feats.push_back(f);
+		nAdded++;
+	}
+
+	MRPT_END
+}
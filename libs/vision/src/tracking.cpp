@@ -11,6 +11,7 @@
 
 #include <mrpt/vision/tracking.h>
 #include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/system/TaskScheduler.h>
 
 // Universal include for all versions of OpenCV
 #include <mrpt/otherlibs/do_opencv_includes.h>
@@ -31,49 +32,56 @@ template <typename FEATLIST>
 inline void trackFeatures_checkResponses(
 	FEATLIST& featureList, const CImage& cur_gray,
 	const float minimum_KLT_response, const unsigned int KLT_response_half_win,
-	const unsigned int max_x, const unsigned int max_y);
+	const unsigned int max_x, const unsigned int max_y,
+	const size_t num_threads);
 
 template <>
 inline void trackFeatures_checkResponses<CFeatureList>(
 	CFeatureList& featureList, const CImage& cur_gray,
 	const float minimum_KLT_response, const unsigned int KLT_response_half_win,
-	const unsigned int max_x, const unsigned int max_y)
+	const unsigned int max_x, const unsigned int max_y,
+	const size_t num_threads)
 {
-	const CFeatureList::iterator itFeatEnd = featureList.end();
-	for (CFeatureList::iterator itFeat = featureList.begin();
-		 itFeat != itFeatEnd; ++itFeat)
-	{
-		CFeature* ft = itFeat->get();
-		if (ft->track_status != status_TRACKED)
-			continue;  // Skip if it's not correctly tracked.
+	// Each feature is only modified by one task:
+	mrpt::system::parallel_for_chunks(
+		featureList.size(),
+		[&](const size_t first, const size_t last) {
+			for (size_t i = first; i < last; i++)
+			{
+				CFeature* ft = featureList[i].get();
+				if (ft->track_status != status_TRACKED)
+					continue;  // Skip if it's not correctly tracked.
 
-		const unsigned int x = ft->x;
-		const unsigned int y = ft->y;
-		if (x > KLT_response_half_win && y > KLT_response_half_win &&
-			x < max_x && y < max_y)
-		{  // Update response:
-			ft->response = cur_gray.KLT_response(x, y, KLT_response_half_win);
-
-			// Is it good enough?
-			// http://grooveshark.com/s/Goonies+Are+Good+Enough/2beBfO?src=5
-			if (ft->response < minimum_KLT_response)
-			{  // Nope!
-				ft->track_status = status_LOST;
+				const unsigned int x = ft->x;
+				const unsigned int y = ft->y;
+				if (x > KLT_response_half_win && y > KLT_response_half_win &&
+					x < max_x && y < max_y)
+				{  // Update response:
+					ft->response =
+						cur_gray.KLT_response(x, y, KLT_response_half_win);
+
+					// Is it good enough?
+					if (ft->response < minimum_KLT_response)
+					{  // Nope!
+						ft->track_status = status_LOST;
+					}
+				}
+				else
+				{  // Out of bounds
+					ft->response = 0;
+					ft->track_status = status_OOB;
+				}
 			}
-		}
-		else
-		{  // Out of bounds
-			ft->response = 0;
-			ft->track_status = status_OOB;
-		}
-	}
+		},
+		num_threads);
 }  // end of trackFeatures_checkResponses<>
 
 template <class FEAT_LIST>
 inline void trackFeatures_checkResponses_impl_simple(
 	FEAT_LIST& featureList, const CImage& cur_gray,
 	const float minimum_KLT_response, const unsigned int KLT_response_half_win,
-	const unsigned int max_x_, const unsigned int max_y_)
+	const unsigned int max_x_, const unsigned int max_y_,
+	const size_t num_threads)
 {
 	if (featureList.empty()) return;
 
@@ -83,52 +91,59 @@ inline void trackFeatures_checkResponses_impl_simple(
 	const pixel_coord_t max_x = static_cast<pixel_coord_t>(max_x_);
 	const pixel_coord_t max_y = static_cast<pixel_coord_t>(max_y_);
 
-	for (int N = featureList.size() - 1; N >= 0; --N)
-	{
-		typename FEAT_LIST::feature_t& ft = featureList[N];
-		if (ft.track_status != status_TRACKED)
-			continue;  // Skip if it's not correctly tracked.
-
-		if (ft.pt.x > half_win && ft.pt.y > half_win && ft.pt.x < max_x &&
-			ft.pt.y < max_y)
-		{  // Update response:
-			ft.response =
-				cur_gray.KLT_response(ft.pt.x, ft.pt.y, KLT_response_half_win);
-
-			// Is it good enough?
-			// http://grooveshark.com/s/Goonies+Are+Good+Enough/2beBfO?src=5
-			if (ft.response < minimum_KLT_response)
-			{  // Nope!
-				ft.track_status = status_LOST;
+	// Each feature is only modified by one task:
+	mrpt::system::parallel_for_chunks(
+		featureList.size(),
+		[&](const size_t first, const size_t last) {
+			for (size_t N = first; N < last; N++)
+			{
+				typename FEAT_LIST::feature_t& ft = featureList[N];
+				if (ft.track_status != status_TRACKED)
+					continue;  // Skip if it's not correctly tracked.
+
+				if (ft.pt.x > half_win && ft.pt.y > half_win &&
+					ft.pt.x < max_x && ft.pt.y < max_y)
+				{  // Update response:
+					ft.response = cur_gray.KLT_response(
+						ft.pt.x, ft.pt.y, KLT_response_half_win);
+
+					// Is it good enough?
+					if (ft.response < minimum_KLT_response)
+					{  // Nope!
+						ft.track_status = status_LOST;
+					}
+				}
+				else
+				{  // Out of bounds
+					ft.response = 0;
+					ft.track_status = status_OOB;
+				}
 			}
-		}
-		else
-		{  // Out of bounds
-			ft.response = 0;
-			ft.track_status = status_OOB;
-		}
-	}
+		},
+		num_threads);
 }  // end of trackFeatures_checkResponses<>
 
 template <>
 inline void trackFeatures_checkResponses<TSimpleFeatureList>(
 	TSimpleFeatureList& featureList, const CImage& cur_gray,
 	const float minimum_KLT_response, const unsigned int KLT_response_half_win,
-	const unsigned int max_x, const unsigned int max_y)
+	const unsigned int max_x, const unsigned int max_y,
+	const size_t num_threads)
 {
 	trackFeatures_checkResponses_impl_simple<TSimpleFeatureList>(
 		featureList, cur_gray, minimum_KLT_response, KLT_response_half_win,
-		max_x, max_y);
+		max_x, max_y, num_threads);
 }
 template <>
 inline void trackFeatures_checkResponses<TSimpleFeaturefList>(
 	TSimpleFeaturefList& featureList, const CImage& cur_gray,
 	const float minimum_KLT_response, const unsigned int KLT_response_half_win,
-	const unsigned int max_x, const unsigned int max_y)
+	const unsigned int max_x, const unsigned int max_y,
+	const size_t num_threads)
 {
 	trackFeatures_checkResponses_impl_simple<TSimpleFeaturefList>(
 		featureList, cur_gray, minimum_KLT_response, KLT_response_half_win,
-		max_x, max_y);
+		max_x, max_y, num_threads);
 }
 
 template <typename FEATLIST>
@@ -631,7 +646,7 @@ void CGenericFeatureTracker::internal_trackFeatures(
 
 		detail::trackFeatures_checkResponses(
 			featureList, cur_gray, minimum_KLT_response, KLT_response_half_win,
-			max_x, max_y);
+			max_x, max_y, extra_params.getWithDefaultVal("num_threads", 0));
 
 		m_timlog.leave("[CGenericFeatureTracker] check KLT responses");
 
@@ -9,29 +9,275 @@
 
 #include "vision-precomp.h"  // Precompiled headers
 
-#include <mrpt/system/memory.h>
 #include <mrpt/vision/tracking.h>
-#include <mrpt/vision/CFeatureExtraction.h>
-
-// Universal include for all versions of OpenCV
-#include <mrpt/otherlibs/do_opencv_includes.h>
-
-#if HAVE_ALLOCA_H
-#include <alloca.h>
-#endif
+#include <mrpt/core/SSE_types.h>
+#include <mrpt/core/round.h>
+#include <mrpt/system/TaskScheduler.h>
+#include <cmath>
+#include <cstring>
 
 using namespace mrpt;
 using namespace mrpt::vision;
 using namespace mrpt::img;
 using namespace std;
 
+namespace
+{
+/** Raw access to one grayscale pyramid level */
+struct TLevel
+{
+	const uint8_t* data;
+	int stride, w, h;
+};
+
+/** Per-thread buffers for trackOneFeature() */
+struct TScratch
+{
+	std::vector<float> Iw, I, Ix, Iy, J;
+};
+
+// Fixed-point precision of bilinear interpolation weights:
+constexpr int W_BITS = 14;
+constexpr float W_SCALE = 1.0f / (1 << W_BITS);
+
+/** Samples the window of `cols`x`rows` pixels whose top-left corner is at
+ * (x0,y0), by bilinear interpolation, into `out` (row-major). Pixels out of
+ * the image take the value of the nearest border pixel. */
+void sampleWindow(
+	const TLevel& im, const float x0, const float y0, const int cols,
+	const int rows, float* out)
+{
+	const int ix = static_cast<int>(std::floor(x0)),
+			  iy = static_cast<int>(std::floor(y0));
+	const float ax = x0 - ix, ay = y0 - iy;
+	const int w00 = mrpt::round((1 - ax) * (1 - ay) * (1 << W_BITS)),
+			  w01 = mrpt::round(ax * (1 - ay) * (1 << W_BITS)),
+			  w10 = mrpt::round((1 - ax) * ay * (1 << W_BITS)),
+			  w11 = (1 << W_BITS) - w00 - w01 - w10;
+
+	if (ix < 0 || iy < 0 || ix + cols > im.w - 1 || iy + rows > im.h - 1)
+	{
+		// Slow path, near or beyond the image borders:
+		auto px = [&im](int x, int y) -> int {
+			x = std::min(std::max(x, 0), im.w - 1);
+			y = std::min(std::max(y, 0), im.h - 1);
+			return im.data[y * im.stride + x];
+		};
+		for (int r = 0; r < rows; r++)
+			for (int c = 0; c < cols; c++)
+				*out++ = W_SCALE * (w00 * px(ix + c, iy + r) +
+									w01 * px(ix + c + 1, iy + r) +
+									w10 * px(ix + c, iy + r + 1) +
+									w11 * px(ix + c + 1, iy + r + 1));
+		return;
+	}
+
+	for (int r = 0; r < rows; r++)
+	{
+		const uint8_t* r0 = im.data + (iy + r) * im.stride + ix;
+		const uint8_t* r1 = r0 + im.stride;
+		int c = 0;
+#if MRPT_HAS_SSE2
+		// 8 pixels at once: interleave each pixel with its right neighbor
+		// and multiply-add them with the pair of weights of their row.
+		const __m128i z = _mm_setzero_si128();
+		const __m128i wr0 = _mm_set1_epi32((w01 << 16) | w00);
+		const __m128i wr1 = _mm_set1_epi32((w11 << 16) | w10);
+		const __m128 scale = _mm_set1_ps(W_SCALE);
+		for (; c + 8 <= cols; c += 8)
+		{
+			const __m128i a0 = _mm_unpacklo_epi8(
+				_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r0 + c)), z);
+			const __m128i b0 = _mm_unpacklo_epi8(
+				_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r0 + c + 1)),
+				z);
+			const __m128i a1 = _mm_unpacklo_epi8(
+				_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r1 + c)), z);
+			const __m128i b1 = _mm_unpacklo_epi8(
+				_mm_loadl_epi64(reinterpret_cast<const __m128i*>(r1 + c + 1)),
+				z);
+			const __m128i lo = _mm_add_epi32(
+				_mm_madd_epi16(_mm_unpacklo_epi16(a0, b0), wr0),
+				_mm_madd_epi16(_mm_unpacklo_epi16(a1, b1), wr1));
+			const __m128i hi = _mm_add_epi32(
+				_mm_madd_epi16(_mm_unpackhi_epi16(a0, b0), wr0),
+				_mm_madd_epi16(_mm_unpackhi_epi16(a1, b1), wr1));
+			_mm_storeu_ps(out + c, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+			_mm_storeu_ps(out + c + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+		}
+#endif
+		for (; c < cols; c++)
+			out[c] = W_SCALE * (w00 * r0[c] + w01 * r0[c + 1] +
+								w10 * r1[c] + w11 * r1[c + 1]);
+		out += cols;
+	}
+}
+
+/** Returns sum(a[i]*b[i]) and sum(a[i]*c[i]) */
+void dot2(
+	const float* a, const float* b, const float* c, const size_t n,
+	float& ab, float& ac)
+{
+	size_t i = 0;
+	ab = ac = 0;
+#if MRPT_HAS_SSE2
+	__m128 sab = _mm_setzero_ps(), sac = _mm_setzero_ps();
+	for (; i + 4 <= n; i += 4)
+	{
+		const __m128 va = _mm_loadu_ps(a + i);
+		sab = _mm_add_ps(sab, _mm_mul_ps(va, _mm_loadu_ps(b + i)));
+		sac = _mm_add_ps(sac, _mm_mul_ps(va, _mm_loadu_ps(c + i)));
+	}
+	alignas(16) float tab[4], tac[4];
+	_mm_store_ps(tab, sab);
+	_mm_store_ps(tac, sac);
+	ab = (tab[0] + tab[1]) + (tab[2] + tab[3]);
+	ac = (tac[0] + tac[1]) + (tac[2] + tac[3]);
+#endif
+	for (; i < n; i++)
+	{
+		ab += a[i] * b[i];
+		ac += a[i] * c[i];
+	}
+}
+
+enum class TLKResult
+{
+	Tracked,
+	OutOfBounds,
+	Lost
+};
+
+/** Pyramidal Lucas-Kanade for one feature at (x,y) in the previous image.
+ * On success, returns its position in the current image in (out_x,out_y) and
+ * the mean absolute intensity difference of the window in out_err. */
+TLKResult trackOneFeature(
+	const std::vector<TLevel>& prev, const std::vector<TLevel>& cur,
+	const float x, const float y, const int half_w, const int half_h,
+	const int max_iters, const float epsilon, float& out_x, float& out_y,
+	float& out_err, TScratch& s)
+{
+	const int ww = 2 * half_w + 1, wh = 2 * half_h + 1;
+	const size_t n = static_cast<size_t>(ww) * wh;
+	s.Iw.resize((ww + 2) * (wh + 2));
+	s.I.resize(n);
+	s.Ix.resize(n);
+	s.Iy.resize(n);
+	s.J.resize(n);
+
+	const int nLevels = static_cast<int>(prev.size());
+	// Pixel centers of level L are at (i+0.5)*2^L-0.5 in level 0:
+	const float top_scale = 1.0f / (1 << (nLevels - 1));
+	float cx = (x + 0.5f) * top_scale - 0.5f,
+		  cy = (y + 0.5f) * top_scale - 0.5f;
+
+	for (int L = nLevels - 1; L >= 0; L--)
+	{
+		const float sc = 1.0f / (1 << L);
+		const float px = (x + 0.5f) * sc - 0.5f, py = (y + 0.5f) * sc - 0.5f;
+		if (L != nLevels - 1)
+		{
+			cx = (cx + 0.5f) * 2 - 0.5f;
+			cy = (cy + 0.5f) * 2 - 0.5f;
+		}
+
+		// Window in the previous image, with a 1 pixel margin to compute
+		// its gradient by central differences:
+		sampleWindow(
+			prev[L], px - half_w - 1, py - half_h - 1, ww + 2, wh + 2,
+			&s.Iw[0]);
+		for (int r = 0; r < wh; r++)
+		{
+			const float* c0 = &s.Iw[(r + 1) * (ww + 2) + 1];
+			const float* cu = c0 - (ww + 2);
+			const float* cd = c0 + (ww + 2);
+			float* I = &s.I[r * ww];
+			float* Ix = &s.Ix[r * ww];
+			float* Iy = &s.Iy[r * ww];
+			for (int c = 0; c < ww; c++)
+			{
+				I[c] = c0[c];
+				Ix[c] = 0.5f * (c0[c + 1] - c0[c - 1]);
+				Iy[c] = 0.5f * (cd[c] - cu[c]);
+			}
+		}
+
+		// Spatial gradient matrix:
+		float Gxx, Gxy, Gyy, dummy;
+		dot2(&s.Ix[0], &s.Ix[0], &s.Iy[0], n, Gxx, Gxy);
+		dot2(&s.Iy[0], &s.Iy[0], &s.Iy[0], n, Gyy, dummy);
+		const float det = Gxx * Gyy - Gxy * Gxy;
+		const float minEig =
+			0.5f * (Gxx + Gyy -
+					std::sqrt((Gxx - Gyy) * (Gxx - Gyy) + 4 * Gxy * Gxy));
+		if (minEig < 1e-2f * n || std::abs(det) < 1e-6f)
+			return TLKResult::Lost;  // Not enough texture
+		const float inv_det = 1.0f / det;
+
+		for (int it = 0; it < max_iters; it++)
+		{
+			const TLevel& im = cur[L];
+			if (cx < -half_w || cy < -half_h || cx > im.w + half_w ||
+				cy > im.h + half_h)
+				return TLKResult::OutOfBounds;
+
+			sampleWindow(im, cx - half_w, cy - half_h, ww, wh, &s.J[0]);
+			for (size_t i = 0; i < n; i++) s.J[i] = s.I[i] - s.J[i];
+			float bx, by;
+			dot2(&s.J[0], &s.Ix[0], &s.Iy[0], n, bx, by);
+
+			const float ex = inv_det * (Gyy * bx - Gxy * by),
+						ey = inv_det * (Gxx * by - Gxy * bx);
+			cx += ex;
+			cy += ey;
+			if (ex * ex + ey * ey < epsilon * epsilon) break;
+		}
+	}
+
+	// Residual at the final position:
+	sampleWindow(cur[0], cx - half_w, cy - half_h, ww, wh, &s.J[0]);
+	float err = 0;
+	for (size_t i = 0; i < n; i++) err += std::abs(s.I[i] - s.J[i]);
+
+	out_x = cx;
+	out_y = cy;
+	out_err = err / n;
+	return TLKResult::Tracked;
+}
+
+void pyramidToLevels(const CImagePyramid& pyr, std::vector<TLevel>& levels)
+{
+	levels.resize(pyr.images.size());
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		const CImage& im = pyr.images[i];
+		ASSERT_(!im.isColor());
+		levels[i].data = im.get_unsafe(0, 0);
+		levels[i].stride = static_cast<int>(im.getRowStride());
+		levels[i].w = static_cast<int>(im.getWidth());
+		levels[i].h = static_cast<int>(im.getHeight());
+	}
+}
+
+/** Whether two grayscale images have identical contents */
+bool sameGrayImage(const CImage& a, const CImage& b)
+{
+	if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight() ||
+		a.isColor() || b.isColor())
+		return false;
+	const size_t w = a.getWidth();
+	for (size_t r = 0; r < a.getHeight(); r++)
+		if (std::memcmp(a.get_unsafe(0, r), b.get_unsafe(0, r), w) != 0)
+			return false;
+	return true;
+}
+}  // namespace
+
 /** Track a set of features from old_img -> new_img using sparse optimal flow
   *(classic KL method)
   *  Optional parameters that can be passed in "extra_params":
   *		- "window_width"  (Default=15)
   *		- "window_height" (Default=15)
-  *
-  *  \sa OpenCV's method cvCalcOpticalFlowPyrLK
   */
 template <typename FEATLIST>
 void CFeatureTracker_KL::trackFeatures_impl_templ(
@@ -39,7 +285,6 @@ void CFeatureTracker_KL::trackFeatures_impl_templ(
 {
 	MRPT_START
 
-#if MRPT_HAS_OPENCV
 	const unsigned int window_width =
 		extra_params.getWithDefaultVal("window_width", 15);
 	const unsigned int window_height =
@@ -47,14 +292,17 @@ void CFeatureTracker_KL::trackFeatures_impl_templ(
 
 	const int LK_levels = extra_params.getWithDefaultVal("LK_levels", 3);
 	const int LK_max_iters = extra_params.getWithDefaultVal("LK_max_iters", 10);
-	const int LK_epsilon = extra_params.getWithDefaultVal("LK_epsilon", 0.1);
+	const float LK_epsilon = extra_params.getWithDefaultVal("LK_epsilon", 0.1);
 	const float LK_max_tracking_error =
 		extra_params.getWithDefaultVal("LK_max_tracking_error", 150.0f);
+	const size_t num_threads =
+		extra_params.getWithDefaultVal("num_threads", 0);
 
 	// Both images must be of the same size
 	ASSERT_(
 		old_img.getWidth() == new_img.getWidth() &&
 		old_img.getHeight() == new_img.getHeight());
+	ASSERT_(LK_levels >= 0);
 
 	const size_t img_width = old_img.getWidth();
 	const size_t img_height = old_img.getHeight();
@@ -65,62 +313,56 @@ void CFeatureTracker_KL::trackFeatures_impl_templ(
 	const CImage prev_gray(old_img, FAST_REF_OR_CONVERT_TO_GRAY);
 	const CImage cur_gray(new_img, FAST_REF_OR_CONVERT_TO_GRAY);
 
-	// Array conversion MRPT->OpenCV
+	// Pyramids: when tracking a video, the new image of the last call is the
+	// old image of this one, so its pyramid is reused:
+	m_timlog.enter("[CFeatureTracker_KL] build pyramids");
+	const size_t nOctaves = LK_levels + 1;
+	if (m_cur_pyr.images.size() == nOctaves &&
+		sameGrayImage(m_cur_pyr.images[0], prev_gray))
+		m_prev_pyr.images.swap(m_cur_pyr.images);
+	else
+		m_prev_pyr.buildPyramid(prev_gray, nOctaves, true, true);
+	m_cur_pyr.buildPyramid(cur_gray, nOctaves, true, true);
+	m_timlog.leave("[CFeatureTracker_KL] build pyramids");
+
 	if (nFeatures > 0)
 	{
-		CvPoint2D32f* points[2];
+		std::vector<TLevel> prevLevels, curLevels;
+		pyramidToLevels(m_prev_pyr, prevLevels);
+		pyramidToLevels(m_cur_pyr, curLevels);
 
-		points[0] = reinterpret_cast<CvPoint2D32f*>(
-			mrpt_alloca(sizeof(CvPoint2D32f) * nFeatures));
-		points[1] = reinterpret_cast<CvPoint2D32f*>(
-			mrpt_alloca(sizeof(CvPoint2D32f) * nFeatures));
+		std::vector<float> new_x(nFeatures), new_y(nFeatures),
+			track_error(nFeatures, 0);
+		std::vector<TLKResult> status(nFeatures);
 
-		std::vector<char> status(nFeatures);
-
-		for (size_t i = 0; i < nFeatures; ++i)
-		{
-			points[0][i].x = featureList.getFeatureX(i);
-			points[0][i].y = featureList.getFeatureY(i);
-		}  // end for
-
-		// local scope for auxiliary variables around cvCalcOpticalFlowPyrLK()
-		const IplImage* prev_gray_ipl = prev_gray.getAs<IplImage>();
-		const IplImage* cur_gray_ipl = cur_gray.getAs<IplImage>();
-
-		// Pyramids
-		// JL: It seems that cache'ing the pyramids of previous images doesn't
-		// really improve the efficiency (!?!?)
-		IplImage* pPyr = nullptr;
-		IplImage* cPyr = nullptr;
-
-		int flags = 0;
-
-		float* track_error =
-			reinterpret_cast<float*>(mrpt_alloca(sizeof(float) * nFeatures));
-
-		cvCalcOpticalFlowPyrLK(
-			prev_gray_ipl, cur_gray_ipl, pPyr, cPyr, &points[0][0],
-			&points[1][0], nFeatures, cvSize(window_width, window_height),
-			LK_levels, &status[0], track_error,
-			cvTermCriteria(
-				CV_TERMCRIT_ITER | CV_TERMCRIT_EPS, LK_max_iters, LK_epsilon),
-			flags);
-
-		cvReleaseImage(&pPyr);
-		cvReleaseImage(&cPyr);
+		// Each feature is tracked independently, and writes to its own
+		// entries in the vectors above:
+		mrpt::system::parallel_for_chunks(
+			nFeatures,
+			[&](const size_t first, const size_t last) {
+				TScratch scratch;
+				for (size_t i = first; i < last; ++i)
+					status[i] = trackOneFeature(
+						prevLevels, curLevels, featureList.getFeatureX(i),
+						featureList.getFeatureY(i), window_width / 2,
+						window_height / 2, LK_max_iters, LK_epsilon, new_x[i],
+						new_y[i], track_error[i], scratch);
+			},
+			num_threads);
 
 		for (size_t i = 0; i < nFeatures; ++i)
 		{
 			const bool trck_err_too_large =
+				status[i] == TLKResult::Lost ||
 				track_error[i] > LK_max_tracking_error;
 
-			if (status[i] == 1 && !trck_err_too_large && points[1][i].x > 0 &&
-				points[1][i].y > 0 && points[1][i].x < img_width &&
-				points[1][i].y < img_height)
+			if (status[i] == TLKResult::Tracked && !trck_err_too_large &&
+				new_x[i] > 0 && new_y[i] > 0 && new_x[i] < img_width &&
+				new_y[i] < img_height)
 			{
 				// Feature could be tracked
-				featureList.setFeatureXf(i, points[1][i].x);
-				featureList.setFeatureYf(i, points[1][i].y);
+				featureList.setFeatureXf(i, new_x[i]);
+				featureList.setFeatureYf(i, new_y[i]);
 				featureList.setTrackStatus(i, status_TRACKED);
 			}  // end if
 			else  // Feature could not be tracked
@@ -132,18 +374,10 @@ void CFeatureTracker_KL::trackFeatures_impl_templ(
 			}  // end else
 		}  // end for
 
-		mrpt_alloca_free(points[0]);
-		mrpt_alloca_free(points[1]);
-		mrpt_alloca_free(track_error);
-
 		// In case it needs to rebuild a kd-tree or whatever
 		featureList.mark_as_outdated();
 	}
 
-#else
-	THROW_EXCEPTION("The MRPT has been compiled with MRPT_HAS_OPENCV=0 !");
-#endif
-
 	MRPT_END
 }  // end trackFeatures
 
@@ -0,0 +1,108 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          http://www.mrpt.org/                          |
+   |                                                                        |
+   | Copyright (c) 2005-2018, Individual contributors, see AUTHORS file     |
+   | See: http://www.mrpt.org/Authors - All rights reserved.                |
+   | Released under BSD License. See details in http://www.mrpt.org/License |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/config.h>
+#include <mrpt/core/round.h>
+#include <mrpt/system/TaskScheduler.h>
+#include <mrpt/vision/tracking.h>
+#include <gtest/gtest.h>
+#include <cmath>
+
+using namespace mrpt;
+using namespace mrpt::img;
+using namespace mrpt::vision;
+
+#if MRPT_HAS_OPENCV  // CImage has no pixels without OpenCV
+
+// A smooth texture, shifted by (dx,dy) pixels:
+static CImage makeTexture(
+	const unsigned int W, const unsigned int H, const double dx,
+	const double dy)
+{
+	CImage img(W, H, CH_GRAY);
+	for (unsigned int y = 0; y < H; y++)
+		for (unsigned int x = 0; x < W; x++)
+		{
+			const double u = x - dx, v = y - dy;
+			const double val = 128 +
+							   60 * std::sin(0.31 * u) * std::cos(0.23 * v) +
+							   35 * std::sin(0.13 * u + 0.19 * v);
+			*img(x, y) = static_cast<uint8_t>(mrpt::round(val));
+		}
+	return img;
+}
+
+static TSimpleFeaturefList makeGridOfFeatures(
+	const unsigned int W, const unsigned int H)
+{
+	TSimpleFeaturefList feats;
+	const unsigned int margin = 30, step = 12;
+	for (unsigned int y = margin; y < H - margin; y += step)
+		for (unsigned int x = margin; x < W - margin; x += step)
+			feats.push_back(TSimpleFeaturef(x, y));
+	return feats;
+}
+
+static TSimpleFeaturefList trackShift(
+	const CImage& img0, const CImage& img1, const unsigned int num_threads)
+{
+	CFeatureTracker_KL tracker;
+	tracker.extra_params["num_threads"] = num_threads;
+	TSimpleFeaturefList feats =
+		makeGridOfFeatures(img0.getWidth(), img0.getHeight());
+	tracker.trackFeatures(img0, img1, feats);
+	return feats;
+}
+
+TEST(CFeatureTracker_KL, TrackSubpixelShift)
+{
+	const unsigned int W = 200, H = 160;
+	const double dx = 2.35, dy = -1.6;
+	const CImage img0 = makeTexture(W, H, 0, 0);
+	const CImage img1 = makeTexture(W, H, dx, dy);
+
+	const TSimpleFeaturefList orig = makeGridOfFeatures(W, H);
+	const TSimpleFeaturefList feats = trackShift(img0, img1, 1);
+	ASSERT_EQ(feats.size(), orig.size());
+
+	size_t nTracked = 0;
+	for (size_t i = 0; i < feats.size(); i++)
+	{
+		if (feats[i].track_status != status_TRACKED) continue;
+		nTracked++;
+		EXPECT_NEAR(feats[i].pt.x, orig[i].pt.x + dx, 0.1) << "i=" << i;
+		EXPECT_NEAR(feats[i].pt.y, orig[i].pt.y + dy, 0.1) << "i=" << i;
+	}
+	EXPECT_GE(nTracked, feats.size() * 9 / 10);
+}
+
+TEST(CFeatureTracker_KL, SameResultForAnyNumThreads)
+{
+	const unsigned int W = 200, H = 160;
+	const CImage img0 = makeTexture(W, H, 0, 0);
+	const CImage img1 = makeTexture(W, H, -3.2, 1.7);
+
+	// Make sure there are worker threads, even on single-core machines:
+	mrpt::system::TaskSchedulerThreadsGuard threads(4);
+
+	const TSimpleFeaturefList serial = trackShift(img0, img1, 1);
+	for (unsigned int nThreads : {0U, 2U, 4U})
+	{
+		const TSimpleFeaturefList par = trackShift(img0, img1, nThreads);
+		ASSERT_EQ(par.size(), serial.size());
+		for (size_t i = 0; i < par.size(); i++)
+		{
+			EXPECT_EQ(par[i].track_status, serial[i].track_status);
+			EXPECT_EQ(par[i].pt.x, serial[i].pt.x);
+			EXPECT_EQ(par[i].pt.y, serial[i].pt.y);
+		}
+	}
+}
+
+#endif  // MRPT_HAS_OPENCV
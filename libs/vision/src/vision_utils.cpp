@@ -78,10 +78,8 @@ void vision::openCV_cross_correlation(
 	else
 	{
 		ASSERT_(!img.isColor() && !patch_img.isColor());
-		im.setFromIplImageReadOnly(
-			const_cast<IplImage*>(img.getAs<IplImage>()));
-		patch_im.setFromIplImageReadOnly(
-			const_cast<IplImage*>(patch_img.getAs<IplImage>()));
+		im.setFromImageReadOnly(img);
+		patch_im.setFromImageReadOnly(patch_img);
 	}
 
 	const int im_w = im.getWidth();
@@ -107,27 +105,20 @@ void vision::openCV_cross_correlation(
 	IplImage* result = cvCreateImage(
 		cvSize(x_search_size + 1, y_search_size + 1), IPL_DEPTH_32F, 1);
 
-	CImage img_region_to_search;
-
-	if (entireImg)
-	{
-		// Just a pointer to the original img:
-		img_region_to_search.setFromImageReadOnly(im);
-	}
-	else
-	{
-		im.extract_patch(
-			img_region_to_search,
-			x_search_ini,  // start corner
-			y_search_ini,
-			patch_w + x_search_size,  // sub-image size
-			patch_h + y_search_size);
-	}
+	// Just a view of the original img, without copying pixels:
+	const CImage img_region_to_search =
+		entireImg ? im
+				  : im.makeView(
+						x_search_ini,  // start corner
+						y_search_ini,
+						patch_w + x_search_size,  // sub-image size
+						patch_h + y_search_size);
 
 	// Compute cross correlation:
 	cvMatchTemplate(
-		img_region_to_search.getAs<IplImage>(), patch_im.getAs<IplImage>(),
-		result, CV_TM_CCORR_NORMED);
+		img_region_to_search.getAs<IplImage>(),
+		static_cast<const CImage&>(patch_im).getAs<IplImage>(), result,
+		CV_TM_CCORR_NORMED);
 
 	// Find the max point:
 	cvMinMaxLoc(result, &mini, &max_val, &min_point, &max_point, nullptr);
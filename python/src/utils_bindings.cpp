@@ -59,6 +59,11 @@ BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(
 // TODO implement read_vector, read_matrix and read_enum
 // end of CConfigFileBase
 
+// CFileGZInputStream
+BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(
+	CFileGZInputStream_open_overloads, open, 1, 2)
+// end of CFileGZInputStream
+
 // Utils
 double mrpt_utils_DEG2RAD(double deg) { return mrpt::DEG2RAD(deg); }
 double mrpt_utils_RAD2DEG(double rad) { return mrpt::RAD2DEG(rad); }
@@ -226,7 +231,11 @@ void export_utils()
 			"Transparently opens a compressed \"gz\" file and reads "
 			"uncompressed data from it.",
 			init<optional<std::string>>(args("filename")))
-			.def("open", &CFileGZInputStream::open, "Opens the file for read.")
+			.def(
+				"open", &CFileGZInputStream::open,
+				CFileGZInputStream_open_overloads(
+					args("filename", "num_threads"),
+					"Opens the file for read."))
 			.def("close", &CFileGZInputStream::close, "Closes the file.");
 	}
 